@@ -23,7 +23,8 @@ i2s_config_t        m_i2s_config;                   // stores values for I2S dri
 i2s_pin_config_t    m_pin_config;
 uint32_t            m_sampleRate=16000;
 uint8_t             m_bitsPerSample = 16;           // bitsPerSample
-uint8_t             m_vol=64;                       // volume
+volatile uint8_t    m_vol=21;                       // volume step 0...21, set by setVolume() on any task
+volatile bool       m_f_volChanged = true;          // applied by opusTask between reads
 size_t              m_i2s_bytesWritten = 0;         // set in i2s_write() but not used
 uint8_t             m_channels=2;
 int16_t             m_outBuff[2048*2];              // Interleaved L/R
@@ -33,8 +34,9 @@ boolean             m_f_forceMono = false;
 
 typedef enum { LEFTCHANNEL=0, RIGHTCHANNEL=1 } SampleIndex;
 
-const uint8_t volumetable[22]={   0,  1,  2,  3,  4 , 6 , 8, 10, 12, 14, 17,
-                                 20, 23, 27, 30 ,34, 38, 43 ,48, 52, 58, 64}; //22 elements
+// volume steps in dB Q7.8, the decoder scales the samples while it synthesizes them
+const int16_t volumetable[22]={OP_VOLUME_MUTE, -9248, -7706, -6805, -6165, -5264, -4624, -4128, -3722, -3379, -2948,
+                                        -2586, -2276, -1919, -1685, -1406, -1159,  -884,  -640,  -462,  -219,     0}; //22 elements
 
 OggOpusFile *of;
 OpusFileCallbacks cb;
@@ -108,15 +110,13 @@ uint8_t getChannels(){
     return m_channels;
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t Gain(int16_t s[2]) {
-    int32_t v[2];
-    float step = (float)m_vol /64;
-    uint8_t l = 0, r = 0;
-
-    v[LEFTCHANNEL] = (s[LEFTCHANNEL]  * (m_vol - l)) >> 6;
-    v[RIGHTCHANNEL]= (s[RIGHTCHANNEL] * (m_vol - r)) >> 6;
-
-    return (v[RIGHTCHANNEL] << 16) | (v[LEFTCHANNEL] & 0xffff);
+void setVolume(uint8_t vol) { // 0...21
+    if(vol > 21) vol = 21;
+    m_vol = vol;
+    m_f_volChanged = true;
+}
+uint8_t getVolume(){
+    return m_vol;
 }
 //---------------------------------------------------------------------------------------------------------------------
 bool playChunk() {
@@ -216,7 +216,7 @@ bool playSample(int16_t sample[2]) {
     sample[LEFTCHANNEL]  = sample[LEFTCHANNEL]  >> 1; // half Vin so we can boost up to 6dB in filters
     sample[RIGHTCHANNEL] = sample[RIGHTCHANNEL] >> 1;
 
-    uint32_t s32 = Gain(sample); // vosample2lume;
+    uint32_t s32 = ((uint16_t)sample[RIGHTCHANNEL] << 16) | (uint16_t)sample[LEFTCHANNEL];
 
     esp_err_t err = i2s_write((i2s_port_t) m_i2s_num, (const char*) &s32, sizeof(uint32_t), &m_i2s_bytesWritten, 1000);
     if(err != ESP_OK) {
@@ -243,6 +243,10 @@ int OPUS_read(void *_stream, unsigned char* ptr, int nbytes) {
 void opusTask(void *parameter) {
     int ret;
     do {
+        if(m_f_volChanged) { // the decoder ramps to the new volume
+            m_f_volChanged = false;
+            op_set_volume(of, volumetable[m_vol]);
+        }
         ret = op_read_stereo(of, m_outBuff, 2048);
         if(ret > 0){
             m_validSamples = ret;
@@ -254,6 +258,7 @@ void opusTask(void *parameter) {
 }
 //---------------------------------------------------------------------------------------------------------------------
 void setup() {
+    int ret;
     setupI2S();
     setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT, -1);
     setBitsPerSample(16);
@@ -266,7 +271,12 @@ void setup() {
     SD.begin(SD_CS);
     file = SD.open("/opus/sample1.opus");
     cb = { OPUS_read, NULL, NULL, NULL };
-    of = op_open_callbacks(NULL, &cb, NULL, 0, NULL);
+    of = op_open_callbacks(NULL, &cb, NULL, 0, &ret);
+    if(of == NULL) {
+        log_e("Can't open the Opus stream, error %i", ret);
+        return;
+    }
+    op_set_gain_offset(of, OP_TRACK_GAIN, 0); // ReplayGain (R128_TRACK_GAIN) if the file is tagged
 
     xTaskCreatePinnedToCore(
             opusTask, /* Function to implement the task */
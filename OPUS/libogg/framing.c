@@ -207,7 +207,7 @@ static int _os_lacing_expand(ogg_stream_state *os,long needed){
 /* Direct table CRC; note that this will be faster in the future if we
    perform the checksum simultaneously with other copies */
 
-static uint32_t _os_update_crc(uint32_t crc, unsigned char *buffer, int size){
+static uint32_t _os_update_crc(uint32_t crc, const unsigned char *buffer, int size){
   while (size>=8){
     crc^=((uint32_t)buffer[0]<<24)|((uint32_t)buffer[1]<<16)|((uint32_t)buffer[2]<<8)|((uint32_t)buffer[3]);
 
@@ -535,10 +535,25 @@ int ogg_sync_init(ogg_sync_state *oy){
   return(0);
 }
 
+/* parse pages in place from a complete, caller-owned buffer instead of
+   copying the stream into our own storage.  The buffer must outlive oy.
+   "Reading" (ogg_sync_buffer() followed by ogg_sync_wrote()) then only
+   exposes more of it: ogg_sync_buffer() returns a pointer to the bytes
+   already at the fill mark, which the caller must not write. */
+int ogg_sync_attach(ogg_sync_state *oy, const unsigned char *data, long size){
+  if(oy){
+    memset(oy,0,sizeof(*oy));
+    oy->data=(unsigned char *)data;
+    oy->storage=(int)size;
+    oy->external=1;
+  }
+  return(0);
+}
+
 /* clear non-flat storage within */
 int ogg_sync_clear(ogg_sync_state *oy){
   if(oy){
-    if(oy->data)free(oy->data);
+    if(oy->data && !oy->external)free(oy->data);
     memset(oy,0,sizeof(*oy));
   }
   return(0);
@@ -560,6 +575,10 @@ int ogg_sync_check(ogg_sync_state *oy){
 char *ogg_sync_buffer(ogg_sync_state *oy, long size){
   if(ogg_sync_check(oy)) return NULL;
 
+  /* in place: the data is already there and cannot be compacted or grown */
+  if(oy->external)
+    return((char *)oy->data+oy->fill);
+
   /* first, clear out any space that has been previously returned */
   if(oy->returned){
     oy->fill-=oy->returned;
@@ -634,26 +653,20 @@ long ogg_sync_pageseek(ogg_sync_state *oy,ogg_page *og){
 
   /* The whole test page is buffered.  Verify the checksum */
   {
-    /* Grab the checksum bytes, set the header field to zero */
-    char chksum[4];
-    ogg_page log;
+    /* Recompute it with the checksum field taken as zero.  The page is
+       only read, so this also works on an attached read-only buffer. */
+    static const unsigned char zeros[4]={0,0,0,0};
+    uint32_t crc_reg;
 
-    memcpy(chksum,page+22,4);
-    memset(page+22,0,4);
-
-    /* set up a temp page struct and recompute the checksum */
-    log.header=page;
-    log.header_len=oy->headerbytes;
-    log.body=page+oy->headerbytes;
-    log.body_len=oy->bodybytes;
-    ogg_page_checksum_set(&log);
+    crc_reg=_os_update_crc(0,page,22);
+    crc_reg=_os_update_crc(crc_reg,zeros,4);
+    crc_reg=_os_update_crc(crc_reg,page+26,oy->headerbytes-26);
+    crc_reg=_os_update_crc(crc_reg,page+oy->headerbytes,oy->bodybytes);
 
     /* Compare */
-    if(memcmp(chksum,page+22,4)){
+    if(crc_reg!=(page[22]|(uint32_t)page[23]<<8|(uint32_t)page[24]<<16|(uint32_t)page[25]<<24)){
       /* D'oh.  Mismatch! Corrupt page (or miscapture and not a page
          at all) */
-      /* replace the computed checksum with the one actually read in */
-      memcpy(page+22,chksum,4);
 
 #ifndef DISABLE_CRC
       /* Bad checksum. Lose sync */
@@ -736,7 +749,7 @@ long ogg_sync_pageseek(ogg_sync_state *oy,ogg_page *og){
 /* add the incoming page to the stream state; we decompose the page
    into packet segments here as well. */
 
-int ogg_stream_pagein(ogg_stream_state *os, ogg_page *og){
+static int _os_pagein(ogg_stream_state *os, ogg_page *og, int inplace){
   unsigned char *header=og->header;
   unsigned char *body=og->body;
   long           bodysize=og->body_len;
@@ -758,8 +771,21 @@ int ogg_stream_pagein(ogg_stream_state *os, ogg_page *og){
     long lr=os->lacing_returned;
     long br=os->body_returned;
 
-    /* body data */
-    if(br){
+    /* body data; a borrowed page body keeps only its unreturned tail,
+       which moves into our own storage before the page can go away */
+    if(os->body_ext){
+      unsigned char *ext=os->body_ext;
+      os->body_ext=NULL;
+      os->body_fill-=br;
+      os->body_returned=0;
+      if(os->body_fill){
+        long left=os->body_fill;
+        os->body_fill=0;
+        if(_os_body_expand(os,left)) return -1;
+        memcpy(os->body_data,ext+br,left);
+        os->body_fill=left;
+      }
+    }else if(br){
       os->body_fill-=br;
       if(os->body_fill)
         memmove(os->body_data,os->body_data+br,os->body_fill);
@@ -822,8 +848,13 @@ int ogg_stream_pagein(ogg_stream_state *os, ogg_page *og){
   }
 
   if(bodysize){
-    if(_os_body_expand(os,bodysize)) return -1;
-    memcpy(os->body_data+os->body_fill,body,bodysize);
+    if(inplace && !os->body_fill){
+      /* nothing pending: packets can be read straight from the page */
+      os->body_ext=body;
+    }else{
+      if(_os_body_expand(os,bodysize)) return -1;
+      memcpy(os->body_data+os->body_fill,body,bodysize);
+    }
     os->body_fill+=bodysize;
   }
 
@@ -865,12 +896,26 @@ int ogg_stream_pagein(ogg_stream_state *os, ogg_page *og){
   return(0);
 }
 
-/* clear things to an initial state.  Good to call, eg, before seeking */
+int ogg_stream_pagein(ogg_stream_state *os, ogg_page *og){
+  return _os_pagein(os,og,0);
+}
+
+/* as ogg_stream_pagein(), but a page that starts with no packet data pending
+   is not copied: packets point into og->body, which the caller keeps valid
+   and unmodified until the next pagein or reset on this stream. */
+int ogg_stream_pagein_inplace(ogg_stream_state *os, ogg_page *og){
+  return _os_pagein(os,og,1);
+}
+
+/* clear things to an initial state.  Good to call, eg, before seeking.
+   In place, the fill mark is the stream position, so it is kept and only
+   the data before it is dropped. */
 int ogg_sync_reset(ogg_sync_state *oy){
   if(ogg_sync_check(oy))return -1;
 
-  oy->fill=0;
-  oy->returned=0;
+  if(!oy->external)
+    oy->fill=0;
+  oy->returned=oy->fill;
   oy->unsynced=0;
   oy->headerbytes=0;
   oy->bodybytes=0;
@@ -880,6 +925,7 @@ int ogg_sync_reset(ogg_sync_state *oy){
 int ogg_stream_reset(ogg_stream_state *os){
   if(ogg_stream_check(os)) return -1;
 
+  os->body_ext=NULL;
   os->body_fill=0;
   os->body_returned=0;
 
@@ -944,7 +990,7 @@ static int _packetout(ogg_stream_state *os,ogg_packet *op,int adv){
     if(op){
       op->e_o_s=eos;
       op->b_o_s=bos;
-      op->packet=os->body_data+os->body_returned;
+      op->packet=(os->body_ext?os->body_ext:os->body_data)+os->body_returned;
       op->packetno=os->packetno;
       op->granulepos=os->granule_vals[ptr];
       op->bytes=bytes;
@@ -55,6 +55,8 @@ typedef struct {
   long    body_storage;          /* storage elements allocated */
   long    body_fill;             /* elements stored; fill mark */
   long    body_returned;         /* elements of fill returned */
+  unsigned char   *body_ext;     /* borrowed page body replacing body_data
+                                    (ogg_stream_pagein_inplace) */
 
 
   int     *lacing_vals;      /* The values that will go to the segment table */
@@ -111,6 +113,9 @@ typedef struct {
   int unsynced;
   int headerbytes;
   int bodybytes;
+
+  int external;   /* data is the caller's buffer (ogg_sync_attach()): it is
+                     parsed in place and never written, moved or freed */
 } ogg_sync_state;
 
 /* Ogg BITSTREAM PRIMITIVES: bitstream ************************/
@@ -166,6 +171,7 @@ extern int      ogg_stream_flush_fill(ogg_stream_state *os, ogg_page *og, int nf
 /* Ogg BITSTREAM PRIMITIVES: decoding **************************/
 
 extern int      ogg_sync_init(ogg_sync_state *oy);
+extern int      ogg_sync_attach(ogg_sync_state *oy, const unsigned char *data, long size);
 extern int      ogg_sync_clear(ogg_sync_state *oy);
 extern int      ogg_sync_reset(ogg_sync_state *oy);
 extern int      ogg_sync_destroy(ogg_sync_state *oy);
@@ -176,6 +182,7 @@ extern int      ogg_sync_wrote(ogg_sync_state *oy, long bytes);
 extern long     ogg_sync_pageseek(ogg_sync_state *oy,ogg_page *og);
 extern int      ogg_sync_pageout(ogg_sync_state *oy, ogg_page *og);
 extern int      ogg_stream_pagein(ogg_stream_state *os, ogg_page *og);
+extern int      ogg_stream_pagein_inplace(ogg_stream_state *os, ogg_page *og);
 extern int      ogg_stream_packetout(ogg_stream_state *os,ogg_packet *op);
 extern int      ogg_stream_packetpeek(ogg_stream_state *os,ogg_packet *op);
 
@@ -46,6 +46,26 @@
  * */
 
 #include "arch.h"
+#include "cpu_support.h"
+
+
+void kf_bfly4_c(kiss_fft_cpx * Fout, const size_t fstride,
+      const kiss_fft_state *st, int m, int N, int mm);
+
+void kf_bfly5_c(kiss_fft_cpx * Fout, const size_t fstride,
+      const kiss_fft_state *st, int m, int N, int mm);
+
+#if defined(FIXED_POINT) && (defined(OPUS_X86_MAY_HAVE_SSE4_1) || defined(OPUS_X86_MAY_HAVE_AVX2))
+#include "x86/kiss_fft_sse.h"
+#endif
+
+#if !defined(OVERRIDE_KF_BFLY)
+#define kf_bfly4(Fout, fstride, st, m, N, mm, arch) \
+   ((void)(arch), kf_bfly4_c(Fout, fstride, st, m, N, mm))
+
+#define kf_bfly5(Fout, fstride, st, m, N, mm, arch) \
+   ((void)(arch), kf_bfly5_c(Fout, fstride, st, m, N, mm))
+#endif
 
 
 #define SAMP_MAX 2147483647
@@ -98,7 +118,11 @@
 #  define KISS_FFT_SIN(phase)  TRIG_UPSCALE*floor(MIN(32767,MAX(-32767,.5+32768 * sin (phase))))*/
 #  define KISS_FFT_COS(phase)  floor(.5+TWID_MAX*cos (phase))
 #  define KISS_FFT_SIN(phase)  floor(.5+TWID_MAX*sin (phase))
+#ifdef FIXED_POINT
 #  define HALF_OF(x) ((x)>>1)
+#else
+#  define HALF_OF(x) ((x)*.5f)
+#endif
 
 
 #define  kf_cexp(x,phase) \
@@ -107,6 +107,23 @@ void quant_all_bands(int encode, const CELTMode *m, int start, int end,
       int32_t balance, ec_ctx *ec, int M, int codedBands, uint32_t *seed,
       int complexity, int arch, int disable_inv);
 
+/** Decoder-only quant_all_bands(): same as quant_all_bands(0, ...), built
+ * without the encoder branches and resynthesis save buffers. */
+void quant_all_bands_dec(const CELTMode *m, int start, int end,
+      celt_norm * X, celt_norm * Y, unsigned char *collapse_masks,
+      const celt_ener *bandE, int *pulses, int shortBlocks, int spread,
+      int dual_stereo, int intensity, int *tf_res, int32_t total_bits,
+      int32_t balance, ec_ctx *ec, int M, int codedBands, uint32_t *seed,
+      int complexity, int arch, int disable_inv);
+
+/** Encoder-only quant_all_bands(): same as quant_all_bands(1, ...) */
+void quant_all_bands_enc(const CELTMode *m, int start, int end,
+      celt_norm * X, celt_norm * Y, unsigned char *collapse_masks,
+      const celt_ener *bandE, int *pulses, int shortBlocks, int spread,
+      int dual_stereo, int intensity, int *tf_res, int32_t total_bits,
+      int32_t balance, ec_ctx *ec, int M, int codedBands, uint32_t *seed,
+      int complexity, int arch, int disable_inv);
+
 void anti_collapse(const CELTMode *m, celt_norm *X_,
       unsigned char *collapse_masks, int LM, int C, int size, int start,
       int end, const opus_val16 *logE, const opus_val16 *prev1logE,
@@ -183,14 +183,87 @@ void comb_filter_const_c(opus_val32 *y, opus_val32 *x, int T, int N,
 #endif
 
 #ifndef OVERRIDE_comb_filter
+#if !defined(OVERRIDE_COMB_FILTER_FADE) || defined(NON_STATIC_COMB_FILTER_FADE_C)
+/* The cross-fade from the old filter (T0, g00..g02) to the new one
+   (T1, g10..g12) over the first overlap samples. */
+#ifndef NON_STATIC_COMB_FILTER_FADE_C
+static
+#endif
+void comb_filter_fade_c(opus_val32 *y, opus_val32 *x, int T0, int T1,
+      opus_val16 g00, opus_val16 g01, opus_val16 g02,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12,
+      const opus_val16 *window, int overlap)
+{
+   int i;
+   opus_val32 x0, x1, x2, x3, x4;
+   x1 = x[-T1+1];
+   x2 = x[-T1  ];
+   x3 = x[-T1-1];
+   x4 = x[-T1-2];
+   if (g00==0 && g01==0 && g02==0)
+   {
+      /* Fading the filter in: the old taps have zero gain and contribute
+         exactly nothing, so only the new ones are evaluated. */
+      for (i=0;i<overlap;i++)
+      {
+         opus_val16 f;
+         x0=x[i-T1+2];
+         f = MULT16_16_Q15(window[i],window[i]);
+         y[i] = x[i]
+                  + MULT16_32_Q15(MULT16_16_Q15(f,g10),x2)
+                  + MULT16_32_Q15(MULT16_16_Q15(f,g11),ADD32(x1,x3))
+                  + MULT16_32_Q15(MULT16_16_Q15(f,g12),ADD32(x0,x4));
+         y[i] = SATURATE(y[i], SIG_SAT);
+         x4=x3;
+         x3=x2;
+         x2=x1;
+         x1=x0;
+      }
+   }
+   else if (g10==0 && g11==0 && g12==0)
+   {
+      /* Fading the filter out: same thing with the new taps. */
+      for (i=0;i<overlap;i++)
+      {
+         opus_val16 f;
+         f = MULT16_16_Q15(window[i],window[i]);
+         y[i] = x[i]
+                  + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g00),x[i-T0])
+                  + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g01),ADD32(x[i-T0+1],x[i-T0-1]))
+                  + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g02),ADD32(x[i-T0+2],x[i-T0-2]));
+         y[i] = SATURATE(y[i], SIG_SAT);
+      }
+   }
+   else
+   {
+      for (i=0;i<overlap;i++)
+      {
+         opus_val16 f;
+         x0=x[i-T1+2];
+         f = MULT16_16_Q15(window[i],window[i]);
+         y[i] = x[i]
+                  + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g00),x[i-T0])
+                  + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g01),ADD32(x[i-T0+1],x[i-T0-1]))
+                  + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g02),ADD32(x[i-T0+2],x[i-T0-2]))
+                  + MULT16_32_Q15(MULT16_16_Q15(f,g10),x2)
+                  + MULT16_32_Q15(MULT16_16_Q15(f,g11),ADD32(x1,x3))
+                  + MULT16_32_Q15(MULT16_16_Q15(f,g12),ADD32(x0,x4));
+         y[i] = SATURATE(y[i], SIG_SAT);
+         x4=x3;
+         x3=x2;
+         x2=x1;
+         x1=x0;
+      }
+   }
+}
+#endif
+
 void comb_filter(opus_val32 *y, opus_val32 *x, int T0, int T1, int N,
       opus_val16 g0, opus_val16 g1, int tapset0, int tapset1,
       const opus_val16 *window, int overlap, int arch)
 {
-   int i;
    /* printf ("%d %d %f %f\n", T0, T1, g0, g1); */
    opus_val16 g00, g01, g02, g10, g11, g12;
-   opus_val32 x0, x1, x2, x3, x4;
    static const opus_val16 gains[3][3] = {
          {QCONST16(0.3066406250f, 15), QCONST16(0.2170410156f, 15), QCONST16(0.1296386719f, 15)},
          {QCONST16(0.4638671875f, 15), QCONST16(0.2680664062f, 15), QCONST16(0.f, 15)},
@@ -213,32 +286,11 @@ void comb_filter(opus_val32 *y, opus_val32 *x, int T0, int T1, int N,
    g10 = MULT16_16_P15(g1, gains[tapset1][0]);
    g11 = MULT16_16_P15(g1, gains[tapset1][1]);
    g12 = MULT16_16_P15(g1, gains[tapset1][2]);
-   x1 = x[-T1+1];
-   x2 = x[-T1  ];
-   x3 = x[-T1-1];
-   x4 = x[-T1-2];
    /* If the filter didn't change, we don't need the overlap */
    if (g0==g1 && T0==T1 && tapset0==tapset1)
       overlap=0;
-   for (i=0;i<overlap;i++)
-   {
-      opus_val16 f;
-      x0=x[i-T1+2];
-      f = MULT16_16_Q15(window[i],window[i]);
-      y[i] = x[i]
-               + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g00),x[i-T0])
-               + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g01),ADD32(x[i-T0+1],x[i-T0-1]))
-               + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g02),ADD32(x[i-T0+2],x[i-T0-2]))
-               + MULT16_32_Q15(MULT16_16_Q15(f,g10),x2)
-               + MULT16_32_Q15(MULT16_16_Q15(f,g11),ADD32(x1,x3))
-               + MULT16_32_Q15(MULT16_16_Q15(f,g12),ADD32(x0,x4));
-      y[i] = SATURATE(y[i], SIG_SAT);
-      x4=x3;
-      x3=x2;
-      x2=x1;
-      x1=x0;
-
-   }
+   if (overlap>0)
+      comb_filter_fade(y, x, T0, T1, g00, g01, g02, g10, g11, g12, window, overlap, arch);
    if (g1==0)
    {
       /* OPT: Happens to work without the OPUS_MOVE(), but only because the current encoder already copies x to y */
@@ -248,7 +300,7 @@ void comb_filter(opus_val32 *y, opus_val32 *x, int T0, int T1, int N,
    }
 
    /* Compute the part with the constant filter. */
-   comb_filter_const(y+i, x+i, T1, N-i, g10, g11, g12, arch);
+   comb_filter_const(y+overlap, x+overlap, T1, N-overlap, g10, g11, g12, arch);
 }
 #endif /* OVERRIDE_comb_filter */
 
@@ -268,11 +320,11 @@ const signed char tf_select_table[4][8] = {
 void init_caps(const CELTMode *m,int *cap,int LM,int C)
 {
    int i;
-   for (i=0;i<m->nbEBands;i++)
+   for (i=0;i<MODE_NBEBANDS(m);i++)
    {
       int N;
-      N=(m->eBands[i+1]-m->eBands[i])<<LM;
-      cap[i] = (m->cache.caps[m->nbEBands*(2*LM+C-1)+i]+64)*C*N>>2;
+      N=(MODE_EBANDS(m)[i+1]-MODE_EBANDS(m)[i])<<LM;
+      cap[i] = (m->cache.caps[MODE_NBEBANDS(m)*(2*LM+C-1)+i]+64)*C*N>>2;
    }
 }
 
@@ -40,6 +40,7 @@
 #include "entenc.h"
 #include "entdec.h"
 #include "arch.h"
+#include "cpu_support.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -130,6 +131,11 @@ typedef struct {
 #define CELT_SET_SILK_INFO_REQUEST    10028
 #define CELT_SET_SILK_INFO(x) CELT_SET_SILK_INFO_REQUEST, __celt_check_silkinfo_ptr(x)
 
+/* Q16 gain applied while writing the final 16-bit output, 0 disables it.
+   Only valid when the CELT output isn't accumulated onto other audio. */
+#define CELT_SET_OUTPUT_GAIN_REQUEST    10030
+#define CELT_SET_OUTPUT_GAIN(x) CELT_SET_OUTPUT_GAIN_REQUEST, __opus_check_int(x)
+
 /* Encoder stuff */
 
 int celt_encoder_get_size(int channels);
@@ -151,6 +157,16 @@ int celt_decoder_init(CELTDecoder *st, int32_t sampling_rate, int channels);
 int celt_decode_with_ec(OpusCustomDecoder * __restrict__ st, const unsigned char *data,
       int len, opus_val16 * __restrict__ pcm, int frame_size, ec_dec *dec, int accum);
 
+/* Same as celt_decode_with_ec(), but writes left-justified 32-bit samples
+   straight from the synthesis precision (no accumulation). */
+int celt_decode_with_ec_s32(OpusCustomDecoder * __restrict__ st, const unsigned char *data,
+      int len, int32_t * __restrict__ pcm, int frame_size, ec_dec *dec);
+
+/* Reads a frame only up to its band energies and returns their log2
+   amplitudes in bandLogE; see celt_decoder.c. */
+int celt_decode_energy(OpusCustomDecoder * __restrict__ st, const unsigned char *data,
+      int len, int frame_size, ec_dec *dec, opus_val16 *bandLogE);
+
 #define celt_encoder_ctl opus_custom_encoder_ctl
 #define celt_decoder_ctl opus_custom_decoder_ctl
 
@@ -224,6 +240,27 @@ void comb_filter(opus_val32 *y, opus_val32 *x, int T0, int T1, int N,
       opus_val16 g0, opus_val16 g1, int tapset0, int tapset1,
       const opus_val16 *window, int overlap, int arch);
 
+/* The SIMD kernels are fixed-point only; the float build relies on the
+   compiler vectorising the C versions. */
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1)
+#include "x86/celt_sse.h"
+#elif defined(FIXED_POINT) && defined(OPUS_ESP32S3_PIE)
+/* ESP32-S3 hook: a PIE (128-bit SIMD) port provides these with the same
+   contract as the _c versions, in-place use and bit-exact output included. */
+#define OVERRIDE_COMB_FILTER_CONST
+void comb_filter_const_pie(opus_val32 *y, opus_val32 *x, int T, int N,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12);
+#define comb_filter_const(y, x, T, N, g10, g11, g12, arch) \
+    ((void)(arch),comb_filter_const_pie(y, x, T, N, g10, g11, g12))
+#define OVERRIDE_COMB_FILTER_FADE
+void comb_filter_fade_pie(opus_val32 *y, opus_val32 *x, int T0, int T1,
+      opus_val16 g00, opus_val16 g01, opus_val16 g02,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12,
+      const opus_val16 *window, int overlap);
+#define comb_filter_fade(y, x, T0, T1, g00, g01, g02, g10, g11, g12, window, overlap, arch) \
+    ((void)(arch),comb_filter_fade_pie(y, x, T0, T1, g00, g01, g02, g10, g11, g12, window, overlap))
+#endif
+
 #ifdef NON_STATIC_COMB_FILTER_CONST_C
 void comb_filter_const_c(opus_val32 *y, opus_val32 *x, int T, int N,
                          opus_val16 g10, opus_val16 g11, opus_val16 g12);
@@ -234,6 +271,18 @@ void comb_filter_const_c(opus_val32 *y, opus_val32 *x, int T, int N,
     ((void)(arch),comb_filter_const_c(y, x, T, N, g10, g11, g12))
 #endif
 
+#ifdef NON_STATIC_COMB_FILTER_FADE_C
+void comb_filter_fade_c(opus_val32 *y, opus_val32 *x, int T0, int T1,
+      opus_val16 g00, opus_val16 g01, opus_val16 g02,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12,
+      const opus_val16 *window, int overlap);
+#endif
+
+#ifndef OVERRIDE_COMB_FILTER_FADE
+# define comb_filter_fade(y, x, T0, T1, g00, g01, g02, g10, g11, g12, window, overlap, arch) \
+    ((void)(arch),comb_filter_fade_c(y, x, T0, T1, g00, g01, g02, g10, g11, g12, window, overlap))
+#endif
+
 void init_caps(const CELTMode *m,int *cap,int LM,int C);
 
 #ifdef RESYNTH
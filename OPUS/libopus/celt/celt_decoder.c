@@ -77,6 +77,7 @@ struct OpusCustomDecoder {
    int signalling;
    int disable_inv;
    int arch;
+   opus_val32 out_gain;
 
    /* Everything beyond this point gets cleared on a reset */
 #define DECODER_RESET_START rng
@@ -101,8 +102,19 @@ struct OpusCustomDecoder {
    /* opus_val16 oldLogE[], Size = 2*mode->nbEBands */
    /* opus_val16 oldLogE2[], Size = 2*mode->nbEBands */
    /* opus_val16 backgroundLogE[], Size = 2*mode->nbEBands */
+   /* PLC scratch, never cleared on a reset:
+      opus_val32 etmp[], Size = mode->overlap
+      opus_val16 exc[], Size = MAX_PERIOD+LPC_ORDER
+      opus_val16 fir_tmp[], Size = MAX_PERIOD (shared with the pitch search) */
 };
 
+/* Size of the pitch-based PLC scratch that lives at the end of the decoder
+   state so that concealing a lost packet never has to allocate. The pitch
+   search buffer (DECODE_BUFFER_SIZE>>1) and fir_tmp are never live at the same
+   time, so they share the last region. */
+#define PLC_SCRATCH_SIZE(overlap) ((overlap)*sizeof(opus_val32) \
+      + (MAX_PERIOD+LPC_ORDER+IMAX(MAX_PERIOD, DECODE_BUFFER_SIZE>>1))*sizeof(opus_val16))
+
 
 int opus_custom_decoder_get_size(const CELTMode *mode, int channels)
 {
@@ -110,7 +122,8 @@ int opus_custom_decoder_get_size(const CELTMode *mode, int channels)
    size = sizeof(struct CELTDecoder)
             + (channels*(DECODE_BUFFER_SIZE+mode->overlap)-1)*sizeof(celt_sig)
             + channels*LPC_ORDER*sizeof(opus_val16)
-            + 4*2*mode->nbEBands*sizeof(opus_val16);
+            + 4*2*mode->nbEBands*sizeof(opus_val16)
+            + PLC_SCRATCH_SIZE(mode->overlap);
    return size;
 }
 
@@ -132,6 +145,12 @@ int opus_custom_decoder_init(CELTDecoder *st, const CELTMode *mode, int channels
    if (st==NULL)
       return OPUS_ALLOC_FAIL;
 
+#ifdef STATIC_MODE_48000_960
+   if (mode->nbEBands != MODE_NBEBANDS(mode) || mode->overlap != MODE_OVERLAP(mode)
+         || mode->shortMdctSize != MODE_SHORTMDCTSIZE(mode) || mode->maxLM != MODE_MAXLM(mode))
+      return OPUS_BAD_ARG;
+#endif
+
    OPUS_CLEAR((char*)st, opus_custom_decoder_get_size(mode, channels));
 
    st->mode = mode;
@@ -195,28 +214,66 @@ static void deemphasis_stereo_simple(celt_sig *in[], opus_val16 *pcm, int N, con
    mem[1] = m1;
 }
 
+/* Saturates to 16 bits and applies the Q16 decoder gain in the same step.
+   Same arithmetic as the separate OPUS_SET_GAIN pass in opus_decode_frame(). */
+#ifdef FIXED_POINT
+#define SIG2WORD16_GAIN(x, gain) \
+   ((opus_val16)SATURATE(MULT16_32_P16(SIG2WORD16(x), gain), 32767))
+#else
+#define SIG2WORD16_GAIN(x, gain) MULT16_32_P16(SCALEOUT(x), gain)
+#endif
+
+static void deemphasis_stereo_gain(celt_sig *in[], opus_val16 *pcm, int N, const opus_val16 coef0,
+      celt_sig *mem, opus_val32 gain)
+{
+   celt_sig * __restrict__ x0;
+   celt_sig * __restrict__ x1;
+   celt_sig m0, m1;
+   int j;
+   x0=in[0];
+   x1=in[1];
+   m0 = mem[0];
+   m1 = mem[1];
+   for (j=0;j<N;j++)
+   {
+      celt_sig tmp0, tmp1;
+      tmp0 = x0[j] + VERY_SMALL + m0;
+      tmp1 = x1[j] + VERY_SMALL + m1;
+      m0 = MULT16_32_Q15(coef0, tmp0);
+      m1 = MULT16_32_Q15(coef0, tmp1);
+      pcm[2*j  ] = SIG2WORD16_GAIN(tmp0, gain);
+      pcm[2*j+1] = SIG2WORD16_GAIN(tmp1, gain);
+   }
+   mem[0] = m0;
+   mem[1] = m1;
+}
 
 
+
+/* Deemphasis, downsampling, saturation and the optional output gain in a
+   single pass that writes the final interleaved samples (stride C) into pcm.
+   With accum the result is added onto what pcm already holds (the SILK
+   output in hybrid mode), in which case gain must be 0. */
 static
 
 void deemphasis(celt_sig *in[], opus_val16 *pcm, int N, int C, int downsample, const opus_val16 *coef,
-      celt_sig *mem, int accum)
+      celt_sig *mem, int accum, opus_val32 gain)
 {
    int c;
    int Nd;
-   int apply_downsampling=0;
    opus_val16 coef0;
-   VARDECL(celt_sig, scratch);
-   SAVE_STACK;
 
+   celt_assert(!(accum && gain));
    /* Short version for common case. */
    if (downsample == 1 && C == 2 && !accum)
    {
-      deemphasis_stereo_simple(in, pcm, N, coef[0], mem);
+      if (gain)
+         deemphasis_stereo_gain(in, pcm, N, coef[0], mem, gain);
+      else
+         deemphasis_stereo_simple(in, pcm, N, coef[0], mem);
       return;
    }
 
-   ALLOC(scratch, N, celt_sig);
    coef0 = coef[0];
    Nd = N/downsample;
    c=0; do {
@@ -229,55 +286,109 @@ void deemphasis(celt_sig *in[], opus_val16 *pcm, int N, int C, int downsample, c
 
       if (downsample>1)
       {
-         /* Shortcut for the standard (non-custom modes) case */
+         /* Only every downsample-th filter output is kept, so write those
+            directly instead of going through a scratch buffer. */
+         for (j=0;j<Nd;j++)
+         {
+            int k;
+            celt_sig tmp = x[j*downsample] + VERY_SMALL + m;
+            m = MULT16_32_Q15(coef0, tmp);
+            if (accum)
+               y[j*C] = SAT16(ADD32(y[j*C], SCALEOUT(SIG2WORD16(tmp))));
+            else if (gain)
+               y[j*C] = SIG2WORD16_GAIN(tmp, gain);
+            else
+               y[j*C] = SCALEOUT(SIG2WORD16(tmp));
+            for (k=1;k<downsample;k++)
+            {
+               tmp = x[j*downsample+k] + VERY_SMALL + m;
+               m = MULT16_32_Q15(coef0, tmp);
+            }
+         }
+         for (j=Nd*downsample;j<N;j++)
+            m = MULT16_32_Q15(coef0, x[j] + VERY_SMALL + m);
+      } else if (accum)
+      {
+         for (j=0;j<N;j++)
+         {
+            celt_sig tmp = x[j] + m + VERY_SMALL;
+            m = MULT16_32_Q15(coef0, tmp);
+            y[j*C] = SAT16(ADD32(y[j*C], SCALEOUT(SIG2WORD16(tmp))));
+         }
+      } else if (gain)
+      {
          for (j=0;j<N;j++)
          {
             celt_sig tmp = x[j] + VERY_SMALL + m;
             m = MULT16_32_Q15(coef0, tmp);
-            scratch[j] = tmp;
+            y[j*C] = SIG2WORD16_GAIN(tmp, gain);
          }
-         apply_downsampling=1;
       } else {
-         /* Shortcut for the standard (non-custom modes) case */
-
-         if (accum)
-         {
-            for (j=0;j<N;j++)
-            {
-               celt_sig tmp = x[j] + m + VERY_SMALL;
-               m = MULT16_32_Q15(coef0, tmp);
-               y[j*C] = SAT16(ADD32(y[j*C], SCALEOUT(SIG2WORD16(tmp))));
-            }
-         } else
-
+         for (j=0;j<N;j++)
          {
-            for (j=0;j<N;j++)
-            {
-               celt_sig tmp = x[j] + VERY_SMALL + m;
-               m = MULT16_32_Q15(coef0, tmp);
-               y[j*C] = SCALEOUT(SIG2WORD16(tmp));
-            }
+            celt_sig tmp = x[j] + VERY_SMALL + m;
+            m = MULT16_32_Q15(coef0, tmp);
+            y[j*C] = SCALEOUT(SIG2WORD16(tmp));
          }
       }
       mem[c] = m;
+   } while (++c<C);
+}
 
-      if (apply_downsampling)
-      {
-         /* Perform down-sampling */
+/* Converts a deemphasised celt_sig to a left-justified 32-bit sample. The Q16
+   gain (0 for unity) is applied at full signal precision before saturating,
+   so a low volume setting does not throw away the low-order bits. */
+#ifdef FIXED_POINT
+static OPUS_INLINE int32_t SIG2INT32_GAIN(celt_sig x, opus_val32 gain)
+{
+   int64_t v = gain ? ((int64_t)x*gain + 32768) >> 16 : x;
+   if (v > ((int64_t)32767<<SIG_SHIFT))
+      v = (int64_t)32767<<SIG_SHIFT;
+   else if (v < -((int64_t)32768<<SIG_SHIFT))
+      v = -((int64_t)32768<<SIG_SHIFT);
+   return (int32_t)((uint32_t)v << (16-SIG_SHIFT));
+}
+#else
+static OPUS_INLINE int32_t SIG2INT32_GAIN(celt_sig x, opus_val32 gain)
+{
+   return FLOAT2INT32(gain ? SCALEOUT(x)*gain : SCALEOUT(x));
+}
+#endif
 
-         if (accum)
-         {
-            for (j=0;j<Nd;j++)
-               y[j*C] = SAT16(ADD32(y[j*C], SCALEOUT(SIG2WORD16(scratch[j*downsample]))));
-         } else
+/* deemphasis() writing 32-bit samples. The filter state is updated exactly as
+   in deemphasis(), so a stream can switch between the two at any frame. */
+static void deemphasis_s32(celt_sig *in[], int32_t *pcm, int N, int C, int downsample,
+      const opus_val16 *coef, celt_sig *mem, opus_val32 gain)
+{
+   int c;
+   int Nd;
+   opus_val16 coef0;
 
+   coef0 = coef[0];
+   Nd = N/downsample;
+   c=0; do {
+      int j;
+      celt_sig * __restrict__ x;
+      int32_t * __restrict__ y;
+      celt_sig m = mem[c];
+      x =in[c];
+      y = pcm+c;
+      for (j=0;j<Nd;j++)
+      {
+         int k;
+         celt_sig tmp = x[j*downsample] + VERY_SMALL + m;
+         m = MULT16_32_Q15(coef0, tmp);
+         y[j*C] = SIG2INT32_GAIN(tmp, gain);
+         for (k=1;k<downsample;k++)
          {
-            for (j=0;j<Nd;j++)
-               y[j*C] = SCALEOUT(SIG2WORD16(scratch[j*downsample]));
+            tmp = x[j*downsample+k] + VERY_SMALL + m;
+            m = MULT16_32_Q15(coef0, tmp);
          }
       }
+      for (j=Nd*downsample;j<N;j++)
+         m = MULT16_32_Q15(coef0, x[j] + VERY_SMALL + m);
+      mem[c] = m;
    } while (++c<C);
-   RESTORE_STACK;
 }
 
 
@@ -299,21 +410,21 @@ void celt_synthesis(const CELTMode *mode, celt_norm *X, celt_sig * out_syn[],
    VARDECL(celt_sig, freq);
    SAVE_STACK;
 
-   overlap = mode->overlap;
-   nbEBands = mode->nbEBands;
-   N = mode->shortMdctSize<<LM;
+   overlap = MODE_OVERLAP(mode);
+   nbEBands = MODE_NBEBANDS(mode);
+   N = MODE_SHORTMDCTSIZE(mode)<<LM;
    ALLOC(freq, N, celt_sig); /**< Interleaved signal MDCTs */
    M = 1<<LM;
 
    if (isTransient)
    {
       B = M;
-      NB = mode->shortMdctSize;
-      shift = mode->maxLM;
+      NB = MODE_SHORTMDCTSIZE(mode);
+      shift = MODE_MAXLM(mode);
    } else {
       B = 1;
-      NB = mode->shortMdctSize<<LM;
-      shift = mode->maxLM-LM;
+      NB = MODE_SHORTMDCTSIZE(mode)<<LM;
+      shift = MODE_MAXLM(mode)-LM;
    }
 
    if (CC==2&&C==1)
@@ -400,20 +511,16 @@ static void tf_decode(int start, int end, int isTransient, int *tf_res, int LM,
    }
 }
 
-static int celt_plc_pitch_search(celt_sig *decode_mem[2], int C, int arch)
+static int celt_plc_pitch_search(celt_sig *decode_mem[2], opus_val16 *lp_pitch_buf,
+      int C, int arch)
 {
    int pitch_index;
-   VARDECL( opus_val16, lp_pitch_buf );
-   SAVE_STACK;
-   opus_val16 *lp_pitch_buf = (opus_val16*)malloc((DECODE_BUFFER_SIZE>>1) * sizeof(opus_val16)); //ALLOC( lp_pitch_buf, DECODE_BUFFER_SIZE>>1, opus_val16 );
    pitch_downsample(decode_mem, lp_pitch_buf,
          DECODE_BUFFER_SIZE, C, arch);
    pitch_search(lp_pitch_buf+(PLC_PITCH_LAG_MAX>>1), lp_pitch_buf,
          DECODE_BUFFER_SIZE-PLC_PITCH_LAG_MAX,
          PLC_PITCH_LAG_MAX-PLC_PITCH_LAG_MIN, &pitch_index, arch);
    pitch_index = PLC_PITCH_LAG_MAX-pitch_index;
-   RESTORE_STACK;
-   free(lp_pitch_buf);
    return pitch_index;
 }
 
@@ -436,9 +543,9 @@ static void celt_decode_lost(CELTDecoder * __restrict__ st, int N, int LM)
    SAVE_STACK;
 
    mode = st->mode;
-   nbEBands = mode->nbEBands;
-   overlap = mode->overlap;
-   eBands = mode->eBands;
+   nbEBands = MODE_NBEBANDS(mode);
+   overlap = MODE_OVERLAP(mode);
+   eBands = MODE_EBANDS(mode);
 
    c=0; do {
       decode_mem[c] = st->_decode_mem + c*(DECODE_BUFFER_SIZE+overlap);
@@ -464,7 +571,7 @@ static void celt_decode_lost(CELTDecoder * __restrict__ st, int N, int LM)
       int effEnd;
       opus_val16 decay;
       end = st->end;
-      effEnd = IMAX(start, IMIN(end, mode->effEBands));
+      effEnd = IMAX(start, IMIN(end, MODE_EFFEBANDS(mode)));
 
 
       ALLOC(X, C*N, celt_norm);   /**< Interleaved normalised MDCTs */
@@ -510,13 +617,17 @@ static void celt_decode_lost(CELTDecoder * __restrict__ st, int N, int LM)
       opus_val16 *exc;
       opus_val16 fade = Q15ONE;
       int pitch_index;
-      VARDECL(opus_val32, etmp);
-      VARDECL(opus_val16, _exc);
-      VARDECL(opus_val16, fir_tmp);
+      opus_val32 *etmp;
+      opus_val16 *_exc;
+      opus_val16 *fir_tmp;
+
+      etmp = (opus_val32*)(backgroundLogE + 2*nbEBands);
+      _exc = (opus_val16*)(etmp + overlap);
+      fir_tmp = _exc + MAX_PERIOD+LPC_ORDER;
 
       if (loss_count == 0)
       {
-         st->last_pitch_index = pitch_index = celt_plc_pitch_search(decode_mem, C, st->arch);
+         st->last_pitch_index = pitch_index = celt_plc_pitch_search(decode_mem, fir_tmp, C, st->arch);
       } else {
          pitch_index = st->last_pitch_index;
          fade = QCONST16(.8f,15);
@@ -526,9 +637,6 @@ static void celt_decode_lost(CELTDecoder * __restrict__ st, int N, int LM)
          decaying signal, but we can't get more than MAX_PERIOD. */
       exc_length = IMIN(2*pitch_index, MAX_PERIOD);
 
-      ALLOC(etmp, overlap, opus_val32);
-      ALLOC(_exc, MAX_PERIOD+LPC_ORDER, opus_val16);
-      ALLOC(fir_tmp, exc_length, opus_val16);
       exc = _exc+LPC_ORDER;
       window = mode->window;
       c=0; do {
@@ -552,19 +660,23 @@ static void celt_decode_lost(CELTDecoder * __restrict__ st, int N, int LM)
             _celt_autocorr(exc, ac, window, overlap,
                    LPC_ORDER, MAX_PERIOD, st->arch);
             /* Add a noise floor of -40 dB. */
-
+#ifdef FIXED_POINT
             ac[0] += SHR32(ac[0],13);
-
+#else
+            ac[0] *= 1.0001f;
+#endif
             /* Use lag windowing to stabilize the Levinson-Durbin recursion. */
             for (i=1;i<=LPC_ORDER;i++)
             {
                /*ac[i] *= exp(-.5*(2*M_PI*.002*i)*(2*M_PI*.002*i));*/
-
+#ifdef FIXED_POINT
                ac[i] -= MULT16_32_Q15(2*i*i, ac[i]);
-
+#else
+               ac[i] -= ac[i]*(0.008f*0.008f)*i*i;
+#endif
             }
             _celt_lpc(lpc+c*LPC_ORDER, ac, LPC_ORDER);
-
+#ifdef FIXED_POINT
          /* For fixed-point, apply bandwidth expansion until we can guarantee that
             no overflow can happen in the IIR filter. This means:
             32768*sum(abs(filter)) < 2^31 */
@@ -580,7 +692,7 @@ static void celt_decode_lost(CELTDecoder * __restrict__ st, int N, int LM)
                lpc[c*LPC_ORDER+i] = MULT16_16_Q15(lpc[c*LPC_ORDER+i], tmp);
             }
          }
-
+#endif
          }
          /* Initialize the LPC history with the samples just before the start
             of the region for which we're computing the excitation. */
@@ -598,9 +710,9 @@ static void celt_decode_lost(CELTDecoder * __restrict__ st, int N, int LM)
          {
             opus_val32 E1=1, E2=1;
             int decay_length;
-
+#ifdef FIXED_POINT
             int shift = IMAX(0,2*celt_zlog2(celt_maxabs16(&exc[MAX_PERIOD-exc_length], exc_length))-20);
-
+#endif
             decay_length = exc_length>>1;
             for (i=0;i<decay_length;i++)
             {
@@ -673,9 +785,13 @@ static void celt_decode_lost(CELTDecoder * __restrict__ st, int N, int LM)
                S2 += SHR32(MULT16_16(tmp, tmp), 10);
             }
             /* This checks for an "explosion" in the synthesis. */
-
+#ifdef FIXED_POINT
             if (!(S1 > SHR32(S2,2)))
-
+#else
+            /* The float test is written this way to catch NaNs in the output
+               of the IIR filter at the same time. */
+            if (!(S1 > 0.2f*S2))
+#endif
             {
                for (i=0;i<extrapolation_len;i++)
                   buf[DECODE_BUFFER_SIZE-N+i] = 0;
@@ -721,8 +837,10 @@ static void celt_decode_lost(CELTDecoder * __restrict__ st, int N, int LM)
    RESTORE_STACK;
 }
 
-int celt_decode_with_ec(CELTDecoder * __restrict__ st, const unsigned char *data,
-      int len, opus_val16 * __restrict__ pcm, int frame_size, ec_dec *dec, int accum)
+/* Exactly one of pcm and pcm32 is non-NULL; pcm32 selects 32-bit output. */
+static int celt_decode_impl(CELTDecoder * __restrict__ st, const unsigned char *data,
+      int len, opus_val16 * __restrict__ pcm, int32_t * __restrict__ pcm32, int frame_size,
+      ec_dec *dec, int accum)
 {
    int c, i, N;
    int spread_decision;
@@ -774,9 +892,9 @@ int celt_decode_with_ec(CELTDecoder * __restrict__ st, const unsigned char *data
 
    VALIDATE_CELT_DECODER(st);
    mode = st->mode;
-   nbEBands = mode->nbEBands;
-   overlap = mode->overlap;
-   eBands = mode->eBands;
+   nbEBands = MODE_NBEBANDS(mode);
+   overlap = MODE_OVERLAP(mode);
+   eBands = MODE_EBANDS(mode);
    start = st->start;
    end = st->end;
    frame_size *= st->downsample;
@@ -790,31 +908,34 @@ int celt_decode_with_ec(CELTDecoder * __restrict__ st, const unsigned char *data
 
    {
 
-      for (LM=0;LM<=mode->maxLM;LM++)
-         if (mode->shortMdctSize<<LM==frame_size)
+      for (LM=0;LM<=MODE_MAXLM(mode);LM++)
+         if (MODE_SHORTMDCTSIZE(mode)<<LM==frame_size)
             break;
-      if (LM>mode->maxLM)
+      if (LM>MODE_MAXLM(mode))
          return OPUS_BAD_ARG;
    }
    M=1<<LM;
 
-   if (len<0 || len>1275 || pcm==NULL)
+   if (len<0 || len>1275 || (pcm==NULL && pcm32==NULL))
       return OPUS_BAD_ARG;
 
-   N = M*mode->shortMdctSize;
+   N = M*MODE_SHORTMDCTSIZE(mode);
    c=0; do {
       decode_mem[c] = st->_decode_mem + c*(DECODE_BUFFER_SIZE+overlap);
       out_syn[c] = decode_mem[c]+DECODE_BUFFER_SIZE-N;
    } while (++c<CC);
 
    effEnd = end;
-   if (effEnd > mode->effEBands)
-      effEnd = mode->effEBands;
+   if (effEnd > MODE_EFFEBANDS(mode))
+      effEnd = MODE_EFFEBANDS(mode);
 
    if (data == NULL || len<=1)
    {
       celt_decode_lost(st, N, LM);
-      deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum);
+      if (pcm32)
+         deemphasis_s32(out_syn, pcm32, N, CC, st->downsample, mode->preemph, st->preemph_memD, st->out_gain);
+      else
+         deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum, st->out_gain);
       RESTORE_STACK;
       return frame_size/st->downsample;
    }
@@ -961,7 +1082,7 @@ int celt_decode_with_ec(CELTDecoder * __restrict__ st, const unsigned char *data
    ALLOC(X, C*N, celt_norm);   /**< Interleaved normalised MDCTs */
 
 
-   quant_all_bands(0, mode, start, end, X, C==2 ? X+N : NULL, collapse_masks,
+   quant_all_bands_dec(mode, start, end, X, C==2 ? X+N : NULL, collapse_masks,
          NULL, pulses, shortBlocks, spread_decision, dual_stereo, intensity, tf_res,
          len*(8<<BITRES)-anti_collapse_rsv, balance, dec, LM, codedBands, &st->rng, 0,
          st->arch, st->disable_inv);
@@ -990,11 +1111,11 @@ int celt_decode_with_ec(CELTDecoder * __restrict__ st, const unsigned char *data
    c=0; do {
       st->postfilter_period=IMAX(st->postfilter_period, COMBFILTER_MINPERIOD);
       st->postfilter_period_old=IMAX(st->postfilter_period_old, COMBFILTER_MINPERIOD);
-      comb_filter(out_syn[c], out_syn[c], st->postfilter_period_old, st->postfilter_period, mode->shortMdctSize,
+      comb_filter(out_syn[c], out_syn[c], st->postfilter_period_old, st->postfilter_period, MODE_SHORTMDCTSIZE(mode),
             st->postfilter_gain_old, st->postfilter_gain, st->postfilter_tapset_old, st->postfilter_tapset,
             mode->window, overlap, st->arch);
       if (LM!=0)
-         comb_filter(out_syn[c]+mode->shortMdctSize, out_syn[c]+mode->shortMdctSize, st->postfilter_period, postfilter_pitch, N-mode->shortMdctSize,
+         comb_filter(out_syn[c]+MODE_SHORTMDCTSIZE(mode), out_syn[c]+MODE_SHORTMDCTSIZE(mode), st->postfilter_period, postfilter_pitch, N-MODE_SHORTMDCTSIZE(mode),
                st->postfilter_gain, postfilter_gain, st->postfilter_tapset, postfilter_tapset,
                mode->window, overlap, st->arch);
 
@@ -1049,7 +1170,10 @@ int celt_decode_with_ec(CELTDecoder * __restrict__ st, const unsigned char *data
    } while (++c<2);
    st->rng = dec->rng;
 
-   deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum);
+   if (pcm32)
+      deemphasis_s32(out_syn, pcm32, N, CC, st->downsample, mode->preemph, st->preemph_memD, st->out_gain);
+   else
+      deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum, st->out_gain);
    st->loss_count = 0;
    RESTORE_STACK;
    if (ec_tell(dec) > 8*len)
@@ -1059,6 +1183,221 @@ int celt_decode_with_ec(CELTDecoder * __restrict__ st, const unsigned char *data
    return frame_size/st->downsample;
 }
 
+/* Decodes a frame only as far as its band energies, for level scans: the
+   header flags, the coarse and fine energies and everything the bit
+   allocation needs are read as in celt_decode_impl(), but the PVQ layer,
+   the synthesis and the postfilter are skipped. Without the PVQ layer the
+   leftover bits that refine the energies cannot be found, so bandLogE and
+   the energy prediction state are only as exact as the fine quantization.
+   bandLogE gets the log2 amplitude of each band (eMeans included) for the
+   st->stream_channels coded channels. The overlap and PLC memories are not
+   updated, so the decoder must be reset before it decodes audio again. */
+int celt_decode_energy(CELTDecoder * __restrict__ st, const unsigned char *data,
+      int len, int frame_size, ec_dec *dec, opus_val16 *bandLogE)
+{
+   int c, i;
+   int32_t bits;
+   ec_dec _dec;
+   VARDECL(int, fine_quant);
+   VARDECL(int, pulses);
+   VARDECL(int, cap);
+   VARDECL(int, offsets);
+   VARDECL(int, fine_priority);
+   VARDECL(int, tf_res);
+   opus_val16 *oldBandE;
+   int isTransient;
+   int intra_ener;
+   const int CC = st->channels;
+   int LM;
+   int start;
+   int end;
+   int alloc_trim;
+   int intensity=0;
+   int dual_stereo=0;
+   int32_t total_bits;
+   int32_t balance;
+   int32_t tell;
+   int dynalloc_logp;
+   int anti_collapse_rsv;
+   int silence;
+   int C = st->stream_channels;
+   const OpusCustomMode *mode;
+   int nbEBands;
+   const int16_t *eBands;
+   ALLOC_STACK;
+
+   VALIDATE_CELT_DECODER(st);
+   mode = st->mode;
+   nbEBands = MODE_NBEBANDS(mode);
+   eBands = MODE_EBANDS(mode);
+   start = st->start;
+   end = st->end;
+   frame_size *= st->downsample;
+
+   oldBandE = (opus_val16*)(st->_decode_mem+(DECODE_BUFFER_SIZE+MODE_OVERLAP(mode))*CC)+CC*LPC_ORDER;
+
+   for (LM=0;LM<=MODE_MAXLM(mode);LM++)
+      if (MODE_SHORTMDCTSIZE(mode)<<LM==frame_size)
+         break;
+   if (LM>MODE_MAXLM(mode))
+      return OPUS_BAD_ARG;
+
+   if (data == NULL || len<=1 || len>1275)
+      return OPUS_BAD_ARG;
+
+   if (dec == NULL)
+   {
+      ec_dec_init(&_dec,(unsigned char*)data,len);
+      dec = &_dec;
+   }
+
+   if (C==1)
+   {
+      for (i=0;i<nbEBands;i++)
+         oldBandE[i]=MAX16(oldBandE[i],oldBandE[nbEBands+i]);
+   }
+
+   total_bits = len*8;
+   tell = ec_tell(dec);
+
+   if (tell >= total_bits)
+      silence = 1;
+   else if (tell==1)
+      silence = ec_dec_bit_logp(dec, 15);
+   else
+      silence = 0;
+   if (silence)
+   {
+      tell = len*8;
+      dec->nbits_total+=tell-ec_tell(dec);
+   }
+
+   /* The postfilter parameters still have to be read to get past them */
+   if (start==0 && tell+16 <= total_bits)
+   {
+      if(ec_dec_bit_logp(dec, 1))
+      {
+         int octave;
+         octave = ec_dec_uint(dec, 6);
+         ec_dec_bits(dec, 4+octave);
+         ec_dec_bits(dec, 3);
+         if (ec_tell(dec)+2<=total_bits)
+            ec_dec_icdf(dec, tapset_icdf, 2);
+      }
+      tell = ec_tell(dec);
+   }
+
+   if (LM > 0 && tell+3 <= total_bits)
+   {
+      isTransient = ec_dec_bit_logp(dec, 3);
+      tell = ec_tell(dec);
+   }
+   else
+      isTransient = 0;
+
+   intra_ener = tell+3<=total_bits ? ec_dec_bit_logp(dec, 3) : 0;
+   unquant_coarse_energy(mode, start, end, oldBandE,
+         intra_ener, dec, C, LM);
+
+   ALLOC(tf_res, nbEBands, int);
+   tf_decode(start, end, isTransient, tf_res, LM, dec);
+
+   tell = ec_tell(dec);
+   if (tell+4 <= total_bits)
+      ec_dec_icdf(dec, spread_icdf, 5);
+
+   ALLOC(cap, nbEBands, int);
+   init_caps(mode,cap,LM,C);
+
+   ALLOC(offsets, nbEBands, int);
+   dynalloc_logp = 6;
+   total_bits<<=BITRES;
+   tell = ec_tell_frac(dec);
+   for (i=start;i<end;i++)
+   {
+      int width, quanta;
+      int dynalloc_loop_logp;
+      int boost;
+      width = C*(eBands[i+1]-eBands[i])<<LM;
+      quanta = IMIN(width<<BITRES, IMAX(6<<BITRES, width));
+      dynalloc_loop_logp = dynalloc_logp;
+      boost = 0;
+      while (tell+(dynalloc_loop_logp<<BITRES) < total_bits && boost < cap[i])
+      {
+         int flag;
+         flag = ec_dec_bit_logp(dec, dynalloc_loop_logp);
+         tell = ec_tell_frac(dec);
+         if (!flag)
+            break;
+         boost += quanta;
+         total_bits -= quanta;
+         dynalloc_loop_logp = 1;
+      }
+      offsets[i] = boost;
+      if (boost>0)
+         dynalloc_logp = IMAX(2, dynalloc_logp-1);
+   }
+
+   ALLOC(fine_quant, nbEBands, int);
+   alloc_trim = tell+(6<<BITRES) <= total_bits ?
+         ec_dec_icdf(dec, trim_icdf, 7) : 5;
+
+   bits = (((int32_t)len*8)<<BITRES) - ec_tell_frac(dec) - 1;
+   anti_collapse_rsv = isTransient&&LM>=2&&bits>=((LM+2)<<BITRES) ? (1<<BITRES) : 0;
+   bits -= anti_collapse_rsv;
+
+   ALLOC(pulses, nbEBands, int);
+   ALLOC(fine_priority, nbEBands, int);
+
+   clt_compute_allocation(mode, start, end, offsets, cap,
+         alloc_trim, &intensity, &dual_stereo, bits, &balance, pulses,
+         fine_quant, fine_priority, C, LM, dec, 0, 0, 0);
+
+   unquant_fine_energy(mode, start, end, oldBandE, fine_quant, dec, C);
+
+   if (silence)
+   {
+      for (i=0;i<C*nbEBands;i++)
+         oldBandE[i] = -QCONST16(28.f,DB_SHIFT);
+   }
+   c=0; do {
+      for (i=0;i<nbEBands;i++)
+      {
+         if (i<start || i>=end)
+            bandLogE[c*nbEBands+i] = -QCONST16(28.f,DB_SHIFT);
+         else
+            bandLogE[c*nbEBands+i] = SATURATE16(ADD32(oldBandE[c*nbEBands+i], SHL32((opus_val32)eMeans[i],6)));
+      }
+   } while (++c<C);
+
+   if (C==1)
+      OPUS_COPY(&oldBandE[nbEBands], oldBandE, nbEBands);
+   c=0; do
+   {
+      for (i=0;i<start;i++)
+         oldBandE[c*nbEBands+i]=0;
+      for (i=end;i<nbEBands;i++)
+         oldBandE[c*nbEBands+i]=0;
+   } while (++c<2);
+   st->loss_count = 0;
+   RESTORE_STACK;
+   if (ec_tell(dec) > 8*len)
+      return OPUS_INTERNAL_ERROR;
+   return frame_size/st->downsample;
+}
+
+int celt_decode_with_ec(CELTDecoder * __restrict__ st, const unsigned char *data,
+      int len, opus_val16 * __restrict__ pcm, int frame_size, ec_dec *dec, int accum)
+{
+   return celt_decode_impl(st, data, len, pcm, NULL, frame_size, dec, accum);
+}
+
+int celt_decode_with_ec_s32(CELTDecoder * __restrict__ st, const unsigned char *data,
+      int len, int32_t * __restrict__ pcm, int frame_size, ec_dec *dec)
+{
+   return celt_decode_impl(st, data, len, NULL, pcm, frame_size, dec, 0);
+}
+
 
 
 int opus_custom_decoder_ctl(CELTDecoder * __restrict__ st, int request, ...)
@@ -1071,7 +1410,7 @@ int opus_custom_decoder_ctl(CELTDecoder * __restrict__ st, int request, ...)
       case CELT_SET_START_BAND_REQUEST:
       {
          int32_t value = va_arg(ap, int32_t);
-         if (value<0 || value>=st->mode->nbEBands)
+         if (value<0 || value>=MODE_NBEBANDS(st->mode))
             goto bad_arg;
          st->start = value;
       }
@@ -1079,7 +1418,7 @@ int opus_custom_decoder_ctl(CELTDecoder * __restrict__ st, int request, ...)
       case CELT_SET_END_BAND_REQUEST:
       {
          int32_t value = va_arg(ap, int32_t);
-         if (value<1 || value>st->mode->nbEBands)
+         if (value<1 || value>MODE_NBEBANDS(st->mode))
             goto bad_arg;
          st->end = value;
       }
@@ -1092,6 +1431,18 @@ int opus_custom_decoder_ctl(CELTDecoder * __restrict__ st, int request, ...)
          st->stream_channels = value;
       }
       break;
+      case CELT_SET_OUTPUT_GAIN_REQUEST:
+      {
+         int32_t value = va_arg(ap, int32_t);
+         if (value<0)
+            goto bad_arg;
+#ifdef FIXED_POINT
+         st->out_gain = value;
+#else
+         st->out_gain = value*(1.f/65536);
+#endif
+      }
+      break;
       case CELT_GET_AND_CLEAR_ERROR_REQUEST:
       {
          int32_t *value = va_arg(ap, int32_t*);
@@ -1115,12 +1466,13 @@ int opus_custom_decoder_ctl(CELTDecoder * __restrict__ st, int request, ...)
          opus_val16 *lpc, *oldBandE, *oldLogE, *oldLogE2;
          lpc = (opus_val16*)(st->_decode_mem+(DECODE_BUFFER_SIZE+st->overlap)*st->channels);
          oldBandE = lpc+st->channels*LPC_ORDER;
-         oldLogE = oldBandE + 2*st->mode->nbEBands;
-         oldLogE2 = oldLogE + 2*st->mode->nbEBands;
+         oldLogE = oldBandE + 2*MODE_NBEBANDS(st->mode);
+         oldLogE2 = oldLogE + 2*MODE_NBEBANDS(st->mode);
          OPUS_CLEAR((char*)&st->DECODER_RESET_START,
                opus_custom_decoder_get_size(st->mode, st->channels)-
+               PLC_SCRATCH_SIZE(st->overlap)-
                ((char*)&st->DECODER_RESET_START - (char*)st));
-         for (i=0;i<2*st->mode->nbEBands;i++)
+         for (i=0;i<2*MODE_NBEBANDS(st->mode);i++)
             oldLogE[i]=oldLogE2[i]=-QCONST16(28.f,DB_SHIFT);
          st->skip_plc = 1;
       }
@@ -27,6 +27,10 @@
    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+/* The float configuration only decodes; the encoder keeps its fixed-point
+   arithmetic and is left out of it, like the SILK encoder in silk/fixed. */
+#if !defined(OPUS_FLOAT_BUILD)
+
 #define CELT_ENCODER_C
 
 #include "cpu_support.h"
@@ -2294,3 +2298,5 @@ bad_request:
    va_end(ap);
    return OPUS_UNIMPLEMENTED;
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -40,7 +40,11 @@ int          p
    int i, j;
    opus_val32 r;
    opus_val32 error = ac[0];
+#ifdef FIXED_POINT
    opus_val32 lpc[LPC_ORDER];
+#else
+   float *lpc = _lpc;
+#endif
    OPUS_CLEAR(lpc, p);
    if (ac[0] != 0)
    {
@@ -64,12 +68,19 @@ int          p
 
          error = error - MULT32_32_Q31(MULT32_32_Q31(r,r),error);
          /* Bail out once we get 30 dB gain */
+#ifdef FIXED_POINT
          if (error<SHR32(ac[0],10))
             break;
+#else
+         if (error<.001f*ac[0])
+            break;
+#endif
       }
    }
+#ifdef FIXED_POINT
    for (i=0;i<p;i++)
       _lpc[i] = ROUND16(lpc[i],16);
+#endif
 }
 
 
@@ -226,6 +237,7 @@ int _celt_autocorr(
       xptr = xx;
    }
    shift=0;
+#ifdef FIXED_POINT
    {
       opus_val32 ac0;
       ac0 = 1+(n<<7);
@@ -246,6 +258,7 @@ int _celt_autocorr(
       } else
          shift = 0;
    }
+#endif
    celt_pitch_xcorr(xptr, xptr, ac, fastN, lag+1, arch);
    for (k=0;k<=lag;k++)
    {
@@ -253,6 +266,7 @@ int _celt_autocorr(
          d = MAC16_16(d, xptr[i], xptr[i-k]);
       ac[k] += d;
    }
+#ifdef FIXED_POINT
    shift = 2*shift;
    if (shift<=0)
       ac[0] += SHL32((int32_t)1, -shift);
@@ -271,6 +285,7 @@ int _celt_autocorr(
          ac[i] = SHR32(ac[i], shift2);
       shift += shift2;
    }
+#endif
 
    RESTORE_STACK;
    return shift;
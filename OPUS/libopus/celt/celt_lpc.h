@@ -31,7 +31,7 @@
 #include "arch.h"
 #include "cpu_support.h"
 
-#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1)
 #include "x86/celt_lpc_sse.h"
 #endif
 
@@ -45,7 +45,7 @@
 #elif (defined(OPUS_X86_MAY_HAVE_SSE) && !defined(OPUS_X86_PRESUME_SSE)) || \
   (defined(OPUS_X86_MAY_HAVE_SSE2) && !defined(OPUS_X86_PRESUME_SSE2)) || \
   (defined(OPUS_X86_MAY_HAVE_SSE4_1) && !defined(OPUS_X86_PRESUME_SSE4_1)) || \
-  (defined(OPUS_X86_MAY_HAVE_AVX) && !defined(OPUS_X86_PRESUME_AVX))
+  (defined(OPUS_X86_MAY_HAVE_AVX2) && !defined(OPUS_X86_PRESUME_AVX2))
 
 #include "x86/x86cpu.h"
 /* We currently support 5 x86 variants:
@@ -53,7 +53,7 @@
  * arch[1] -> sse
  * arch[2] -> sse2
  * arch[3] -> sse4.1
- * arch[4] -> avx
+ * arch[4] -> avx2
  */
 #define OPUS_ARCHMASK 7
 int opus_select_arch(void);
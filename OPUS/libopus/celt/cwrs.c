@@ -457,64 +457,69 @@ void encode_pulses(const int *_y,int _n,int _k,ec_enc *_enc){
   ec_enc_uint(_enc,icwrs(_n,_y),CELT_PVQ_V(_n,_k));
 }
 
-static opus_val32 cwrsi(int _n,int _k,uint32_t _i,int *_y){
+/*Decodes the pulse count and sign of the first of _n dimensions, removing
+   its contribution from *_k and *_i.
+  With a constant _n (see cwrsi4() and cwrsi8()) the row pointer and the
+   choice between the two cases below are resolved at compile time.*/
+static OPUS_INLINE int cwrsi_dim(int _n,int *_k,uint32_t *_i){
   uint32_t p;
+  uint32_t q;
   int         s;
   int         k0;
-  int16_t  val;
-  opus_val32  yy=0;
-  celt_assert(_k>0);
-  celt_assert(_n>1);
-  while(_n>2){
-    uint32_t q;
-    /*Lots of pulses case:*/
-    if(_k>=_n){
-      const uint32_t *row;
-      row=CELT_PVQ_U_ROW[_n];
-      /*Are the pulses in this dimension negative?*/
-      p=row[_k+1];
-      s=-(_i>=p);
-      _i-=p&s;
-      /*Count how many pulses were placed in this dimension.*/
-      k0=_k;
-      q=row[_n];
-      if(q>_i){
-        celt_sig_assert(p>q);
-        _k=_n;
-        do p=CELT_PVQ_U_ROW[--_k][_n];
-        while(p>_i);
-      }
-      else for(p=row[_k];p>_i;p=row[_k])_k--;
-      _i-=p;
-      val=(k0-_k+s)^s;
-      *_y++=val;
-      yy=MAC16_16(yy,val,val);
+  int         k;
+  uint32_t i;
+  k=*_k;
+  i=*_i;
+  /*Lots of pulses case:*/
+  if(k>=_n){
+    const uint32_t *row;
+    row=CELT_PVQ_U_ROW[_n];
+    /*Are the pulses in this dimension negative?*/
+    p=row[k+1];
+    s=-(i>=p);
+    i-=p&s;
+    /*Count how many pulses were placed in this dimension.*/
+    k0=k;
+    q=row[_n];
+    if(q>i){
+      celt_sig_assert(p>q);
+      k=_n;
+      do p=CELT_PVQ_U_ROW[--k][_n];
+      while(p>i);
     }
-    /*Lots of dimensions case:*/
-    else{
-      /*Are there any pulses in this dimension at all?*/
-      p=CELT_PVQ_U_ROW[_k][_n];
-      q=CELT_PVQ_U_ROW[_k+1][_n];
-      if(p<=_i&&_i<q){
-        _i-=p;
-        *_y++=0;
-      }
-      else{
-        /*Are the pulses in this dimension negative?*/
-        s=-(_i>=q);
-        _i-=q&s;
-        /*Count how many pulses were placed in this dimension.*/
-        k0=_k;
-        do p=CELT_PVQ_U_ROW[--_k][_n];
-        while(p>_i);
-        _i-=p;
-        val=(k0-_k+s)^s;
-        *_y++=val;
-        yy=MAC16_16(yy,val,val);
-      }
+    else for(p=row[k];p>i;p=row[k])k--;
+    i-=p;
+  }
+  /*Lots of dimensions case:*/
+  else{
+    /*Are there any pulses in this dimension at all?*/
+    p=CELT_PVQ_U_ROW[k][_n];
+    q=CELT_PVQ_U_ROW[k+1][_n];
+    if(p<=i&&i<q){
+      *_i=i-p;
+      return 0;
     }
-    _n--;
+    /*Are the pulses in this dimension negative?*/
+    s=-(i>=q);
+    i-=q&s;
+    /*Count how many pulses were placed in this dimension.*/
+    k0=k;
+    do p=CELT_PVQ_U_ROW[--k][_n];
+    while(p>i);
+    i-=p;
   }
+  *_k=k;
+  *_i=i;
+  return (k0-k+s)^s;
+}
+
+/*The last two dimensions, which have a closed form.*/
+static OPUS_INLINE opus_val32 cwrsi2(int _k,uint32_t _i,int *_y){
+  uint32_t p;
+  int         s;
+  int         k0;
+  int16_t  val;
+  opus_val32  yy;
   /*_n==2*/
   p=2*_k+1;
   s=-(_i>=p);
@@ -523,16 +528,67 @@ static opus_val32 cwrsi(int _n,int _k,uint32_t _i,int *_y){
   _k=(_i+1)>>1;
   if(_k)_i-=2*_k-1;
   val=(k0-_k+s)^s;
-  *_y++=val;
-  yy=MAC16_16(yy,val,val);
+  _y[0]=val;
+  yy=MULT16_16(val,val);
   /*_n==1*/
   s=-(int)_i;
   val=(_k+s)^s;
-  *_y=val;
+  _y[1]=val;
   yy=MAC16_16(yy,val,val);
   return yy;
 }
 
+/*Once all the pulses are placed the index is 0 and the rest of the vector
+   is zero, so stop walking the table.*/
+#define CWRSI_DIM(_n,_k,_i,_y,_yy) \
+  do{ \
+    int16_t val_; \
+    if(!(_k)){ \
+      OPUS_CLEAR(_y,_n); \
+      return _yy; \
+    } \
+    val_=cwrsi_dim(_n,&(_k),&(_i)); \
+    *(_y)++=val_; \
+    _yy=MAC16_16(_yy,val_,val_); \
+  } \
+  while(0)
+
+/*Fully unrolled versions for N=4 and N=8, which between them make up about
+   half of the PVQ vectors in 64-128 kb/s music.*/
+static opus_val32 cwrsi4(int _k,uint32_t _i,int *_y){
+  opus_val32 yy=0;
+  CWRSI_DIM(4,_k,_i,_y,yy);
+  CWRSI_DIM(3,_k,_i,_y,yy);
+  return ADD32(yy,cwrsi2(_k,_i,_y));
+}
+
+static opus_val32 cwrsi8(int _k,uint32_t _i,int *_y){
+  opus_val32 yy=0;
+  CWRSI_DIM(8,_k,_i,_y,yy);
+  CWRSI_DIM(7,_k,_i,_y,yy);
+  CWRSI_DIM(6,_k,_i,_y,yy);
+  CWRSI_DIM(5,_k,_i,_y,yy);
+  CWRSI_DIM(4,_k,_i,_y,yy);
+  CWRSI_DIM(3,_k,_i,_y,yy);
+  return ADD32(yy,cwrsi2(_k,_i,_y));
+}
+
+static opus_val32 cwrsi(int _n,int _k,uint32_t _i,int *_y){
+  opus_val32  yy=0;
+  celt_assert(_k>0);
+  celt_assert(_n>1);
+  switch(_n){
+    case 2:return cwrsi2(_k,_i,_y);
+    case 4:return cwrsi4(_k,_i,_y);
+    case 8:return cwrsi8(_k,_i,_y);
+  }
+  while(_n>2){
+    CWRSI_DIM(_n,_k,_i,_y,yy);
+    _n--;
+  }
+  return ADD32(yy,cwrsi2(_k,_i,_y));
+}
+
 opus_val32 decode_pulses(int *_y,int _n,int _k,ec_dec *_dec){
   return cwrsi(_n,_k,ec_dec_uint(_dec,CELT_PVQ_V(_n,_k)),_y);
 }
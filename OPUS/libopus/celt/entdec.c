@@ -175,16 +175,30 @@ int ec_dec_icdf(ec_dec *_this,const unsigned char *_icdf,unsigned _ftb){
   uint32_t d;
   uint32_t s;
   uint32_t t;
+  uint32_t u;
   int         ret;
   s=_this->rng;
   d=_this->val;
   r=s>>_ftb;
-  ret=-1;
-  do{
-    t=s;
-    s=IMUL32(r,_icdf[++ret]);
+  /*Every table has at least two entries (the last one is 0), and most
+     symbols are 0 or 1, so decide between those two without a branch and
+     only fall back to the linear search for the tail.*/
+  t=IMUL32(r,_icdf[0]);
+  u=IMUL32(r,_icdf[1]);
+  if(d>=u){
+    ret=d<t;
+    s=ret?u:t;
+    t=ret?t:_this->rng;
+  }
+  else{
+    ret=1;
+    s=u;
+    do{
+      t=s;
+      s=IMUL32(r,_icdf[++ret]);
+    }
+    while(d<s);
   }
-  while(d<s);
   _this->val=d-s;
   _this->rng=t-s;
   ec_dec_normalize(_this);
@@ -225,11 +239,27 @@ uint32_t ec_dec_bits(ec_dec *_this,unsigned _bits){
   window=_this->end_window;
   available=_this->nend_bits;
   if((unsigned)available<_bits){
-    do{
-      window|=(ec_window)ec_read_byte_from_end(_this)<<available;
-      available+=EC_SYM_BITS;
+    int nsyms;
+    /*Fill the window with as many whole symbols as fit, using a single
+       32-bit big-endian load from the end of the buffer when possible.*/
+    nsyms=(EC_WINDOW_SIZE-available)/EC_SYM_BITS;
+    if(_this->end_offs+4<=_this->storage){
+      const unsigned char *buf;
+      uint32_t     bytes;
+      buf=_this->buf+_this->storage-_this->end_offs-4;
+      bytes=(uint32_t)buf[0]<<3*EC_SYM_BITS|(uint32_t)buf[1]<<2*EC_SYM_BITS
+       |(uint32_t)buf[2]<<EC_SYM_BITS|buf[3];
+      window|=(ec_window)(bytes&(0xFFFFFFFFU>>(EC_WINDOW_SIZE-nsyms*EC_SYM_BITS)))<<available;
+      _this->end_offs+=nsyms;
+      available+=nsyms*EC_SYM_BITS;
+    }
+    else{
+      do{
+        window|=(ec_window)ec_read_byte_from_end(_this)<<available;
+        available+=EC_SYM_BITS;
+      }
+      while(available<=EC_WINDOW_SIZE-EC_SYM_BITS);
     }
-    while(available<=EC_WINDOW_SIZE-EC_SYM_BITS);
   }
   ret=(uint32_t)window&(((uint32_t)1<<_bits)-1U);
   window>>=_bits;
@@ -78,6 +78,7 @@ int ec_dec_bit_logp(ec_dec *_this,unsigned _logp);
           [s>0?ft-_icdf[s-1]:0,ft-_icdf[s]), where ft=1<<_ftb.
          The values must be monotonically non-increasing, and the last value
           must be 0.
+         The table must have at least two entries.
   _ftb: The number of bits of precision in the cumulative distribution.
   Return: The decoded symbol s.*/
 int ec_dec_icdf(ec_dec *_this,const unsigned char *_icdf,unsigned _ftb);
@@ -77,6 +77,25 @@
 #include <math.h>
 #define float2int(x) lrintf(x)
 
+/* Scales a [-1,1] float sample to 16 bits with saturation. */
+static OPUS_INLINE int16_t FLOAT2INT16(float x)
+{
+   x = x*CELT_SIG_SCALE;
+   x = MAX32(x, -32768);
+   x = MIN32(x, 32767);
+   return (int16_t)float2int(x);
+}
+
+/* Scales a [-1,1] float sample to a left-justified 32-bit integer with
+   saturation. The upper bound is the largest float below 2^31. */
+static OPUS_INLINE int32_t FLOAT2INT32(float x)
+{
+   x = x*2147483648.f;
+   x = MAX32(x, -2147483648.f);
+   x = MIN32(x, 2147483520.f);
+   return (int32_t)float2int(x);
+}
+
 
 
 
@@ -96,7 +96,7 @@ static void kf_bfly2(
    }
 }
 
-static void kf_bfly4(
+void kf_bfly4_c(
                      kiss_fft_cpx * Fout,
                      const size_t fstride,
                      const kiss_fft_state *st,
@@ -185,8 +185,12 @@ static void kf_bfly3(
    kiss_twiddle_cpx epi3;
 
    kiss_fft_cpx * Fout_beg = Fout;
+#ifdef FIXED_POINT
    /*epi3.r = -16384;*/ /* Unused */
    epi3.i = -28378;
+#else
+   epi3 = st->twiddles[fstride*m];
+#endif
    for (i=0;i<N;i++)
    {
       Fout = Fout_beg + i*mm;
@@ -223,7 +227,7 @@ static void kf_bfly3(
 
 
 #ifndef OVERRIDE_kf_bfly5
-static void kf_bfly5(
+void kf_bfly5_c(
                      kiss_fft_cpx * Fout,
                      const size_t fstride,
                      const kiss_fft_state *st,
@@ -239,10 +243,15 @@ static void kf_bfly5(
    kiss_twiddle_cpx ya,yb;
    kiss_fft_cpx * Fout_beg = Fout;
 
+#ifdef FIXED_POINT
    ya.r = 10126;
    ya.i = -31164;
    yb.r = -26510;
    yb.i = -19261;
+#else
+   ya = st->twiddles[fstride*m];
+   yb = st->twiddles[fstride*2*m];
+#endif
    tw=st->twiddles;
 
    for (i=0;i<N;i++)
@@ -298,7 +307,7 @@ static void kf_bfly5(
 #endif
 
 
-void opus_fft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout)
+void opus_fft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout, int arch)
 {
     int m2, m;
     int p;
@@ -331,14 +340,14 @@ void opus_fft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout)
           kf_bfly2(fout, m, fstride[i]);
           break;
        case 4:
-          kf_bfly4(fout,fstride[i]<<shift,st,m, fstride[i], m2);
+          kf_bfly4(fout,fstride[i]<<shift,st,m, fstride[i], m2, arch);
           break;
  #ifndef RADIX_TWO_ONLY
        case 3:
           kf_bfly3(fout,fstride[i]<<shift,st,m, fstride[i], m2);
           break;
        case 5:
-          kf_bfly5(fout,fstride[i]<<shift,st,m, fstride[i], m2);
+          kf_bfly5(fout,fstride[i]<<shift,st,m, fstride[i], m2, arch);
           break;
  #endif
        }
@@ -350,9 +359,11 @@ void opus_fft_c(const kiss_fft_state *st,const kiss_fft_cpx *fin,kiss_fft_cpx *f
 {
    int i;
    opus_val16 scale;
+#ifdef FIXED_POINT
    /* Allows us to scale with MULT16_32_Q16(), which is faster than
       MULT16_32_Q15() on ARM. */
    int scale_shift = st->scale_shift-1;
+#endif
    scale = st->scale;
 
    celt_assert2 (fin != fout, "In-place FFT not supported");
@@ -363,7 +374,7 @@ void opus_fft_c(const kiss_fft_state *st,const kiss_fft_cpx *fin,kiss_fft_cpx *f
       fout[st->bitrev[i]].r = SHR32(MULT16_32_Q16(scale, x.r), scale_shift);
       fout[st->bitrev[i]].i = SHR32(MULT16_32_Q16(scale, x.i), scale_shift);
    }
-   opus_fft_impl(st, fout);
+   opus_fft_impl(st, fout, 0);
 }
 
 
@@ -376,7 +387,7 @@ void opus_ifft_c(const kiss_fft_state *st,const kiss_fft_cpx *fin,kiss_fft_cpx *
       fout[st->bitrev[i]] = fin[i];
    for (i=0;i<st->nfft;i++)
       fout[i].i = -fout[i].i;
-   opus_fft_impl(st, fout);
+   opus_fft_impl(st, fout, 0);
    for (i=0;i<st->nfft;i++)
       fout[i].i = -fout[i].i;
 }
@@ -48,8 +48,13 @@ extern "C" {
 
 #include "arch.h"
 
+#ifdef FIXED_POINT
 #  define kiss_fft_scalar int32_t
 #  define kiss_twiddle_scalar int16_t
+#else
+#  define kiss_fft_scalar float
+#  define kiss_twiddle_scalar float
+#endif
 
 typedef struct {
     kiss_fft_scalar r;
@@ -75,7 +80,9 @@ typedef struct arch_fft_state{
 typedef struct kiss_fft_state{
     int nfft;
     opus_val16 scale;
+#ifdef FIXED_POINT
     int scale_shift;
+#endif
     int shift;
     int16_t factors[2*MAXFACTORS];
     const int16_t *bitrev;
@@ -127,7 +134,7 @@ kiss_fft_state *opus_fft_alloc(int nfft,void * mem,size_t * lenmem, int arch);
 void opus_fft_c(const kiss_fft_state *cfg,const kiss_fft_cpx *fin,kiss_fft_cpx *fout);
 void opus_ifft_c(const kiss_fft_state *cfg,const kiss_fft_cpx *fin,kiss_fft_cpx *fout);
 
-void opus_fft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout);
+void opus_fft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout, int arch);
 void opus_ifft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout);
 
 void opus_fft_free(const kiss_fft_state *cfg, int arch);
@@ -61,6 +61,8 @@ unsigned isqrt32(uint32_t _val){
   return g;
 }
 
+#ifdef FIXED_POINT
+
 opus_val32 frac_div32(opus_val32 a, opus_val32 b)
 {
    opus_val16 rcp;
@@ -200,3 +202,4 @@ opus_val32 celt_rcp(opus_val32 x)
    return VSHR32(EXTEND32(r),i-16);
 }
 
+#endif /* FIXED_POINT */
@@ -38,8 +38,6 @@
 #include "entcode.h"
 #include "os_support.h"
 
-//#define PI 3.141592653f
-
 /* Multiplies two 16-bit fractional values. Bit-exactness of this macro is important */
 #define FRAC_MUL16(a,b) ((16384+((int32_t)(int16_t)(a)*(int16_t)(b)))>>15)
 
@@ -72,7 +70,22 @@ static OPUS_INLINE opus_val32 celt_maxabs32(const opus_val32 *x, int len)
 }
 
 
-#include "os_support.h"
+#ifndef FIXED_POINT
+
+#ifndef PI
+#define PI 3.141592653f
+#endif
+#define celt_sqrt(x) ((float)sqrt(x))
+#define celt_rsqrt(x) (1.f/celt_sqrt(x))
+#define celt_rsqrt_norm(x) (celt_rsqrt(x))
+#define celt_cos_norm(x) ((float)cos((.5f*PI)*(x)))
+#define celt_rcp(x) (1.f/(x))
+#define celt_div(a,b) ((a)/(b))
+#define frac_div32(a,b) ((float)(a)/(b))
+#define celt_log2(x) ((float)(1.442695040888963387*log(x)))
+#define celt_exp2(x) ((float)exp(0.6931471805599453094*(x)))
+
+#else /* FIXED_POINT */
 
 #ifndef OVERRIDE_CELT_ILOG2
 /** Integer log in base2. Undefined for zero and negative numbers */
@@ -185,4 +198,6 @@ static OPUS_INLINE opus_val16 celt_atan2p(opus_val16 y, opus_val16 x)
    }
 }
 
+#endif /* FIXED_POINT */
+
 #endif /* MATHOPS_H */
@@ -75,13 +75,27 @@ void clt_mdct_backward_c(const mdct_lookup *l, kiss_fft_scalar *in,
       int overlap, int shift, int stride, int arch);
 
 /* Is run-time CPU detection enabled on this platform? */
-
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1)
+#include "x86/mdct_sse.h"
+#elif defined(FIXED_POINT) && defined(OPUS_ESP32S3_PIE)
+/* ESP32-S3 hook: a PIE (128-bit SIMD) port provides clt_mdct_backward_pie()
+   with the same contract as clt_mdct_backward_c(), bit-exact output included. */
+#define OVERRIDE_OPUS_MDCT_BACKWARD
+void clt_mdct_backward_pie(const mdct_lookup *l, kiss_fft_scalar *in,
+      kiss_fft_scalar * __restrict__ out,
+      const opus_val16 * __restrict__ window,
+      int overlap, int shift, int stride, int arch);
+#define clt_mdct_backward(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
+   clt_mdct_backward_pie(_l, _in, _out, _window, _overlap, _shift, _stride, _arch)
+#endif
 
 #define clt_mdct_forward(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
    clt_mdct_forward_c(_l, _in, _out, _window, _overlap, _shift, _stride, _arch)
 
+#if !defined(OVERRIDE_OPUS_MDCT_BACKWARD)
 #define clt_mdct_backward(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
    clt_mdct_backward_c(_l, _in, _out, _window, _overlap, _shift, _stride, _arch)
+#endif
 
 
 #endif
@@ -59,7 +59,11 @@ static const unsigned char band_allocation[] = {
 200,200,200,200,200,200,200,200,198,193,188,183,178,173,168,163,158,153,148,129,104,
 };
 
+#ifdef FIXED_POINT
   #include "static_modes_fixed.h"
+#else
+  #include "static_modes_float.h"
+#endif
 
 CELTMode *opus_custom_mode_create(int32_t Fs, int frame_size, int *error)
 {
@@ -70,5 +70,53 @@ struct OpusCustomMode {
    PulseCache cache;
 };
 
+/* Mode accessors for the hot paths. With STATIC_MODE_48000_960 the only mode
+   Opus uses (48 kHz, 960-sample frames, 120-sample short MDCTs) is baked in:
+   band loops get constant trip counts and eBands/logN reads are folded by the
+   compiler. The values must match mode48000_960_120 in static_modes_*.h. */
+#ifdef STATIC_MODE_48000_960
+
+#ifdef CUSTOM_MODES
+#error "STATIC_MODE_48000_960 cannot be used with CUSTOM_MODES"
+#endif
+
+static OPUS_INLINE const int16_t *static_mode_eBands(void)
+{
+   static const int16_t eBands[22] = {
+      0,  1,  2,  3,  4,  5,  6,  7,  8, 10, 12, 14, 16, 20, 24, 28, 34, 40, 48, 60, 78, 100
+   };
+   return eBands;
+}
+
+static OPUS_INLINE const int16_t *static_mode_logN(void)
+{
+   static const int16_t logN[21] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 8, 8, 16, 16, 16, 21, 21, 24, 29, 34, 36
+   };
+   return logN;
+}
+
+/* The mode pointer is still evaluated (and discarded) so functions that only
+   read it through these accessors do not trip -Wunused-parameter. */
+#define MODE_OVERLAP(m)       ((void)(m), 120)
+#define MODE_NBEBANDS(m)      ((void)(m), 21)
+#define MODE_EFFEBANDS(m)     ((void)(m), 21)
+#define MODE_MAXLM(m)         ((void)(m), 3)
+#define MODE_SHORTMDCTSIZE(m) ((void)(m), 120)
+#define MODE_EBANDS(m)        ((void)(m), static_mode_eBands())
+#define MODE_LOGN(m)          ((void)(m), static_mode_logN())
+
+#else
+
+#define MODE_OVERLAP(m)       ((m)->overlap)
+#define MODE_NBEBANDS(m)      ((m)->nbEBands)
+#define MODE_EFFEBANDS(m)     ((m)->effEBands)
+#define MODE_MAXLM(m)         ((m)->maxLM)
+#define MODE_SHORTMDCTSIZE(m) ((m)->shortMdctSize)
+#define MODE_EBANDS(m)        ((m)->eBands)
+#define MODE_LOGN(m)          ((m)->logN)
+
+#endif
+
 
 #endif
@@ -40,16 +40,20 @@
 
 static void find_best_pitch(opus_val32 *xcorr, opus_val16 *y, int len,
                             int max_pitch, int *best_pitch
+#ifdef FIXED_POINT
                             , int yshift, opus_val32 maxcorr
+#endif
                             )
 {
    int i, j;
    opus_val32 Syy=1;
    opus_val16 best_num[2];
    opus_val32 best_den[2];
+#ifdef FIXED_POINT
    int xshift;
 
    xshift = celt_ilog2(maxcorr)-14;
+#endif
    best_num[0] = -1;
    best_num[1] = -1;
    best_den[0] = 0;
@@ -65,6 +69,11 @@ static void find_best_pitch(opus_val32 *xcorr, opus_val16 *y, int len,
          opus_val16 num;
          opus_val32 xcorr16;
          xcorr16 = EXTRACT16(VSHR32(xcorr[i], xshift));
+#ifndef FIXED_POINT
+         /* Considering the range of xcorr16, this should avoid both underflows
+            and overflows (inf) when squaring xcorr16 */
+         xcorr16 *= 1e-12f;
+#endif
          num = MULT16_16_Q15(xcorr16,xcorr16);
          if (MULT16_32_Q15(num,best_den[1]) > MULT16_32_Q15(best_num[1],Syy))
          {
@@ -132,6 +141,7 @@ void pitch_downsample(celt_sig * __restrict__ x[], opus_val16 * __restrict__ x_l
    opus_val16 lpc[4];
    opus_val16 lpc2[5];
    opus_val16 c1 = QCONST16(.8f,15);
+#ifdef FIXED_POINT
    int shift;
    opus_val32 maxabs = celt_maxabs32(x[0], len);
    if (C==2)
@@ -146,6 +156,7 @@ void pitch_downsample(celt_sig * __restrict__ x[], opus_val16 * __restrict__ x_l
       shift=0;
    if (C==2)
       shift++;
+#endif
    for (i=1;i<len>>1;i++)
       x_lp[i] = SHR32(HALF32(HALF32(x[0][(2*i-1)]+x[0][(2*i+1)])+x[0][2*i]), shift);
    x_lp[0] = SHR32(HALF32(HALF32(x[0][1])+x[0][0]), shift);
@@ -160,12 +171,20 @@ void pitch_downsample(celt_sig * __restrict__ x[], opus_val16 * __restrict__ x_l
                   4, len>>1, arch);
 
    /* Noise floor -40 dB */
+#ifdef FIXED_POINT
    ac[0] += SHR32(ac[0],13);
+#else
+   ac[0] *= 1.0001f;
+#endif
    /* Lag windowing */
    for (i=1;i<=4;i++)
    {
       /*ac[i] *= exp(-.5*(2*M_PI*.002*i)*(2*M_PI*.002*i));*/
+#ifdef FIXED_POINT
       ac[i] -= MULT16_32_Q15(2*i*i, ac[i]);
+#else
+      ac[i] -= ac[i]*(.008f*i)*(.008f*i);
+#endif
    }
 
    _celt_lpc(lpc, ac, 4);
@@ -229,9 +248,11 @@ void pitch_search(const opus_val16 * __restrict__ x_lp, opus_val16 * __restrict_
    VARDECL(opus_val16, x_lp4);
    VARDECL(opus_val16, y_lp4);
    VARDECL(opus_val32, xcorr);
+#ifdef FIXED_POINT
    opus_val32 maxcorr;
    opus_val32 xmax, ymax;
    int shift=0;
+#endif
    int offset;
 
    SAVE_STACK;
@@ -250,6 +271,7 @@ void pitch_search(const opus_val16 * __restrict__ x_lp, opus_val16 * __restrict_
    for (j=0;j<lag>>2;j++)
       y_lp4[j] = y[2*j];
 
+#ifdef FIXED_POINT
    xmax = celt_maxabs16(x_lp4, len>>2);
    ymax = celt_maxabs16(y_lp4, lag>>2);
    shift = celt_ilog2(MAX32(1, MAX32(xmax, ymax)))-11;
@@ -264,35 +286,46 @@ void pitch_search(const opus_val16 * __restrict__ x_lp, opus_val16 * __restrict_
    } else {
       shift = 0;
    }
+#endif
 
    /* Coarse search with 4x decimation */
+#ifdef FIXED_POINT
    maxcorr =
-
+#endif
    celt_pitch_xcorr(x_lp4, y_lp4, xcorr, len>>2, max_pitch>>2, arch);
 
    find_best_pitch(xcorr, y_lp4, len>>2, max_pitch>>2, best_pitch
+#ifdef FIXED_POINT
                    , 0, maxcorr
+#endif
                    );
 
    /* Finer search with 2x decimation */
+#ifdef FIXED_POINT
    maxcorr=1;
+#endif
    for (i=0;i<max_pitch>>1;i++)
    {
       opus_val32 sum;
       xcorr[i] = 0;
       if (abs(i-2*best_pitch[0])>2 && abs(i-2*best_pitch[1])>2)
          continue;
+#ifdef FIXED_POINT
       sum = 0;
       for (j=0;j<len>>1;j++)
          sum += SHR32(MULT16_16(x_lp[j],y[i+j]), shift);
-
+#else
+      sum = celt_inner_prod(x_lp, y+i, len>>1, arch);
+#endif
       xcorr[i] = MAX32(-1, sum);
-
+#ifdef FIXED_POINT
       maxcorr = MAX32(maxcorr, sum);
-
+#endif
    }
    find_best_pitch(xcorr, y, len>>1, max_pitch>>1, best_pitch
+#ifdef FIXED_POINT
                    , shift+1, maxcorr
+#endif
                    );
 
    /* Refine by pseudo-interpolation */
@@ -316,6 +349,7 @@ void pitch_search(const opus_val16 * __restrict__ x_lp, opus_val16 * __restrict_
    RESTORE_STACK;
 }
 
+#ifdef FIXED_POINT
 static opus_val16 compute_pitch_gain(opus_val32 xy, opus_val32 xx, opus_val32 yy)
 {
    opus_val32 x2y2;
@@ -343,6 +377,12 @@ static opus_val16 compute_pitch_gain(opus_val32 xy, opus_val32 xx, opus_val32 yy
    g = VSHR32(g, (shift>>1)-1);
    return EXTRACT16(MIN32(g, Q15ONE));
 }
+#else
+static opus_val16 compute_pitch_gain(opus_val32 xy, opus_val32 xx, opus_val32 yy)
+{
+   return xy/celt_sqrt(1+xx*yy);
+}
+#endif
 
 static const int second_check[16] = {0, 0, 3, 2, 3, 2, 5, 2, 3, 2, 3, 2, 5, 2, 3, 2};
 opus_val16 remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
@@ -36,6 +36,7 @@
 #include "rate.h"
 
 
+#ifdef FIXED_POINT
 /* Mean energy in each band quantized in Q4 */
 const signed char eMeans[25] = {
       103,100, 92, 85, 81,
@@ -44,11 +45,27 @@ const signed char eMeans[25] = {
        72, 70, 74, 76, 71,
        60, 60, 60, 60, 60
 };
+#else
+/* Mean energy in each band quantized in Q4 and converted back to float */
+const opus_val16 eMeans[25] = {
+      6.437500f, 6.250000f, 5.750000f, 5.312500f, 5.062500f,
+      4.812500f, 4.500000f, 4.375000f, 4.875000f, 4.687500f,
+      4.562500f, 4.437500f, 4.875000f, 4.625000f, 4.312500f,
+      4.500000f, 4.375000f, 4.625000f, 4.750000f, 4.437500f,
+      3.750000f, 3.750000f, 3.750000f, 3.750000f, 3.750000f
+};
+#endif
 
 /* prediction coefficients: 0.9, 0.8, 0.65, 0.5 */
+#ifdef FIXED_POINT
 static const opus_val16 pred_coef[4] = {29440, 26112, 21248, 16384};
 static const opus_val16 beta_coef[4] = {30147, 22282, 12124, 6554};
 static const opus_val16 beta_intra = 4915;
+#else
+static const opus_val16 pred_coef[4] = {29440/32768., 26112/32768., 21248/32768., 16384/32768.};
+static const opus_val16 beta_coef[4] = {30147/32768., 22282/32768., 12124/32768., 6554/32768.};
+static const opus_val16 beta_intra = 4915/32768.;
+#endif
 
 
 /*Parameters of the Laplace-like probability models used for the coarse energy.
@@ -170,14 +187,21 @@ static int quant_coarse_energy_impl(const CELTMode *m, int start, int end,
          opus_val32 f, tmp;
          opus_val16 oldE;
          opus_val16 decay_bound;
-         x = eBands[i+c*m->nbEBands];
-         oldE = MAX16(-QCONST16(9.f,DB_SHIFT), oldEBands[i+c*m->nbEBands]);
+         x = eBands[i+c*MODE_NBEBANDS(m)];
+         oldE = MAX16(-QCONST16(9.f,DB_SHIFT), oldEBands[i+c*MODE_NBEBANDS(m)]);
 
+#ifdef FIXED_POINT
          f = SHL32(EXTEND32(x),7) - PSHR32(MULT16_16(coef,oldE), 8) - prev[c];
          /* Rounding to nearest integer here is really important! */
          qi = (f+QCONST32(.5f,DB_SHIFT+7))>>(DB_SHIFT+7);
          decay_bound = EXTRACT16(MAX32(-QCONST16(28.f,DB_SHIFT),
-               SUB32((opus_val32)oldEBands[i+c*m->nbEBands],max_decay)));
+               SUB32((opus_val32)oldEBands[i+c*MODE_NBEBANDS(m)],max_decay)));
+#else
+         f = x-coef*oldE-prev[c];
+         /* Rounding to nearest integer here is really important! */
+         qi = (int)floor(.5f+f);
+         decay_bound = MAX16(-QCONST16(28.f,DB_SHIFT), oldEBands[i+c*MODE_NBEBANDS(m)]) - max_decay;
+#endif
          /* Prevent the energy from going down too quickly (e.g. for bands
             that have just one bin) */
          if (qi < 0 && x < decay_bound)
@@ -219,13 +243,13 @@ static int quant_coarse_energy_impl(const CELTMode *m, int start, int end,
          }
          else
             qi = -1;
-         error[i+c*m->nbEBands] = PSHR32(f,7) - SHL16(qi,DB_SHIFT);
+         error[i+c*MODE_NBEBANDS(m)] = PSHR32(f,7) - SHL16(qi,DB_SHIFT);
          badness += abs(qi0-qi);
          q = (opus_val32)SHL32(EXTEND32(qi),DB_SHIFT);
 
          tmp = PSHR32(MULT16_16(coef,oldE),8) + prev[c] + SHL32(q,7);
          tmp = MAX32(-QCONST32(28.f, DB_SHIFT+7), tmp);
-         oldEBands[i+c*m->nbEBands] = PSHR32(tmp, 7);
+         oldEBands[i+c*MODE_NBEBANDS(m)] = PSHR32(tmp, 7);
          prev[c] = prev[c] + SHL32(q,7) - MULT16_16(beta,PSHR32(q,8));
       } while (++c < C);
    }
@@ -250,7 +274,7 @@ void quant_coarse_energy(const CELTMode *m, int start, int end, int effEnd,
 
    intra = force_intra || (!two_pass && *delayedIntra>2*C*(end-start) && nbAvailableBytes > (end-start)*C);
    intra_bias = (int32_t)((budget**delayedIntra*loss_rate)/(C*512));
-   new_distortion = loss_distortion(eBands, oldEBands, start, effEnd, m->nbEBands, C);
+   new_distortion = loss_distortion(eBands, oldEBands, start, effEnd, MODE_NBEBANDS(m), C);
 
    tell = ec_tell(enc);
    if (tell+3 > budget)
@@ -259,16 +283,19 @@ void quant_coarse_energy(const CELTMode *m, int start, int end, int effEnd,
    max_decay = QCONST16(16.f,DB_SHIFT);
    if (end-start>10)
    {
+#ifdef FIXED_POINT
       max_decay = MIN32(max_decay, SHL32(EXTEND32(nbAvailableBytes),DB_SHIFT-3));
-
+#else
+      max_decay = MIN32(max_decay, .125f*nbAvailableBytes);
+#endif
    }
    if (lfe)
       max_decay = QCONST16(3.f,DB_SHIFT);
    enc_start_state = *enc;
 
-   ALLOC(oldEBands_intra, C*m->nbEBands, opus_val16);
-   ALLOC(error_intra, C*m->nbEBands, opus_val16);
-   OPUS_COPY(oldEBands_intra, oldEBands, C*m->nbEBands);
+   ALLOC(oldEBands_intra, C*MODE_NBEBANDS(m), opus_val16);
+   ALLOC(error_intra, C*MODE_NBEBANDS(m), opus_val16);
+   OPUS_COPY(oldEBands_intra, oldEBands, C*MODE_NBEBANDS(m));
 
    if (two_pass || intra)
    {
@@ -311,13 +338,13 @@ void quant_coarse_energy(const CELTMode *m, int start, int end, int effEnd,
          *enc = enc_intra_state;
          /* Copy intra bits to bit-stream */
          OPUS_COPY(intra_buf, intra_bits, nintra_bytes - nstart_bytes);
-         OPUS_COPY(oldEBands, oldEBands_intra, C*m->nbEBands);
-         OPUS_COPY(error, error_intra, C*m->nbEBands);
+         OPUS_COPY(oldEBands, oldEBands_intra, C*MODE_NBEBANDS(m));
+         OPUS_COPY(error, error_intra, C*MODE_NBEBANDS(m));
          intra = 1;
       }
    } else {
-      OPUS_COPY(oldEBands, oldEBands_intra, C*m->nbEBands);
-      OPUS_COPY(error, error_intra, C*m->nbEBands);
+      OPUS_COPY(oldEBands, oldEBands_intra, C*MODE_NBEBANDS(m));
+      OPUS_COPY(error, error_intra, C*MODE_NBEBANDS(m));
    }
 
    if (intra)
@@ -344,15 +371,23 @@ void quant_fine_energy(const CELTMode *m, int start, int end, opus_val16 *oldEBa
          int q2;
          opus_val16 offset;
          /* Has to be without rounding */
-         q2 = (error[i+c*m->nbEBands]+QCONST16(.5f,DB_SHIFT))>>(DB_SHIFT-fine_quant[i]);
+#ifdef FIXED_POINT
+         q2 = (error[i+c*MODE_NBEBANDS(m)]+QCONST16(.5f,DB_SHIFT))>>(DB_SHIFT-fine_quant[i]);
+#else
+         q2 = (int)floor((error[i+c*MODE_NBEBANDS(m)]+.5f)*frac);
+#endif
          if (q2 > frac-1)
             q2 = frac-1;
          if (q2<0)
             q2 = 0;
          ec_enc_bits(enc, q2, fine_quant[i]);
+#ifdef FIXED_POINT
          offset = SUB16(SHR32(SHL32(EXTEND32(q2),DB_SHIFT)+QCONST16(.5f,DB_SHIFT),fine_quant[i]),QCONST16(.5f,DB_SHIFT));
-         oldEBands[i+c*m->nbEBands] += offset;
-         error[i+c*m->nbEBands] -= offset;
+#else
+         offset = (q2+.5f)*(1<<(14-fine_quant[i]))*(1.f/16384) - .5f;
+#endif
+         oldEBands[i+c*MODE_NBEBANDS(m)] += offset;
+         error[i+c*MODE_NBEBANDS(m)] -= offset;
          /*printf ("%f ", error[i] - offset);*/
       } while (++c < C);
    }
@@ -373,11 +408,15 @@ void quant_energy_finalise(const CELTMode *m, int start, int end, opus_val16 *ol
          do {
             int q2;
             opus_val16 offset;
-            q2 = error[i+c*m->nbEBands]<0 ? 0 : 1;
+            q2 = error[i+c*MODE_NBEBANDS(m)]<0 ? 0 : 1;
             ec_enc_bits(enc, q2, 1);
+#ifdef FIXED_POINT
             offset = SHR16(SHL16(q2,DB_SHIFT)-QCONST16(.5f,DB_SHIFT),fine_quant[i]+1);
-            oldEBands[i+c*m->nbEBands] += offset;
-            error[i+c*m->nbEBands] -= offset;
+#else
+            offset = (q2-.5f)*(1<<(14-fine_quant[i]-1))*(1.f/16384);
+#endif
+            oldEBands[i+c*MODE_NBEBANDS(m)] += offset;
+            error[i+c*MODE_NBEBANDS(m)] -= offset;
             bits_left--;
          } while (++c < C);
       }
@@ -438,10 +477,10 @@ void unquant_coarse_energy(const CELTMode *m, int start, int end, opus_val16 *ol
             qi = -1;
          q = (opus_val32)SHL32(EXTEND32(qi),DB_SHIFT);
 
-         oldEBands[i+c*m->nbEBands] = MAX16(-QCONST16(9.f,DB_SHIFT), oldEBands[i+c*m->nbEBands]);
-         tmp = PSHR32(MULT16_16(coef,oldEBands[i+c*m->nbEBands]),8) + prev[c] + SHL32(q,7);
+         oldEBands[i+c*MODE_NBEBANDS(m)] = MAX16(-QCONST16(9.f,DB_SHIFT), oldEBands[i+c*MODE_NBEBANDS(m)]);
+         tmp = PSHR32(MULT16_16(coef,oldEBands[i+c*MODE_NBEBANDS(m)]),8) + prev[c] + SHL32(q,7);
          tmp = MAX32(-QCONST32(28.f, DB_SHIFT+7), tmp);
-         oldEBands[i+c*m->nbEBands] = PSHR32(tmp, 7);
+         oldEBands[i+c*MODE_NBEBANDS(m)] = PSHR32(tmp, 7);
          prev[c] = prev[c] + SHL32(q,7) - MULT16_16(beta,PSHR32(q,8));
       } while (++c < C);
    }
@@ -460,8 +499,12 @@ void unquant_fine_energy(const CELTMode *m, int start, int end, opus_val16 *oldE
          int q2;
          opus_val16 offset;
          q2 = ec_dec_bits(dec, fine_quant[i]);
+#ifdef FIXED_POINT
          offset = SUB16(SHR32(SHL32(EXTEND32(q2),DB_SHIFT)+QCONST16(.5f,DB_SHIFT),fine_quant[i]),QCONST16(.5f,DB_SHIFT));
-         oldEBands[i+c*m->nbEBands] += offset;
+#else
+         offset = (q2+.5f)*(1<<(14-fine_quant[i]))*(1.f/16384) - .5f;
+#endif
+         oldEBands[i+c*MODE_NBEBANDS(m)] += offset;
       } while (++c < C);
    }
 }
@@ -482,8 +525,12 @@ void unquant_energy_finalise(const CELTMode *m, int start, int end, opus_val16 *
             int q2;
             opus_val16 offset;
             q2 = ec_dec_bits(dec, 1);
+#ifdef FIXED_POINT
             offset = SHR16(SHL16(q2,DB_SHIFT)-QCONST16(.5f,DB_SHIFT),fine_quant[i]+1);
-            oldEBands[i+c*m->nbEBands] += offset;
+#else
+            offset = (q2-.5f)*(1<<(14-fine_quant[i]-1))*(1.f/16384);
+#endif
+            oldEBands[i+c*MODE_NBEBANDS(m)] += offset;
             bits_left--;
          } while (++c < C);
       }
@@ -498,13 +545,15 @@ void amp2Log2(const CELTMode *m, int effEnd, int end,
    do {
       for (i=0;i<effEnd;i++)
       {
-         bandLogE[i+c*m->nbEBands] =
-               celt_log2(bandE[i+c*m->nbEBands])
+         bandLogE[i+c*MODE_NBEBANDS(m)] =
+               celt_log2(bandE[i+c*MODE_NBEBANDS(m)])
                - SHL16((opus_val16)eMeans[i],6);
+#ifdef FIXED_POINT
          /* Compensate for bandE[] being Q12 but celt_log2() taking a Q14 input. */
-         bandLogE[i+c*m->nbEBands] += QCONST16(2.f, DB_SHIFT);
+         bandLogE[i+c*MODE_NBEBANDS(m)] += QCONST16(2.f, DB_SHIFT);
+#endif
       }
       for (i=effEnd;i<end;i++)
-         bandLogE[c*m->nbEBands+i] = -QCONST16(14.f,DB_SHIFT);
+         bandLogE[c*MODE_NBEBANDS(m)+i] = -QCONST16(14.f,DB_SHIFT);
    } while (++c < C);
 }
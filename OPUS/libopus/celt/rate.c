@@ -329,10 +329,10 @@ static OPUS_INLINE int interp_bits2pulses(const CELTMode *m, int start, int end,
       /*Figure out how many left-over bits we would be adding to this band.
         This can include bits we've stolen back from higher, skipped bands.*/
       left = total-psum;
-      percoeff = celt_udiv(left, m->eBands[codedBands]-m->eBands[start]);
-      left -= (m->eBands[codedBands]-m->eBands[start])*percoeff;
-      rem = IMAX(left-(m->eBands[j]-m->eBands[start]),0);
-      band_width = m->eBands[codedBands]-m->eBands[j];
+      percoeff = celt_udiv(left, MODE_EBANDS(m)[codedBands]-MODE_EBANDS(m)[start]);
+      left -= (MODE_EBANDS(m)[codedBands]-MODE_EBANDS(m)[start])*percoeff;
+      rem = IMAX(left-(MODE_EBANDS(m)[j]-MODE_EBANDS(m)[start]),0);
+      band_width = MODE_EBANDS(m)[codedBands]-MODE_EBANDS(m)[j];
       band_bits = (int)(bits[j] + percoeff*band_width + rem);
       /*Only code a skip decision if we're above the threshold for this band.
         Otherwise it is force-skipped.
@@ -415,13 +415,13 @@ static OPUS_INLINE int interp_bits2pulses(const CELTMode *m, int start, int end,
 
    /* Allocate the remaining bits */
    left = total-psum;
-   percoeff = celt_udiv(left, m->eBands[codedBands]-m->eBands[start]);
-   left -= (m->eBands[codedBands]-m->eBands[start])*percoeff;
+   percoeff = celt_udiv(left, MODE_EBANDS(m)[codedBands]-MODE_EBANDS(m)[start]);
+   left -= (MODE_EBANDS(m)[codedBands]-MODE_EBANDS(m)[start])*percoeff;
    for (j=start;j<codedBands;j++)
-      bits[j] += ((int)percoeff*(m->eBands[j+1]-m->eBands[j]));
+      bits[j] += ((int)percoeff*(MODE_EBANDS(m)[j+1]-MODE_EBANDS(m)[j]));
    for (j=start;j<codedBands;j++)
    {
-      int tmp = (int)IMIN(left, m->eBands[j+1]-m->eBands[j]);
+      int tmp = (int)IMIN(left, MODE_EBANDS(m)[j+1]-MODE_EBANDS(m)[j]);
       bits[j] += tmp;
       left -= tmp;
    }
@@ -436,7 +436,7 @@ static OPUS_INLINE int interp_bits2pulses(const CELTMode *m, int start, int end,
       int32_t excess, bit;
 
       celt_assert(bits[j] >= 0);
-      N0 = m->eBands[j+1]-m->eBands[j];
+      N0 = MODE_EBANDS(m)[j+1]-MODE_EBANDS(m)[j];
       N=N0<<LM;
       bit = (int32_t)bits[j]+balance;
 
@@ -448,7 +448,7 @@ static OPUS_INLINE int interp_bits2pulses(const CELTMode *m, int start, int end,
          /* Compensate for the extra DoF in stereo */
          den=(C*N+ ((C==2 && N>2 && !*dual_stereo && j<*intensity) ? 1 : 0));
 
-         NClogN = den*(m->logN[j] + logM);
+         NClogN = den*(MODE_LOGN(m)[j] + logM);
 
          /* Offset for the number of fine bits by log2(N)/2 + FINE_OFFSET
             compared to their "fair share" of total/N */
@@ -541,7 +541,7 @@ int clt_compute_allocation(const CELTMode *m, int start, int end, const int *off
    SAVE_STACK;
 
    total = IMAX(total, 0);
-   len = m->nbEBands;
+   len = MODE_NBEBANDS(m);
    skip_start = start;
    /* Reserve a bit to signal the end of manually skipped bands. */
    skip_rsv = total >= 1<<BITRES ? 1<<BITRES : 0;
@@ -568,13 +568,13 @@ int clt_compute_allocation(const CELTMode *m, int start, int end, const int *off
    for (j=start;j<end;j++)
    {
       /* Below this threshold, we're sure not to allocate any PVQ bits */
-      thresh[j] = IMAX((C)<<BITRES, (3*(m->eBands[j+1]-m->eBands[j])<<LM<<BITRES)>>4);
+      thresh[j] = IMAX((C)<<BITRES, (3*(MODE_EBANDS(m)[j+1]-MODE_EBANDS(m)[j])<<LM<<BITRES)>>4);
       /* Tilt of the allocation curve */
-      trim_offset[j] = C*(m->eBands[j+1]-m->eBands[j])*(alloc_trim-5-LM)*(end-j-1)
+      trim_offset[j] = C*(MODE_EBANDS(m)[j+1]-MODE_EBANDS(m)[j])*(alloc_trim-5-LM)*(end-j-1)
             *(1<<(LM+BITRES))>>6;
       /* Giving less resolution to single-coefficient bands because they get
          more benefit from having one coarse value per coefficient*/
-      if ((m->eBands[j+1]-m->eBands[j])<<LM==1)
+      if ((MODE_EBANDS(m)[j+1]-MODE_EBANDS(m)[j])<<LM==1)
          trim_offset[j] -= C<<BITRES;
    }
    lo = 1;
@@ -587,7 +587,7 @@ int clt_compute_allocation(const CELTMode *m, int start, int end, const int *off
       for (j=end;j-->start;)
       {
          int bitsj;
-         int N = m->eBands[j+1]-m->eBands[j];
+         int N = MODE_EBANDS(m)[j+1]-MODE_EBANDS(m)[j];
          bitsj = C*N*m->allocVectors[mid*len+j]<<LM>>2;
          if (bitsj > 0)
             bitsj = IMAX(0, bitsj + trim_offset[j]);
@@ -614,7 +614,7 @@ int clt_compute_allocation(const CELTMode *m, int start, int end, const int *off
    for (j=start;j<end;j++)
    {
       int bits1j, bits2j;
-      int N = m->eBands[j+1]-m->eBands[j];
+      int N = MODE_EBANDS(m)[j+1]-MODE_EBANDS(m)[j];
       bits1j = C*N*m->allocVectors[lo*len+j]<<LM>>2;
       bits2j = hi>=m->nbAllocVectors ?
             cap[j] : C*N*m->allocVectors[hi*len+j]<<LM>>2;
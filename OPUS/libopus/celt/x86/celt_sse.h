@@ -0,0 +1,72 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CELT_SSE_H
+#define CELT_SSE_H
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+void comb_filter_const_sse4_1(opus_val32 *y, opus_val32 *x, int T, int N,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12);
+
+void comb_filter_fade_sse4_1(opus_val32 *y, opus_val32 *x, int T0, int T1,
+      opus_val16 g00, opus_val16 g01, opus_val16 g02,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12,
+      const opus_val16 *window, int overlap);
+
+#if defined(OPUS_X86_PRESUME_SSE4_1)
+
+#define OVERRIDE_COMB_FILTER_CONST
+#define comb_filter_const(y, x, T, N, g10, g11, g12, arch) \
+    ((void)(arch),comb_filter_const_sse4_1(y, x, T, N, g10, g11, g12))
+
+#define OVERRIDE_COMB_FILTER_FADE
+#define comb_filter_fade(y, x, T0, T1, g00, g01, g02, g10, g11, g12, window, overlap, arch) \
+    ((void)(arch),comb_filter_fade_sse4_1(y, x, T0, T1, g00, g01, g02, g10, g11, g12, window, overlap))
+
+#elif defined(OPUS_HAVE_RTCD)
+
+#define OVERRIDE_COMB_FILTER_CONST
+#define NON_STATIC_COMB_FILTER_CONST_C
+extern void (*const COMB_FILTER_CONST_IMPL[OPUS_ARCHMASK+1])(opus_val32 *y,
+      opus_val32 *x, int T, int N, opus_val16 g10, opus_val16 g11, opus_val16 g12);
+#define comb_filter_const(y, x, T, N, g10, g11, g12, arch) \
+    ((*COMB_FILTER_CONST_IMPL[(arch)&OPUS_ARCHMASK])(y, x, T, N, g10, g11, g12))
+
+#define OVERRIDE_COMB_FILTER_FADE
+#define NON_STATIC_COMB_FILTER_FADE_C
+extern void (*const COMB_FILTER_FADE_IMPL[OPUS_ARCHMASK+1])(opus_val32 *y,
+      opus_val32 *x, int T0, int T1, opus_val16 g00, opus_val16 g01, opus_val16 g02,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12,
+      const opus_val16 *window, int overlap);
+#define comb_filter_fade(y, x, T0, T1, g00, g01, g02, g10, g11, g12, window, overlap, arch) \
+    ((*COMB_FILTER_FADE_IMPL[(arch)&OPUS_ARCHMASK])(y, x, T0, T1, g00, g01, g02, \
+    g10, g11, g12, window, overlap))
+
+#endif
+
+#endif
+
+#endif /* CELT_SSE_H */
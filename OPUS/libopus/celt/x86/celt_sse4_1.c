@@ -0,0 +1,144 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../celt.h"
+#include "x86cpu.h"
+
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+#include "fixed_sse4_1.h"
+
+/* Same as comb_filter_const_c(), four outputs at a time. The filter may run
+   in place (y==x): each block only reads x[i-T-2..i-T+5], and since
+   T>=COMBFILTER_MINPERIOD those samples were all written by earlier blocks,
+   exactly as in the scalar recursion. */
+void OPUS_TARGET_SSE4_1 comb_filter_const_sse4_1(opus_val32 *y, opus_val32 *x,
+      int T, int N, opus_val16 g10, opus_val16 g11, opus_val16 g12)
+{
+   int i;
+   __m128i vg10, vg11, vg12, sat, nsat;
+   vg10 = _mm_set1_epi32(g10);
+   vg11 = _mm_set1_epi32(g11);
+   vg12 = _mm_set1_epi32(g12);
+   sat = _mm_set1_epi32(SIG_SAT);
+   nsat = _mm_set1_epi32(-SIG_SAT);
+   for (i=0;i<N-3;i+=4)
+   {
+      __m128i x0, x1, x2, x3, x4, t;
+      const opus_val32 *xp = x+i-T;
+      x4 = _mm_loadu_si128((const __m128i *)(xp-2));
+      x3 = _mm_loadu_si128((const __m128i *)(xp-1));
+      x2 = _mm_loadu_si128((const __m128i *)xp);
+      x1 = _mm_loadu_si128((const __m128i *)(xp+1));
+      x0 = _mm_loadu_si128((const __m128i *)(xp+2));
+      t = _mm_loadu_si128((const __m128i *)(x+i));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(vg10, x2));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(vg11, _mm_add_epi32(x1, x3)));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(vg12, _mm_add_epi32(x0, x4)));
+      t = _mm_max_epi32(_mm_min_epi32(t, sat), nsat);
+      _mm_storeu_si128((__m128i *)(y+i), t);
+   }
+   for (;i<N;i++)
+   {
+      opus_val32 t;
+      t = x[i]
+            + MULT16_32_Q15(g10,x[i-T])
+            + MULT16_32_Q15(g11,ADD32(x[i-T+1],x[i-T-1]))
+            + MULT16_32_Q15(g12,ADD32(x[i-T+2],x[i-T-2]));
+      y[i] = SATURATE(t, SIG_SAT);
+   }
+}
+
+/* Same as comb_filter_fade_c(), four outputs at a time. The per-sample tap
+   gains are formed exactly as in C (f and 1-f in Q15, then scaled by each
+   tap gain and truncated to 16 bits), and the same in-place argument as
+   above applies to both T0 and T1. */
+void OPUS_TARGET_SSE4_1 comb_filter_fade_sse4_1(opus_val32 *y, opus_val32 *x,
+      int T0, int T1, opus_val16 g00, opus_val16 g01, opus_val16 g02,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12,
+      const opus_val16 *window, int overlap)
+{
+   int i;
+   __m128i vg00, vg01, vg02, vg10, vg11, vg12, one, sat, nsat;
+   vg00 = _mm_set1_epi32(g00);
+   vg01 = _mm_set1_epi32(g01);
+   vg02 = _mm_set1_epi32(g02);
+   vg10 = _mm_set1_epi32(g10);
+   vg11 = _mm_set1_epi32(g11);
+   vg12 = _mm_set1_epi32(g12);
+   one = _mm_set1_epi32(Q15ONE);
+   sat = _mm_set1_epi32(SIG_SAT);
+   nsat = _mm_set1_epi32(-SIG_SAT);
+   for (i=0;i<overlap-3;i+=4)
+   {
+      __m128i w, f, nf, t;
+      const opus_val32 *x0p = x+i-T0;
+      const opus_val32 *x1p = x+i-T1;
+      w = load_epi16x4(window+i);
+      f = _mm_srai_epi32(_mm_mullo_epi32(w, w), 15);
+      nf = _mm_sub_epi32(one, f);
+      t = _mm_loadu_si128((const __m128i *)(x+i));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(
+            _mm_srai_epi32(_mm_mullo_epi32(nf, vg00), 15),
+            _mm_loadu_si128((const __m128i *)x0p)));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(
+            _mm_srai_epi32(_mm_mullo_epi32(nf, vg01), 15),
+            _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x0p+1)),
+                          _mm_loadu_si128((const __m128i *)(x0p-1)))));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(
+            _mm_srai_epi32(_mm_mullo_epi32(nf, vg02), 15),
+            _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x0p+2)),
+                          _mm_loadu_si128((const __m128i *)(x0p-2)))));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(
+            _mm_srai_epi32(_mm_mullo_epi32(f, vg10), 15),
+            _mm_loadu_si128((const __m128i *)x1p)));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(
+            _mm_srai_epi32(_mm_mullo_epi32(f, vg11), 15),
+            _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x1p+1)),
+                          _mm_loadu_si128((const __m128i *)(x1p-1)))));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(
+            _mm_srai_epi32(_mm_mullo_epi32(f, vg12), 15),
+            _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x1p+2)),
+                          _mm_loadu_si128((const __m128i *)(x1p-2)))));
+      t = _mm_max_epi32(_mm_min_epi32(t, sat), nsat);
+      _mm_storeu_si128((__m128i *)(y+i), t);
+   }
+   for (;i<overlap;i++)
+   {
+      opus_val16 f;
+      opus_val32 t;
+      f = MULT16_16_Q15(window[i],window[i]);
+      t = x[i]
+            + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g00),x[i-T0])
+            + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g01),ADD32(x[i-T0+1],x[i-T0-1]))
+            + MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g02),ADD32(x[i-T0+2],x[i-T0-2]))
+            + MULT16_32_Q15(MULT16_16_Q15(f,g10),x[i-T1])
+            + MULT16_32_Q15(MULT16_16_Q15(f,g11),ADD32(x[i-T1+1],x[i-T1-1]))
+            + MULT16_32_Q15(MULT16_16_Q15(f,g12),ADD32(x[i-T1+2],x[i-T1-2]));
+      y[i] = SATURATE(t, SIG_SAT);
+   }
+}
+
+#endif
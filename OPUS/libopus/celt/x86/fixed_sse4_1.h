@@ -0,0 +1,55 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FIXED_SSE4_1_H
+#define FIXED_SSE4_1_H
+
+#include <smmintrin.h>
+#include "x86cpu.h"
+
+/* MULT16_32_Q15(a, b) on four lanes. The result is taken from the full 64-bit
+   product, which equals the split 16-bit form in fixed_generic.h modulo 2^32,
+   so it wraps exactly like the C macro. */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 __m128i mult16_32_q15_epi32(__m128i a, __m128i b)
+{
+   __m128i even, odd;
+   even = _mm_srli_epi64(_mm_mul_epi32(a, b), 15);
+   odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+   odd = _mm_slli_epi64(odd, 17);
+   return _mm_blend_epi16(even, odd, 0xCC);
+}
+
+/* Loads four int16 values and sign-extends them to 32 bits. */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 __m128i load_epi16x4(const int16_t *p)
+{
+   return _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)p));
+}
+
+static OPUS_INLINE OPUS_TARGET_SSE4_1 __m128i reverse_epi32(__m128i x)
+{
+   return _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+#endif
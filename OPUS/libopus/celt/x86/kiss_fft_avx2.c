@@ -0,0 +1,261 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../_kiss_fft_guts.h"
+#include "x86cpu.h"
+
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_AVX2)
+
+#include <immintrin.h>
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+#define kf_bfly4_narrow kf_bfly4_sse4_1
+#define kf_bfly5_narrow kf_bfly5_sse4_1
+#else
+#define kf_bfly4_narrow kf_bfly4_c
+#define kf_bfly5_narrow kf_bfly5_c
+#endif
+
+/* MULT16_32_Q15(a, b) on eight lanes, see kiss_fft_sse4_1.c. */
+static OPUS_INLINE OPUS_TARGET_AVX2 __m256i mult16_32_q15_epi32x8(__m256i a, __m256i b)
+{
+   __m256i even, odd;
+   even = _mm256_srli_epi64(_mm256_mul_epi32(a, b), 15);
+   odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+   odd = _mm256_slli_epi64(odd, 17);
+   return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+/* Loads eight consecutive complex values as separate real/imaginary vectors. */
+static OPUS_INLINE OPUS_TARGET_AVX2 void cpx_load8(const kiss_fft_cpx *p,
+      __m256i *re, __m256i *im)
+{
+   __m256i a, b;
+   a = _mm256_shuffle_epi32(_mm256_loadu_si256((const __m256i *)p), _MM_SHUFFLE(3, 1, 2, 0));
+   b = _mm256_shuffle_epi32(_mm256_loadu_si256((const __m256i *)(p + 4)), _MM_SHUFFLE(3, 1, 2, 0));
+   *re = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+   *im = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static OPUS_INLINE OPUS_TARGET_AVX2 void cpx_store8(kiss_fft_cpx *p,
+      __m256i re, __m256i im)
+{
+   re = _mm256_permute4x64_epi64(re, _MM_SHUFFLE(3, 1, 2, 0));
+   im = _mm256_permute4x64_epi64(im, _MM_SHUFFLE(3, 1, 2, 0));
+   _mm256_storeu_si256((__m256i *)p, _mm256_unpacklo_epi32(re, im));
+   _mm256_storeu_si256((__m256i *)(p + 4), _mm256_unpackhi_epi32(re, im));
+}
+
+/* Gathers tw[k*stride] for k=0..7; idx holds k*stride. */
+static OPUS_INLINE OPUS_TARGET_AVX2 void tw_load8(const kiss_twiddle_cpx *tw,
+      __m256i idx, __m256i *re, __m256i *im)
+{
+   __m256i v;
+   v = _mm256_i32gather_epi32((const int *)tw, idx, sizeof(kiss_twiddle_cpx));
+   *re = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+   *im = _mm256_srai_epi32(v, 16);
+}
+
+static OPUS_INLINE OPUS_TARGET_AVX2 __m256i tw_index8(size_t stride)
+{
+   return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+         _mm256_set1_epi32((int)stride));
+}
+
+/* C_MUL() */
+static OPUS_INLINE OPUS_TARGET_AVX2 void cmul8(__m256i *mr, __m256i *mi,
+      __m256i ar, __m256i ai, __m256i br, __m256i bi)
+{
+   *mr = _mm256_sub_epi32(mult16_32_q15_epi32x8(br, ar), mult16_32_q15_epi32x8(bi, ai));
+   *mi = _mm256_add_epi32(mult16_32_q15_epi32x8(bi, ar), mult16_32_q15_epi32x8(br, ai));
+}
+
+void OPUS_TARGET_AVX2 kf_bfly4_avx2(
+                     kiss_fft_cpx * Fout,
+                     const size_t fstride,
+                     const kiss_fft_state *st,
+                     int m,
+                     int N,
+                     int mm
+                    )
+{
+   int i, j;
+   const kiss_twiddle_cpx *tw = st->twiddles;
+   const int m2=2*m;
+   const int m3=3*m;
+   kiss_fft_cpx * Fout_beg = Fout;
+   __m256i idx1, idx2, idx3;
+
+   /* The degenerate m==1 stage and the short m==4 stages don't fill a
+      256-bit register. */
+   if (m&7)
+   {
+      kf_bfly4_narrow(Fout, fstride, st, m, N, mm);
+      return;
+   }
+   idx1 = tw_index8(fstride);
+   idx2 = tw_index8(2*fstride);
+   idx3 = tw_index8(3*fstride);
+   for (i=0;i<N;i++)
+   {
+      Fout = Fout_beg + i*mm;
+      for (j=0;j<m;j+=8)
+      {
+         __m256i f0r, f0i, f1r, f1i, f2r, f2i, f3r, f3i;
+         __m256i t1r, t1i, t2r, t2i, t3r, t3i;
+         __m256i s0r, s0i, s1r, s1i, s2r, s2i, s3r, s3i, s4r, s4i, s5r, s5i;
+
+         cpx_load8(Fout, &f0r, &f0i);
+         cpx_load8(Fout + m, &f1r, &f1i);
+         cpx_load8(Fout + m2, &f2r, &f2i);
+         cpx_load8(Fout + m3, &f3r, &f3i);
+         tw_load8(tw + j*fstride, idx1, &t1r, &t1i);
+         tw_load8(tw + 2*j*fstride, idx2, &t2r, &t2i);
+         tw_load8(tw + 3*j*fstride, idx3, &t3r, &t3i);
+
+         cmul8(&s0r, &s0i, f1r, f1i, t1r, t1i);
+         cmul8(&s1r, &s1i, f2r, f2i, t2r, t2i);
+         cmul8(&s2r, &s2i, f3r, f3i, t3r, t3i);
+
+         s5r = _mm256_sub_epi32(f0r, s1r);
+         s5i = _mm256_sub_epi32(f0i, s1i);
+         f0r = _mm256_add_epi32(f0r, s1r);
+         f0i = _mm256_add_epi32(f0i, s1i);
+         s3r = _mm256_add_epi32(s0r, s2r);
+         s3i = _mm256_add_epi32(s0i, s2i);
+         s4r = _mm256_sub_epi32(s0r, s2r);
+         s4i = _mm256_sub_epi32(s0i, s2i);
+
+         cpx_store8(Fout + m2, _mm256_sub_epi32(f0r, s3r), _mm256_sub_epi32(f0i, s3i));
+         cpx_store8(Fout, _mm256_add_epi32(f0r, s3r), _mm256_add_epi32(f0i, s3i));
+         cpx_store8(Fout + m, _mm256_add_epi32(s5r, s4i), _mm256_sub_epi32(s5i, s4r));
+         cpx_store8(Fout + m3, _mm256_sub_epi32(s5r, s4i), _mm256_add_epi32(s5i, s4r));
+         Fout += 8;
+      }
+   }
+}
+
+void OPUS_TARGET_AVX2 kf_bfly5_avx2(
+                     kiss_fft_cpx * Fout,
+                     const size_t fstride,
+                     const kiss_fft_state *st,
+                     int m,
+                     int N,
+                     int mm
+                    )
+{
+   int i, u;
+   const kiss_twiddle_cpx *tw = st->twiddles;
+   kiss_fft_cpx * Fout_beg = Fout;
+   const __m256i yar = _mm256_set1_epi32(10126);
+   const __m256i yai = _mm256_set1_epi32(-31164);
+   const __m256i ybr = _mm256_set1_epi32(-26510);
+   const __m256i ybi = _mm256_set1_epi32(-19261);
+   __m256i idx1, idx2, idx3, idx4;
+
+   if (m&7)
+   {
+      kf_bfly5_narrow(Fout, fstride, st, m, N, mm);
+      return;
+   }
+   idx1 = tw_index8(fstride);
+   idx2 = tw_index8(2*fstride);
+   idx3 = tw_index8(3*fstride);
+   idx4 = tw_index8(4*fstride);
+   for (i=0;i<N;i++)
+   {
+      kiss_fft_cpx *Fout0, *Fout1, *Fout2, *Fout3, *Fout4;
+      Fout = Fout_beg + i*mm;
+      Fout0=Fout;
+      Fout1=Fout0+m;
+      Fout2=Fout0+2*m;
+      Fout3=Fout0+3*m;
+      Fout4=Fout0+4*m;
+
+      for (u=0; u<m; u+=8)
+      {
+         __m256i s0r, s0i, s1r, s1i, s2r, s2i, s3r, s3i, s4r, s4i;
+         __m256i s5r, s5i, s6r, s6i, s7r, s7i, s8r, s8i, s9r, s9i, s10r, s10i;
+         __m256i s11r, s11i, s12r, s12i;
+         __m256i tr, ti, xr, xi;
+
+         cpx_load8(Fout0, &s0r, &s0i);
+
+         cpx_load8(Fout1, &xr, &xi);
+         tw_load8(tw + u*fstride, idx1, &tr, &ti);
+         cmul8(&s1r, &s1i, xr, xi, tr, ti);
+         cpx_load8(Fout2, &xr, &xi);
+         tw_load8(tw + 2*u*fstride, idx2, &tr, &ti);
+         cmul8(&s2r, &s2i, xr, xi, tr, ti);
+         cpx_load8(Fout3, &xr, &xi);
+         tw_load8(tw + 3*u*fstride, idx3, &tr, &ti);
+         cmul8(&s3r, &s3i, xr, xi, tr, ti);
+         cpx_load8(Fout4, &xr, &xi);
+         tw_load8(tw + 4*u*fstride, idx4, &tr, &ti);
+         cmul8(&s4r, &s4i, xr, xi, tr, ti);
+
+         s7r = _mm256_add_epi32(s1r, s4r);
+         s7i = _mm256_add_epi32(s1i, s4i);
+         s10r = _mm256_sub_epi32(s1r, s4r);
+         s10i = _mm256_sub_epi32(s1i, s4i);
+         s8r = _mm256_add_epi32(s2r, s3r);
+         s8i = _mm256_add_epi32(s2i, s3i);
+         s9r = _mm256_sub_epi32(s2r, s3r);
+         s9i = _mm256_sub_epi32(s2i, s3i);
+
+         cpx_store8(Fout0, _mm256_add_epi32(s0r, _mm256_add_epi32(s7r, s8r)),
+               _mm256_add_epi32(s0i, _mm256_add_epi32(s7i, s8i)));
+
+         s5r = _mm256_add_epi32(s0r, _mm256_add_epi32(mult16_32_q15_epi32x8(yar, s7r),
+               mult16_32_q15_epi32x8(ybr, s8r)));
+         s5i = _mm256_add_epi32(s0i, _mm256_add_epi32(mult16_32_q15_epi32x8(yar, s7i),
+               mult16_32_q15_epi32x8(ybr, s8i)));
+         s6r = _mm256_add_epi32(mult16_32_q15_epi32x8(yai, s10i),
+               mult16_32_q15_epi32x8(ybi, s9i));
+         s6i = _mm256_sub_epi32(_mm256_setzero_si256(),
+               _mm256_add_epi32(mult16_32_q15_epi32x8(yai, s10r),
+               mult16_32_q15_epi32x8(ybi, s9r)));
+
+         cpx_store8(Fout1, _mm256_sub_epi32(s5r, s6r), _mm256_sub_epi32(s5i, s6i));
+         cpx_store8(Fout4, _mm256_add_epi32(s5r, s6r), _mm256_add_epi32(s5i, s6i));
+
+         s11r = _mm256_add_epi32(s0r, _mm256_add_epi32(mult16_32_q15_epi32x8(ybr, s7r),
+               mult16_32_q15_epi32x8(yar, s8r)));
+         s11i = _mm256_add_epi32(s0i, _mm256_add_epi32(mult16_32_q15_epi32x8(ybr, s7i),
+               mult16_32_q15_epi32x8(yar, s8i)));
+         s12r = _mm256_sub_epi32(mult16_32_q15_epi32x8(yai, s9i),
+               mult16_32_q15_epi32x8(ybi, s10i));
+         s12i = _mm256_sub_epi32(mult16_32_q15_epi32x8(ybi, s10r),
+               mult16_32_q15_epi32x8(yai, s9r));
+
+         cpx_store8(Fout2, _mm256_add_epi32(s11r, s12r), _mm256_add_epi32(s11i, s12i));
+         cpx_store8(Fout3, _mm256_sub_epi32(s11r, s12r), _mm256_sub_epi32(s11i, s12i));
+
+         Fout0+=8;Fout1+=8;Fout2+=8;Fout3+=8;Fout4+=8;
+      }
+   }
+}
+
+#endif /* OPUS_X86_MAY_HAVE_AVX2 */
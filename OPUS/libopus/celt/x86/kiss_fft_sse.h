@@ -0,0 +1,80 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KISS_FFT_SSE_H
+#define KISS_FFT_SSE_H
+
+/* Fixed-point radix-4 and radix-5 butterflies. They produce the same bits as
+   kf_bfly4_c()/kf_bfly5_c(): the multiplies are done as full 32x32->64-bit
+   products, which is exactly what MULT16_32_Q15() computes modulo 2^32. */
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+void kf_bfly4_sse4_1(kiss_fft_cpx * Fout, const size_t fstride,
+      const kiss_fft_state *st, int m, int N, int mm);
+
+void kf_bfly5_sse4_1(kiss_fft_cpx * Fout, const size_t fstride,
+      const kiss_fft_state *st, int m, int N, int mm);
+#endif
+
+#if defined(OPUS_X86_MAY_HAVE_AVX2)
+void kf_bfly4_avx2(kiss_fft_cpx * Fout, const size_t fstride,
+      const kiss_fft_state *st, int m, int N, int mm);
+
+void kf_bfly5_avx2(kiss_fft_cpx * Fout, const size_t fstride,
+      const kiss_fft_state *st, int m, int N, int mm);
+#endif
+
+#if defined(OPUS_X86_PRESUME_AVX2)
+
+#define OVERRIDE_KF_BFLY
+#define kf_bfly4(Fout, fstride, st, m, N, mm, arch) \
+   ((void)(arch), kf_bfly4_avx2(Fout, fstride, st, m, N, mm))
+#define kf_bfly5(Fout, fstride, st, m, N, mm, arch) \
+   ((void)(arch), kf_bfly5_avx2(Fout, fstride, st, m, N, mm))
+
+#elif defined(OPUS_X86_PRESUME_SSE4_1) && !defined(OPUS_X86_MAY_HAVE_AVX2)
+
+#define OVERRIDE_KF_BFLY
+#define kf_bfly4(Fout, fstride, st, m, N, mm, arch) \
+   ((void)(arch), kf_bfly4_sse4_1(Fout, fstride, st, m, N, mm))
+#define kf_bfly5(Fout, fstride, st, m, N, mm, arch) \
+   ((void)(arch), kf_bfly5_sse4_1(Fout, fstride, st, m, N, mm))
+
+#elif defined(OPUS_HAVE_RTCD)
+
+#define OVERRIDE_KF_BFLY
+extern void (*const KF_BFLY4_IMPL[OPUS_ARCHMASK + 1])(kiss_fft_cpx * Fout,
+      const size_t fstride, const kiss_fft_state *st, int m, int N, int mm);
+#define kf_bfly4(Fout, fstride, st, m, N, mm, arch) \
+   ((*KF_BFLY4_IMPL[(arch) & OPUS_ARCHMASK])(Fout, fstride, st, m, N, mm))
+
+extern void (*const KF_BFLY5_IMPL[OPUS_ARCHMASK + 1])(kiss_fft_cpx * Fout,
+      const size_t fstride, const kiss_fft_state *st, int m, int N, int mm);
+#define kf_bfly5(Fout, fstride, st, m, N, mm, arch) \
+   ((*KF_BFLY5_IMPL[(arch) & OPUS_ARCHMASK])(Fout, fstride, st, m, N, mm))
+
+#endif
+
+#endif /* KISS_FFT_SSE_H */
@@ -0,0 +1,248 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../_kiss_fft_guts.h"
+#include "x86cpu.h"
+
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+#include <string.h>
+#include "fixed_sse4_1.h"
+
+/* Loads four consecutive complex values as separate real/imaginary vectors. */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 void cpx_load4(const kiss_fft_cpx *p,
+      __m128i *re, __m128i *im)
+{
+   __m128i a, b;
+   a = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)p), _MM_SHUFFLE(3, 1, 2, 0));
+   b = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(p + 2)), _MM_SHUFFLE(3, 1, 2, 0));
+   *re = _mm_unpacklo_epi64(a, b);
+   *im = _mm_unpackhi_epi64(a, b);
+}
+
+static OPUS_INLINE OPUS_TARGET_SSE4_1 void cpx_store4(kiss_fft_cpx *p,
+      __m128i re, __m128i im)
+{
+   _mm_storeu_si128((__m128i *)p, _mm_unpacklo_epi32(re, im));
+   _mm_storeu_si128((__m128i *)(p + 2), _mm_unpackhi_epi32(re, im));
+}
+
+/* Gathers tw[0], tw[stride], tw[2*stride] and tw[3*stride]. */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 void tw_load4(const kiss_twiddle_cpx *tw,
+      size_t stride, __m128i *re, __m128i *im)
+{
+   int32_t t0, t1, t2, t3;
+   __m128i v;
+   memcpy(&t0, tw, sizeof(t0));
+   memcpy(&t1, tw + stride, sizeof(t1));
+   memcpy(&t2, tw + 2*stride, sizeof(t2));
+   memcpy(&t3, tw + 3*stride, sizeof(t3));
+   v = _mm_setr_epi32(t0, t1, t2, t3);
+   *re = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+   *im = _mm_srai_epi32(v, 16);
+}
+
+/* C_MUL() */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 void cmul4(__m128i *mr, __m128i *mi,
+      __m128i ar, __m128i ai, __m128i br, __m128i bi)
+{
+   *mr = _mm_sub_epi32(mult16_32_q15_epi32(br, ar), mult16_32_q15_epi32(bi, ai));
+   *mi = _mm_add_epi32(mult16_32_q15_epi32(bi, ar), mult16_32_q15_epi32(br, ai));
+}
+
+void OPUS_TARGET_SSE4_1 kf_bfly4_sse4_1(
+                     kiss_fft_cpx * Fout,
+                     const size_t fstride,
+                     const kiss_fft_state *st,
+                     int m,
+                     int N,
+                     int mm
+                    )
+{
+   int i;
+
+   if (m==1)
+   {
+      /* Degenerate case where all the twiddles are 1. One butterfly is two
+         registers: [F0 F1] and [F2 F3]. */
+      const __m128i sign = _mm_setr_epi32(1, -1, 1, 1);
+      for (i=0;i<N;i++)
+      {
+         __m128i x01, x23, s, d, sw, q, f0, f2, f1, f3;
+         x01 = _mm_loadu_si128((const __m128i *)Fout);
+         x23 = _mm_loadu_si128((const __m128i *)(Fout + 2));
+         s = _mm_add_epi32(x01, x23);
+         d = _mm_sub_epi32(x01, x23);
+         sw = _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2));
+         f0 = _mm_add_epi32(s, sw);
+         f2 = _mm_sub_epi32(s, sw);
+         /* q = (scratch1.i, -scratch1.r) */
+         q = _mm_sign_epi32(_mm_shuffle_epi32(d, _MM_SHUFFLE(0, 1, 2, 3)), sign);
+         f1 = _mm_add_epi32(d, q);
+         f3 = _mm_sub_epi32(d, q);
+         _mm_storeu_si128((__m128i *)Fout, _mm_unpacklo_epi64(f0, f1));
+         _mm_storeu_si128((__m128i *)(Fout + 2), _mm_unpacklo_epi64(f2, f3));
+         Fout+=4;
+      }
+   } else {
+      int j;
+      const kiss_twiddle_cpx *tw = st->twiddles;
+      const int m2=2*m;
+      const int m3=3*m;
+      kiss_fft_cpx * Fout_beg = Fout;
+      for (i=0;i<N;i++)
+      {
+         Fout = Fout_beg + i*mm;
+         /* m is guaranteed to be a multiple of 4. */
+         for (j=0;j<m;j+=4)
+         {
+            __m128i f0r, f0i, f1r, f1i, f2r, f2i, f3r, f3i;
+            __m128i t1r, t1i, t2r, t2i, t3r, t3i;
+            __m128i s0r, s0i, s1r, s1i, s2r, s2i, s3r, s3i, s4r, s4i, s5r, s5i;
+
+            cpx_load4(Fout, &f0r, &f0i);
+            cpx_load4(Fout + m, &f1r, &f1i);
+            cpx_load4(Fout + m2, &f2r, &f2i);
+            cpx_load4(Fout + m3, &f3r, &f3i);
+            tw_load4(tw + j*fstride, fstride, &t1r, &t1i);
+            tw_load4(tw + 2*j*fstride, 2*fstride, &t2r, &t2i);
+            tw_load4(tw + 3*j*fstride, 3*fstride, &t3r, &t3i);
+
+            cmul4(&s0r, &s0i, f1r, f1i, t1r, t1i);
+            cmul4(&s1r, &s1i, f2r, f2i, t2r, t2i);
+            cmul4(&s2r, &s2i, f3r, f3i, t3r, t3i);
+
+            s5r = _mm_sub_epi32(f0r, s1r);
+            s5i = _mm_sub_epi32(f0i, s1i);
+            f0r = _mm_add_epi32(f0r, s1r);
+            f0i = _mm_add_epi32(f0i, s1i);
+            s3r = _mm_add_epi32(s0r, s2r);
+            s3i = _mm_add_epi32(s0i, s2i);
+            s4r = _mm_sub_epi32(s0r, s2r);
+            s4i = _mm_sub_epi32(s0i, s2i);
+
+            cpx_store4(Fout + m2, _mm_sub_epi32(f0r, s3r), _mm_sub_epi32(f0i, s3i));
+            cpx_store4(Fout, _mm_add_epi32(f0r, s3r), _mm_add_epi32(f0i, s3i));
+            cpx_store4(Fout + m, _mm_add_epi32(s5r, s4i), _mm_sub_epi32(s5i, s4r));
+            cpx_store4(Fout + m3, _mm_sub_epi32(s5r, s4i), _mm_add_epi32(s5i, s4r));
+            Fout += 4;
+         }
+      }
+   }
+}
+
+void OPUS_TARGET_SSE4_1 kf_bfly5_sse4_1(
+                     kiss_fft_cpx * Fout,
+                     const size_t fstride,
+                     const kiss_fft_state *st,
+                     int m,
+                     int N,
+                     int mm
+                    )
+{
+   int i, u;
+   const kiss_twiddle_cpx *tw = st->twiddles;
+   kiss_fft_cpx * Fout_beg = Fout;
+   const __m128i yar = _mm_set1_epi32(10126);
+   const __m128i yai = _mm_set1_epi32(-31164);
+   const __m128i ybr = _mm_set1_epi32(-26510);
+   const __m128i ybi = _mm_set1_epi32(-19261);
+
+   for (i=0;i<N;i++)
+   {
+      kiss_fft_cpx *Fout0, *Fout1, *Fout2, *Fout3, *Fout4;
+      Fout = Fout_beg + i*mm;
+      Fout0=Fout;
+      Fout1=Fout0+m;
+      Fout2=Fout0+2*m;
+      Fout3=Fout0+3*m;
+      Fout4=Fout0+4*m;
+
+      /* For non-custom modes, m is guaranteed to be a multiple of 4. */
+      for (u=0; u<m; u+=4)
+      {
+         __m128i s0r, s0i, s1r, s1i, s2r, s2i, s3r, s3i, s4r, s4i;
+         __m128i s5r, s5i, s6r, s6i, s7r, s7i, s8r, s8i, s9r, s9i, s10r, s10i;
+         __m128i s11r, s11i, s12r, s12i;
+         __m128i tr, ti, xr, xi;
+
+         cpx_load4(Fout0, &s0r, &s0i);
+
+         cpx_load4(Fout1, &xr, &xi);
+         tw_load4(tw + u*fstride, fstride, &tr, &ti);
+         cmul4(&s1r, &s1i, xr, xi, tr, ti);
+         cpx_load4(Fout2, &xr, &xi);
+         tw_load4(tw + 2*u*fstride, 2*fstride, &tr, &ti);
+         cmul4(&s2r, &s2i, xr, xi, tr, ti);
+         cpx_load4(Fout3, &xr, &xi);
+         tw_load4(tw + 3*u*fstride, 3*fstride, &tr, &ti);
+         cmul4(&s3r, &s3i, xr, xi, tr, ti);
+         cpx_load4(Fout4, &xr, &xi);
+         tw_load4(tw + 4*u*fstride, 4*fstride, &tr, &ti);
+         cmul4(&s4r, &s4i, xr, xi, tr, ti);
+
+         s7r = _mm_add_epi32(s1r, s4r);
+         s7i = _mm_add_epi32(s1i, s4i);
+         s10r = _mm_sub_epi32(s1r, s4r);
+         s10i = _mm_sub_epi32(s1i, s4i);
+         s8r = _mm_add_epi32(s2r, s3r);
+         s8i = _mm_add_epi32(s2i, s3i);
+         s9r = _mm_sub_epi32(s2r, s3r);
+         s9i = _mm_sub_epi32(s2i, s3i);
+
+         cpx_store4(Fout0, _mm_add_epi32(s0r, _mm_add_epi32(s7r, s8r)),
+               _mm_add_epi32(s0i, _mm_add_epi32(s7i, s8i)));
+
+         s5r = _mm_add_epi32(s0r, _mm_add_epi32(mult16_32_q15_epi32(yar, s7r),
+               mult16_32_q15_epi32(ybr, s8r)));
+         s5i = _mm_add_epi32(s0i, _mm_add_epi32(mult16_32_q15_epi32(yar, s7i),
+               mult16_32_q15_epi32(ybr, s8i)));
+         s6r = _mm_add_epi32(mult16_32_q15_epi32(yai, s10i),
+               mult16_32_q15_epi32(ybi, s9i));
+         s6i = _mm_sub_epi32(_mm_setzero_si128(),
+               _mm_add_epi32(mult16_32_q15_epi32(yai, s10r),
+               mult16_32_q15_epi32(ybi, s9r)));
+
+         cpx_store4(Fout1, _mm_sub_epi32(s5r, s6r), _mm_sub_epi32(s5i, s6i));
+         cpx_store4(Fout4, _mm_add_epi32(s5r, s6r), _mm_add_epi32(s5i, s6i));
+
+         s11r = _mm_add_epi32(s0r, _mm_add_epi32(mult16_32_q15_epi32(ybr, s7r),
+               mult16_32_q15_epi32(yar, s8r)));
+         s11i = _mm_add_epi32(s0i, _mm_add_epi32(mult16_32_q15_epi32(ybr, s7i),
+               mult16_32_q15_epi32(yar, s8i)));
+         s12r = _mm_sub_epi32(mult16_32_q15_epi32(yai, s9i),
+               mult16_32_q15_epi32(ybi, s10i));
+         s12i = _mm_sub_epi32(mult16_32_q15_epi32(ybi, s10r),
+               mult16_32_q15_epi32(yai, s9r));
+
+         cpx_store4(Fout2, _mm_add_epi32(s11r, s12r), _mm_add_epi32(s11i, s12i));
+         cpx_store4(Fout3, _mm_sub_epi32(s11r, s12r), _mm_sub_epi32(s11i, s12i));
+
+         Fout0+=4;Fout1+=4;Fout2+=4;Fout3+=4;Fout4+=4;
+      }
+   }
+}
+
+#endif /* OPUS_X86_MAY_HAVE_SSE4_1 */
@@ -0,0 +1,57 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef MDCT_SSE_H
+#define MDCT_SSE_H
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+void clt_mdct_backward_sse4_1(const mdct_lookup *l, kiss_fft_scalar *in,
+      kiss_fft_scalar * __restrict__ out,
+      const opus_val16 * __restrict__ window,
+      int overlap, int shift, int stride, int arch);
+
+#if defined(OPUS_X86_PRESUME_SSE4_1)
+
+#define OVERRIDE_OPUS_MDCT_BACKWARD
+#define clt_mdct_backward(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
+   clt_mdct_backward_sse4_1(_l, _in, _out, _window, _overlap, _shift, _stride, _arch)
+
+#elif defined(OPUS_HAVE_RTCD)
+
+#define OVERRIDE_OPUS_MDCT_BACKWARD
+extern void (*const CLT_MDCT_BACKWARD_IMPL[OPUS_ARCHMASK+1])(
+      const mdct_lookup *l, kiss_fft_scalar *in,
+      kiss_fft_scalar * __restrict__ out, const opus_val16 * __restrict__ window,
+      int overlap, int shift, int stride, int arch);
+#define clt_mdct_backward(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
+   ((*CLT_MDCT_BACKWARD_IMPL[(_arch)&OPUS_ARCHMASK])(_l, _in, _out, _window, \
+   _overlap, _shift, _stride, _arch))
+
+#endif
+
+#endif
+
+#endif /* MDCT_SSE_H */
@@ -0,0 +1,220 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../mdct.h"
+#include "../_kiss_fft_guts.h"
+#include "x86cpu.h"
+
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+#include "fixed_sse4_1.h"
+
+/* Same as clt_mdct_backward_c(), with the pre-rotation, the post-rotation and
+   the TDAC windowing done four coefficients at a time. The FFT in between
+   goes through the arch dispatch as well. */
+void OPUS_TARGET_SSE4_1 clt_mdct_backward_sse4_1(const mdct_lookup *l,
+      kiss_fft_scalar *in, kiss_fft_scalar * __restrict__ out,
+      const opus_val16 * __restrict__ window, int overlap, int shift, int stride,
+      int arch)
+{
+   int i;
+   int N, N2, N4;
+   const kiss_twiddle_scalar *trig;
+
+   N = l->n;
+   trig = l->trig;
+   for (i=0;i<shift;i++)
+   {
+      N >>= 1;
+      trig += N;
+   }
+   N2 = N>>1;
+   N4 = N>>2;
+
+   /* Pre-rotate */
+   {
+      const kiss_fft_scalar * __restrict__ xp1 = in;
+      const kiss_fft_scalar * __restrict__ xp2 = in+stride*(N2-1);
+      kiss_fft_scalar * __restrict__ yp = out+(overlap>>1);
+      const kiss_twiddle_scalar * __restrict__ t = &trig[0];
+      const int16_t * __restrict__ bitrev = l->kfft[shift]->bitrev;
+      for(i=0;i+4<=N4;i+=4)
+      {
+         __m128i x1, x2, t0, t1, yr, yi, lo, hi;
+         if (stride == 1)
+         {
+            /* x1 = xp1[0,2,4,6], x2 = xp2[0,-2,-4,-6] */
+            x1 = _mm_castps_si128(_mm_shuffle_ps(
+                  _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)xp1)),
+                  _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(xp1+4))),
+                  _MM_SHUFFLE(2, 0, 2, 0)));
+            x2 = _mm_castps_si128(_mm_shuffle_ps(
+                  _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(xp2-3))),
+                  _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(xp2-7))),
+                  _MM_SHUFFLE(1, 3, 1, 3)));
+         } else {
+            x1 = _mm_setr_epi32(xp1[0], xp1[2*stride], xp1[4*stride], xp1[6*stride]);
+            x2 = _mm_setr_epi32(xp2[0], xp2[-2*stride], xp2[-4*stride], xp2[-6*stride]);
+         }
+         t0 = load_epi16x4(t+i);
+         t1 = load_epi16x4(t+N4+i);
+         yr = _mm_add_epi32(mult16_32_q15_epi32(t0, x2), mult16_32_q15_epi32(t1, x1));
+         yi = _mm_sub_epi32(mult16_32_q15_epi32(t0, x1), mult16_32_q15_epi32(t1, x2));
+         /* We swap real and imag because we use an FFT instead of an IFFT.
+            Storing the pre-rotation directly in the bitrev order. */
+         lo = _mm_unpacklo_epi32(yi, yr);
+         hi = _mm_unpackhi_epi32(yi, yr);
+         _mm_storel_epi64((__m128i *)(yp+2*bitrev[0]), lo);
+         _mm_storel_epi64((__m128i *)(yp+2*bitrev[1]), _mm_srli_si128(lo, 8));
+         _mm_storel_epi64((__m128i *)(yp+2*bitrev[2]), hi);
+         _mm_storel_epi64((__m128i *)(yp+2*bitrev[3]), _mm_srli_si128(hi, 8));
+         bitrev += 4;
+         xp1+=8*stride;
+         xp2-=8*stride;
+      }
+      for(;i<N4;i++)
+      {
+         int rev;
+         kiss_fft_scalar yr, yi;
+         rev = *bitrev++;
+         yr = ADD32_ovflw(S_MUL(*xp2, t[i]), S_MUL(*xp1, t[N4+i]));
+         yi = SUB32_ovflw(S_MUL(*xp1, t[i]), S_MUL(*xp2, t[N4+i]));
+         yp[2*rev+1] = yr;
+         yp[2*rev] = yi;
+         xp1+=2*stride;
+         xp2-=2*stride;
+      }
+   }
+
+   opus_fft_impl(l->kfft[shift], (kiss_fft_cpx*)(out+(overlap>>1)), arch);
+
+   /* Post-rotate and de-shuffle from both ends of the buffer at once to make
+      it in-place. Four pairs from each end per step, as long as the two
+      blocks can't overlap. */
+   {
+      kiss_fft_scalar * yp0 = out+(overlap>>1);
+      kiss_fft_scalar * yp1 = out+(overlap>>1)+N2-2;
+      const kiss_twiddle_scalar *t = &trig[0];
+      for(i=0;i+4<=(N4>>1);i+=4)
+      {
+         __m128i a, b, re0, im0, re1, im1, t0, t1, t0b, t1b;
+         __m128i yr0, yi0, yr1, yi1;
+         /* Front: pairs i..i+3, (im, re) in memory. */
+         a = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)yp0), _MM_SHUFFLE(3, 1, 2, 0));
+         b = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(yp0+4)), _MM_SHUFFLE(3, 1, 2, 0));
+         im0 = _mm_unpacklo_epi64(a, b);
+         re0 = _mm_unpackhi_epi64(a, b);
+         /* Back: pairs N4-1-i down to N4-4-i, lane k holds pair N4-1-i-k. */
+         a = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(yp1-6)), _MM_SHUFFLE(3, 1, 2, 0));
+         b = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(yp1-2)), _MM_SHUFFLE(3, 1, 2, 0));
+         im1 = reverse_epi32(_mm_unpacklo_epi64(a, b));
+         re1 = reverse_epi32(_mm_unpackhi_epi64(a, b));
+
+         t0 = load_epi16x4(t+i);
+         t1 = load_epi16x4(t+N4+i);
+         t0b = reverse_epi32(load_epi16x4(t+N4-i-4));
+         t1b = reverse_epi32(load_epi16x4(t+N2-i-4));
+
+         /* We'd scale up by 2 here, but instead it's done when mixing the windows */
+         yr0 = _mm_add_epi32(mult16_32_q15_epi32(t0, re0), mult16_32_q15_epi32(t1, im0));
+         yi0 = _mm_sub_epi32(mult16_32_q15_epi32(t1, re0), mult16_32_q15_epi32(t0, im0));
+         yr1 = _mm_add_epi32(mult16_32_q15_epi32(t0b, re1), mult16_32_q15_epi32(t1b, im1));
+         yi1 = _mm_sub_epi32(mult16_32_q15_epi32(t1b, re1), mult16_32_q15_epi32(t0b, im1));
+
+         /* yp0 gets (yr0, yi1), yp1 gets (yr1, yi0). */
+         _mm_storeu_si128((__m128i *)yp0, _mm_unpacklo_epi32(yr0, yi1));
+         _mm_storeu_si128((__m128i *)(yp0+4), _mm_unpackhi_epi32(yr0, yi1));
+         yr1 = reverse_epi32(yr1);
+         yi0 = reverse_epi32(yi0);
+         _mm_storeu_si128((__m128i *)(yp1-6), _mm_unpacklo_epi32(yr1, yi0));
+         _mm_storeu_si128((__m128i *)(yp1-2), _mm_unpackhi_epi32(yr1, yi0));
+         yp0 += 8;
+         yp1 -= 8;
+      }
+      /* Loop to (N4+1)>>1 to handle odd N4. When N4 is odd, the
+         middle pair will be computed twice. */
+      for(;i<(N4+1)>>1;i++)
+      {
+         kiss_fft_scalar re, im, yr, yi;
+         kiss_twiddle_scalar t0, t1;
+         re = yp0[1];
+         im = yp0[0];
+         t0 = t[i];
+         t1 = t[N4+i];
+         yr = ADD32_ovflw(S_MUL(re,t0), S_MUL(im,t1));
+         yi = SUB32_ovflw(S_MUL(re,t1), S_MUL(im,t0));
+         re = yp1[1];
+         im = yp1[0];
+         yp0[0] = yr;
+         yp1[1] = yi;
+
+         t0 = t[(N4-i-1)];
+         t1 = t[(N2-i-1)];
+         yr = ADD32_ovflw(S_MUL(re,t0), S_MUL(im,t1));
+         yi = SUB32_ovflw(S_MUL(re,t1), S_MUL(im,t0));
+         yp1[0] = yr;
+         yp0[1] = yi;
+         yp0 += 2;
+         yp1 -= 2;
+      }
+   }
+
+   /* Mirror on both sides for TDAC */
+   {
+      kiss_fft_scalar * __restrict__ xp1 = out+overlap-1;
+      kiss_fft_scalar * __restrict__ yp1 = out;
+      const opus_val16 * __restrict__ wp1 = window;
+      const opus_val16 * __restrict__ wp2 = window+overlap-1;
+
+      for(i = 0; i+4 <= overlap/2; i+=4)
+      {
+         __m128i x1, x2, w1, w2;
+         x1 = reverse_epi32(_mm_loadu_si128((const __m128i *)(xp1-3)));
+         x2 = _mm_loadu_si128((const __m128i *)yp1);
+         w1 = load_epi16x4(wp1);
+         w2 = reverse_epi32(load_epi16x4(wp2-3));
+         _mm_storeu_si128((__m128i *)yp1, _mm_sub_epi32(
+               mult16_32_q15_epi32(w2, x2), mult16_32_q15_epi32(w1, x1)));
+         _mm_storeu_si128((__m128i *)(xp1-3), reverse_epi32(_mm_add_epi32(
+               mult16_32_q15_epi32(w1, x2), mult16_32_q15_epi32(w2, x1))));
+         yp1 += 4;
+         xp1 -= 4;
+         wp1 += 4;
+         wp2 -= 4;
+      }
+      for(; i < overlap/2; i++)
+      {
+         kiss_fft_scalar x1, x2;
+         x1 = *xp1;
+         x2 = *yp1;
+         *yp1++ = SUB32_ovflw(MULT16_32_Q15(*wp2, x2), MULT16_32_Q15(*wp1, x1));
+         *xp1-- = ADD32_ovflw(MULT16_32_Q15(*wp1, x2), MULT16_32_Q15(*wp2, x1));
+         wp1++;
+         wp2--;
+      }
+   }
+}
+
+#endif /* OPUS_X86_MAY_HAVE_SSE4_1 */
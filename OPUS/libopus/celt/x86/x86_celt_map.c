@@ -0,0 +1,94 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../cpu_support.h"
+#include "x86cpu.h"
+#include "../_kiss_fft_guts.h"
+#include "../mdct.h"
+#include "../celt.h"
+
+#if defined(OPUS_HAVE_RTCD) && defined(FIXED_POINT)
+
+# if (defined(OPUS_X86_MAY_HAVE_SSE4_1) && !defined(OPUS_X86_PRESUME_SSE4_1)) || \
+  (defined(OPUS_X86_MAY_HAVE_AVX2) && !defined(OPUS_X86_PRESUME_AVX2))
+
+void (*const KF_BFLY4_IMPL[OPUS_ARCHMASK + 1])(kiss_fft_cpx * Fout,
+      const size_t fstride, const kiss_fft_state *st, int m, int N, int mm) = {
+  kf_bfly4_c,                   /* non-sse */
+  kf_bfly4_c,
+  kf_bfly4_c,
+  MAY_HAVE_SSE4_1(kf_bfly4),    /* sse4.1  */
+  MAY_HAVE_AVX2(kf_bfly4)       /* avx2    */
+};
+
+void (*const KF_BFLY5_IMPL[OPUS_ARCHMASK + 1])(kiss_fft_cpx * Fout,
+      const size_t fstride, const kiss_fft_state *st, int m, int N, int mm) = {
+  kf_bfly5_c,                   /* non-sse */
+  kf_bfly5_c,
+  kf_bfly5_c,
+  MAY_HAVE_SSE4_1(kf_bfly5),    /* sse4.1  */
+  MAY_HAVE_AVX2(kf_bfly5)       /* avx2    */
+};
+
+#  if defined(OPUS_X86_MAY_HAVE_SSE4_1) && !defined(OPUS_X86_PRESUME_SSE4_1)
+
+/* The rotations are bound by the bit-reversed scatter, so AVX2 machines use
+   the SSE4.1 version too (its FFT still goes through the AVX2 butterflies). */
+void (*const CLT_MDCT_BACKWARD_IMPL[OPUS_ARCHMASK+1])(
+      const mdct_lookup *l, kiss_fft_scalar *in,
+      kiss_fft_scalar * __restrict__ out, const opus_val16 * __restrict__ window,
+      int overlap, int shift, int stride, int arch) = {
+  clt_mdct_backward_c,          /* non-sse */
+  clt_mdct_backward_c,
+  clt_mdct_backward_c,
+  clt_mdct_backward_sse4_1,     /* sse4.1  */
+  clt_mdct_backward_sse4_1      /* avx2    */
+};
+
+void (*const COMB_FILTER_CONST_IMPL[OPUS_ARCHMASK+1])(opus_val32 *y,
+      opus_val32 *x, int T, int N, opus_val16 g10, opus_val16 g11, opus_val16 g12) = {
+  comb_filter_const_c,          /* non-sse */
+  comb_filter_const_c,
+  comb_filter_const_c,
+  comb_filter_const_sse4_1,     /* sse4.1  */
+  comb_filter_const_sse4_1      /* avx2    */
+};
+
+void (*const COMB_FILTER_FADE_IMPL[OPUS_ARCHMASK+1])(opus_val32 *y,
+      opus_val32 *x, int T0, int T1, opus_val16 g00, opus_val16 g01, opus_val16 g02,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12,
+      const opus_val16 *window, int overlap) = {
+  comb_filter_fade_c,           /* non-sse */
+  comb_filter_fade_c,
+  comb_filter_fade_c,
+  comb_filter_fade_sse4_1,      /* sse4.1  */
+  comb_filter_fade_sse4_1       /* avx2    */
+};
+
+#  endif
+
+# endif
+
+#endif
@@ -0,0 +1,135 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../cpu_support.h"
+#include "x86cpu.h"
+
+#if defined(OPUS_HAVE_RTCD) && \
+  ((defined(OPUS_X86_MAY_HAVE_SSE4_1) && !defined(OPUS_X86_PRESUME_SSE4_1)) || \
+  (defined(OPUS_X86_MAY_HAVE_AVX2) && !defined(OPUS_X86_PRESUME_AVX2)))
+
+#if defined(_MSC_VER)
+
+#include <intrin.h>
+static _inline void cpuid(unsigned int CPUInfo[4], unsigned int InfoType)
+{
+   __cpuidex((int*)CPUInfo, InfoType, 0);
+}
+
+static _inline unsigned int xgetbv0(void)
+{
+   return (unsigned int)_xgetbv(0);
+}
+
+#else
+
+#include <cpuid.h>
+static void cpuid(unsigned int CPUInfo[4], unsigned int InfoType)
+{
+   __cpuid_count(InfoType, 0, CPUInfo[0], CPUInfo[1], CPUInfo[2], CPUInfo[3]);
+}
+
+static unsigned int xgetbv0(void)
+{
+   unsigned int eax, edx;
+   __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+   return eax;
+}
+
+#endif
+
+typedef struct CPU_Feature{
+   int HW_SSE;
+   int HW_SSE2;
+   int HW_SSE41;
+   int HW_AVX2;
+} CPU_Feature;
+
+static void opus_cpu_feature_check(CPU_Feature *cpu_feature)
+{
+   unsigned int info[4] = {0};
+   unsigned int nIds = 0;
+
+   cpuid(info, 0);
+   nIds = info[0];
+
+   cpu_feature->HW_SSE = 0;
+   cpu_feature->HW_SSE2 = 0;
+   cpu_feature->HW_SSE41 = 0;
+   cpu_feature->HW_AVX2 = 0;
+   if (nIds >= 1)
+   {
+      int os_avx;
+      cpuid(info, 1);
+      cpu_feature->HW_SSE = (info[3] & (1 << 25)) != 0;
+      cpu_feature->HW_SSE2 = (info[3] & (1 << 26)) != 0;
+      cpu_feature->HW_SSE41 = (info[2] & (1 << 19)) != 0;
+      /* AVX2 also needs the OS to save the YMM registers (OSXSAVE + XCR0). */
+      os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0
+            && (xgetbv0() & 0x6) == 0x6;
+      if (os_avx && nIds >= 7)
+      {
+         cpuid(info, 7);
+         cpu_feature->HW_AVX2 = (info[1] & (1 << 5)) != 0;
+      }
+   }
+}
+
+int opus_select_arch(void)
+{
+   CPU_Feature cpu_feature;
+   int arch;
+
+   opus_cpu_feature_check(&cpu_feature);
+
+   arch = 0;
+   if (!cpu_feature.HW_SSE)
+   {
+      return arch;
+   }
+   arch++;
+
+   if (!cpu_feature.HW_SSE2)
+   {
+      return arch;
+   }
+   arch++;
+
+   if (!cpu_feature.HW_SSE41)
+   {
+      return arch;
+   }
+   arch++;
+
+   if (!cpu_feature.HW_AVX2)
+   {
+      return arch;
+   }
+   arch++;
+
+   return arch;
+}
+
+#endif
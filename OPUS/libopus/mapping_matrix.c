@@ -104,11 +104,21 @@ void mapping_matrix_multiply_channel_in_short(
     opus_val32 tmp = 0;
     for (col = 0; col < input_rows; col++)
     {
+#if defined(FIXED_POINT)
       tmp +=
         ((int32_t)matrix_data[MATRIX_INDEX(matrix->rows, output_row, col)] *
         (int32_t)input[MATRIX_INDEX(input_rows, col, i)]) >> 8;
+#else
+      tmp +=
+        matrix_data[MATRIX_INDEX(matrix->rows, output_row, col)] *
+        input[MATRIX_INDEX(input_rows, col, i)];
+#endif
     }
+#if defined(FIXED_POINT)
     output[output_rows * i] = (int16_t)((tmp + 64) >> 7);
+#else
+    output[output_rows * i] = (1/(32768.f*32768.f))*tmp;
+#endif
   }
 }
 
@@ -132,7 +142,11 @@ void mapping_matrix_multiply_channel_out_short(
 
   for (i = 0; i < frame_size; i++)
   {
+#if defined(FIXED_POINT)
     input_sample = (int32_t)input[input_rows * i];
+#else
+    input_sample = (int32_t)FLOAT2INT16(input[input_rows * i]);
+#endif
     for (row = 0; row < output_rows; row++)
     {
       int32_t tmp =
@@ -142,6 +142,38 @@ OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_float(
     int decode_fec
 ) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4);
 
+/** Number of bands per frame in the output of opus_decode_energy(). */
+#define OPUS_ENERGY_BANDS 21
+
+/** Scan an Opus packet for its band levels without decoding the audio.
+  * Only the entropy-coded side information is read: the CELT band energies
+  * and, for SILK, the gains with the LPC and pitch parameters that shape
+  * them. The PVQ layer, the synthesis and the postfilter are skipped, which
+  * makes a scan many times faster than opus_decode().
+  * The levels are given for the CELT bands (0-200 Hz up to 15.6-20 kHz) as
+  * the mean power per channel in dB relative to a full-scale square wave,
+  * in Q8. They are accurate to about the energy resolution the encoder
+  * spent: a dB or two for CELT, a few dB per band for SILK.
+  * Bands that are not coded read -128 dB.
+  * A scan leaves the decoder in a state that only further scans can use:
+  * reset it with #OPUS_RESET_STATE before decoding audio again.
+  * @param [in] st <tt>OpusDecoder*</tt>: Decoder state
+  * @param [in] data <tt>char*</tt>: Input payload
+  * @param [in] len <tt>int32_t</tt>: Number of bytes in payload
+  * @param [out] band_db <tt>opus_int16*</tt>: #OPUS_ENERGY_BANDS levels for
+  *  each frame of the packet
+  * @param [in] max_frames <tt>int</tt>: Number of frames there is room for in \a band_db
+  * @returns Number of frames in the packet, each
+  *  opus_packet_get_samples_per_frame() long, or @ref opus_errorcodes
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_energy(
+    OpusDecoder *st,
+    const unsigned char *data,
+    int32_t len,
+    int16_t *band_db,
+    int max_frames
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4);
+
 /** Perform a CTL function on an Opus decoder.
   *
   * Generally the request and subsequent arguments are generated
@@ -232,6 +264,15 @@ OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_packet_get_nb_frames(const unsigned
   */
 OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_packet_get_nb_samples(const unsigned char packet[], int32_t len, int32_t Fs) OPUS_ARG_NONNULL(1);
 
+/** Checks whether an Opus packet has LBRR (in-band FEC) data.
+  * @param [in] packet <tt>char*</tt>: Opus packet
+  * @param [in] len <tt>int32_t</tt>: Length of packet
+  * @returns 1 if the packet carries a redundant copy of the previous frame that
+  *          opus_decode() with decode_fec=1 can use, 0 if not
+  * @retval OPUS_INVALID_PACKET The compressed data passed is corrupted or of an unsupported type
+  */
+OPUS_EXPORT int opus_packet_has_lbrr(const unsigned char packet[], int32_t len);
+
 /** Gets the number of samples of an Opus packet.
   * @param [in] dec <tt>OpusDecoder*</tt>: Decoder state
   * @param [in] packet <tt>char*</tt>: Opus packet
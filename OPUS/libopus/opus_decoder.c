@@ -43,6 +43,7 @@
 #include "silk/define.h"
 #include "celt/mathops.h"
 #include "celt/cpu_support.h"
+#include "opus_worker.h"
 
 struct OpusDecoder {
    int          celt_dec_offset;
@@ -51,6 +52,7 @@ struct OpusDecoder {
    int32_t   Fs;          /** Sampling rate (at the API level) */
    silk_DecControlStruct DecControl;
    int          decode_gain;
+   int          hybrid_worker;
    int          arch;
 
    /* Everything beyond this point gets cleared on a reset */
@@ -63,7 +65,12 @@ struct OpusDecoder {
    int          frame_size;
    int          prev_redundancy;
    int          last_packet_duration;
-
+   /* Gain changes glide over OPUS_GAIN_RAMP_MS instead of stepping */
+   int          gain_ramp;
+   opus_val32   gain_applied;
+#ifndef FIXED_POINT
+   opus_val16   softclip_mem[2];
+#endif
 
    uint32_t  rangeFinal;
 };
@@ -71,6 +78,9 @@ struct OpusDecoder {
 
 #define VALIDATE_OPUS_DECODER(st)
 
+/* Length of the glide to a new OPUS_SET_GAIN value */
+#define OPUS_GAIN_RAMP_MS 10
+
 
 int opus_decoder_get_size(int channels)
 {
@@ -190,8 +200,94 @@ static int opus_packet_get_mode(const unsigned char *data)
    return mode;
 }
 
+/* SILK synthesis of a hybrid frame, run by the worker thread while the
+   calling thread decodes CELT. */
+typedef struct {
+   void                  *silk_dec;
+   silk_DecControlStruct *DecControl;
+   int16_t               *pcm;
+   int32_t                frame_size;
+   int                    arch;
+   int32_t                ret;
+} silk_synth_job;
+
+static void silk_synth_job_run(void *arg)
+{
+   silk_synth_job *job = (silk_synth_job*)arg;
+   job->ret = silk_Decode_synth(job->silk_dec, job->DecControl, job->pcm,
+                                &job->frame_size, job->arch);
+}
+
+/* Scales the first ramp samples of each channel from *gain_applied towards
+   gain (both linear, Q16 in fixed point) in equal steps and the rest by
+   gain. Returns how many ramp samples were consumed. */
+static int opus_gain_ramp(opus_val16 *pcm, int frame_size, int channels,
+      opus_val32 *gain_applied, opus_val32 gain, int ramp)
+{
+   int i, c;
+   int n;
+   n = IMIN(frame_size, ramp);
+#ifdef FIXED_POINT
+   {
+      /* Q24 accumulator so that a long ramp still lands on the target */
+      int64_t acc = (int64_t)*gain_applied<<8;
+      int64_t step = (((int64_t)gain<<8)-acc)/ramp;
+      for (i=0;i<frame_size;i++)
+      {
+         opus_val32 g;
+         if (i<n)
+         {
+            acc += step;
+            g = (opus_val32)(acc>>8);
+         } else
+            g = gain;
+         for (c=0;c<channels;c++)
+         {
+            opus_val32 x;
+            x = MULT16_32_P16(pcm[i*channels+c], g);
+            pcm[i*channels+c] = SATURATE(x, 32767);
+         }
+      }
+      *gain_applied = n==ramp ? gain : (opus_val32)(acc>>8);
+   }
+#else
+   {
+      opus_val32 g = *gain_applied;
+      opus_val32 step = (gain-g)/ramp;
+      for (i=0;i<frame_size;i++)
+      {
+         if (i<n)
+            g += step;
+         for (c=0;c<channels;c++)
+            pcm[i*channels+c] *= i<n ? g : gain;
+      }
+      *gain_applied = n==ramp ? gain : g;
+   }
+#endif
+   return n;
+}
+
 static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
-      int32_t len, opus_val16 *pcm, int frame_size, int decode_fec)
+      int32_t len, opus_val16 *pcm, int32_t *pcm32, int frame_size, int decode_fec);
+
+/* The concealment a transition cross-fades from covers the same samples as
+   the frame being decoded, so it must not advance the gain ramp. */
+static void opus_decode_frame_transition(OpusDecoder *st, opus_val16 *pcm,
+      int frame_size)
+{
+   int gain_ramp = st->gain_ramp;
+   opus_val32 gain_applied = st->gain_applied;
+   opus_decode_frame(st, NULL, 0, pcm, NULL, frame_size, 0);
+   st->gain_ramp = gain_ramp;
+   st->gain_applied = gain_applied;
+}
+
+/* Exactly one of pcm and pcm32 is non-NULL. With pcm32, CELT-only frames are
+   written by CELT straight from its synthesis precision; frames that mix in
+   SILK, redundancy or a transition are built in opus_val16 as usual and
+   widened to 32 bits at the end. */
+static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
+      int32_t len, opus_val16 *pcm, int32_t *pcm32, int frame_size, int decode_fec)
 {
    void *silk_dec;
    CELTDecoder *celt_dec;
@@ -207,6 +303,9 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    opus_val16 *pcm_transition=NULL;
    int redundant_audio_size;
    VARDECL(opus_val16, redundant_audio);
+   int pcm16_size;
+   VARDECL(opus_val16, pcm16);
+   int direct32 = 0;
 
    int audiosize;
    int mode;
@@ -221,6 +320,14 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    const opus_val16 *window;
    uint32_t redundant_rng = 0;
    int celt_accum;
+   opus_val32 gain;
+   int32_t gain_q16;
+   int gain_fused = 0;
+   int gain_ramp;
+   int gain_fusable;
+   int silk_split;
+   int silk_job_started = 0;
+   silk_synth_job silk_job;
    ALLOC_STACK;
 
    silk_dec = (char*)st+st->silk_dec_offset;
@@ -258,7 +365,12 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       {
          /* If we haven't got any packet yet, all we can do is return zeros */
          for (i=0;i<audiosize*st->channels;i++)
-            pcm[i] = 0;
+         {
+            if (pcm32)
+               pcm32[i] = 0;
+            else
+               pcm[i] = 0;
+         }
          RESTORE_STACK;
          return audiosize;
       }
@@ -268,13 +380,16 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       if (audiosize > F20)
       {
          do {
-            int ret = opus_decode_frame(st, NULL, 0, pcm, IMIN(audiosize, F20), 0);
+            int ret = opus_decode_frame(st, NULL, 0, pcm, pcm32, IMIN(audiosize, F20), 0);
             if (ret<0)
             {
                RESTORE_STACK;
                return ret;
             }
-            pcm += ret*st->channels;
+            if (pcm32)
+               pcm32 += ret*st->channels;
+            else
+               pcm += ret*st->channels;
             audiosize -= ret;
          } while (audiosize > 0);
          RESTORE_STACK;
@@ -288,10 +403,37 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       }
    }
 
+   /* CELT can apply a steady gain while writing its samples, but reads an
+      output gain of 0 as unity, so ramps and muting are applied here */
+   gain = QCONST32(1.f, 16);
+   gain_q16 = 0;
+   if (st->decode_gain)
+   {
+      gain = celt_exp2(MULT16_16_P15(QCONST16(6.48814081e-4f, 25), st->decode_gain));
+#ifdef FIXED_POINT
+      gain_q16 = gain;
+#else
+      gain_q16 = (int32_t)floor(.5f+65536.f*gain);
+#endif
+   }
+   gain_ramp = st->gain_ramp > 0;
+   gain_fusable = !gain_ramp && (!st->decode_gain || gain_q16 != 0);
+
    /* In fixed-point, we can tell CELT to do the accumulation on top of the
       SILK PCM buffer. This saves some stack space. */
-
+#ifdef FIXED_POINT
    celt_accum = (mode != MODE_CELT_ONLY) && (frame_size >= F10);
+#else
+   celt_accum = 0;
+#endif
+
+   /* With the hybrid worker enabled, SILK only parses its bits up front and
+      synthesizes into pcm_silk on the other core while CELT is decoded. CELT
+      then cannot accumulate on top of the SILK output, so the two are summed
+      afterwards; that sum saturates the same way as celt_accum does. */
+   silk_split = st->hybrid_worker && mode == MODE_HYBRID && data != NULL && !decode_fec;
+   if (silk_split)
+      celt_accum = 0;
 
 
    pcm_transition_silk_size = ALLOC_NONE;
@@ -312,7 +454,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    if (transition && mode == MODE_CELT_ONLY)
    {
       pcm_transition = pcm_transition_celt;
-      opus_decode_frame(st, NULL, 0, pcm_transition, IMIN(F5, audiosize), 0);
+      opus_decode_frame_transition(st, pcm_transition, IMIN(F5, audiosize));
    }
    if (audiosize > frame_size)
    {
@@ -323,6 +465,17 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       frame_size = audiosize;
    }
 
+   pcm16_size = ALLOC_NONE;
+   if (pcm32)
+   {
+      direct32 = mode == MODE_CELT_ONLY && !transition && gain_fusable;
+      if (!direct32)
+         pcm16_size = frame_size*st->channels;
+   }
+   ALLOC(pcm16, pcm16_size, opus_val16);
+   if (pcm32)
+      pcm = pcm16;
+
    /* Don't allocate any memory when in CELT-only mode */
    pcm_silk_size = (mode != MODE_CELT_ONLY && !celt_accum) ? IMAX(F10, frame_size)*st->channels : ALLOC_NONE;
    ALLOC(pcm_silk, pcm_silk_size, int16_t);
@@ -332,9 +485,11 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    {
       int lost_flag, decoded_samples;
       int16_t *pcm_ptr;
+#ifdef FIXED_POINT
       if (celt_accum)
          pcm_ptr = pcm;
       else
+#endif
          pcm_ptr = pcm_silk;
 
       if (st->prev_mode==MODE_CELT_ONLY)
@@ -364,26 +519,40 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
      }
 
      lost_flag = data == NULL ? 1 : 2 * decode_fec;
-     decoded_samples = 0;
-     do {
-        /* Call SILK decoder */
-        int first_frame = decoded_samples == 0;
-        silk_ret = silk_Decode( silk_dec, &st->DecControl,
-                                lost_flag, first_frame, &dec, pcm_ptr, &silk_frame_size, st->arch );
-        if( silk_ret ) {
-           if (lost_flag) {
-              /* PLC failure should not be fatal */
-              silk_frame_size = frame_size;
-              for (i=0;i<frame_size*st->channels;i++)
-                 pcm_ptr[i] = 0;
-           } else {
-             RESTORE_STACK;
-             return OPUS_INTERNAL_ERROR;
-           }
+     if (silk_split)
+     {
+        /* Hybrid frames are 10 or 20 ms, which SILK decodes in one call */
+        if (silk_Decode_parse(silk_dec, &st->DecControl, lost_flag, 1, &dec))
+        {
+           RESTORE_STACK;
+           return OPUS_INTERNAL_ERROR;
         }
-        pcm_ptr += silk_frame_size * st->channels;
-        decoded_samples += silk_frame_size;
-      } while( decoded_samples < frame_size );
+        silk_job.silk_dec = silk_dec;
+        silk_job.DecControl = &st->DecControl;
+        silk_job.pcm = pcm_ptr;
+        silk_job.arch = st->arch;
+     } else {
+        decoded_samples = 0;
+        do {
+           /* Call SILK decoder */
+           int first_frame = decoded_samples == 0;
+           silk_ret = silk_Decode( silk_dec, &st->DecControl,
+                                   lost_flag, first_frame, &dec, pcm_ptr, &silk_frame_size, st->arch );
+           if( silk_ret ) {
+              if (lost_flag) {
+                 /* PLC failure should not be fatal */
+                 silk_frame_size = frame_size;
+                 for (i=0;i<frame_size*st->channels;i++)
+                    pcm_ptr[i] = 0;
+              } else {
+                RESTORE_STACK;
+                return OPUS_INTERNAL_ERROR;
+              }
+           }
+           pcm_ptr += silk_frame_size * st->channels;
+           decoded_samples += silk_frame_size;
+         } while( decoded_samples < frame_size );
+     }
    }
 
    start_band = 0;
@@ -430,7 +599,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    if (transition && mode != MODE_CELT_ONLY)
    {
       pcm_transition = pcm_transition_silk;
-      opus_decode_frame(st, NULL, 0, pcm_transition, IMIN(F5, audiosize), 0);
+      opus_decode_frame_transition(st, pcm_transition, IMIN(F5, audiosize));
    }
 
 
@@ -465,6 +634,12 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    redundant_audio_size = redundancy ? F5*st->channels : ALLOC_NONE;
    ALLOC(redundant_audio, redundant_audio_size, opus_val16);
 
+   /* When the CELT output is the final output (no SILK to add and no
+      transition to cross-fade), CELT applies the decoder gain while writing
+      its samples instead of us making another pass over pcm. */
+   gain_fused = st->decode_gain && mode == MODE_CELT_ONLY && !transition && gain_fusable;
+   MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_OUTPUT_GAIN(gain_fused ? gain_q16 : 0)));
+
    /* 5 ms redundant frame for CELT->SILK*/
    if (redundancy && celt_to_silk)
    {
@@ -483,9 +658,29 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       /* Make sure to discard any previous CELT state */
       if (mode != st->prev_mode && st->prev_mode > 0 && !st->prev_redundancy)
          MUST_SUCCEED(celt_decoder_ctl(celt_dec, OPUS_RESET_STATE));
+      /* No early return from here until the SILK job has been joined */
+      if (silk_split)
+         silk_job_started = opus_worker_start(silk_synth_job_run, &silk_job) == 0;
       /* Decode CELT */
-      celt_ret = celt_decode_with_ec(celt_dec, decode_fec ? NULL : data,
-                                     len, pcm, celt_frame_size, &dec, celt_accum);
+      if (direct32)
+         celt_ret = celt_decode_with_ec_s32(celt_dec, decode_fec ? NULL : data,
+                                            len, pcm32, celt_frame_size, &dec);
+      else
+         celt_ret = celt_decode_with_ec(celt_dec, decode_fec ? NULL : data,
+                                        len, pcm, celt_frame_size, &dec, celt_accum);
+      if (silk_split)
+      {
+         if (silk_job_started)
+            opus_worker_join();
+         else
+            silk_synth_job_run(&silk_job);
+         celt_assert(silk_job.ret || silk_job.frame_size == frame_size);
+         if (silk_job.ret)
+         {
+            RESTORE_STACK;
+            return OPUS_INTERNAL_ERROR;
+         }
+      }
    } else {
       unsigned char silence[2] = {0xFF, 0xFF};
       if (!celt_accum)
@@ -505,7 +700,11 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    if (mode != MODE_CELT_ONLY && !celt_accum)
    {
       for (i=0;i<frame_size*st->channels;i++)
+#ifdef FIXED_POINT
          pcm[i] = SAT16(ADD32(pcm[i], pcm_silk[i]));
+#else
+         pcm[i] = pcm[i] + (opus_val16)((1.f/32768.f)*pcm_silk[i]);
+#endif
    }
 
    {
@@ -556,10 +755,12 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       }
    }
 
-   if(st->decode_gain)
+   if (gain_ramp)
+   {
+      st->gain_ramp -= opus_gain_ramp(pcm, frame_size, st->channels,
+                                      &st->gain_applied, gain, st->gain_ramp);
+   } else if(st->decode_gain && !gain_fused)
    {
-      opus_val32 gain;
-      gain = celt_exp2(MULT16_16_P15(QCONST16(6.48814081e-4f, 25), st->decode_gain));
       for (i=0;i<frame_size*st->channels;i++)
       {
          opus_val32 x;
@@ -568,15 +769,27 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       }
    }
 
+   if (pcm32 && !direct32)
+   {
+      for (i=0;i<audiosize*st->channels;i++)
+#ifdef FIXED_POINT
+         pcm32[i] = SHL32(EXTEND32(pcm[i]), 16);
+#else
+         pcm32[i] = FLOAT2INT32(pcm[i]);
+#endif
+   }
+
    if (len <= 1)
       st->rangeFinal = 0;
    else
       st->rangeFinal = dec.rng ^ redundant_rng;
 
+   if (!gain_ramp)
+      st->gain_applied = gain;
    st->prev_mode = mode;
    st->prev_redundancy = redundancy && !celt_to_silk;
 
-   if (celt_ret>=0)
+   if (celt_ret>=0 && !direct32)
    {
       if (OPUS_CHECK_ARRAY(pcm, audiosize*st->channels))
          OPUS_PRINT_INT(audiosize);
@@ -587,8 +800,9 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
 
 }
 
-int opus_decode_native(OpusDecoder *st, const unsigned char *data,
-      int32_t len, opus_val16 *pcm, int frame_size, int decode_fec,
+/* Output goes to pcm, or to pcm32 as 32-bit samples when pcm is NULL. */
+static int opus_decode_native_impl(OpusDecoder *st, const unsigned char *data,
+      int32_t len, opus_val16 *pcm, int32_t *pcm32, int frame_size, int decode_fec,
       int self_delimited, int32_t *packet_offset, int soft_clip)
 {
 //   log_i("len %i frame_size %i decode_fec %i self_delimited %i, packet_offset %i", len, frame_size, decode_fec, self_delimited, *packet_offset);
@@ -612,7 +826,8 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       int pcm_count=0;
       do {
          int ret;
-         ret = opus_decode_frame(st, NULL, 0, pcm+pcm_count*st->channels, frame_size-pcm_count, 0);
+         ret = opus_decode_frame(st, NULL, 0, pcm ? pcm+pcm_count*st->channels : NULL,
+               pcm32 ? pcm32+pcm_count*st->channels : NULL, frame_size-pcm_count, 0);
          if (ret<0){
             log_i("ret %i", ret);
             return ret;
@@ -620,7 +835,7 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
          pcm_count += ret;
       } while (pcm_count < frame_size);
       celt_assert(pcm_count == frame_size);
-      if (OPUS_CHECK_ARRAY(pcm, pcm_count*st->channels))
+      if (pcm && OPUS_CHECK_ARRAY(pcm, pcm_count*st->channels))
          OPUS_PRINT_INT(pcm_count);
       st->last_packet_duration = pcm_count;
       log_i("pcm_count %i", pcm_count);
@@ -648,7 +863,7 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       int ret;
       /* If no FEC can be present, run the PLC (recursive call) */
       if (frame_size < packet_frame_size || packet_mode == MODE_CELT_ONLY || st->mode == MODE_CELT_ONLY){
-          ret = opus_decode_native(st, NULL, 0, pcm, frame_size, 0, 0, NULL, soft_clip);
+          ret = opus_decode_native_impl(st, NULL, 0, pcm, pcm32, frame_size, 0, 0, NULL, soft_clip);
           log_i("ret %i", ret);
           return ret;
       }
@@ -656,7 +871,8 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       duration_copy = st->last_packet_duration;
       if (frame_size-packet_frame_size!=0)
       {
-         ret = opus_decode_native(st, NULL, 0, pcm, frame_size-packet_frame_size, 0, 0, NULL, soft_clip);
+         ret = opus_decode_native_impl(st, NULL, 0, pcm, pcm32, frame_size-packet_frame_size, 0, 0, NULL,
+               soft_clip);
          if (ret<0)
          {
             st->last_packet_duration = duration_copy;
@@ -670,15 +886,15 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       st->bandwidth = packet_bandwidth;
       st->frame_size = packet_frame_size;
       st->stream_channels = packet_stream_channels;
-      ret = opus_decode_frame(st, data, size[0], pcm+st->channels*(frame_size-packet_frame_size),
-            packet_frame_size, 1);
+      ret = opus_decode_frame(st, data, size[0], pcm ? pcm+st->channels*(frame_size-packet_frame_size) : NULL,
+            pcm32 ? pcm32+st->channels*(frame_size-packet_frame_size) : NULL, packet_frame_size, 1);
       if (ret<0){
           log_i("ret %i", ret);
           return ret;
       }
 
       else {
-         if (OPUS_CHECK_ARRAY(pcm, frame_size*st->channels))
+         if (pcm && OPUS_CHECK_ARRAY(pcm, frame_size*st->channels))
             OPUS_PRINT_INT(frame_size);
          st->last_packet_duration = frame_size;
          log_i("frame_size %i", frame_size);
@@ -703,7 +919,8 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
    for (i=0;i<count;i++)
    {
       int ret;
-      ret = opus_decode_frame(st, data, size[i], pcm+nb_samples*st->channels, frame_size-nb_samples, 0);
+      ret = opus_decode_frame(st, data, size[i], pcm ? pcm+nb_samples*st->channels : NULL,
+            pcm32 ? pcm32+nb_samples*st->channels : NULL, frame_size-nb_samples, 0);
       if (ret<0){
           log_i("ret %i", ret);
           return ret;
@@ -714,12 +931,36 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       nb_samples += ret;
    }
    st->last_packet_duration = nb_samples;
-   if (OPUS_CHECK_ARRAY(pcm, nb_samples*st->channels))
+   if (pcm && OPUS_CHECK_ARRAY(pcm, nb_samples*st->channels))
       OPUS_PRINT_INT(nb_samples);
+#ifndef FIXED_POINT
+   if (soft_clip && pcm)
+      opus_pcm_soft_clip(pcm, nb_samples, st->channels, st->softclip_mem);
+   else
+      st->softclip_mem[0]=st->softclip_mem[1]=0;
+#endif
 //   log_i("len %i, nb_samples %i", len, nb_samples);
    return nb_samples;
 }
 
+int opus_decode_native(OpusDecoder *st, const unsigned char *data,
+      int32_t len, opus_val16 *pcm, int frame_size, int decode_fec,
+      int self_delimited, int32_t *packet_offset, int soft_clip)
+{
+   return opus_decode_native_impl(st, data, len, pcm, NULL, frame_size, decode_fec,
+         self_delimited, packet_offset, soft_clip);
+}
+
+int opus_decode_native_s32(OpusDecoder *st, const unsigned char *data,
+      int32_t len, int32_t *pcm, int frame_size, int decode_fec,
+      int self_delimited, int32_t *packet_offset)
+{
+   return opus_decode_native_impl(st, data, len, NULL, pcm, frame_size, decode_fec,
+         self_delimited, packet_offset, 0);
+}
+
+
+#ifdef FIXED_POINT
 
 int opus_decode(OpusDecoder *st, const unsigned char *data,
       int32_t len, opus_val16 *pcm, int frame_size, int decode_fec)
@@ -730,7 +971,348 @@ int opus_decode(OpusDecoder *st, const unsigned char *data,
    return opus_decode_native(st, data, len, pcm, frame_size, decode_fec, 0, NULL, 0);
 }
 
+int opus_decode_float(OpusDecoder *st, const unsigned char *data,
+      int32_t len, float *pcm, int frame_size, int decode_fec)
+{
+   VARDECL(int16_t, out);
+   int ret, i;
+   int nb_samples;
+   ALLOC_STACK;
+
+   if(frame_size<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   if (data != NULL && len > 0 && !decode_fec)
+   {
+      nb_samples = opus_decoder_get_nb_samples(st, data, len);
+      if (nb_samples>0)
+         frame_size = IMIN(frame_size, nb_samples);
+      else
+      {
+         RESTORE_STACK;
+         return OPUS_INVALID_PACKET;
+      }
+   }
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out, frame_size*st->channels, int16_t);
+
+   ret = opus_decode_native(st, data, len, out, frame_size, decode_fec, 0, NULL, 0);
+   if (ret > 0)
+   {
+      for (i=0;i<ret*st->channels;i++)
+         pcm[i] = (1.f/32768.f)*(out[i]);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+
+#else
+
+int opus_decode(OpusDecoder *st, const unsigned char *data,
+      int32_t len, int16_t *pcm, int frame_size, int decode_fec)
+{
+   VARDECL(float, out);
+   int ret, i;
+   int nb_samples;
+   ALLOC_STACK;
+
+   if(frame_size<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+
+   if (data != NULL && len > 0 && !decode_fec)
+   {
+      nb_samples = opus_decoder_get_nb_samples(st, data, len);
+      if (nb_samples>0)
+         frame_size = IMIN(frame_size, nb_samples);
+      else
+      {
+         RESTORE_STACK;
+         return OPUS_INVALID_PACKET;
+      }
+   }
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out, frame_size*st->channels, float);
+
+   ret = opus_decode_native(st, data, len, out, frame_size, decode_fec, 0, NULL, 1);
+   if (ret > 0)
+   {
+      for (i=0;i<ret*st->channels;i++)
+         pcm[i] = FLOAT2INT16(out[i]);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+
+int opus_decode_float(OpusDecoder *st, const unsigned char *data,
+      int32_t len, opus_val16 *pcm, int frame_size, int decode_fec)
+{
+   if(frame_size<=0)
+      return OPUS_BAD_ARG;
+   return opus_decode_native(st, data, len, pcm, frame_size, decode_fec, 0, NULL, 0);
+}
+
+#endif
+
+
+
+/* Edges of the CELT bands in Hz. SILK levels are estimated for the same
+   bands, so that every frame is reported on one scale. */
+static const int32_t energy_band_Hz[OPUS_ENERGY_BANDS+1] = {
+      0,   200,   400,   600,   800,  1000,  1200,  1400,  1600,  2000,  2400,
+   2800,  3200,  4000,  4800,  5600,  6800,  8000,  9600, 12000, 15600, 20000
+};
+
+/* The CELT band energies are those of the pre-emphasized signal. This is
+   the mean power gain of the de-emphasis filter over each band, in
+   128*log2 units. */
+static const int16_t energy_deemph_Q7[OPUS_ENERGY_BANDS] = {
+   699, 690, 673, 650, 623, 594, 565, 535, 493, 440, 392,
+   349, 292, 226, 170, 111,  52,  -4, -68, -136, -194
+};
+
+/* Converts a CELT log2 band amplitude to the power of the decoded signal in
+   that band, in 128*log2 units of squared 16-bit samples. */
+#ifdef FIXED_POINT
+#define CELT_ENERGY_Q7(x, band) (SHR32((opus_val32)(x), DB_SHIFT-8) \
+      + energy_deemph_Q7[band] + OPUS_ENERGY_CELT_OFFSET_Q7)
+#else
+#define CELT_ENERGY_Q7(x, band) ((int32_t)floor(.5f+256.f*(x)) \
+      + energy_deemph_Q7[band] + OPUS_ENERGY_CELT_OFFSET_Q7)
+#endif
+/* Scaling of the MDCT, measured against the power of decoded frames */
+#define OPUS_ENERGY_CELT_OFFSET_Q7 (-128)
+
+/* Level scan of one frame, following opus_decode_frame() through all the
+   mode switches and redundant frames so the CELT and SILK states stay in
+   step with the bitstream. level_Q7 gets OPUS_ENERGY_BANDS values. */
+static int opus_decode_energy_frame(OpusDecoder *st, const unsigned char *data,
+      int32_t len, int32_t *level_Q7)
+{
+   void *silk_dec;
+   CELTDecoder *celt_dec;
+   ec_dec dec;
+   int i, c;
+   int audiosize;
+   int mode;
+   int bandwidth;
+   int start_band;
+   int redundancy=0;
+   int redundancy_bytes=0;
+   int celt_to_silk=0;
+   int F2_5, F5, F20;
+   int endband;
+   opus_val16 bandLogE[2*OPUS_ENERGY_BANDS];
+
+   silk_dec = (char*)st+st->silk_dec_offset;
+   celt_dec = (CELTDecoder*)((char*)st+st->celt_dec_offset);
+   F20 = st->Fs/50;
+   F5 = F20>>2;
+   F2_5 = F5>>1;
+   audiosize = st->frame_size;
+   mode = st->mode;
+   bandwidth = st->bandwidth;
+
+   for (i=0;i<OPUS_ENERGY_BANDS;i++)
+      level_Q7[i] = SILK_LEVEL_FLOOR_Q7;
+   /* DTX and empty frames carry no energies; the state is left as is */
+   if (len<=1)
+      return audiosize;
+   ec_dec_init(&dec,(unsigned char*)data,len);
+
+   if (mode != MODE_CELT_ONLY)
+   {
+      int32_t silk_Q7[OPUS_ENERGY_BANDS];
+      int nb_silk, nb_frames;
+
+      if (st->prev_mode==MODE_CELT_ONLY)
+         silk_InitDecoder( silk_dec );
+      st->DecControl.payloadSize_ms = IMAX(10, 1000 * audiosize / st->Fs);
+      st->DecControl.nChannelsInternal = st->stream_channels;
+      if (mode == MODE_SILK_ONLY && bandwidth == OPUS_BANDWIDTH_NARROWBAND)
+         st->DecControl.internalSampleRate = 8000;
+      else if (mode == MODE_SILK_ONLY && bandwidth == OPUS_BANDWIDTH_MEDIUMBAND)
+         st->DecControl.internalSampleRate = 12000;
+      else
+         st->DecControl.internalSampleRate = 16000;
+      /* SILK reaches 8 kHz at most, which is where the hybrid CELT layer starts */
+      nb_silk = 17;
+      nb_frames = IMAX(1, audiosize/F20);
+      for (i=0;i<nb_frames;i++)
+      {
+         if (silk_Decode_level(silk_dec, &st->DecControl, i==0, &dec,
+               energy_band_Hz, nb_silk, i==0 ? level_Q7 : silk_Q7))
+            return OPUS_INTERNAL_ERROR;
+         if (i>0)
+         {
+            for (c=0;c<nb_silk;c++)
+               level_Q7[c] = silk_log2_add_Q7(level_Q7[c], silk_Q7[c]);
+         }
+      }
+      for (c=0;c<nb_silk;c++)
+         level_Q7[c] -= silk_lin2log(nb_frames);
+   }
+
+   if (mode != MODE_CELT_ONLY && ec_tell(&dec)+17+20*(mode == MODE_HYBRID) <= 8*len)
+   {
+      if (mode == MODE_HYBRID)
+         redundancy = ec_dec_bit_logp(&dec, 12);
+      else
+         redundancy = 1;
+      if (redundancy)
+      {
+         celt_to_silk = ec_dec_bit_logp(&dec, 1);
+         redundancy_bytes = mode==MODE_HYBRID ?
+               (int32_t)ec_dec_uint(&dec, 256)+2 :
+               len-((ec_tell(&dec)+7)>>3);
+         len -= redundancy_bytes;
+         if (len*8 < ec_tell(&dec))
+         {
+            len = 0;
+            redundancy_bytes = 0;
+            redundancy = 0;
+         }
+         dec.storage -= redundancy_bytes;
+      }
+   }
+   start_band = mode != MODE_CELT_ONLY ? 17 : 0;
+
+   switch(bandwidth)
+   {
+   case OPUS_BANDWIDTH_NARROWBAND:
+      endband = 13;
+      break;
+   case OPUS_BANDWIDTH_MEDIUMBAND:
+   case OPUS_BANDWIDTH_WIDEBAND:
+      endband = 17;
+      break;
+   case OPUS_BANDWIDTH_SUPERWIDEBAND:
+      endband = 19;
+      break;
+   default:
+      endband = 21;
+      break;
+   }
+   MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_END_BAND(endband)));
+   MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_CHANNELS(st->stream_channels)));
+
+   /* The redundant frames only matter for the energy prediction state */
+   if (redundancy && celt_to_silk)
+   {
+      MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_START_BAND(0)));
+      celt_decode_energy(celt_dec, data+len, redundancy_bytes, F5, NULL, bandLogE);
+   }
+   MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_START_BAND(start_band)));
+
+   if (mode != MODE_SILK_ONLY)
+   {
+      int ret;
+      if (mode != st->prev_mode && st->prev_mode > 0 && !st->prev_redundancy)
+         MUST_SUCCEED(celt_decoder_ctl(celt_dec, OPUS_RESET_STATE));
+      ret = celt_decode_energy(celt_dec, data, len, IMIN(F20, audiosize), &dec, bandLogE);
+      if (ret<0)
+         return ret;
+      for (i=start_band;i<endband;i++)
+      {
+         level_Q7[i] = CELT_ENERGY_Q7(bandLogE[i], i);
+         /* Mean power over the two channels */
+         if (st->stream_channels==2)
+            level_Q7[i] = silk_log2_add_Q7(level_Q7[i],
+                  CELT_ENERGY_Q7(bandLogE[OPUS_ENERGY_BANDS+i], i)) - 128;
+      }
+   } else if (st->prev_mode == MODE_HYBRID && !(redundancy && celt_to_silk && st->prev_redundancy))
+   {
+      static const unsigned char silence[2] = {0xFF, 0xFF};
+      MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_START_BAND(0)));
+      celt_decode_energy(celt_dec, silence, 2, F2_5, NULL, bandLogE);
+   }
+
+   if (redundancy && !celt_to_silk)
+   {
+      MUST_SUCCEED(celt_decoder_ctl(celt_dec, OPUS_RESET_STATE));
+      MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_START_BAND(0)));
+      celt_decode_energy(celt_dec, data+len, redundancy_bytes, F5, NULL, bandLogE);
+   }
+   st->prev_mode = mode;
+   st->prev_redundancy = redundancy && !celt_to_silk;
+   return audiosize;
+}
+
+int opus_decode_energy_native(OpusDecoder *st, const unsigned char *data,
+      int32_t len, int32_t *level_Q7, int max_frames, int self_delimited,
+      int32_t *packet_offset)
+{
+   int i, count, offset;
+   unsigned char toc;
+   int16_t size[48];
+   VALIDATE_OPUS_DECODER(st);
+   if (data==NULL || len<=0)
+      return OPUS_BAD_ARG;
+   count = opus_packet_parse_impl(data, len, self_delimited, &toc, NULL,
+                                  size, &offset, packet_offset);
+   if (count<0)
+      return count;
+   if (count > max_frames)
+      return OPUS_BUFFER_TOO_SMALL;
 
+   st->mode = opus_packet_get_mode(data);
+   st->bandwidth = opus_packet_get_bandwidth(data);
+   st->frame_size = opus_packet_get_samples_per_frame(data, st->Fs);
+   st->stream_channels = opus_packet_get_nb_channels(data);
+   data += offset;
+
+   for (i=0;i<count;i++)
+   {
+      int ret;
+      ret = opus_decode_energy_frame(st, data, size[i], level_Q7+i*OPUS_ENERGY_BANDS);
+      if (ret<0)
+         return ret;
+      data += size[i];
+   }
+   st->last_packet_duration = count*st->frame_size;
+   return count;
+}
+
+void opus_energy_to_db(const int32_t *level_Q7, int16_t *band_db, int n)
+{
+   int i;
+   for (i=0;i<n;i++)
+   {
+      /* 0 dB is a full-scale square wave: 2^30 squared 16-bit samples.
+         10*log10(2) dB per unit of log2, in Q8 and Q12. */
+      int32_t x = IMAX(level_Q7[i] - 30*128, -(32768<<12)/24660);
+      band_db[i] = (int16_t)IMAX(-32768, IMIN(32767, (x*24660) >> 12));
+   }
+}
+
+int opus_decode_energy(OpusDecoder *st, const unsigned char *data,
+      int32_t len, int16_t *band_db, int max_frames)
+{
+   int ret;
+   VARDECL(int32_t, level_Q7);
+   ALLOC_STACK;
+   if (data==NULL || len<=0 || max_frames<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   ret = opus_packet_get_nb_frames(data, len);
+   if (ret<0)
+   {
+      RESTORE_STACK;
+      return ret;
+   }
+   ALLOC(level_Q7, IMIN(ret, max_frames)*OPUS_ENERGY_BANDS, int32_t);
+   ret = opus_decode_energy_native(st, data, len, level_Q7, max_frames, 0, NULL);
+   if (ret>0)
+      opus_energy_to_db(level_Q7, band_db, ret*OPUS_ENERGY_BANDS);
+   RESTORE_STACK;
+   return ret;
+}
 
 int opus_decoder_ctl(OpusDecoder *st, int request, ...)
 {
@@ -819,6 +1401,10 @@ int opus_decoder_ctl(OpusDecoder *st, int request, ...)
        {
           goto bad_arg;
        }
+       /* Once audio has gone out, glide to the new gain rather than
+          stepping to it */
+       if (value != st->decode_gain && st->prev_mode > 0)
+          st->gain_ramp = st->Fs/1000*OPUS_GAIN_RAMP_MS;
        st->decode_gain = value;
    }
    break;
@@ -832,6 +1418,31 @@ int opus_decoder_ctl(OpusDecoder *st, int request, ...)
       *value = st->last_packet_duration;
    }
    break;
+   case OPUS_SET_HYBRID_WORKER_REQUEST:
+   {
+       int32_t value = va_arg(ap, int32_t);
+       if (value<0 || value>1)
+       {
+          goto bad_arg;
+       }
+       if (value && opus_worker_init() != 0)
+       {
+          ret = OPUS_UNIMPLEMENTED;
+          break;
+       }
+       st->hybrid_worker = value;
+   }
+   break;
+   case OPUS_GET_HYBRID_WORKER_REQUEST:
+   {
+      int32_t *value = va_arg(ap, int32_t*);
+      if (!value)
+      {
+         goto bad_arg;
+      }
+      *value = st->hybrid_worker;
+   }
+   break;
    case OPUS_SET_PHASE_INVERSION_DISABLED_REQUEST:
    {
        int32_t value = va_arg(ap, int32_t);
@@ -927,6 +1538,36 @@ int opus_packet_get_nb_samples(const unsigned char packet[], int32_t len,
       return samples;
 }
 
+int opus_packet_has_lbrr(const unsigned char packet[], int32_t len)
+{
+   int ret;
+   const unsigned char *frames[48];
+   int16_t size[48];
+   int packet_mode, packet_frame_size, packet_stream_channels;
+   int nb_frames=1;
+   int lbrr;
+
+   packet_mode = opus_packet_get_mode(packet);
+   if (packet_mode == MODE_CELT_ONLY)
+      return 0;
+   packet_frame_size = opus_packet_get_samples_per_frame(packet, 48000);
+   if (packet_frame_size > 960)
+      nb_frames = packet_frame_size/960;
+   packet_stream_channels = opus_packet_get_nb_channels(packet);
+   ret = opus_packet_parse(packet, len, NULL, frames, size, NULL);
+   if (ret <= 0)
+      return ret;
+   if (size[0] == 0)
+      return 0;
+   /* The SILK header starts with the VAD flags and the LBRR flag of the mid
+      channel (then the side channel), each coded with a probability of 1/2,
+      so they are the top bits of the first byte. */
+   lbrr = (frames[0][0] >> (7-nb_frames)) & 0x1;
+   if (packet_stream_channels == 2)
+      lbrr = lbrr || ((frames[0][0] >> (6-2*nb_frames)) & 0x1);
+   return lbrr;
+}
+
 int opus_decoder_get_nb_samples(const OpusDecoder *dec,
       const unsigned char packet[], int32_t len)
 {
@@ -124,6 +124,8 @@ extern "C" {
 #define OPUS_SET_PHASE_INVERSION_DISABLED_REQUEST 4046
 #define OPUS_GET_PHASE_INVERSION_DISABLED_REQUEST 4047
 #define OPUS_GET_IN_DTX_REQUEST              4049
+#define OPUS_SET_HYBRID_WORKER_REQUEST       4050
+#define OPUS_GET_HYBRID_WORKER_REQUEST       4051
 
 /** Defines for the presence of extended APIs. */
 #define OPUS_HAVE_OPUS_PROJECTION_H
@@ -723,6 +725,30 @@ extern "C" {
   * @hideinitializer */
 #define OPUS_GET_PITCH(x) OPUS_GET_PITCH_REQUEST, __opus_check_int_ptr(x)
 
+/** Configures parallel decoding of hybrid packets.
+  * When enabled, the SILK half of a hybrid (SILK+CELT) frame is synthesized
+  * on a helper thread (a FreeRTOS task on the other core on the ESP32)
+  * while the calling thread decodes the CELT half. The output is identical
+  * either way. If the helper is busy with another decoder's frame the work
+  * is done on the calling thread.
+  * This setting survives decoder reset.
+  * @param[in] x <tt>int32_t</tt>: Allowed values:
+  * <dl>
+  * <dt>0</dt><dd>Decode on the calling thread only (default).</dd>
+  * <dt>1</dt><dd>Use the helper thread for hybrid frames.</dd>
+  * </dl>
+  * Returns OPUS_UNIMPLEMENTED if the platform has no thread support.
+  * @hideinitializer */
+#define OPUS_SET_HYBRID_WORKER(x) OPUS_SET_HYBRID_WORKER_REQUEST, __opus_check_int(x)
+/** Gets the decoder's hybrid worker setting. @see OPUS_SET_HYBRID_WORKER
+  * @param[out] x <tt>int32_t *</tt>: Returns one of the following values:
+  * <dl>
+  * <dt>0</dt><dd>Decode on the calling thread only (default).</dd>
+  * <dt>1</dt><dd>Use the helper thread for hybrid frames.</dd>
+  * </dl>
+  * @hideinitializer */
+#define OPUS_GET_HYBRID_WORKER(x) OPUS_GET_HYBRID_WORKER_REQUEST, __opus_check_int_ptr(x)
+
 /**@}*/
 
 /** @defgroup opus_libinfo Opus library information functions
@@ -629,6 +629,46 @@ OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_multistream_decode_float(
     int decode_fec
 ) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4);
 
+/** Decode a multistream Opus packet to left-justified 32-bit samples.
+  * Full scale is [-2^31, 2^31-1]; rounded to 16 bits the output matches
+  * opus_multistream_decode(). CELT-only frames of a single-stream layout keep
+  * the decoder's internal precision in the low bits, and any #OPUS_SET_GAIN
+  * is applied before saturation rather than after.
+  * Parameters are as for opus_multistream_decode().
+  * @returns Number of samples decoded on success or a negative error code
+  *          (see @ref opus_errorcodes) on failure.
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_multistream_decode_s32(
+    OpusMSDecoder *st,
+    const unsigned char *data,
+    int32_t len,
+    int32_t *pcm,
+    int frame_size,
+    int decode_fec
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4);
+
+/** Scan a multistream Opus packet for its band levels without decoding the
+  * audio. This is the multistream counterpart of opus_decode_energy(): the
+  * levels are the mean power over all the coded channels.
+  * Reset the decoder with #OPUS_RESET_STATE before decoding audio again.
+  * @param st <tt>OpusMSDecoder*</tt>: Multistream decoder state.
+  * @param[in] data <tt>const unsigned char*</tt>: Input payload.
+  * @param len <tt>int32_t</tt>: Number of bytes in payload.
+  * @param[out] band_db <tt>opus_int16*</tt>: #OPUS_ENERGY_BANDS levels in
+  *                                           dB (Q8) for each frame.
+  * @param max_frames <tt>int</tt>: Number of frames there is room for in
+  *                                 \a band_db.
+  * @returns Number of frames scanned on success or a negative error code
+  *          (see @ref opus_errorcodes) on failure.
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_multistream_decode_energy(
+    OpusMSDecoder *st,
+    const unsigned char *data,
+    int32_t len,
+    int16_t *band_db,
+    int max_frames
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4);
+
 /** Perform a CTL function on a multistream Opus decoder.
   *
   * Generally the request and subsequent arguments are generated by a
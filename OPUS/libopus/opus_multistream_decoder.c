@@ -36,6 +36,7 @@
 #include <stdarg.h>
 #include "celt/float_cast.h"
 #include "celt/os_support.h"
+#include "silk/SigProc_FIX.h"
 
 /* DECODER */
 
@@ -175,6 +176,60 @@ static int opus_multistream_packet_validate(const unsigned char *data,
    return samples;
 }
 
+static void opus_copy_channel_out_short(
+  void *dst,
+  int dst_stride,
+  int dst_channel,
+  const opus_val16 *src,
+  int src_stride,
+  int frame_size,
+  void *user_data
+);
+
+static void opus_copy_channel_out_float(
+  void *dst,
+  int dst_stride,
+  int dst_channel,
+  const opus_val16 *src,
+  int src_stride,
+  int frame_size,
+  void *user_data
+);
+
+static void opus_copy_channel_out_s32(
+  void *dst,
+  int dst_stride,
+  int dst_channel,
+  const opus_val16 *src,
+  int src_stride,
+  int frame_size,
+  void *user_data
+);
+
+/* True when the single stream already produces the output layout, so it can
+   be decoded straight into the caller's interleaved buffer. */
+static int opus_multistream_is_direct(const ChannelLayout *layout)
+{
+   int c;
+   if (layout->nb_streams != 1 || layout->nb_channels != layout->nb_coupled_streams+1)
+      return 0;
+   for (c=0;c<layout->nb_channels;c++)
+      if (layout->mapping[c] != c)
+         return 0;
+   return 1;
+}
+
+/* True when at least one output channel is taken from stream s. A layout that
+   selects a subset of the channels (opusfile's op_set_channel_layout()) can
+   leave whole streams unused. */
+static int opus_multistream_stream_used(const ChannelLayout *layout, int s)
+{
+   if (s < layout->nb_coupled_streams)
+      return get_left_channel(layout, s, -1) != -1
+            || get_right_channel(layout, s, -1) != -1;
+   return get_mono_channel(layout, s, -1) != -1;
+}
+
 int opus_multistream_decode_native(
       OpusMSDecoder *st,
       const unsigned char *data,
@@ -194,6 +249,10 @@ int opus_multistream_decode_native(
    int s, c;
    char *ptr;
    int do_plc=0;
+   int direct;
+   int direct32;
+   int nb_samples=0;
+   int decoded=0;
    VARDECL(opus_val16, buf);
    ALLOC_STACK;
 
@@ -206,7 +265,17 @@ int opus_multistream_decode_native(
    /* Limit frame_size to avoid excessive stack allocations. */
    MUST_SUCCEED(opus_multistream_decoder_ctl(st, OPUS_GET_SAMPLE_RATE(&Fs)));
    frame_size = IMIN(frame_size, Fs/25*3);
-   ALLOC(buf, 2*frame_size, opus_val16);
+   /* 32-bit output of a direct layout comes from the decoder itself, at CELT's
+      synthesis precision rather than widened from 16 bits. */
+   direct32 = copy_channel_out == opus_copy_channel_out_s32;
+#ifdef FIXED_POINT
+   direct = (copy_channel_out == opus_copy_channel_out_short || direct32)
+         && opus_multistream_is_direct(&st->layout);
+#else
+   direct = (copy_channel_out == opus_copy_channel_out_float || direct32)
+         && opus_multistream_is_direct(&st->layout);
+#endif
+   ALLOC(buf, direct ? ALLOC_NONE : 2*frame_size, opus_val16);
    ptr = (char*)st + align(sizeof(OpusMSDecoder));
    coupled_size = opus_decoder_get_size(2);
    mono_size = opus_decoder_get_size(1);
@@ -235,6 +304,7 @@ int opus_multistream_decode_native(
          RESTORE_STACK;
          return OPUS_BUFFER_TOO_SMALL;
       }
+      nb_samples = ret;
    }
    for (s=0;s<st->layout.nb_streams;s++)
    {
@@ -251,7 +321,33 @@ int opus_multistream_decode_native(
          return OPUS_INTERNAL_ERROR;
       }
       packet_offset = 0;
-      ret = opus_decode_native(dec, data, len, buf, frame_size, decode_fec, s!=st->layout.nb_streams-1, &packet_offset, soft_clip);
+      if (!direct && !opus_multistream_stream_used(&st->layout, s))
+      {
+         /* Nothing would be copied out: only step over its sub-packet. The
+            layout is fixed for the life of the decoder, so the skipped
+            decoder's state is never needed. */
+         if (!do_plc)
+         {
+            unsigned char toc;
+            int16_t size[48];
+            ret = opus_packet_parse_impl(data, len, s!=st->layout.nb_streams-1,
+                  &toc, NULL, size, NULL, &packet_offset);
+            if (ret < 0)
+            {
+               RESTORE_STACK;
+               return ret;
+            }
+            data += packet_offset;
+            len -= packet_offset;
+         }
+         continue;
+      }
+      if (direct && direct32)
+         ret = opus_decode_native_s32(dec, data, len, (int32_t*)pcm,
+               frame_size, decode_fec, s!=st->layout.nb_streams-1, &packet_offset);
+      else
+         ret = opus_decode_native(dec, data, len, direct ? (opus_val16*)pcm : buf,
+               frame_size, decode_fec, s!=st->layout.nb_streams-1, &packet_offset, soft_clip);
       data += packet_offset;
       len -= packet_offset;
       if (ret <= 0)
@@ -260,6 +356,9 @@ int opus_multistream_decode_native(
          return ret;
       }
       frame_size = ret;
+      decoded = 1;
+      if (direct)
+         break;
       if (s < st->layout.nb_coupled_streams)
       {
          int chan, prev;
@@ -291,6 +390,8 @@ int opus_multistream_decode_native(
          }
       }
    }
+   if (!decoded && !do_plc)
+      frame_size = nb_samples;
    /* Handle muted channels */
    for (c=0;c<st->layout.nb_channels;c++)
    {
@@ -304,6 +405,36 @@ int opus_multistream_decode_native(
    return frame_size;
 }
 
+static void opus_copy_channel_out_float(
+  void *dst,
+  int dst_stride,
+  int dst_channel,
+  const opus_val16 *src,
+  int src_stride,
+  int frame_size,
+  void *user_data
+)
+{
+   float *float_dst;
+   int32_t i;
+   (void)user_data;
+   float_dst = (float*)dst;
+   if (src != NULL)
+   {
+      for (i=0;i<frame_size;i++)
+#if defined(FIXED_POINT)
+         float_dst[i*dst_stride+dst_channel] = (1/32768.f)*src[i*src_stride];
+#else
+         float_dst[i*dst_stride+dst_channel] = src[i*src_stride];
+#endif
+   }
+   else
+   {
+      for (i=0;i<frame_size;i++)
+         float_dst[i*dst_stride+dst_channel] = 0;
+   }
+}
+
 static void opus_copy_channel_out_short(
   void *dst,
   int dst_stride,
@@ -321,8 +452,11 @@ static void opus_copy_channel_out_short(
    if (src != NULL)
    {
       for (i=0;i<frame_size;i++)
+#if defined(FIXED_POINT)
          short_dst[i*dst_stride+dst_channel] = src[i*src_stride];
-
+#else
+         short_dst[i*dst_stride+dst_channel] = FLOAT2INT16(src[i*src_stride]);
+#endif
    }
    else
    {
@@ -331,6 +465,36 @@ static void opus_copy_channel_out_short(
    }
 }
 
+static void opus_copy_channel_out_s32(
+  void *dst,
+  int dst_stride,
+  int dst_channel,
+  const opus_val16 *src,
+  int src_stride,
+  int frame_size,
+  void *user_data
+)
+{
+   int32_t *s32_dst;
+   int32_t i;
+   (void)user_data;
+   s32_dst = (int32_t*)dst;
+   if (src != NULL)
+   {
+      for (i=0;i<frame_size;i++)
+#if defined(FIXED_POINT)
+         s32_dst[i*dst_stride+dst_channel] = SHL32(EXTEND32(src[i*src_stride]), 16);
+#else
+         s32_dst[i*dst_stride+dst_channel] = FLOAT2INT32(src[i*src_stride]);
+#endif
+   }
+   else
+   {
+      for (i=0;i<frame_size;i++)
+         s32_dst[i*dst_stride+dst_channel] = 0;
+   }
+}
+
 int opus_multistream_decode(
       OpusMSDecoder *st,
       const unsigned char *data,
@@ -341,10 +505,138 @@ int opus_multistream_decode(
 )
 {
  //   log_i("len %i", len);
+#if defined(FIXED_POINT)
    return opus_multistream_decode_native(st, data, len,
        pcm, opus_copy_channel_out_short, frame_size, decode_fec, 0, NULL);
+#else
+   return opus_multistream_decode_native(st, data, len,
+       pcm, opus_copy_channel_out_short, frame_size, decode_fec, 1, NULL);
+#endif
 }
 
+int opus_multistream_decode_float(
+      OpusMSDecoder *st,
+      const unsigned char *data,
+      int32_t len,
+      float *pcm,
+      int frame_size,
+      int decode_fec
+)
+{
+   return opus_multistream_decode_native(st, data, len,
+       pcm, opus_copy_channel_out_float, frame_size, decode_fec, 0, NULL);
+}
+
+int opus_multistream_decode_s32(
+      OpusMSDecoder *st,
+      const unsigned char *data,
+      int32_t len,
+      int32_t *pcm,
+      int frame_size,
+      int decode_fec
+)
+{
+   return opus_multistream_decode_native(st, data, len,
+       pcm, opus_copy_channel_out_s32, frame_size, decode_fec, 0, NULL);
+}
+
+int opus_multistream_decode_energy(
+      OpusMSDecoder *st,
+      const unsigned char *data,
+      int32_t len,
+      int16_t *band_db,
+      int max_frames
+)
+{
+   int32_t Fs;
+   int coupled_size;
+   int mono_size;
+   int s, i, b;
+   int count=0;
+   int channels=0;
+   char *ptr;
+   VARDECL(int32_t, level_Q7);
+   VARDECL(int32_t, stream_Q7);
+   ALLOC_STACK;
+
+   VALIDATE_MS_DECODER(st);
+   if (data==NULL || len<=0 || max_frames<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   if (len < 2*st->layout.nb_streams-1)
+   {
+      RESTORE_STACK;
+      return OPUS_INVALID_PACKET;
+   }
+   MUST_SUCCEED(opus_multistream_decoder_ctl(st, OPUS_GET_SAMPLE_RATE(&Fs)));
+   s = opus_multistream_packet_validate(data, len, st->layout.nb_streams, Fs);
+   if (s < 0)
+   {
+      RESTORE_STACK;
+      return s;
+   }
+   /* 2.5 ms frames are the most a stream can have */
+   max_frames = IMIN(max_frames, s/(Fs/400));
+   ALLOC(level_Q7, max_frames*OPUS_ENERGY_BANDS, int32_t);
+   ALLOC(stream_Q7, max_frames*OPUS_ENERGY_BANDS, int32_t);
+   ptr = (char*)st + align(sizeof(OpusMSDecoder));
+   coupled_size = opus_decoder_get_size(2);
+   mono_size = opus_decoder_get_size(1);
+
+   for (s=0;s<st->layout.nb_streams;s++)
+   {
+      OpusDecoder *dec;
+      int32_t packet_offset;
+      int ret, weight;
+
+      dec = (OpusDecoder*)ptr;
+      ptr += (s < st->layout.nb_coupled_streams) ? align(coupled_size) : align(mono_size);
+      packet_offset = 0;
+      if (!opus_multistream_stream_used(&st->layout, s))
+      {
+         unsigned char toc;
+         int16_t size[48];
+         ret = opus_packet_parse_impl(data, len, s!=st->layout.nb_streams-1,
+               &toc, NULL, size, NULL, &packet_offset);
+      } else {
+         ret = opus_decode_energy_native(dec, data, len, stream_Q7, max_frames,
+               s!=st->layout.nb_streams-1, &packet_offset);
+      }
+      if (ret < 0)
+      {
+         RESTORE_STACK;
+         return ret;
+      }
+      data += packet_offset;
+      len -= packet_offset;
+      if (!opus_multistream_stream_used(&st->layout, s))
+         continue;
+      /* Every stream counts with the channels it carries. Streams may split
+         the packet duration into different frame sizes: the first stream
+         sets the frame grid and the others are sampled on it. */
+      weight = s < st->layout.nb_coupled_streams ? 2 : 1;
+      if (count == 0)
+         count = ret;
+      for (i=0;i<count;i++)
+      {
+         const int32_t *src = stream_Q7 + (i*ret/count)*OPUS_ENERGY_BANDS;
+         for (b=0;b<OPUS_ENERGY_BANDS;b++)
+         {
+            int32_t x = src[b] + silk_lin2log(weight);
+            level_Q7[i*OPUS_ENERGY_BANDS+b] = channels == 0 ? x
+                  : silk_log2_add_Q7(level_Q7[i*OPUS_ENERGY_BANDS+b], x);
+         }
+      }
+      channels += weight;
+   }
+   for (i=0;i<count*OPUS_ENERGY_BANDS;i++)
+      level_Q7[i] -= silk_lin2log(channels);
+   opus_energy_to_db(level_Q7, band_db, count*OPUS_ENERGY_BANDS);
+   RESTORE_STACK;
+   return count;
+}
 
 int opus_multistream_decoder_ctl_va_list(OpusMSDecoder *st, int request,
                                          va_list ap)
@@ -361,6 +653,7 @@ int opus_multistream_decoder_ctl_va_list(OpusMSDecoder *st, int request,
        case OPUS_GET_BANDWIDTH_REQUEST:
        case OPUS_GET_SAMPLE_RATE_REQUEST:
        case OPUS_GET_GAIN_REQUEST:
+       case OPUS_GET_HYBRID_WORKER_REQUEST:
        case OPUS_GET_LAST_PACKET_DURATION_REQUEST:
        case OPUS_GET_PHASE_INVERSION_DISABLED_REQUEST:
        {
@@ -437,6 +730,7 @@ int opus_multistream_decoder_ctl_va_list(OpusMSDecoder *st, int request,
        }
        break;
        case OPUS_SET_GAIN_REQUEST:
+       case OPUS_SET_HYBRID_WORKER_REQUEST:
        case OPUS_SET_PHASE_INVERSION_DISABLED_REQUEST:
        {
           int s;
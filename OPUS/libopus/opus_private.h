@@ -146,6 +146,21 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data, int32_t len,
       opus_val16 *pcm, int frame_size, int decode_fec, int self_delimited,
       int32_t *packet_offset, int soft_clip);
 
+/* opus_decode_native() producing left-justified 32-bit samples. Soft clipping
+   does not apply: the float build saturates at full scale instead. */
+int opus_decode_native_s32(OpusDecoder *st, const unsigned char *data, int32_t len,
+      int32_t *pcm, int frame_size, int decode_fec, int self_delimited,
+      int32_t *packet_offset);
+
+/* Level scan behind opus_decode_energy(): OPUS_ENERGY_BANDS levels per
+   frame, in 128*log2 units of squared 16-bit samples. */
+int opus_decode_energy_native(OpusDecoder *st, const unsigned char *data,
+      int32_t len, int32_t *level_Q7, int max_frames, int self_delimited,
+      int32_t *packet_offset);
+
+/* Converts n levels from opus_decode_energy_native() to dB in Q8. */
+void opus_energy_to_db(const int32_t *level_Q7, int16_t *band_db, int n);
+
 /* Make sure everything is properly aligned. */
 static OPUS_INLINE int align(int i)
 {
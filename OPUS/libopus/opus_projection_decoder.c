@@ -191,9 +191,15 @@ int opus_projection_decode(OpusProjectionDecoder *st, const unsigned char *data,
                            int decode_fec)
 {
     log_i("len %i", len);
+#if defined(FIXED_POINT)
   return opus_multistream_decode_native(get_multistream_decoder(st), data, len,
     pcm, opus_projection_copy_channel_out_short, frame_size, decode_fec, 0,
     get_dec_demixing_matrix(st));
+#else
+  return opus_multistream_decode_native(get_multistream_decoder(st), data, len,
+    pcm, opus_projection_copy_channel_out_short, frame_size, decode_fec, 1,
+    get_dec_demixing_matrix(st));
+#endif
 }
 
 //int opus_projection_decoder_ctl(OpusProjectionDecoder *st, int request, ...)
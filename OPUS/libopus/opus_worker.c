@@ -0,0 +1,220 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "opus_worker.h"
+
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#endif
+
+#if defined(ESP_PLATFORM) && portNUM_PROCESSORS > 1
+
+/* The worker belongs on the core the decoding task is not pinned to: the
+   sketch decodes on core 0, so by default it shares core 1 with Arduino's
+   loopTask (priority 1). It runs above loopTask on purpose: the decoder
+   blocks in opus_worker_join() until the SILK half is done, so the worker
+   preempts loop() for at most that half of each hybrid frame, while at equal
+   priority a busy loop() would stretch every frame by time slices. Builds
+   that decode on core 1, or whose loop() is time critical, override both. */
+#ifndef OPUS_WORKER_CORE
+#define OPUS_WORKER_CORE 1
+#endif
+#ifndef OPUS_WORKER_PRIORITY
+#define OPUS_WORKER_PRIORITY (tskIDLE_PRIORITY + 2)
+#endif
+/* In bytes. SILK synthesis and resampling of a 20 ms stereo frame. */
+#ifndef OPUS_WORKER_STACK_SIZE
+#define OPUS_WORKER_STACK_SIZE 16384
+#endif
+
+static portMUX_TYPE worker_mux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t worker_busy;
+static SemaphoreHandle_t worker_go;
+static SemaphoreHandle_t worker_done;
+static opus_worker_func worker_func;
+static void *worker_arg;
+static volatile int worker_state; /* 0: none, 1: being created, 2: running */
+
+static void opus_worker_task(void *unused)
+{
+   (void)unused;
+   for (;;)
+   {
+      xSemaphoreTake(worker_go, portMAX_DELAY);
+      worker_func(worker_arg);
+      xSemaphoreGive(worker_done);
+   }
+}
+
+int opus_worker_init(void)
+{
+   int state;
+   portENTER_CRITICAL(&worker_mux);
+   state = worker_state;
+   if (state == 0)
+      worker_state = 1;
+   portEXIT_CRITICAL(&worker_mux);
+   if (state != 0)
+      return state == 2 ? 0 : -1;
+
+   worker_busy = xSemaphoreCreateMutex();
+   worker_go = xSemaphoreCreateBinary();
+   worker_done = xSemaphoreCreateBinary();
+   if (worker_busy && worker_go && worker_done &&
+       xTaskCreatePinnedToCore(opus_worker_task, "opus_worker", OPUS_WORKER_STACK_SIZE,
+                               NULL, OPUS_WORKER_PRIORITY, NULL, OPUS_WORKER_CORE) == pdPASS)
+   {
+      portENTER_CRITICAL(&worker_mux);
+      worker_state = 2;
+      portEXIT_CRITICAL(&worker_mux);
+      return 0;
+   }
+   if (worker_busy) vSemaphoreDelete(worker_busy);
+   if (worker_go) vSemaphoreDelete(worker_go);
+   if (worker_done) vSemaphoreDelete(worker_done);
+   portENTER_CRITICAL(&worker_mux);
+   worker_state = 0;
+   portEXIT_CRITICAL(&worker_mux);
+   return -1;
+}
+
+int opus_worker_start(opus_worker_func func, void *arg)
+{
+   if (worker_state != 2 || xSemaphoreTake(worker_busy, 0) != pdTRUE)
+      return -1;
+   worker_func = func;
+   worker_arg = arg;
+   xSemaphoreGive(worker_go);
+   return 0;
+}
+
+void opus_worker_join(void)
+{
+   xSemaphoreTake(worker_done, portMAX_DELAY);
+   xSemaphoreGive(worker_busy);
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+
+#include <pthread.h>
+#include <unistd.h>
+
+static pthread_once_t worker_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t worker_busy = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t worker_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t worker_cond = PTHREAD_COND_INITIALIZER;
+static opus_worker_func worker_func;
+static void *worker_arg;
+static int worker_pending;
+static int worker_done;
+static int worker_ok;
+
+/* Waits until *flag is set, then clears it. */
+static void opus_worker_wait(int *flag)
+{
+   pthread_mutex_lock(&worker_lock);
+   while (!*flag)
+      pthread_cond_wait(&worker_cond, &worker_lock);
+   *flag = 0;
+   pthread_mutex_unlock(&worker_lock);
+}
+
+/* Sets *flag and wakes the other side. */
+static void opus_worker_post(int *flag)
+{
+   pthread_mutex_lock(&worker_lock);
+   *flag = 1;
+   pthread_cond_broadcast(&worker_cond);
+   pthread_mutex_unlock(&worker_lock);
+}
+
+static void *opus_worker_thread(void *unused)
+{
+   (void)unused;
+   for (;;)
+   {
+      opus_worker_wait(&worker_pending);
+      worker_func(worker_arg);
+      opus_worker_post(&worker_done);
+   }
+   return NULL;
+}
+
+static void opus_worker_create(void)
+{
+   pthread_t thread;
+   /* With a single CPU the two halves would only take turns */
+   if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+      return;
+   if (pthread_create(&thread, NULL, opus_worker_thread, NULL) == 0)
+   {
+      pthread_detach(thread);
+      worker_ok = 1;
+   }
+}
+
+int opus_worker_init(void)
+{
+   pthread_once(&worker_once, opus_worker_create);
+   return worker_ok ? 0 : -1;
+}
+
+int opus_worker_start(opus_worker_func func, void *arg)
+{
+   if (!worker_ok || pthread_mutex_trylock(&worker_busy) != 0)
+      return -1;
+   worker_func = func;
+   worker_arg = arg;
+   opus_worker_post(&worker_pending);
+   return 0;
+}
+
+void opus_worker_join(void)
+{
+   opus_worker_wait(&worker_done);
+   pthread_mutex_unlock(&worker_busy);
+}
+
+#else
+
+int opus_worker_init(void)
+{
+   return -1;
+}
+
+int opus_worker_start(opus_worker_func func, void *arg)
+{
+   (void)func;
+   (void)arg;
+   return -1;
+}
+
+void opus_worker_join(void)
+{
+}
+
+#endif
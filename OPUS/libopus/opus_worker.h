@@ -0,0 +1,50 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OPUS_WORKER_H
+#define OPUS_WORKER_H
+
+/* A single helper thread that runs one job next to the caller. On the ESP32
+   it is a FreeRTOS task pinned to the core the decoder is not running on; on
+   a hosted build it is a pthread. The hybrid decoder uses it to synthesize
+   SILK while CELT is being decoded (see OPUS_SET_HYBRID_WORKER). */
+
+typedef void (*opus_worker_func)(void *arg);
+
+/* Creates the helper thread if it does not exist yet. Returns 0 on success,
+   or -1 if there is no thread support or the thread cannot be created. */
+int opus_worker_init(void);
+
+/* Hands func(arg) to the helper. Returns 0 if the helper took the job, in
+   which case opus_worker_join() must be called before the caller touches
+   anything func writes. Returns -1 if the helper is missing or busy with
+   another caller's job; the caller is then expected to run func itself. */
+int opus_worker_start(opus_worker_func func, void *arg);
+
+/* Waits for the job handed over by the last successful opus_worker_start()
+   of the calling thread. */
+void opus_worker_join(void);
+
+#endif /* OPUS_WORKER_H */
@@ -117,6 +117,47 @@ int32_t silk_Decode(                                   /* O    Returns error cod
     int                             arch                /* I    Run-time architecture                           */
 );
 
+/**************************************************************/
+/* Decode a frame in two steps: silk_Decode_parse() reads all */
+/* of the frame's bits from the range decoder, after which    */
+/* silk_Decode_synth() produces the samples without touching  */
+/* it. Calling one after the other is the same as silk_Decode */
+/**************************************************************/
+int32_t silk_Decode_parse(                             /* O    Returns error code                              */
+    void*                           decState,           /* I/O  State                                           */
+    silk_DecControlStruct*          decControl,         /* I/O  Control Structure                               */
+    int32_t                        lostFlag,           /* I    0: no loss, 1 loss, 2 decode fec                */
+    int32_t                        newPacketFlag,      /* I    Indicates first decoder call for this packet    */
+    ec_dec                          *psRangeDec         /* I/O  Compressor data structure                       */
+);
+
+int32_t silk_Decode_synth(                             /* O    Returns error code                              */
+    void*                           decState,           /* I/O  State                                           */
+    silk_DecControlStruct*          decControl,         /* I/O  Control Structure                               */
+    int16_t                      *samplesOut,        /* O    Decoded output speech vector                    */
+    int32_t                      *nSamplesOut,       /* O    Number of samples decoded                       */
+    int                             arch                /* I    Run-time architecture                           */
+);
+
+/* Maximum number of bands silk_Decode_level() takes */
+#define SILK_MAX_BANDS 24
+
+/****************************************************************/
+/* Level scan of a frame: reads the frame like silk_Decode()    */
+/* but, instead of synthesizing it, estimates its power in each */
+/* band from the gains, pulses and LPC/LTP parameters. Leaves   */
+/* the decoder unfit for silk_Decode() until it is reset        */
+/****************************************************************/
+int32_t silk_Decode_level(                             /* O    Returns error code                              */
+    void*                           decState,           /* I/O  State                                           */
+    silk_DecControlStruct*          decControl,         /* I/O  Control Structure                               */
+    int32_t                        newPacketFlag,      /* I    Indicates first decoder call for this packet    */
+    ec_dec                          *psRangeDec,        /* I/O  Compressor data structure                       */
+    const int32_t                band_Hz[],          /* I    Band edges in Hz [ nb_bands + 1 ]               */
+    int32_t                        nb_bands,           /* I    Number of bands                                 */
+    int32_t                      level_Q7[]          /* O    Power per band, 128 * log2 [ nb_bands ]         */
+);
+
 #if 0
 /**************************************/
 /* Get table of contents for a packet */
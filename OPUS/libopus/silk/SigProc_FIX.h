@@ -73,7 +73,8 @@ int32_t silk_resampler(
     silk_resampler_state_struct *S,                 /* I/O  Resampler state                                             */
     int16_t                  out[],              /* O    Output signal                                               */
     const int16_t            in[],               /* I    Input signal                                                */
-    int32_t                  inLen               /* I    Number of input samples                                     */
+    int32_t                  inLen,              /* I    Number of input samples                                     */
+    int                      arch                /* I    Run-time architecture                                       */
 );
 
 /*!
@@ -188,6 +189,13 @@ int32_t silk_log2lin(
     const int32_t            inLog_Q7            /* I  input on log scale                                            */
 );
 
+/* Sum of two values on the 128 * log2() scale of silk_lin2log(), i.e.    */
+/* 128 * log2( 2^(a/128) + 2^(b/128) )                                     */
+int32_t silk_log2_add_Q7(
+    int32_t                    a_Q7,               /* I  first term on log scale                                        */
+    int32_t                    b_Q7                /* I  second term on log scale                                       */
+);
+
 /* Compute number of bits to right shift the sum of squares of a vector    */
 /* of int16s to make it fit in an int32                                    */
 void silk_sum_sqr_shift(
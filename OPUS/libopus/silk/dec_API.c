@@ -39,6 +39,15 @@ typedef struct {
     int32_t                         nChannelsAPI;
     int32_t                         nChannelsInternal;
     int32_t                         prev_decode_only_middle;
+    /* Frame state handed from silk_Decode_parse() to silk_Decode_synth() */
+    int32_t                         lostFlag;
+    int32_t                         decode_only_middle;
+    int32_t                         has_side;
+    int32_t                         stereo_to_mono;
+    int32_t                         parse_ret;
+    int32_t                         MS_pred_Q13[ 2 ];
+    int32_t                         condCoding[ DECODER_NUM_CHANNELS ];
+    int16_t                         pulses[ DECODER_NUM_CHANNELS ][ MAX_FRAME_LENGTH ];
 } silk_decoder;
 
 /*********************/
@@ -74,32 +83,23 @@ int32_t silk_InitDecoder(                              /* O    Returns error cod
     return ret;
 }
 
-/* Decode a frame */
-int32_t silk_Decode(                                   /* O    Returns error code                              */
+/* Decode the bitstream part of a frame. Everything that reads psRangeDec
+   happens here; the signal processing is left to silk_Decode_synth(). */
+int32_t silk_Decode_parse(                             /* O    Returns error code                              */
     void*                           decState,           /* I/O  State                                           */
     silk_DecControlStruct*          decControl,         /* I/O  Control Structure                               */
     int32_t                        lostFlag,           /* I    0: no loss, 1 loss, 2 decode fec                */
     int32_t                        newPacketFlag,      /* I    Indicates first decoder call for this packet    */
-    ec_dec                          *psRangeDec,        /* I/O  Compressor data structure                       */
-    int16_t                      *samplesOut,        /* O    Decoded output speech vector                    */
-    int32_t                      *nSamplesOut,       /* O    Number of samples decoded                       */
-    int                             arch                /* I    Run-time architecture                           */
+    ec_dec                          *psRangeDec         /* I/O  Compressor data structure                       */
 )
 {
     int32_t   i, n, decode_only_middle = 0, ret = SILK_NO_ERROR;
-    int32_t nSamplesOutDec, LBRR_symbol;
-    int16_t *samplesOut1_tmp[ 2 ];
-    VARDECL( int16_t, samplesOut1_tmp_storage1 );
-    VARDECL( int16_t, samplesOut1_tmp_storage2 );
-    VARDECL( int16_t, samplesOut2_tmp );
+    int32_t LBRR_symbol;
     int32_t MS_pred_Q13[ 2 ] = { 0 };
-    int16_t *resample_out_ptr;
     silk_decoder *psDec = ( silk_decoder * )decState;
     silk_decoder_state *channel_state = psDec->channel_state;
     int32_t has_side;
     int32_t stereo_to_mono;
-    int delay_stack_alloc;
-    SAVE_STACK;
 
     celt_assert( decControl->nChannelsInternal == 1 || decControl->nChannelsInternal == 2 );
 
@@ -141,13 +141,11 @@ int32_t silk_Decode(                                   /* O    Returns error cod
                 channel_state[ n ].nb_subfr = 4;
             } else {
                 celt_assert( 0 );
-                RESTORE_STACK;
                 return SILK_DEC_INVALID_FRAME_SIZE;
             }
             fs_kHz_dec = ( decControl->internalSampleRate >> 10 ) + 1;
             if( fs_kHz_dec != 8 && fs_kHz_dec != 12 && fs_kHz_dec != 16 ) {
                 celt_assert( 0 );
-                RESTORE_STACK;
                 return SILK_DEC_INVALID_SAMPLING_FREQUENCY;
             }
             ret += silk_decoder_set_fs( &channel_state[ n ], fs_kHz_dec, decControl->API_sampleRate );
@@ -164,7 +162,6 @@ int32_t silk_Decode(                                   /* O    Returns error cod
 
     if( decControl->API_sampleRate > (int32_t)MAX_API_FS_KHZ * 1000 || decControl->API_sampleRate < 8000 ) {
         ret = SILK_DEC_INVALID_SAMPLING_FREQUENCY;
-        RESTORE_STACK;
         return( ret );
     }
 
@@ -252,36 +249,20 @@ int32_t silk_Decode(                                   /* O    Returns error cod
         psDec->channel_state[ 1 ].first_frame_after_reset = 1;
     }
 
-    /* Check if the temp buffer fits into the output PCM buffer. If it fits,
-       we can delay allocating the temp buffer until after the SILK peak stack
-       usage. We need to use a < and not a <= because of the two extra samples. */
-    delay_stack_alloc = decControl->internalSampleRate*decControl->nChannelsInternal
-          < decControl->API_sampleRate*decControl->nChannelsAPI;
-    ALLOC( samplesOut1_tmp_storage1, delay_stack_alloc ? ALLOC_NONE
-           : decControl->nChannelsInternal*(channel_state[ 0 ].frame_length + 2 ),
-           int16_t );
-    if ( delay_stack_alloc )
-    {
-       samplesOut1_tmp[ 0 ] = samplesOut;
-       samplesOut1_tmp[ 1 ] = samplesOut + channel_state[ 0 ].frame_length + 2;
-    } else {
-       samplesOut1_tmp[ 0 ] = samplesOut1_tmp_storage1;
-       samplesOut1_tmp[ 1 ] = samplesOut1_tmp_storage1 + channel_state[ 0 ].frame_length + 2;
-    }
-
     if( lostFlag == FLAG_DECODE_NORMAL ) {
         has_side = !decode_only_middle;
     } else {
         has_side = !psDec->prev_decode_only_middle
               || (decControl->nChannelsInternal == 2 && lostFlag == FLAG_DECODE_LBRR && channel_state[1].LBRR_flags[ channel_state[1].nFramesDecoded ] == 1 );
     }
-    /* Call decoder for one frame */
+    /* Parse one frame per channel. The frame counters are only advanced by
+       silk_Decode_synth(), so both channels use the same frame index here. */
     for( n = 0; n < decControl->nChannelsInternal; n++ ) {
         if( n == 0 || has_side ) {
             int32_t FrameIndex;
             int32_t condCoding;
 
-            FrameIndex = channel_state[ 0 ].nFramesDecoded - n;
+            FrameIndex = channel_state[ 0 ].nFramesDecoded;
             /* Use independent coding if no previous frame available */
             if( FrameIndex <= 0 ) {
                 condCoding = CODE_INDEPENDENTLY;
@@ -294,7 +275,69 @@ int32_t silk_Decode(                                   /* O    Returns error cod
             } else {
                 condCoding = CODE_CONDITIONALLY;
             }
-            ret += silk_decode_frame( &channel_state[ n ], psRangeDec, &samplesOut1_tmp[ n ][ 2 ], &nSamplesOutDec, lostFlag, condCoding, arch);
+            silk_decode_frame_parse( &channel_state[ n ], psRangeDec, psDec->pulses[ n ], lostFlag, condCoding );
+            psDec->condCoding[ n ] = condCoding;
+        }
+    }
+
+    psDec->lostFlag           = lostFlag;
+    psDec->decode_only_middle = decode_only_middle;
+    psDec->has_side           = has_side;
+    psDec->stereo_to_mono     = stereo_to_mono;
+    psDec->MS_pred_Q13[ 0 ]   = MS_pred_Q13[ 0 ];
+    psDec->MS_pred_Q13[ 1 ]   = MS_pred_Q13[ 1 ];
+    psDec->parse_ret          = ret;
+    return SILK_NO_ERROR;
+}
+
+/* Signal processing part of a frame decode, using the state left behind by
+   silk_Decode_parse(). It does not touch the range decoder, so it can run
+   concurrently with the CELT layer of a hybrid packet. */
+int32_t silk_Decode_synth(                             /* O    Returns error code                              */
+    void*                           decState,           /* I/O  State                                           */
+    silk_DecControlStruct*          decControl,         /* I/O  Control Structure                               */
+    int16_t                      *samplesOut,        /* O    Decoded output speech vector                    */
+    int32_t                      *nSamplesOut,       /* O    Number of samples decoded                       */
+    int                             arch                /* I    Run-time architecture                           */
+)
+{
+    int32_t   i, n, ret;
+    int32_t nSamplesOutDec;
+    int16_t *samplesOut1_tmp[ 2 ];
+    VARDECL( int16_t, samplesOut1_tmp_storage1 );
+    VARDECL( int16_t, samplesOut1_tmp_storage2 );
+    VARDECL( int16_t, samplesOut2_tmp );
+    int16_t *resample_out_ptr;
+    silk_decoder *psDec = ( silk_decoder * )decState;
+    silk_decoder_state *channel_state = psDec->channel_state;
+    int32_t lostFlag = psDec->lostFlag;
+    int delay_stack_alloc;
+    SAVE_STACK;
+
+    ret = psDec->parse_ret;
+
+    /* Check if the temp buffer fits into the output PCM buffer. If it fits,
+       we can delay allocating the temp buffer until after the SILK peak stack
+       usage. We need to use a < and not a <= because of the two extra samples. */
+    delay_stack_alloc = decControl->internalSampleRate*decControl->nChannelsInternal
+          < decControl->API_sampleRate*decControl->nChannelsAPI;
+    ALLOC( samplesOut1_tmp_storage1, delay_stack_alloc ? ALLOC_NONE
+           : decControl->nChannelsInternal*(channel_state[ 0 ].frame_length + 2 ),
+           int16_t );
+    if ( delay_stack_alloc )
+    {
+       samplesOut1_tmp[ 0 ] = samplesOut;
+       samplesOut1_tmp[ 1 ] = samplesOut + channel_state[ 0 ].frame_length + 2;
+    } else {
+       samplesOut1_tmp[ 0 ] = samplesOut1_tmp_storage1;
+       samplesOut1_tmp[ 1 ] = samplesOut1_tmp_storage1 + channel_state[ 0 ].frame_length + 2;
+    }
+
+    /* Call decoder for one frame */
+    for( n = 0; n < decControl->nChannelsInternal; n++ ) {
+        if( n == 0 || psDec->has_side ) {
+            ret += silk_decode_frame_synth( &channel_state[ n ], &samplesOut1_tmp[ n ][ 2 ], &nSamplesOutDec,
+                psDec->pulses[ n ], lostFlag, psDec->condCoding[ n ], arch );
         } else {
             silk_memset( &samplesOut1_tmp[ n ][ 2 ], 0, nSamplesOutDec * sizeof( int16_t ) );
         }
@@ -303,7 +346,7 @@ int32_t silk_Decode(                                   /* O    Returns error cod
 
     if( decControl->nChannelsAPI == 2 && decControl->nChannelsInternal == 2 ) {
         /* Convert Mid/Side to Left/Right */
-        silk_stereo_MS_to_LR( &psDec->sStereo, samplesOut1_tmp[ 0 ], samplesOut1_tmp[ 1 ], MS_pred_Q13, channel_state[ 0 ].fs_kHz, nSamplesOutDec );
+        silk_stereo_MS_to_LR( &psDec->sStereo, samplesOut1_tmp[ 0 ], samplesOut1_tmp[ 1 ], psDec->MS_pred_Q13, channel_state[ 0 ].fs_kHz, nSamplesOutDec );
     } else {
         /* Buffering */
         silk_memcpy( samplesOut1_tmp[ 0 ], psDec->sStereo.sMid, 2 * sizeof( int16_t ) );
@@ -334,7 +377,7 @@ int32_t silk_Decode(                                   /* O    Returns error cod
     for( n = 0; n < silk_min( decControl->nChannelsAPI, decControl->nChannelsInternal ); n++ ) {
 
         /* Resample decoded signal to API_sampleRate */
-        ret += silk_resampler( &channel_state[ n ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ n ][ 1 ], nSamplesOutDec );
+        ret += silk_resampler( &channel_state[ n ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ n ][ 1 ], nSamplesOutDec, arch );
 
         /* Interleave if stereo output and stereo stream */
         if( decControl->nChannelsAPI == 2 ) {
@@ -346,10 +389,10 @@ int32_t silk_Decode(                                   /* O    Returns error cod
 
     /* Create two channel output from mono stream */
     if( decControl->nChannelsAPI == 2 && decControl->nChannelsInternal == 1 ) {
-        if ( stereo_to_mono ){
+        if ( psDec->stereo_to_mono ){
             /* Resample right channel for newly collapsed stereo just in case
                we weren't doing collapsing when switching to mono */
-            ret += silk_resampler( &channel_state[ 1 ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ 0 ][ 1 ], nSamplesOutDec );
+            ret += silk_resampler( &channel_state[ 1 ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ 0 ][ 1 ], nSamplesOutDec, arch );
 
             for( i = 0; i < *nSamplesOut; i++ ) {
                 samplesOut[ 1 + 2 * i ] = resample_out_ptr[ i ];
@@ -375,12 +418,90 @@ int32_t silk_Decode(                                   /* O    Returns error cod
        for ( i = 0; i < psDec->nChannelsInternal; i++ )
           psDec->channel_state[ i ].LastGainIndex = 10;
     } else {
-       psDec->prev_decode_only_middle = decode_only_middle;
+       psDec->prev_decode_only_middle = psDec->decode_only_middle;
     }
     RESTORE_STACK;
     return ret;
 }
 
+/* Level scan of a frame: silk_Decode_parse() followed by a level estimate
+   per band from the frame parameters instead of the synthesis. The levels
+   are the mean power per API channel, in 128 * log2() of squared output
+   samples. Only the state the bitstream parsing depends on is kept up to
+   date, so the decoder must be reset before it produces audio again. */
+int32_t silk_Decode_level(                             /* O    Returns error code                              */
+    void*                           decState,           /* I/O  State                                           */
+    silk_DecControlStruct*          decControl,         /* I/O  Control Structure                               */
+    int32_t                        newPacketFlag,      /* I    Indicates first decoder call for this packet    */
+    ec_dec                          *psRangeDec,        /* I/O  Compressor data structure                       */
+    const int32_t                band_Hz[],          /* I    Band edges in Hz [ nb_bands + 1 ]               */
+    int32_t                        nb_bands,           /* I    Number of bands                                 */
+    int32_t                      level_Q7[]          /* O    Power per band, 128 * log2 [ nb_bands ]         */
+)
+{
+    int32_t   b, n, ret, pred_Q13;
+    int32_t   side_Q7[ SILK_MAX_BANDS ];
+    silk_decoder *psDec = ( silk_decoder * )decState;
+    silk_decoder_state *channel_state = psDec->channel_state;
+
+    celt_assert( nb_bands <= SILK_MAX_BANDS );
+    ret = silk_Decode_parse( decState, decControl, FLAG_DECODE_NORMAL, newPacketFlag, psRangeDec );
+    if( ret ) {
+        return ret;
+    }
+
+    silk_decode_frame_level( &channel_state[ 0 ], psDec->pulses[ 0 ], psDec->condCoding[ 0 ],
+        band_Hz, nb_bands, level_Q7 );
+    if( decControl->nChannelsInternal == 2 ) {
+        if( psDec->has_side ) {
+            silk_decode_frame_level( &channel_state[ 1 ], psDec->pulses[ 1 ], psDec->condCoding[ 1 ],
+                band_Hz, nb_bands, side_Q7 );
+        } else {
+            for( b = 0; b < nb_bands; b++ ) {
+                side_Q7[ b ] = SILK_LEVEL_FLOOR_Q7;
+            }
+        }
+        if( decControl->nChannelsAPI == 2 ) {
+            /* Left and right are mid +/- side, where the side channel also gets */
+            /* the prediction from mid, so the mean power is mid^2 + side^2      */
+            pred_Q13 = silk_abs( psDec->MS_pred_Q13[ 0 ] + psDec->MS_pred_Q13[ 1 ] );
+            for( b = 0; b < nb_bands; b++ ) {
+                if( pred_Q13 > 0 ) {
+                    side_Q7[ b ] = silk_log2_add_Q7( side_Q7[ b ],
+                        level_Q7[ b ] + silk_LSHIFT( silk_lin2log( pred_Q13 ) - 13 * 128, 1 ) );
+                }
+                level_Q7[ b ] = silk_log2_add_Q7( level_Q7[ b ], side_Q7[ b ] );
+            }
+        }
+    }
+    for( n = 0; n < decControl->nChannelsInternal; n++ ) {
+        channel_state[ n ].nFramesDecoded++;
+    }
+    psDec->prev_decode_only_middle = psDec->decode_only_middle;
+    return psDec->parse_ret;
+}
+
+/* Decode a frame */
+int32_t silk_Decode(                                   /* O    Returns error code                              */
+    void*                           decState,           /* I/O  State                                           */
+    silk_DecControlStruct*          decControl,         /* I/O  Control Structure                               */
+    int32_t                        lostFlag,           /* I    0: no loss, 1 loss, 2 decode fec                */
+    int32_t                        newPacketFlag,      /* I    Indicates first decoder call for this packet    */
+    ec_dec                          *psRangeDec,        /* I/O  Compressor data structure                       */
+    int16_t                      *samplesOut,        /* O    Decoded output speech vector                    */
+    int32_t                      *nSamplesOut,       /* O    Number of samples decoded                       */
+    int                             arch                /* I    Run-time architecture                           */
+)
+{
+    int32_t ret;
+
+    ret = silk_Decode_parse( decState, decControl, lostFlag, newPacketFlag, psRangeDec );
+    if( ret ) {
+        return ret;
+    }
+    return silk_Decode_synth( decState, decControl, samplesOut, nSamplesOut, arch );
+}
+
 #if 0
 /* Getting table of contents for a packet */
 int32_t silk_get_TOC(
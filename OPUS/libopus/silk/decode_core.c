@@ -28,6 +28,88 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "main.h"
 #include "../celt/stack_alloc.h"
 
+/* Long-term synthesis of one subframe: adds the 5-tap pitch prediction to the
+   excitation and appends the result to the LTP state */
+void silk_LTP_synthesis_c(
+    int32_t                  pres_Q14[],                     /* O    LPC excitation                              */
+    int32_t                  sLTP_Q15[],                     /* I/O  LTP state, at the first new sample          */
+    const int32_t            pexc_Q14[],                     /* I    Excitation                                  */
+    const int16_t            B_Q14[ LTP_ORDER ],             /* I    LTP coefficients                            */
+    int                         lag,                            /* I    Pitch lag                                   */
+    int                         length                          /* I    Subframe length                             */
+)
+{
+    int i;
+    int32_t LTP_pred_Q13;
+    const int32_t *pred_lag_ptr;
+
+    /* Set up pointer */
+    pred_lag_ptr = &sLTP_Q15[ -lag + LTP_ORDER / 2 ];
+    for( i = 0; i < length; i++ ) {
+        /* Unrolled loop */
+        /* Avoids introducing a bias because silk_SMLAWB() always rounds to -inf */
+        LTP_pred_Q13 = 2;
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[  0 ], B_Q14[ 0 ] );
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ -1 ], B_Q14[ 1 ] );
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ -2 ], B_Q14[ 2 ] );
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ -3 ], B_Q14[ 3 ] );
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ -4 ], B_Q14[ 4 ] );
+        pred_lag_ptr++;
+
+        /* Generate LPC excitation */
+        pres_Q14[ i ] = silk_ADD_LSHIFT32( pexc_Q14[ i ], LTP_pred_Q13, 1 );
+
+        /* Update states */
+        sLTP_Q15[ i ] = silk_LSHIFT( pres_Q14[ i ], 1 );
+    }
+}
+
+/* Short-term synthesis of one subframe, followed by the gain scaling to the
+   output. sLPC_Q14 holds MAX_LPC_ORDER samples of history, then the subframe */
+void silk_LPC_synthesis_c(
+    int32_t                  sLPC_Q14[],                     /* I/O  LPC state                                   */
+    int16_t                  xq[],                           /* O    Decoded speech                              */
+    const int32_t            pres_Q14[],                     /* I    LPC excitation                              */
+    const int16_t            A_Q12[],                        /* I    LPC coefficients                            */
+    int32_t                  Gain_Q10,                       /* I    Subframe gain                               */
+    int                         LPC_order,                      /* I    LPC order, 10 or 16                         */
+    int                         length                          /* I    Subframe length                             */
+)
+{
+    int i;
+    int32_t LPC_pred_Q10;
+
+    celt_assert( LPC_order == 10 || LPC_order == 16 );
+    for( i = 0; i < length; i++ ) {
+        /* Avoids introducing a bias because silk_SMLAWB() always rounds to -inf */
+        LPC_pred_Q10 = silk_RSHIFT( LPC_order, 1 );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  1 ], A_Q12[ 0 ] );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  2 ], A_Q12[ 1 ] );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  3 ], A_Q12[ 2 ] );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  4 ], A_Q12[ 3 ] );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  5 ], A_Q12[ 4 ] );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  6 ], A_Q12[ 5 ] );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  7 ], A_Q12[ 6 ] );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  8 ], A_Q12[ 7 ] );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  9 ], A_Q12[ 8 ] );
+        LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 10 ], A_Q12[ 9 ] );
+        if( LPC_order == 16 ) {
+            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 11 ], A_Q12[ 10 ] );
+            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 12 ], A_Q12[ 11 ] );
+            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 13 ], A_Q12[ 12 ] );
+            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 14 ], A_Q12[ 13 ] );
+            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 15 ], A_Q12[ 14 ] );
+            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 16 ], A_Q12[ 15 ] );
+        }
+
+        /* Add prediction to LPC excitation */
+        sLPC_Q14[ MAX_LPC_ORDER + i ] = silk_ADD_SAT32( pres_Q14[ i ], silk_LSHIFT_SAT32( LPC_pred_Q10, 4 ) );
+
+        /* Scale with gain */
+        xq[ i ] = (int16_t)silk_SAT16( silk_RSHIFT_ROUND( silk_SMULWW( sLPC_Q14[ MAX_LPC_ORDER + i ], Gain_Q10 ), 8 ) );
+    }
+}
+
 /**********************************************************/
 /* Core decoder. Performs inverse NSQ operation LTP + LPC */
 /**********************************************************/
@@ -43,8 +125,8 @@ void silk_decode_core(
     int16_t *A_Q12, *B_Q14, *pxq, A_Q12_tmp[ MAX_LPC_ORDER ];
     VARDECL( int16_t, sLTP );
     VARDECL( int32_t, sLTP_Q15 );
-    int32_t LTP_pred_Q13, LPC_pred_Q10, Gain_Q10, inv_gain_Q31, gain_adj_Q16, rand_seed, offset_Q10;
-    int32_t *pred_lag_ptr, *pexc_Q14, *pres_Q14;
+    int32_t Gain_Q10, inv_gain_Q31, gain_adj_Q16, rand_seed, offset_Q10;
+    int32_t *pexc_Q14, *pres_Q14;
     VARDECL( int32_t, res_Q14 );
     VARDECL( int32_t, sLPC_Q14 );
     SAVE_STACK;
@@ -166,60 +248,14 @@ void silk_decode_core(
 
         /* Long-term prediction */
         if( signalType == TYPE_VOICED ) {
-            /* Set up pointer */
-            pred_lag_ptr = &sLTP_Q15[ sLTP_buf_idx - lag + LTP_ORDER / 2 ];
-            for( i = 0; i < psDec->subfr_length; i++ ) {
-                /* Unrolled loop */
-                /* Avoids introducing a bias because silk_SMLAWB() always rounds to -inf */
-                LTP_pred_Q13 = 2;
-                LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[  0 ], B_Q14[ 0 ] );
-                LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ -1 ], B_Q14[ 1 ] );
-                LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ -2 ], B_Q14[ 2 ] );
-                LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ -3 ], B_Q14[ 3 ] );
-                LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ -4 ], B_Q14[ 4 ] );
-                pred_lag_ptr++;
-
-                /* Generate LPC excitation */
-                pres_Q14[ i ] = silk_ADD_LSHIFT32( pexc_Q14[ i ], LTP_pred_Q13, 1 );
-
-                /* Update states */
-                sLTP_Q15[ sLTP_buf_idx ] = silk_LSHIFT( pres_Q14[ i ], 1 );
-                sLTP_buf_idx++;
-            }
+            silk_LTP_synthesis( pres_Q14, &sLTP_Q15[ sLTP_buf_idx ], pexc_Q14, B_Q14, lag, psDec->subfr_length, arch );
+            sLTP_buf_idx += psDec->subfr_length;
         } else {
             pres_Q14 = pexc_Q14;
         }
 
-        for( i = 0; i < psDec->subfr_length; i++ ) {
-            /* Short-term prediction */
-            celt_assert( psDec->LPC_order == 10 || psDec->LPC_order == 16 );
-            /* Avoids introducing a bias because silk_SMLAWB() always rounds to -inf */
-            LPC_pred_Q10 = silk_RSHIFT( psDec->LPC_order, 1 );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  1 ], A_Q12_tmp[ 0 ] );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  2 ], A_Q12_tmp[ 1 ] );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  3 ], A_Q12_tmp[ 2 ] );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  4 ], A_Q12_tmp[ 3 ] );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  5 ], A_Q12_tmp[ 4 ] );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  6 ], A_Q12_tmp[ 5 ] );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  7 ], A_Q12_tmp[ 6 ] );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  8 ], A_Q12_tmp[ 7 ] );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i -  9 ], A_Q12_tmp[ 8 ] );
-            LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 10 ], A_Q12_tmp[ 9 ] );
-            if( psDec->LPC_order == 16 ) {
-                LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 11 ], A_Q12_tmp[ 10 ] );
-                LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 12 ], A_Q12_tmp[ 11 ] );
-                LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 13 ], A_Q12_tmp[ 12 ] );
-                LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 14 ], A_Q12_tmp[ 13 ] );
-                LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 15 ], A_Q12_tmp[ 14 ] );
-                LPC_pred_Q10 = silk_SMLAWB( LPC_pred_Q10, sLPC_Q14[ MAX_LPC_ORDER + i - 16 ], A_Q12_tmp[ 15 ] );
-            }
-
-            /* Add prediction to LPC excitation */
-            sLPC_Q14[ MAX_LPC_ORDER + i ] = silk_ADD_SAT32( pres_Q14[ i ], silk_LSHIFT_SAT32( LPC_pred_Q10, 4 ) );
-
-            /* Scale with gain */
-            pxq[ i ] = (int16_t)silk_SAT16( silk_RSHIFT_ROUND( silk_SMULWW( sLPC_Q14[ MAX_LPC_ORDER + i ], Gain_Q10 ), 8 ) );
-        }
+        /* Short-term prediction */
+        silk_LPC_synthesis( sLPC_Q14, pxq, pres_Q14, A_Q12_tmp, Gain_Q10, psDec->LPC_order, psDec->subfr_length, arch );
 
         /* Update LPC filter state */
         silk_memcpy( sLPC_Q14, &sLPC_Q14[ psDec->subfr_length ], MAX_LPC_ORDER * sizeof( int32_t ) );
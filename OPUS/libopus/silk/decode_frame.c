@@ -29,36 +29,23 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "../celt/stack_alloc.h"
 #include "PLC.h"
 
-/****************/
-/* Decode frame */
-/****************/
-int32_t silk_decode_frame(
+/********************************/
+/* Decode frame, bitstream part */
+/********************************/
+void silk_decode_frame_parse(
     silk_decoder_state          *psDec,                         /* I/O  Pointer to Silk decoder state               */
     ec_dec                      *psRangeDec,                    /* I/O  Compressor data structure                   */
-    int16_t                  pOut[],                         /* O    Pointer to output speech frame              */
-    int32_t                  *pN,                            /* O    Pointer to size of output frame             */
+    int16_t                  pulses[],                       /* O    Excitation pulses [MAX_FRAME_LENGTH]        */
     int32_t                    lostFlag,                       /* I    0: no loss, 1 loss, 2 decode fec            */
-    int32_t                    condCoding,                     /* I    The type of conditional coding to use       */
-    int                         arch                            /* I    Run-time architecture                       */
+    int32_t                    condCoding                      /* I    The type of conditional coding to use       */
 )
 {
-    VARDECL( silk_decoder_control, psDecCtrl );
-    int32_t         L, mv_len, ret = 0;
-    SAVE_STACK;
-
-    L = psDec->frame_length;
-    ALLOC( psDecCtrl, 1, silk_decoder_control );
-    psDecCtrl->LTP_scale_Q14 = 0;
-
     /* Safety checks */
-    celt_assert( L > 0 && L <= MAX_FRAME_LENGTH );
+    celt_assert( psDec->frame_length > 0 && psDec->frame_length <= MAX_FRAME_LENGTH );
 
     if(   lostFlag == FLAG_DECODE_NORMAL ||
         ( lostFlag == FLAG_DECODE_LBRR && psDec->LBRR_flags[ psDec->nFramesDecoded ] == 1 ) )
     {
-        VARDECL( int16_t, pulses );
-        ALLOC( pulses, (L + SHELL_CODEC_FRAME_LENGTH - 1) &
-                       ~(SHELL_CODEC_FRAME_LENGTH - 1), int16_t );
         /*********************************************/
         /* Decode quantization indices of side info  */
         /*********************************************/
@@ -69,7 +56,33 @@ int32_t silk_decode_frame(
         /*********************************************/
         silk_decode_pulses( psRangeDec, pulses, psDec->indices.signalType,
                 psDec->indices.quantOffsetType, psDec->frame_length );
+    }
+}
 
+/********************************/
+/* Decode frame, synthesis part */
+/********************************/
+int32_t silk_decode_frame_synth(
+    silk_decoder_state          *psDec,                         /* I/O  Pointer to Silk decoder state               */
+    int16_t                  pOut[],                         /* O    Pointer to output speech frame              */
+    int32_t                  *pN,                            /* O    Pointer to size of output frame             */
+    const int16_t            pulses[],                       /* I    Pulses from silk_decode_frame_parse()       */
+    int32_t                    lostFlag,                       /* I    0: no loss, 1 loss, 2 decode fec            */
+    int32_t                    condCoding,                     /* I    The type of conditional coding to use       */
+    int                         arch                            /* I    Run-time architecture                       */
+)
+{
+    VARDECL( silk_decoder_control, psDecCtrl );
+    int32_t         L, mv_len, ret = 0;
+    SAVE_STACK;
+
+    L = psDec->frame_length;
+    ALLOC( psDecCtrl, 1, silk_decoder_control );
+    psDecCtrl->LTP_scale_Q14 = 0;
+
+    if(   lostFlag == FLAG_DECODE_NORMAL ||
+        ( lostFlag == FLAG_DECODE_LBRR && psDec->LBRR_flags[ psDec->nFramesDecoded ] == 1 ) )
+    {
         /********************************************/
         /* Decode parameters and pulse signal       */
         /********************************************/
@@ -124,3 +137,128 @@ int32_t silk_decode_frame(
     RESTORE_STACK;
     return ret;
 }
+
+/* 128 * log2() of a 64-bit value, which must be positive */
+static int32_t silk_lin2log64( int64_t x )
+{
+    int32_t shift = 0;
+
+    while( x > silk_int32_MAX ) {
+        x = silk_RSHIFT64( x, 1 );
+        shift++;
+    }
+    return silk_lin2log( (int32_t)silk_max_64( x, 1 ) ) + silk_LSHIFT( shift, 7 );
+}
+
+/* 128 * log2() of |A(e^jw)|^2 for the whitening filter A_Q12, where w is  */
+/* angle_Q7 / 128 * pi. Uses the 2 * cos() table of the NLSF conversion.  */
+static int32_t silk_LPC_response_log2( const int16_t *A_Q12, int32_t order, int32_t angle_Q7 )
+{
+    int32_t k, idx, re_Q12, im_Q12;
+
+    /* Both parts are doubled by the table */
+    re_Q12 = 2 * 4096;
+    im_Q12 = 0;
+    for( k = 0; k < order; k++ ) {
+        idx = ( angle_Q7 * ( k + 1 ) ) & 255;
+        re_Q12 -= silk_RSHIFT( silk_SMULBB( A_Q12[ k ], silk_LSFCosTab_FIX_Q12[ idx > 128 ? 256 - idx : idx ] ), 12 );
+        /* sin( x ) = cos( x - pi / 2 ), and cos() is even */
+        idx = ( angle_Q7 * ( k + 1 ) - 64 ) & 255;
+        im_Q12 += silk_RSHIFT( silk_SMULBB( A_Q12[ k ], silk_LSFCosTab_FIX_Q12[ idx > 128 ? 256 - idx : idx ] ), 12 );
+    }
+    /* Undo the doubling (2 bits) and the Q12 scaling of the squares */
+    return silk_lin2log64( silk_SMULL( re_Q12, re_Q12 ) + silk_SMULL( im_Q12, im_Q12 ) ) - ( 2 + 24 ) * 128;
+}
+
+/********************************************/
+/* Estimate the level of a frame, per band  */
+/********************************************/
+void silk_decode_frame_level(
+    silk_decoder_state          *psDec,                         /* I/O  Pointer to Silk decoder state               */
+    const int16_t            pulses[],                       /* I    Pulses from silk_decode_frame_parse()       */
+    int32_t                    condCoding,                     /* I    The type of conditional coding to use       */
+    const int32_t            band_Hz[],                      /* I    Band edges in Hz [ nb_bands + 1 ]           */
+    int32_t                    nb_bands,                       /* I    Number of bands                             */
+    int32_t                  level_Q7[]                      /* O    Power per band, 128 * log2 [ nb_bands ]     */
+)
+{
+    int32_t   i, k, b, x_Q10, offset_Q10, b_Q7, fs_half_Hz, lo_Hz, hi_Hz, res_Q7, sub_Q7;
+    int32_t   Gains_Q16[ MAX_NB_SUBFR ];
+    int16_t   NLSF_Q15[ MAX_LPC_ORDER ], A_Q12[ MAX_LPC_ORDER ];
+    const int8_t *cbk_ptr_Q7;
+    int64_t   nrg_Q20;
+
+    /* Only the parameters the level depends on are decoded, from the      */
+    /* second half of the frame: the interpolated LPC coefficients of the  */
+    /* first half cost a second conversion for little difference in level */
+    silk_gains_dequant( Gains_Q16, psDec->indices.GainsIndices,
+        &psDec->LastGainIndex, condCoding == CODE_CONDITIONALLY, psDec->nb_subfr );
+    silk_NLSF_decode( NLSF_Q15, psDec->indices.NLSFIndices, psDec->psNLSF_CB );
+    silk_NLSF2A( A_Q12, NLSF_Q15, psDec->LPC_order, psDec->arch );
+
+    /* Power of the LPC residual: the excitation that the pulses describe  */
+    /* (as rebuilt by silk_decode_core()) times the subframe gains         */
+    offset_Q10 = silk_Quantization_Offsets_Q10[ psDec->indices.signalType >> 1 ][ psDec->indices.quantOffsetType ];
+    cbk_ptr_Q7 = silk_LTP_vq_ptrs_Q7[ psDec->indices.PERIndex ];
+    res_Q7 = 0;
+    for( k = 0; k < psDec->nb_subfr; k++ ) {
+        nrg_Q20 = 0;
+        for( i = k * psDec->subfr_length; i < ( k + 1 ) * psDec->subfr_length; i++ ) {
+            x_Q10 = silk_LSHIFT( (int32_t)pulses[ i ], 10 );
+            if( x_Q10 > 0 ) {
+                x_Q10 -= QUANT_LEVEL_ADJUST_Q10;
+            } else if( x_Q10 < 0 ) {
+                x_Q10 += QUANT_LEVEL_ADJUST_Q10;
+            }
+            x_Q10 += offset_Q10;
+            nrg_Q20 += silk_SMULL( x_Q10, x_Q10 );
+        }
+        sub_Q7 = silk_lin2log64( nrg_Q20 ) + silk_LSHIFT( silk_lin2log( Gains_Q16[ k ] ), 1 );
+        if( psDec->indices.signalType == TYPE_VOICED ) {
+            /* The pitch predictor amplifies white noise by 1 / ( 1 - b^2 ) */
+            b_Q7 = 0;
+            for( i = 0; i < LTP_ORDER; i++ ) {
+                b_Q7 += cbk_ptr_Q7[ psDec->indices.LTPIndex[ k ] * LTP_ORDER + i ];
+            }
+            b_Q7 = silk_min_int( silk_abs( b_Q7 ), SILK_FIX_CONST( 0.95, 7 ) );
+            sub_Q7 -= silk_lin2log( ( 1 << 14 ) - silk_SMULBB( b_Q7, b_Q7 ) ) - 14 * 128;
+        }
+        res_Q7 = k == 0 ? sub_Q7 : silk_log2_add_Q7( res_Q7, sub_Q7 );
+    }
+    /* Mean over the frame; the pulses are Q20 and the gains Q16, squared */
+    res_Q7 -= silk_lin2log( psDec->frame_length ) + ( 20 + 2 * 16 ) * 128;
+
+    /* The residual is white, so a band gets its share of the bandwidth,   */
+    /* shaped by the LPC synthesis filter (evaluated at the band centre)   */
+    fs_half_Hz = silk_SMULBB( psDec->fs_kHz, 500 );
+    res_Q7 -= silk_lin2log( fs_half_Hz );
+    for( b = 0; b < nb_bands; b++ ) {
+        lo_Hz = band_Hz[ b ];
+        hi_Hz = silk_min_int( band_Hz[ b + 1 ], fs_half_Hz );
+        if( lo_Hz >= hi_Hz ) {
+            level_Q7[ b ] = SILK_LEVEL_FLOOR_Q7;
+            continue;
+        }
+        level_Q7[ b ] = res_Q7 + silk_lin2log( hi_Hz - lo_Hz ) - silk_LPC_response_log2( A_Q12, psDec->LPC_order,
+            silk_DIV32( silk_LSHIFT( lo_Hz + hi_Hz, 6 ) + silk_RSHIFT( fs_half_Hz, 1 ), fs_half_Hz ) );
+    }
+}
+
+/****************/
+/* Decode frame */
+/****************/
+int32_t silk_decode_frame(
+    silk_decoder_state          *psDec,                         /* I/O  Pointer to Silk decoder state               */
+    ec_dec                      *psRangeDec,                    /* I/O  Compressor data structure                   */
+    int16_t                  pOut[],                         /* O    Pointer to output speech frame              */
+    int32_t                  *pN,                            /* O    Pointer to size of output frame             */
+    int32_t                    lostFlag,                       /* I    0: no loss, 1 loss, 2 decode fec            */
+    int32_t                    condCoding,                     /* I    The type of conditional coding to use       */
+    int                         arch                            /* I    Run-time architecture                       */
+)
+{
+    int16_t pulses[ MAX_FRAME_LENGTH ];
+
+    silk_decode_frame_parse( psDec, psRangeDec, pulses, lostFlag, condCoding );
+    return silk_decode_frame_synth( psDec, pOut, pN, pulses, lostFlag, condCoding, arch );
+}
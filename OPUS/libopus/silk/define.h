@@ -134,6 +134,9 @@ extern "C"
 
 #define QUANT_LEVEL_ADJUST_Q10                  80
 
+/* Level reported by silk_decode_frame_level() for bands above the coded bandwidth */
+#define SILK_LEVEL_FLOOR_Q7                     ( -64 * 128 )
+
 /* Maximum numbers of iterations used to stabilize an LPC vector */
 #define MAX_LPC_STABILIZE_ITERATIONS            16
 #define MAX_PREDICTION_POWER_GAIN               1e4f
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "Arduino.h"
 #include "main_FIX.h"
 
@@ -85,3 +87,4 @@ void silk_LTP_analysis_filter_FIX(
     }
 }
 
+#endif /* !OPUS_FLOAT_BUILD */
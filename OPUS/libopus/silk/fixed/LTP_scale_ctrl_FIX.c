@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "main_FIX.h"
 
 /* Calculation of LTP state scaling */
@@ -47,3 +49,5 @@ void silk_LTP_scale_ctrl_FIX(
     }
     psEncCtrl->LTP_scale_Q14 = silk_LTPScales_table_Q14[ psEnc->sCmn.indices.LTP_scaleIndex ];
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "../SigProc_FIX.h"
 
 /* Apply sine window to signal vector.                                      */
@@ -95,3 +97,5 @@ void silk_apply_sine_window(
         S1_Q16 = silk_min( S1_Q16, ( (int32_t)1 << 16 ) );
     }
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "../SigProc_FIX.h"
 #include "../../celt/celt_lpc.h"
 
@@ -42,3 +44,5 @@ void silk_autocorr(
     corrCount = silk_min_int( inputDataSize, correlationCount );
     *scale = _celt_autocorr(inputData, results, NULL, 0, corrCount-1, inputDataSize, arch);
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
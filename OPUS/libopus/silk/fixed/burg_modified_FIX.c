@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "../SigProc_FIX.h"
 #include "../define.h"
 #include "../tuning_parameters.h"
@@ -280,3 +282,5 @@ void silk_burg_modified_c(
     free(CAb);
     free(xcorr);
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
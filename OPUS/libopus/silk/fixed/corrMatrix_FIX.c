@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 /**********************************************************************
  * Correlation Matrix Computations for LS estimate.
  **********************************************************************/
@@ -144,3 +146,4 @@ void silk_corrMatrix_FIX(
     }
 }
 
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include <stdlib.h>
 #include "main_FIX.h"
 #include "../../celt/stack_alloc.h"
@@ -442,3 +444,5 @@ static OPUS_INLINE void silk_LBRR_encode_FIX(
         silk_memcpy( psEncCtrl->Gains_Q16, TempGains_Q16, psEnc->sCmn.nb_subfr * sizeof( int32_t ) );
     }
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "main_FIX.h"
 #include "../tuning_parameters.h"
 
@@ -93,3 +95,5 @@ TOC(div)
         xXLTP_Q17_ptr += LTP_ORDER;
     }
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
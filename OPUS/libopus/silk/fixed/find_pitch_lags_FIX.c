@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "main_FIX.h"
 #include "../../celt/stack_alloc.h"
 #include "../tuning_parameters.h"
@@ -137,3 +139,5 @@ void silk_find_pitch_lags_FIX(
     }
     RESTORE_STACK;
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "main_FIX.h"
 #include "../../celt/stack_alloc.h"
 
@@ -139,3 +141,5 @@ void silk_find_pred_coefs_FIX(
     silk_memcpy( psEnc->sCmn.prev_NLSFq_Q15, NLSF_Q15, sizeof( psEnc->sCmn.prev_NLSFq_Q15 ) );
     RESTORE_STACK;
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "../SigProc_FIX.h"
 
 /* Step up function, converts reflection coefficients to prediction coefficients */
@@ -48,3 +50,5 @@ void silk_k2a(
         A_Q24[ k ] = -silk_LSHIFT( (int32_t)rc_Q15[ k ], 9 );
     }
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "main_FIX.h"
 #include "../../celt/stack_alloc.h"
 #include "../tuning_parameters.h"
@@ -401,3 +403,5 @@ void silk_noise_shape_analysis_FIX(
     RESTORE_STACK;
 }
 #endif /* OVERRIDE_silk_noise_shape_analysis_FIX */
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 /***********************************************************
 * Pitch analyser function
 ********************************************************** */
@@ -715,3 +717,5 @@ static void silk_P_Ana_calc_energy_st3(
     }
     RESTORE_STACK;
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
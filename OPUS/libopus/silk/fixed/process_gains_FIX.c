@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "main_FIX.h"
 #include "../tuning_parameters.h"
 
@@ -111,3 +113,5 @@ void silk_process_gains_FIX(
     silk_assert( psEncCtrl->Lambda_Q10 > 0 );
     silk_assert( psEncCtrl->Lambda_Q10 < SILK_FIX_CONST( 2, 10 ) );
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
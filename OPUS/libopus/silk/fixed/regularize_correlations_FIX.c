@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "main_FIX.h"
 
 /* Add noise to matrix diagonal */
@@ -41,3 +43,5 @@ void silk_regularize_correlations_FIX(
     }
     xx[ 0 ] += noise;
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "../SigProc_FIX.h"
 
 /* Faster than schur64(), but much less accurate.                       */
@@ -101,3 +103,5 @@ int32_t silk_schur(                              /* O    Returns residual energy
     /* return residual energy */
     return silk_max_32( 1, C[ 0 ][ 1 ] );
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "../SigProc_FIX.h"
 #include "../../celt/pitch.h"
 
@@ -87,3 +89,5 @@ int64_t silk_inner_prod16_aligned_64_c(
     }
     return sum;
 }
+
+#endif /* !OPUS_FLOAT_BUILD */
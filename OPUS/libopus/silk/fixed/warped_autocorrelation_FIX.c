@@ -25,6 +25,8 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 ***********************************************************************/
 
+#if !defined(OPUS_FLOAT_BUILD)
+
 #include "main_FIX.h"
 
 /* Autocorrelations for a warped frequency axis */
@@ -83,3 +85,5 @@ void silk_warped_autocorrelation_FIX_c(
     free(corr_QC);
 }
 #endif /* OVERRIDE_silk_warped_autocorrelation_FIX_c */
+
+#endif /* !OPUS_FLOAT_BUILD */
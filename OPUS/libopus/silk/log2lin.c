@@ -52,3 +52,20 @@ int32_t silk_log2lin(
     }
     return out;
 }
+
+/* Sum of two values on the log scale, without leaving it. Terms more than */
+/* 2^-20 below the larger one do not change the result.                    */
+int32_t silk_log2_add_Q7(
+    int32_t                    a_Q7,               /* I  first term on log scale                                        */
+    int32_t                    b_Q7                /* I  second term on log scale                                       */
+)
+{
+    int32_t max_Q7, diff_Q7;
+
+    max_Q7 = silk_max_int( a_Q7, b_Q7 );
+    diff_Q7 = max_Q7 - silk_min_int( a_Q7, b_Q7 );
+    if( diff_Q7 >= 20 * 128 ) {
+        return max_Q7;
+    }
+    return max_Q7 + silk_lin2log( silk_LSHIFT( 1, 16 ) + silk_log2lin( 16 * 128 - diff_Q7 ) ) - 16 * 128;
+}
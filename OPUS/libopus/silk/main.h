@@ -413,6 +413,37 @@ int32_t silk_decode_frame(
     int                         arch                            /* I    Run-time architecture                       */
 );
 
+/* Bitstream part of silk_decode_frame(): indices and excitation pulses */
+void silk_decode_frame_parse(
+    silk_decoder_state          *psDec,                         /* I/O  Pointer to Silk decoder state               */
+    ec_dec                      *psRangeDec,                    /* I/O  Compressor data structure                   */
+    int16_t                  pulses[],                       /* O    Excitation pulses [MAX_FRAME_LENGTH]        */
+    int32_t                    lostFlag,                       /* I    0: no loss, 1 loss, 2 decode fec            */
+    int32_t                    condCoding                      /* I    The type of conditional coding to use       */
+);
+
+/* Synthesis part of silk_decode_frame(); does not read the range decoder */
+int32_t silk_decode_frame_synth(
+    silk_decoder_state          *psDec,                         /* I/O  Pointer to Silk decoder state               */
+    int16_t                  pOut[],                         /* O    Pointer to output speech frame              */
+    int32_t                  *pN,                            /* O    Pointer to size of output frame             */
+    const int16_t            pulses[],                       /* I    Pulses from silk_decode_frame_parse()       */
+    int32_t                    lostFlag,                       /* I    0: no loss, 1 loss, 2 decode fec            */
+    int32_t                    condCoding,                     /* I    The type of conditional coding to use       */
+    int                         arch                            /* I    Run-time architecture                       */
+);
+
+/* Level estimate for silk_decode_frame() in place of the synthesis: power */
+/* per band, from the gains, pulses and LPC/LTP parameters of the frame    */
+void silk_decode_frame_level(
+    silk_decoder_state          *psDec,                         /* I/O  Pointer to Silk decoder state               */
+    const int16_t            pulses[],                       /* I    Pulses from silk_decode_frame_parse()       */
+    int32_t                    condCoding,                     /* I    The type of conditional coding to use       */
+    const int32_t            band_Hz[],                      /* I    Band edges in Hz [ nb_bands + 1 ]           */
+    int32_t                    nb_bands,                       /* I    Number of bands                             */
+    int32_t                  level_Q7[]                      /* O    Power per band, 128 * log2 [ nb_bands ]     */
+);
+
 /* Decode indices from bitstream */
 void silk_decode_indices(
     silk_decoder_state          *psDec,                         /* I/O  State                                       */
@@ -438,6 +469,48 @@ void silk_decode_core(
     int                         arch                            /* I    Run-time architecture                       */
 );
 
+/* Long-term synthesis of one subframe, used by silk_decode_core() */
+void silk_LTP_synthesis_c(
+    int32_t                  pres_Q14[],                     /* O    LPC excitation                              */
+    int32_t                  sLTP_Q15[],                     /* I/O  LTP state, at the first new sample          */
+    const int32_t            pexc_Q14[],                     /* I    Excitation                                  */
+    const int16_t            B_Q14[ LTP_ORDER ],             /* I    LTP coefficients                            */
+    int                         lag,                            /* I    Pitch lag                                   */
+    int                         length                          /* I    Subframe length                             */
+);
+
+/* Short-term synthesis and gain scaling of one subframe, used by silk_decode_core() */
+void silk_LPC_synthesis_c(
+    int32_t                  sLPC_Q14[],                     /* I/O  LPC state                                   */
+    int16_t                  xq[],                           /* O    Decoded speech                              */
+    const int32_t            pres_Q14[],                     /* I    LPC excitation                              */
+    const int16_t            A_Q12[],                        /* I    LPC coefficients                            */
+    int32_t                  Gain_Q10,                       /* I    Subframe gain                               */
+    int                         LPC_order,                      /* I    LPC order, 10 or 16                         */
+    int                         length                          /* I    Subframe length                             */
+);
+
+#if !defined(OVERRIDE_silk_decode_core_synthesis) && defined(OPUS_ESP32S3_PIE)
+/* ESP32-S3 hook: a PIE (128-bit SIMD) port provides these with the same
+   contract as the _c versions, bit-exact output included. */
+#define OVERRIDE_silk_decode_core_synthesis
+void silk_LTP_synthesis_pie( int32_t pres_Q14[], int32_t sLTP_Q15[], const int32_t pexc_Q14[],
+    const int16_t B_Q14[ LTP_ORDER ], int lag, int length );
+void silk_LPC_synthesis_pie( int32_t sLPC_Q14[], int16_t xq[], const int32_t pres_Q14[],
+    const int16_t A_Q12[], int32_t Gain_Q10, int LPC_order, int length );
+#define silk_LTP_synthesis( pres_Q14, sLTP_Q15, pexc_Q14, B_Q14, lag, length, arch ) \
+    ((void)(arch), silk_LTP_synthesis_pie( pres_Q14, sLTP_Q15, pexc_Q14, B_Q14, lag, length ))
+#define silk_LPC_synthesis( sLPC_Q14, xq, pres_Q14, A_Q12, Gain_Q10, LPC_order, length, arch ) \
+    ((void)(arch), silk_LPC_synthesis_pie( sLPC_Q14, xq, pres_Q14, A_Q12, Gain_Q10, LPC_order, length ))
+#endif
+
+#if !defined(OVERRIDE_silk_decode_core_synthesis)
+#define silk_LTP_synthesis( pres_Q14, sLTP_Q15, pexc_Q14, B_Q14, lag, length, arch ) \
+    ((void)(arch), silk_LTP_synthesis_c( pres_Q14, sLTP_Q15, pexc_Q14, B_Q14, lag, length ))
+#define silk_LPC_synthesis( sLPC_Q14, xq, pres_Q14, A_Q12, Gain_Q10, LPC_order, length, arch ) \
+    ((void)(arch), silk_LPC_synthesis_c( sLPC_Q14, xq, pres_Q14, A_Q12, Gain_Q10, LPC_order, length ))
+#endif
+
 /* Decode quantization indices of excitation (Shell coding) */
 void silk_decode_pulses(
     ec_dec                      *psRangeDec,                    /* I/O  Compressor data structure                   */
@@ -174,7 +174,8 @@ int32_t silk_resampler(
     silk_resampler_state_struct *S,                 /* I/O  Resampler state                                             */
     int16_t                  out[],              /* O    Output signal                                               */
     const int16_t            in[],               /* I    Input signal                                                */
-    int32_t                  inLen               /* I    Number of input samples                                     */
+    int32_t                  inLen,              /* I    Number of input samples                                     */
+    int                      arch                /* I    Run-time architecture                                       */
 )
 {
     int32_t nSamples;
@@ -195,12 +196,12 @@ int32_t silk_resampler(
             silk_resampler_private_up2_HQ_wrapper( S, &out[ S->Fs_out_kHz ], &in[ nSamples ], inLen - S->Fs_in_kHz );
             break;
         case USE_silk_resampler_private_IIR_FIR:
-            silk_resampler_private_IIR_FIR( S, out, S->delayBuf, S->Fs_in_kHz );
-            silk_resampler_private_IIR_FIR( S, &out[ S->Fs_out_kHz ], &in[ nSamples ], inLen - S->Fs_in_kHz );
+            silk_resampler_private_IIR_FIR( S, out, S->delayBuf, S->Fs_in_kHz, arch );
+            silk_resampler_private_IIR_FIR( S, &out[ S->Fs_out_kHz ], &in[ nSamples ], inLen - S->Fs_in_kHz, arch );
             break;
         case USE_silk_resampler_private_down_FIR:
-            silk_resampler_private_down_FIR( S, out, S->delayBuf, S->Fs_in_kHz );
-            silk_resampler_private_down_FIR( S, &out[ S->Fs_out_kHz ], &in[ nSamples ], inLen - S->Fs_in_kHz );
+            silk_resampler_private_down_FIR( S, out, S->delayBuf, S->Fs_in_kHz, arch );
+            silk_resampler_private_down_FIR( S, &out[ S->Fs_out_kHz ], &in[ nSamples ], inLen - S->Fs_in_kHz, arch );
             break;
         default:
             silk_memcpy( out, S->delayBuf, S->Fs_in_kHz * sizeof( int16_t ) );
@@ -46,7 +46,8 @@ void silk_resampler_private_IIR_FIR(
     void                            *SS,            /* I/O  Resampler state             */
     int16_t                      out[],          /* O    Output signal               */
     const int16_t                in[],           /* I    Input signal                */
-    int32_t                      inLen           /* I    Number of input samples     */
+    int32_t                      inLen,          /* I    Number of input samples     */
+    int                          arch            /* I    Run-time architecture       */
 );
 
 /* Description: Hybrid IIR/FIR polyphase implementation of resampling */
@@ -54,9 +55,40 @@ void silk_resampler_private_down_FIR(
     void                            *SS,            /* I/O  Resampler state             */
     int16_t                      out[],          /* O    Output signal               */
     const int16_t                in[],           /* I    Input signal                */
-    int32_t                      inLen           /* I    Number of input samples     */
+    int32_t                      inLen,          /* I    Number of input samples     */
+    int                          arch            /* I    Run-time architecture       */
 );
 
+/* Fractional interpolation of the 2x upsampled signal, used by silk_resampler_private_IIR_FIR() */
+int16_t *silk_resampler_private_IIR_FIR_INTERPOL_c(
+    int16_t                      *out,           /* O    Output signal               */
+    int16_t                      *buf,           /* I    Upsampled signal            */
+    int32_t                      max_index_Q16,  /* I    End of the input, Q16       */
+    int32_t                      index_increment_Q16 /* I Input step per output, Q16 */
+);
+
+/* Polyphase FIR of the AR2-filtered signal, used by silk_resampler_private_down_FIR() */
+int16_t *silk_resampler_private_down_FIR_INTERPOL_c(
+    int16_t                      *out,           /* O    Output signal               */
+    int32_t                      *buf,           /* I    Filtered signal, Q8         */
+    const int16_t                *FIR_Coefs,     /* I    FIR coefficients            */
+    int32_t                      FIR_Order,      /* I    FIR order                   */
+    int32_t                      FIR_Fracs,      /* I    Number of fractional phases */
+    int32_t                      max_index_Q16,  /* I    End of the input, Q16       */
+    int32_t                      index_increment_Q16 /* I Input step per output, Q16 */
+);
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+#include "x86/resampler_sse.h"
+#endif
+
+#if !defined(OVERRIDE_silk_resampler_private_INTERPOL)
+#define silk_resampler_private_IIR_FIR_INTERPOL( out, buf, max_index_Q16, index_increment_Q16, arch ) \
+    ((void)(arch), silk_resampler_private_IIR_FIR_INTERPOL_c( out, buf, max_index_Q16, index_increment_Q16 ))
+#define silk_resampler_private_down_FIR_INTERPOL( out, buf, FIR_Coefs, FIR_Order, FIR_Fracs, max_index_Q16, index_increment_Q16, arch ) \
+    ((void)(arch), silk_resampler_private_down_FIR_INTERPOL_c( out, buf, FIR_Coefs, FIR_Order, FIR_Fracs, max_index_Q16, index_increment_Q16 ))
+#endif
+
 /* Upsample by a factor 2, high quality */
 void silk_resampler_private_up2_HQ_wrapper(
     void                            *SS,            /* I/O  Resampler state (unused)    */
@@ -29,7 +29,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "resampler_private.h"
 #include "../celt/stack_alloc.h"
 
-static OPUS_INLINE int16_t *silk_resampler_private_IIR_FIR_INTERPOL(
+int16_t *silk_resampler_private_IIR_FIR_INTERPOL_c(
     int16_t  *out,
     int16_t  *buf,
     int32_t  max_index_Q16,
@@ -62,7 +62,8 @@ void silk_resampler_private_IIR_FIR(
     void                            *SS,            /* I/O  Resampler state             */
     int16_t                      out[],          /* O    Output signal               */
     const int16_t                in[],           /* I    Input signal                */
-    int32_t                      inLen           /* I    Number of input samples     */
+    int32_t                      inLen,          /* I    Number of input samples     */
+    int                          arch            /* I    Run-time architecture       */
 )
 {
     silk_resampler_state_struct *S = (silk_resampler_state_struct *)SS;
@@ -85,7 +86,7 @@ void silk_resampler_private_IIR_FIR(
         silk_resampler_private_up2_HQ( S->sIIR, &buf[ RESAMPLER_ORDER_FIR_12 ], in, nSamplesIn );
 
         max_index_Q16 = silk_LSHIFT32( nSamplesIn, 16 + 1 );         /* + 1 because 2x upsampling */
-        out = silk_resampler_private_IIR_FIR_INTERPOL( out, buf, max_index_Q16, index_increment_Q16 );
+        out = silk_resampler_private_IIR_FIR_INTERPOL( out, buf, max_index_Q16, index_increment_Q16, arch );
         in += nSamplesIn;
         inLen -= nSamplesIn;
 
@@ -30,7 +30,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "resampler_private.h"
 #include "../celt/stack_alloc.h"
 
-static OPUS_INLINE int16_t *silk_resampler_private_down_FIR_INTERPOL(
+int16_t *silk_resampler_private_down_FIR_INTERPOL_c(
     int16_t          *out,
     int32_t          *buf,
     const int16_t    *FIR_Coefs,
@@ -143,7 +143,8 @@ void silk_resampler_private_down_FIR(
     void                            *SS,            /* I/O  Resampler state             */
     int16_t                      out[],          /* O    Output signal               */
     const int16_t                in[],           /* I    Input signal                */
-    int32_t                      inLen           /* I    Number of input samples     */
+    int32_t                      inLen,          /* I    Number of input samples     */
+    int                          arch            /* I    Run-time architecture       */
 )
 {
     silk_resampler_state_struct *S = (silk_resampler_state_struct *)SS;
@@ -172,7 +173,7 @@ void silk_resampler_private_down_FIR(
 
         /* Interpolate filtered signal */
         out = silk_resampler_private_down_FIR_INTERPOL( out, buf, FIR_Coefs, S->FIR_Order,
-            S->FIR_Fracs, max_index_Q16, index_increment_Q16 );
+            S->FIR_Fracs, max_index_Q16, index_increment_Q16, arch );
 
         in += nSamplesIn;
         inLen -= nSamplesIn;
@@ -0,0 +1,149 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../main.h"
+#include "../../celt/x86/x86cpu.h"
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+#include "macros_sse4_1.h"
+
+/* Same as silk_LTP_synthesis_c(), four output samples per step. A block of
+   four only reads LTP state written before the block as long as the lag is
+   at least 4 + LTP_ORDER / 2, which SILK pitch lags always are. */
+void OPUS_TARGET_SSE4_1 silk_LTP_synthesis_sse4_1(
+    int32_t                  pres_Q14[],                     /* O    LPC excitation                              */
+    int32_t                  sLTP_Q15[],                     /* I/O  LTP state, at the first new sample          */
+    const int32_t            pexc_Q14[],                     /* I    Excitation                                  */
+    const int16_t            B_Q14[ LTP_ORDER ],             /* I    LTP coefficients                            */
+    int                         lag,                            /* I    Pitch lag                                   */
+    int                         length                          /* I    Subframe length                             */
+)
+{
+    int i;
+    int32_t LTP_pred_Q13;
+    const int32_t *pred_lag_ptr;
+    __m128i b0, b1, b2, b3, b4, pred, res;
+
+    if( lag < 4 + LTP_ORDER / 2 ) {
+        silk_LTP_synthesis_c( pres_Q14, sLTP_Q15, pexc_Q14, B_Q14, lag, length );
+        return;
+    }
+
+    pred_lag_ptr = &sLTP_Q15[ -lag + LTP_ORDER / 2 ];
+    b0 = _mm_set1_epi32( B_Q14[ 0 ] );
+    b1 = _mm_set1_epi32( B_Q14[ 1 ] );
+    b2 = _mm_set1_epi32( B_Q14[ 2 ] );
+    b3 = _mm_set1_epi32( B_Q14[ 3 ] );
+    b4 = _mm_set1_epi32( B_Q14[ 4 ] );
+    for( i = 0; i < length - 3; i += 4 ) {
+        pred = _mm_set1_epi32( 2 );
+        pred = _mm_add_epi32( pred, silk_SMULWW_epi32( _mm_loadu_si128( (const __m128i *)&pred_lag_ptr[ i     ] ), b0 ) );
+        pred = _mm_add_epi32( pred, silk_SMULWW_epi32( _mm_loadu_si128( (const __m128i *)&pred_lag_ptr[ i - 1 ] ), b1 ) );
+        pred = _mm_add_epi32( pred, silk_SMULWW_epi32( _mm_loadu_si128( (const __m128i *)&pred_lag_ptr[ i - 2 ] ), b2 ) );
+        pred = _mm_add_epi32( pred, silk_SMULWW_epi32( _mm_loadu_si128( (const __m128i *)&pred_lag_ptr[ i - 3 ] ), b3 ) );
+        pred = _mm_add_epi32( pred, silk_SMULWW_epi32( _mm_loadu_si128( (const __m128i *)&pred_lag_ptr[ i - 4 ] ), b4 ) );
+
+        res = _mm_add_epi32( _mm_loadu_si128( (const __m128i *)&pexc_Q14[ i ] ), _mm_slli_epi32( pred, 1 ) );
+        _mm_storeu_si128( (__m128i *)&pres_Q14[ i ], res );
+        _mm_storeu_si128( (__m128i *)&sLTP_Q15[ i ], _mm_slli_epi32( res, 1 ) );
+    }
+    for( ; i < length; i++ ) {
+        LTP_pred_Q13 = 2;
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ i     ], B_Q14[ 0 ] );
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ i - 1 ], B_Q14[ 1 ] );
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ i - 2 ], B_Q14[ 2 ] );
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ i - 3 ], B_Q14[ 3 ] );
+        LTP_pred_Q13 = silk_SMLAWB( LTP_pred_Q13, pred_lag_ptr[ i - 4 ], B_Q14[ 4 ] );
+        pres_Q14[ i ] = silk_ADD_LSHIFT32( pexc_Q14[ i ], LTP_pred_Q13, 1 );
+        sLTP_Q15[ i ] = silk_LSHIFT( pres_Q14[ i ], 1 );
+    }
+}
+
+/* Same as silk_LPC_synthesis_c(). The recursion stays one sample at a time,
+   but each prediction is a single dot product of the last 16 state samples
+   against the coefficients stored in history order (zero-padded for order
+   10). The window is kept in registers and shifted along as samples are
+   produced, so nothing is reloaded from the state just written. The gain
+   scaling is a separate pass over the finished subframe. */
+void OPUS_TARGET_SSE4_1 silk_LPC_synthesis_sse4_1(
+    int32_t                  sLPC_Q14[],                     /* I/O  LPC state                                   */
+    int16_t                  xq[],                           /* O    Decoded speech                              */
+    const int32_t            pres_Q14[],                     /* I    LPC excitation                              */
+    const int16_t            A_Q12[],                        /* I    LPC coefficients                            */
+    int32_t                  Gain_Q10,                       /* I    Subframe gain                               */
+    int                         LPC_order,                      /* I    LPC order, 10 or 16                         */
+    int                         length                          /* I    Subframe length                             */
+)
+{
+    int i, j;
+    int32_t LPC_pred_Q10, out_Q14, A_rev[ MAX_LPC_ORDER ];
+    __m128i a0, a1, a2, a3, w0, w1, w2, w3, acc, gain, out;
+
+    celt_assert( LPC_order == 10 || LPC_order == 16 );
+    silk_memset( A_rev, 0, sizeof( A_rev ) );
+    for( j = 0; j < LPC_order; j++ ) {
+        A_rev[ MAX_LPC_ORDER - 1 - j ] = A_Q12[ j ];
+    }
+    a0 = _mm_loadu_si128( (const __m128i *)&A_rev[  0 ] );
+    a1 = _mm_loadu_si128( (const __m128i *)&A_rev[  4 ] );
+    a2 = _mm_loadu_si128( (const __m128i *)&A_rev[  8 ] );
+    a3 = _mm_loadu_si128( (const __m128i *)&A_rev[ 12 ] );
+    w0 = _mm_loadu_si128( (const __m128i *)&sLPC_Q14[  0 ] );
+    w1 = _mm_loadu_si128( (const __m128i *)&sLPC_Q14[  4 ] );
+    w2 = _mm_loadu_si128( (const __m128i *)&sLPC_Q14[  8 ] );
+    w3 = _mm_loadu_si128( (const __m128i *)&sLPC_Q14[ 12 ] );
+
+    for( i = 0; i < length; i++ ) {
+        acc = _mm_add_epi32( silk_SMULWW_epi32( w0, a0 ), silk_SMULWW_epi32( w1, a1 ) );
+        acc = _mm_add_epi32( acc, _mm_add_epi32( silk_SMULWW_epi32( w2, a2 ), silk_SMULWW_epi32( w3, a3 ) ) );
+        acc = _mm_add_epi32( acc, _mm_shuffle_epi32( acc, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+        acc = _mm_add_epi32( acc, _mm_shuffle_epi32( acc, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+        /* Avoids introducing a bias because silk_SMLAWB() always rounds to -inf */
+        LPC_pred_Q10 = silk_ADD32_ovflw( silk_RSHIFT( LPC_order, 1 ), _mm_cvtsi128_si32( acc ) );
+
+        /* Add prediction to LPC excitation */
+        out_Q14 = silk_ADD_SAT32( pres_Q14[ i ], silk_LSHIFT_SAT32( LPC_pred_Q10, 4 ) );
+        sLPC_Q14[ MAX_LPC_ORDER + i ] = out_Q14;
+
+        w0 = _mm_alignr_epi8( w1, w0, 4 );
+        w1 = _mm_alignr_epi8( w2, w1, 4 );
+        w2 = _mm_alignr_epi8( w3, w2, 4 );
+        w3 = _mm_alignr_epi8( _mm_cvtsi32_si128( out_Q14 ), w3, 4 );
+    }
+
+    /* Scale with gain */
+    gain = _mm_set1_epi32( Gain_Q10 );
+    for( i = 0; i < length - 3; i += 4 ) {
+        out = silk_SMULWW_epi32( _mm_loadu_si128( (const __m128i *)&sLPC_Q14[ MAX_LPC_ORDER + i ] ), gain );
+        out = _mm_srai_epi32( _mm_add_epi32( _mm_srai_epi32( out, 7 ), _mm_set1_epi32( 1 ) ), 1 );
+        _mm_storel_epi64( (__m128i *)&xq[ i ], _mm_packs_epi32( out, out ) );
+    }
+    for( ; i < length; i++ ) {
+        xq[ i ] = (int16_t)silk_SAT16( silk_RSHIFT_ROUND( silk_SMULWW( sLPC_Q14[ MAX_LPC_ORDER + i ], Gain_Q10 ), 8 ) );
+    }
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SILK_MACROS_SSE4_1_H
+#define SILK_MACROS_SSE4_1_H
+
+#include <smmintrin.h>
+#include "../../celt/x86/x86cpu.h"
+
+/* silk_SMULWW() on four lanes, taken from the full 64-bit product. With the
+   second operand sign-extended from 16 bits this is silk_SMULWB(), so both
+   the fixed-point C macro forms give the same bits. */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 __m128i silk_SMULWW_epi32( __m128i a, __m128i b )
+{
+    __m128i even, odd;
+    even = _mm_srli_epi64( _mm_mul_epi32( a, b ), 16 );
+    odd  = _mm_mul_epi32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+    odd  = _mm_slli_epi64( odd, 16 );
+    return _mm_blend_epi16( even, odd, 0xCC );
+}
+
+/* Sums of the four lanes of each argument, as the four lanes of the result */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 __m128i silk_hsum4_epi32( __m128i a, __m128i b, __m128i c, __m128i d )
+{
+    return _mm_hadd_epi32( _mm_hadd_epi32( a, b ), _mm_hadd_epi32( c, d ) );
+}
+
+#endif
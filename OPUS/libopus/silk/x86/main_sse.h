@@ -0,0 +1,120 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef MAIN_SSE_H
+#define MAIN_SSE_H
+
+/* The SSE4.1 encoder kernels (NSQ, VAD, VQ_WMat_EC) are not part of this
+   tree, so their C versions are used as-is. NSQ.c and VAD.c still export
+   the helpers those kernels share whenever SSE4.1 may be present. */
+
+# if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+void silk_noise_shape_quantizer(
+    silk_nsq_state      *NSQ,
+    int32_t             signalType,
+    const int32_t       x_sc_Q10[],
+    int8_t              pulses[],
+    int16_t             xq[],
+    int32_t             sLTP_Q15[],
+    const int16_t       a_Q12[],
+    const int16_t       b_Q14[],
+    const int16_t       AR_shp_Q13[],
+    int32_t             lag,
+    int32_t             HarmShapeFIRPacked_Q14,
+    int32_t             Tilt_Q14,
+    int32_t             LF_shp_Q14,
+    int32_t             Gain_Q16,
+    int32_t             Lambda_Q10,
+    int32_t             offset_Q10,
+    int32_t             length,
+    int32_t             shapingLPCOrder,
+    int32_t             predictLPCOrder,
+    int                 arch
+);
+
+void silk_VAD_GetNoiseLevels(
+    const int32_t       pX[ VAD_N_BANDS ],
+    silk_VAD_state      *psSilk_VAD
+);
+
+void silk_LTP_synthesis_sse4_1(
+    int32_t                  pres_Q14[],
+    int32_t                  sLTP_Q15[],
+    const int32_t            pexc_Q14[],
+    const int16_t            B_Q14[ LTP_ORDER ],
+    int                         lag,
+    int                         length
+);
+
+void silk_LPC_synthesis_sse4_1(
+    int32_t                  sLPC_Q14[],
+    int16_t                  xq[],
+    const int32_t            pres_Q14[],
+    const int16_t            A_Q12[],
+    int32_t                  Gain_Q10,
+    int                         LPC_order,
+    int                         length
+);
+
+#  if defined(OPUS_X86_PRESUME_SSE4_1)
+
+#   define OVERRIDE_silk_decode_core_synthesis
+#   define silk_LTP_synthesis( pres_Q14, sLTP_Q15, pexc_Q14, B_Q14, lag, length, arch ) \
+    ((void)(arch), silk_LTP_synthesis_sse4_1( pres_Q14, sLTP_Q15, pexc_Q14, B_Q14, lag, length ))
+#   define silk_LPC_synthesis( sLPC_Q14, xq, pres_Q14, A_Q12, Gain_Q10, LPC_order, length, arch ) \
+    ((void)(arch), silk_LPC_synthesis_sse4_1( sLPC_Q14, xq, pres_Q14, A_Q12, Gain_Q10, LPC_order, length ))
+
+#  elif defined(OPUS_HAVE_RTCD)
+
+extern void (*const SILK_LTP_SYNTHESIS_IMPL[ OPUS_ARCHMASK + 1 ] )(
+    int32_t                  pres_Q14[],
+    int32_t                  sLTP_Q15[],
+    const int32_t            pexc_Q14[],
+    const int16_t            B_Q14[ LTP_ORDER ],
+    int                         lag,
+    int                         length
+);
+
+extern void (*const SILK_LPC_SYNTHESIS_IMPL[ OPUS_ARCHMASK + 1 ] )(
+    int32_t                  sLPC_Q14[],
+    int16_t                  xq[],
+    const int32_t            pres_Q14[],
+    const int16_t            A_Q12[],
+    int32_t                  Gain_Q10,
+    int                         LPC_order,
+    int                         length
+);
+
+#   define OVERRIDE_silk_decode_core_synthesis
+#   define silk_LTP_synthesis( pres_Q14, sLTP_Q15, pexc_Q14, B_Q14, lag, length, arch ) \
+    ((*SILK_LTP_SYNTHESIS_IMPL[ (arch) & OPUS_ARCHMASK ])( pres_Q14, sLTP_Q15, pexc_Q14, B_Q14, lag, length ))
+#   define silk_LPC_synthesis( sLPC_Q14, xq, pres_Q14, A_Q12, Gain_Q10, LPC_order, length, arch ) \
+    ((*SILK_LPC_SYNTHESIS_IMPL[ (arch) & OPUS_ARCHMASK ])( sLPC_Q14, xq, pres_Q14, A_Q12, Gain_Q10, LPC_order, length ))
+
+#  endif
+# endif
+
+#endif
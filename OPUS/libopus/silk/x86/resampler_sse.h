@@ -0,0 +1,84 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SILK_RESAMPLER_SSE_H
+#define SILK_RESAMPLER_SSE_H
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+int16_t *silk_resampler_private_IIR_FIR_INTERPOL_sse4_1(
+    int16_t                      *out,
+    int16_t                      *buf,
+    int32_t                      max_index_Q16,
+    int32_t                      index_increment_Q16
+);
+
+int16_t *silk_resampler_private_down_FIR_INTERPOL_sse4_1(
+    int16_t                      *out,
+    int32_t                      *buf,
+    const int16_t                *FIR_Coefs,
+    int32_t                      FIR_Order,
+    int32_t                      FIR_Fracs,
+    int32_t                      max_index_Q16,
+    int32_t                      index_increment_Q16
+);
+
+# if defined(OPUS_X86_PRESUME_SSE4_1)
+
+#  define OVERRIDE_silk_resampler_private_INTERPOL
+#  define silk_resampler_private_IIR_FIR_INTERPOL( out, buf, max_index_Q16, index_increment_Q16, arch ) \
+    ((void)(arch), silk_resampler_private_IIR_FIR_INTERPOL_sse4_1( out, buf, max_index_Q16, index_increment_Q16 ))
+#  define silk_resampler_private_down_FIR_INTERPOL( out, buf, FIR_Coefs, FIR_Order, FIR_Fracs, max_index_Q16, index_increment_Q16, arch ) \
+    ((void)(arch), silk_resampler_private_down_FIR_INTERPOL_sse4_1( out, buf, FIR_Coefs, FIR_Order, FIR_Fracs, max_index_Q16, index_increment_Q16 ))
+
+# elif defined(OPUS_HAVE_RTCD)
+
+extern int16_t *(*const SILK_RESAMPLER_IIR_FIR_INTERPOL_IMPL[ OPUS_ARCHMASK + 1 ] )(
+    int16_t                      *out,
+    int16_t                      *buf,
+    int32_t                      max_index_Q16,
+    int32_t                      index_increment_Q16
+);
+
+extern int16_t *(*const SILK_RESAMPLER_DOWN_FIR_INTERPOL_IMPL[ OPUS_ARCHMASK + 1 ] )(
+    int16_t                      *out,
+    int32_t                      *buf,
+    const int16_t                *FIR_Coefs,
+    int32_t                      FIR_Order,
+    int32_t                      FIR_Fracs,
+    int32_t                      max_index_Q16,
+    int32_t                      index_increment_Q16
+);
+
+#  define OVERRIDE_silk_resampler_private_INTERPOL
+#  define silk_resampler_private_IIR_FIR_INTERPOL( out, buf, max_index_Q16, index_increment_Q16, arch ) \
+    ((*SILK_RESAMPLER_IIR_FIR_INTERPOL_IMPL[ (arch) & OPUS_ARCHMASK ])( out, buf, max_index_Q16, index_increment_Q16 ))
+#  define silk_resampler_private_down_FIR_INTERPOL( out, buf, FIR_Coefs, FIR_Order, FIR_Fracs, max_index_Q16, index_increment_Q16, arch ) \
+    ((*SILK_RESAMPLER_DOWN_FIR_INTERPOL_IMPL[ (arch) & OPUS_ARCHMASK ])( out, buf, FIR_Coefs, FIR_Order, FIR_Fracs, max_index_Q16, index_increment_Q16 ))
+
+# endif
+#endif
+
+#endif
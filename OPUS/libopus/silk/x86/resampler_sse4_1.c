@@ -0,0 +1,226 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../resampler_private.h"
+#include "../../celt/x86/x86cpu.h"
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+#include "macros_sse4_1.h"
+
+/* Same as silk_resampler_private_IIR_FIR_INTERPOL_c(). Both halves of each
+   of the 12 phases are laid out as one 8-tap row, so every output is a single
+   pmaddwd against the upsampled signal; four outputs are summed and rounded
+   together. The 16x16-bit products and their sums are exact, as in C. */
+int16_t * OPUS_TARGET_SSE4_1 silk_resampler_private_IIR_FIR_INTERPOL_sse4_1(
+    int16_t                      *out,           /* O    Output signal               */
+    int16_t                      *buf,           /* I    Upsampled signal            */
+    int32_t                      max_index_Q16,  /* I    End of the input, Q16       */
+    int32_t                      index_increment_Q16 /* I Input step per output, Q16 */
+)
+{
+    int k, j;
+    int32_t index_Q16, table_index;
+    int16_t FIR_Coefs[ 12 ][ RESAMPLER_ORDER_FIR_12 ];
+    __m128i prod[ 4 ], res;
+
+    for( k = 0; k < 12; k++ ) {
+        for( j = 0; j < RESAMPLER_ORDER_FIR_12 / 2; j++ ) {
+            FIR_Coefs[ k ][ j ] = silk_resampler_frac_FIR_12[ k ][ j ];
+            FIR_Coefs[ k ][ RESAMPLER_ORDER_FIR_12 - 1 - j ] = silk_resampler_frac_FIR_12[ 11 - k ][ j ];
+        }
+    }
+
+    index_Q16 = 0;
+    while( index_Q16 + 3 * index_increment_Q16 < max_index_Q16 ) {
+        for( j = 0; j < 4; j++ ) {
+            table_index = silk_SMULWB( index_Q16 & 0xFFFF, 12 );
+            prod[ j ] = _mm_madd_epi16( _mm_loadu_si128( (const __m128i *)&buf[ index_Q16 >> 16 ] ),
+                                        _mm_loadu_si128( (const __m128i *)FIR_Coefs[ table_index ] ) );
+            index_Q16 += index_increment_Q16;
+        }
+        res = silk_hsum4_epi32( prod[ 0 ], prod[ 1 ], prod[ 2 ], prod[ 3 ] );
+        res = _mm_srai_epi32( _mm_add_epi32( _mm_srai_epi32( res, 14 ), _mm_set1_epi32( 1 ) ), 1 );
+        _mm_storel_epi64( (__m128i *)out, _mm_packs_epi32( res, res ) );
+        out += 4;
+    }
+    for( ; index_Q16 < max_index_Q16; index_Q16 += index_increment_Q16 ) {
+        table_index = silk_SMULWB( index_Q16 & 0xFFFF, 12 );
+        prod[ 0 ] = _mm_madd_epi16( _mm_loadu_si128( (const __m128i *)&buf[ index_Q16 >> 16 ] ),
+                                    _mm_loadu_si128( (const __m128i *)FIR_Coefs[ table_index ] ) );
+        res = silk_hsum4_epi32( prod[ 0 ], prod[ 0 ], prod[ 0 ], prod[ 0 ] );
+        *out++ = (int16_t)silk_SAT16( silk_RSHIFT_ROUND( _mm_cvtsi128_si32( res ), 15 ) );
+    }
+    return out;
+}
+
+/* Products of one output's taps with the coefficient vectors, still to be
+   summed across lanes. The symmetric filters add the mirrored input first.
+   The last vector of the 18-tap cases overlaps the one before it and only
+   its upper two lanes carry coefficients, so nothing past the FIR window is
+   read. */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 __m128i silk_resampler_down_FIR_taps(
+    const int32_t                *buf_ptr,
+    const __m128i                *coefs,
+    int32_t                      FIR_Order
+)
+{
+    __m128i acc, x;
+    int v;
+
+    acc = _mm_setzero_si128();
+    switch( FIR_Order ) {
+        case RESAMPLER_DOWN_ORDER_FIR0:
+            for( v = 0; v < 4; v++ ) {
+                x = _mm_loadu_si128( (const __m128i *)&buf_ptr[ 4 * v ] );
+                acc = _mm_add_epi32( acc, silk_SMULWW_epi32( x, coefs[ v ] ) );
+            }
+            x = _mm_loadu_si128( (const __m128i *)&buf_ptr[ 14 ] );
+            acc = _mm_add_epi32( acc, silk_SMULWW_epi32( x, coefs[ 4 ] ) );
+            break;
+        case RESAMPLER_DOWN_ORDER_FIR1:
+            for( v = 0; v < 3; v++ ) {
+                x = _mm_add_epi32( _mm_loadu_si128( (const __m128i *)&buf_ptr[ 4 * v ] ),
+                    _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *)&buf_ptr[ 20 - 4 * v ] ), _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+                acc = _mm_add_epi32( acc, silk_SMULWW_epi32( x, coefs[ v ] ) );
+            }
+            break;
+        default:
+            for( v = 0; v < 4; v++ ) {
+                x = _mm_add_epi32( _mm_loadu_si128( (const __m128i *)&buf_ptr[ 4 * v ] ),
+                    _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *)&buf_ptr[ 32 - 4 * v ] ), _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+                acc = _mm_add_epi32( acc, silk_SMULWW_epi32( x, coefs[ v ] ) );
+            }
+            x = _mm_add_epi32( _mm_loadu_si128( (const __m128i *)&buf_ptr[ 14 ] ),
+                _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *)&buf_ptr[ 18 ] ), _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+            acc = _mm_add_epi32( acc, silk_SMULWW_epi32( x, coefs[ 4 ] ) );
+            break;
+    }
+    return acc;
+}
+
+static OPUS_INLINE OPUS_TARGET_SSE4_1 int16_t *silk_resampler_down_FIR_loop(
+    int16_t                      *out,
+    int32_t                      *buf,
+    const __m128i                *coefs,         /* I    5 coefficient vectors per phase */
+    int32_t                      FIR_Order,
+    int32_t                      FIR_Fracs,
+    int32_t                      max_index_Q16,
+    int32_t                      index_increment_Q16
+)
+{
+    int j;
+    int32_t index_Q16, interpol_ind;
+    __m128i acc[ 4 ], res;
+
+    index_Q16 = 0;
+    while( index_Q16 + 3 * index_increment_Q16 < max_index_Q16 ) {
+        for( j = 0; j < 4; j++ ) {
+            interpol_ind = silk_SMULWB( index_Q16 & 0xFFFF, FIR_Fracs );
+            acc[ j ] = silk_resampler_down_FIR_taps( buf + silk_RSHIFT( index_Q16, 16 ), &coefs[ 5 * interpol_ind ], FIR_Order );
+            index_Q16 += index_increment_Q16;
+        }
+        res = silk_hsum4_epi32( acc[ 0 ], acc[ 1 ], acc[ 2 ], acc[ 3 ] );
+        res = _mm_srai_epi32( _mm_add_epi32( _mm_srai_epi32( res, 5 ), _mm_set1_epi32( 1 ) ), 1 );
+        _mm_storel_epi64( (__m128i *)out, _mm_packs_epi32( res, res ) );
+        out += 4;
+    }
+    for( ; index_Q16 < max_index_Q16; index_Q16 += index_increment_Q16 ) {
+        interpol_ind = silk_SMULWB( index_Q16 & 0xFFFF, FIR_Fracs );
+        acc[ 0 ] = silk_resampler_down_FIR_taps( buf + silk_RSHIFT( index_Q16, 16 ), &coefs[ 5 * interpol_ind ], FIR_Order );
+        res = silk_hsum4_epi32( acc[ 0 ], acc[ 0 ], acc[ 0 ], acc[ 0 ] );
+        *out++ = (int16_t)silk_SAT16( silk_RSHIFT_ROUND( _mm_cvtsi128_si32( res ), 6 ) );
+    }
+    return out;
+}
+
+/* Same as silk_resampler_private_down_FIR_INTERPOL_c(). The coefficients of
+   each phase are widened once per call into vectors that line up with a
+   contiguous load of the filtered signal; products are full 64-bit ones, so
+   each tap floors exactly like silk_SMLAWB(). */
+int16_t * OPUS_TARGET_SSE4_1 silk_resampler_private_down_FIR_INTERPOL_sse4_1(
+    int16_t                      *out,           /* O    Output signal               */
+    int32_t                      *buf,           /* I    Filtered signal, Q8         */
+    const int16_t                *FIR_Coefs,     /* I    FIR coefficients            */
+    int32_t                      FIR_Order,      /* I    FIR order                   */
+    int32_t                      FIR_Fracs,      /* I    Number of fractional phases */
+    int32_t                      max_index_Q16,  /* I    End of the input, Q16       */
+    int32_t                      index_increment_Q16 /* I Input step per output, Q16 */
+)
+{
+    int k, j;
+    int32_t taps[ 3 * 20 ];
+    __m128i coefs[ 3 * 5 ];
+
+    silk_memset( taps, 0, sizeof( taps ) );
+    switch( FIR_Order ) {
+        case RESAMPLER_DOWN_ORDER_FIR0:
+            /* Phase k: taps 0..8 from row k, taps 17..9 from row FIR_Fracs - 1 - k;
+               taps 16 and 17 go to the upper lanes of the fifth vector */
+            celt_assert( FIR_Fracs <= 3 );
+            for( k = 0; k < FIR_Fracs; k++ ) {
+                int32_t row[ RESAMPLER_DOWN_ORDER_FIR0 ];
+                for( j = 0; j < RESAMPLER_DOWN_ORDER_FIR0 / 2; j++ ) {
+                    row[ j ] = FIR_Coefs[ RESAMPLER_DOWN_ORDER_FIR0 / 2 * k + j ];
+                    row[ RESAMPLER_DOWN_ORDER_FIR0 - 1 - j ] = FIR_Coefs[ RESAMPLER_DOWN_ORDER_FIR0 / 2 * ( FIR_Fracs - 1 - k ) + j ];
+                }
+                for( j = 0; j < 16; j++ ) {
+                    taps[ 20 * k + j ] = row[ j ];
+                }
+                taps[ 20 * k + 18 ] = row[ 16 ];
+                taps[ 20 * k + 19 ] = row[ 17 ];
+            }
+            break;
+        case RESAMPLER_DOWN_ORDER_FIR1:
+            for( j = 0; j < RESAMPLER_DOWN_ORDER_FIR1 / 2; j++ ) {
+                taps[ j ] = FIR_Coefs[ j ];
+            }
+            break;
+        case RESAMPLER_DOWN_ORDER_FIR2:
+            for( j = 0; j < 16; j++ ) {
+                taps[ j ] = FIR_Coefs[ j ];
+            }
+            taps[ 18 ] = FIR_Coefs[ 16 ];
+            taps[ 19 ] = FIR_Coefs[ 17 ];
+            break;
+        default:
+            celt_assert( 0 );
+            return out;
+    }
+    for( k = 0; k < 3 * 5; k++ ) {
+        coefs[ k ] = _mm_loadu_si128( (const __m128i *)&taps[ 4 * k ] );
+    }
+
+    switch( FIR_Order ) {
+        case RESAMPLER_DOWN_ORDER_FIR0:
+            return silk_resampler_down_FIR_loop( out, buf, coefs, RESAMPLER_DOWN_ORDER_FIR0, FIR_Fracs, max_index_Q16, index_increment_Q16 );
+        case RESAMPLER_DOWN_ORDER_FIR1:
+            return silk_resampler_down_FIR_loop( out, buf, coefs, RESAMPLER_DOWN_ORDER_FIR1, FIR_Fracs, max_index_Q16, index_increment_Q16 );
+        default:
+            return silk_resampler_down_FIR_loop( out, buf, coefs, RESAMPLER_DOWN_ORDER_FIR2, FIR_Fracs, max_index_Q16, index_increment_Q16 );
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../main.h"
+#include "../resampler_private.h"
+#include "../../celt/x86/x86cpu.h"
+
+#if defined(OPUS_HAVE_RTCD) && defined(OPUS_X86_MAY_HAVE_SSE4_1) && !defined(OPUS_X86_PRESUME_SSE4_1)
+
+/* AVX2 machines use the SSE4.1 versions. The LPC recursion is serial and the
+   LTP blocks are bound by the lag; the resampler kernels are bound by their
+   per-output gathers rather than by the multiplies. */
+void (*const SILK_LTP_SYNTHESIS_IMPL[ OPUS_ARCHMASK + 1 ] )(
+    int32_t                  pres_Q14[],
+    int32_t                  sLTP_Q15[],
+    const int32_t            pexc_Q14[],
+    const int16_t            B_Q14[ LTP_ORDER ],
+    int                         lag,
+    int                         length
+) = {
+  silk_LTP_synthesis_c,                  /* non-sse */
+  silk_LTP_synthesis_c,
+  silk_LTP_synthesis_c,
+  silk_LTP_synthesis_sse4_1,             /* sse4.1  */
+  silk_LTP_synthesis_sse4_1              /* avx2    */
+};
+
+void (*const SILK_LPC_SYNTHESIS_IMPL[ OPUS_ARCHMASK + 1 ] )(
+    int32_t                  sLPC_Q14[],
+    int16_t                  xq[],
+    const int32_t            pres_Q14[],
+    const int16_t            A_Q12[],
+    int32_t                  Gain_Q10,
+    int                         LPC_order,
+    int                         length
+) = {
+  silk_LPC_synthesis_c,                  /* non-sse */
+  silk_LPC_synthesis_c,
+  silk_LPC_synthesis_c,
+  silk_LPC_synthesis_sse4_1,             /* sse4.1  */
+  silk_LPC_synthesis_sse4_1              /* avx2    */
+};
+
+int16_t *(*const SILK_RESAMPLER_IIR_FIR_INTERPOL_IMPL[ OPUS_ARCHMASK + 1 ] )(
+    int16_t                      *out,
+    int16_t                      *buf,
+    int32_t                      max_index_Q16,
+    int32_t                      index_increment_Q16
+) = {
+  silk_resampler_private_IIR_FIR_INTERPOL_c,         /* non-sse */
+  silk_resampler_private_IIR_FIR_INTERPOL_c,
+  silk_resampler_private_IIR_FIR_INTERPOL_c,
+  silk_resampler_private_IIR_FIR_INTERPOL_sse4_1,    /* sse4.1  */
+  silk_resampler_private_IIR_FIR_INTERPOL_sse4_1     /* avx2    */
+};
+
+int16_t *(*const SILK_RESAMPLER_DOWN_FIR_INTERPOL_IMPL[ OPUS_ARCHMASK + 1 ] )(
+    int16_t                      *out,
+    int32_t                      *buf,
+    const int16_t                *FIR_Coefs,
+    int32_t                      FIR_Order,
+    int32_t                      FIR_Fracs,
+    int32_t                      max_index_Q16,
+    int32_t                      index_increment_Q16
+) = {
+  silk_resampler_private_down_FIR_INTERPOL_c,        /* non-sse */
+  silk_resampler_private_down_FIR_INTERPOL_c,
+  silk_resampler_private_down_FIR_INTERPOL_c,
+  silk_resampler_private_down_FIR_INTERPOL_sse4_1,   /* sse4.1  */
+  silk_resampler_private_down_FIR_INTERPOL_sse4_1    /* avx2    */
+};
+
+#endif
@@ -0,0 +1,1152 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE libopusfile SOFTWARE CODEC SOURCE CODE. *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE libopusfile SOURCE CODE IS (C) COPYRIGHT 2012-2020           *
+ * by the Xiph.Org Foundation and contributors https://xiph.org/    *
+ *                                                                  *
+ ********************************************************************/
+
+/* Plain HTTP/1.1 (and Icecast) source for op_open_url() and friends.
+   A fetch thread keeps a few seconds of audio buffered ahead of the reader (OP_HTTP_READAHEAD_MS()), so the decoder
+   only waits on the network when that runs dry. Seekable servers are read with bounded Range requests on one keep-alive
+   connection: a seek into the ring or a short hop forward costs nothing, anything else is one more request on the
+   same socket. Icecast servers are read live, with their in-band metadata stripped out.
+   There is no TLS: https:// URLs fail to open. On the ESP32 the sockets are lwIP's and the thread is ESP-IDF's
+   pthread layer over FreeRTOS.*/
+
+#include "config.h"
+#include "Arduino.h"
+#include "internal.h"
+#include "opusfile.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/*The first range request of a sequential read, and the largest.
+  Each request that runs to its end doubles the next one, so a long read turns
+   into a handful of requests while a seek only costs a short one.*/
+#define OP_HTTP_CHUNK_MIN  (32*1024)
+#define OP_HTTP_CHUNK_MAX  (1024*1024)
+/*Forward seeks of up to this many bytes past the ring are read through on the
+   current request instead of starting a new one.*/
+#define OP_HTTP_SKIP_MAX   (32*1024)
+/*A request with at most this much body left is drained so its connection can
+   be reused; otherwise the connection is closed.*/
+#define OP_HTTP_DRAIN_MAX  (8*1024)
+/*Bytes read since the last seek before the reader counts as playing rather than
+   searching (op_open() and op_pcm_seek() scan in OP_CHUNK_SIZE steps).
+  Only then is running dry a rebuffer.*/
+#define OP_HTTP_PLAYING    (64*1024)
+#define OP_HTTP_RING_MIN   (16*1024)
+#define OP_HTTP_RING_MAX   (4*1024*1024)
+#define OP_HTTP_REDIRECTS  (4)
+#define OP_HTTP_RETRIES    (3)
+#define OP_HTTP_LINE_MAX   (1024)
+#define OP_HTTP_RECV_SIZE  (2048)
+#define OP_HTTP_STACK_SIZE (8192)
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL (0)
+#endif
+
+#ifndef OP_HTTP_TIMEOUT_MS
+#define OP_HTTP_TIMEOUT_MS (10000)
+#endif
+
+/*How the end of a response body is found.*/
+#define OP_HTTP_BODY_NONE    (0)
+#define OP_HTTP_BODY_LENGTH  (1)
+#define OP_HTTP_BODY_CHUNKED (2)
+#define OP_HTTP_BODY_CLOSE   (3)
+
+typedef struct OpusHttpStream{
+    /*The request target.*/
+    char               host[256];
+    char               port[8];
+    char              *path;
+    /*Connection state, only touched by the fetch thread once it runs (fd is
+       also read by op_http_close() under the lock).*/
+    int                fd;
+    int                keep_alive;
+    int                body_mode;
+    int64_t            body_left;
+    int64_t            chunk_left;
+    int                chunk_started;
+    unsigned char      sbuf[OP_HTTP_RECV_SIZE];
+    int                sb_pos;
+    int                sb_len;
+    /*Icecast metadata: the audio bytes between blocks, the audio bytes left
+       before the next one, and the block being collected (meta_len<0 while
+       waiting for its length byte).*/
+    int32_t            metaint;
+    int32_t            meta_left;
+    int                meta_len;
+    int                meta_fill;
+    char               meta[16 * 255 + 1];
+    /*The stream offset of the next body byte, and the end of the current range
+       request.*/
+    int64_t            net_pos;
+    int64_t            req_end;
+    int32_t            chunk_size;
+    int                retries;
+    /*Shared with the reader.*/
+    pthread_mutex_t    lock;
+    pthread_cond_t     data_cond;
+    pthread_cond_t     space_cond;
+    pthread_t          thread;
+    unsigned char     *ring;
+    size_t             ring_size;
+    size_t             ring_head;
+    size_t             fill;
+    /*The stream offset of the first byte in the ring.*/
+    int64_t            pos;
+    int64_t            size;
+    int                seekable;
+    /*Bumped by every seek that empties the ring, so the fetch thread can tell
+       data from before the seek.*/
+    int                gen;
+    int                restart;
+    int64_t            restart_pos;
+    int                eof;
+    int                error;
+    int                quit;
+    /*Bytes read since the last seek.*/
+    int64_t            delivered;
+    struct timespec    start_time;
+    OpusHttpStats_t    st;
+    OpusHttpStats_t   *user_stats;
+} OpusHttpStream_t;
+//----------------------------------------------------------------------------------------------------------------------
+static int32_t op_http_elapsed_ms(const struct timespec *_start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int32_t) ((now.tv_sec - _start->tv_sec) * 1000 + (now.tv_nsec - _start->tv_nsec) / 1000000);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static char *op_http_strdup(const char *_s, size_t _n) {
+    char *ret;
+    ret = (char*) malloc(_n + 1);
+    if(ret != NULL) {
+        memcpy(ret, _s, _n);
+        ret[_n] = '\0';
+    }
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void opus_server_info_init(OpusServerInfo_t *_info) {
+    memset(_info, 0, sizeof(*_info));
+    _info->bitrate_kbps = -1;
+    _info->is_public = -1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void opus_server_info_clear(OpusServerInfo_t *_info) {
+    free(_info->name);
+    free(_info->description);
+    free(_info->genre);
+    free(_info->url);
+    free(_info->server);
+    free(_info->content_type);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Splits an http:// URL into host, port and path.
+  Return: 0 on success, OP_EIMPL for schemes (https) and forms (user info) we
+   don't support, or OP_EINVAL if it is not a URL.*/
+static int op_http_parse_url(OpusHttpStream_t *_s, const char *_url) {
+    const char *host;
+    const char *host_end;
+    const char *p;
+    size_t host_len;
+    if(op_strncasecmp(_url, "https://", 8) == 0) return OP_EIMPL;
+    if(op_strncasecmp(_url, "http://", 7) != 0) return OP_EINVAL;
+    host = _url + 7;
+    if(*host == '[') {
+        /*IPv6 literal.*/
+        host_end = strchr(host, ']');
+        if(host_end == NULL) return OP_EINVAL;
+        p = host_end + 1;
+        host++;
+    }
+    else {
+        host_end = host + strcspn(host, ":/?#@");
+        p = host_end;
+    }
+    if(*p == '@') return OP_EIMPL;
+    host_len = host_end - host;
+    if(host_len == 0 || host_len >= sizeof(_s->host)) return OP_EINVAL;
+    memcpy(_s->host, host, host_len);
+    _s->host[host_len] = '\0';
+    if(*p == ':') {
+        size_t port_len;
+        p++;
+        port_len = strspn(p, "0123456789");
+        if(port_len == 0 || port_len >= sizeof(_s->port)) return OP_EINVAL;
+        memcpy(_s->port, p, port_len);
+        _s->port[port_len] = '\0';
+        p += port_len;
+    }
+    else
+        strcpy(_s->port, "80");
+    free(_s->path);
+    if(*p == '/')
+        _s->path = op_http_strdup(p, strcspn(p, "#"));
+    else if(*p == '?') {
+        _s->path = (char*) malloc(strcspn(p, "#") + 2);
+        if(_s->path != NULL) {
+            _s->path[0] = '/';
+            memcpy(_s->path + 1, p, strcspn(p, "#"));
+            _s->path[strcspn(p, "#") + 1] = '\0';
+        }
+    }
+    else if(*p == '\0' || *p == '#')
+        _s->path = op_http_strdup("/", 1);
+    else
+        return OP_EINVAL;
+    return _s->path != NULL ? 0 : OP_EFAULT;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Removes "." and ".." segments from the path part (before any query) of
+   _path, which starts with '/' (RFC 3986 section 5.2.4).*/
+static void op_http_remove_dot_segments(char *_path) {
+    char *out;
+    char *in;
+    char *end;
+    out = in = _path;
+    end = _path + strcspn(_path, "?");
+    while(in < end) {
+        char *next;
+        size_t seg_len;
+        /*in points at the '/' that starts a segment.*/
+        next = in + 1;
+        while(next < end && *next != '/')
+            next++;
+        seg_len = next - in - 1;
+        if(seg_len == 2 && in[1] == '.' && in[2] == '.') {
+            while(out > _path && *--out != '/');
+        }
+        else if(seg_len != 1 || in[1] != '.') {
+            memmove(out, in, next - in);
+            out += next - in;
+            in = next;
+            continue;
+        }
+        /*A trailing "." or ".." still names a directory.*/
+        if(next == end) *out++ = '/';
+        in = next;
+    }
+    memmove(out, end, strlen(end) + 1);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Points the stream at the target of a Location header: an absolute URL, or a
+   reference relative to the current one (RFC 3986 section 5.2).
+  Return: 0 on success, or the op_http_parse_url() error.*/
+static int op_http_follow(OpusHttpStream_t *_s, const char *_location) {
+    const char *p;
+    char *path;
+    size_t base_len;
+    size_t len;
+    p = _location + strspn(_location, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+-.");
+    if(p > _location && *p == ':') return op_http_parse_url(_s, _location);
+    if(_location[0] == '/' && _location[1] == '/') {
+        /*Same scheme, other server.*/
+        int ret;
+        len = strlen(_location);
+        path = (char*) malloc(len + 6);
+        if(path == NULL) return OP_EFAULT;
+        memcpy(path, "http:", 5);
+        memcpy(path + 5, _location, len + 1);
+        ret = op_http_parse_url(_s, path);
+        free(path);
+        return ret;
+    }
+    len = strcspn(_location, "#");
+    if(len == 0) return 0;
+    if(_location[0] == '/')
+        base_len = 0;
+    else {
+        /*Keep the current path up to its query ("?x") or its last '/' ("x").*/
+        base_len = strcspn(_s->path, "?");
+        if(_location[0] != '?') {
+            while(base_len > 0 && _s->path[base_len - 1] != '/')
+                base_len--;
+        }
+    }
+    path = (char*) malloc(base_len + len + 1);
+    if(path == NULL) return OP_EFAULT;
+    memcpy(path, _s->path, base_len);
+    memcpy(path + base_len, _location, len);
+    path[base_len + len] = '\0';
+    op_http_remove_dot_segments(path);
+    free(_s->path);
+    _s->path = path;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void op_http_disconnect(OpusHttpStream_t *_s) {
+    if(_s->fd >= 0) {
+        pthread_mutex_lock(&_s->lock);
+        close(_s->fd);
+        _s->fd = -1;
+        pthread_mutex_unlock(&_s->lock);
+    }
+    _s->sb_pos = _s->sb_len = 0;
+    _s->body_mode = OP_HTTP_BODY_NONE;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*connect() with the same OP_HTTP_TIMEOUT_MS bound as every later send and
+ recv. The fd isn't published until this returns, so op_http_close() can't cut
+ it short; a blocking connect() could otherwise hang for the OS timeout.*/
+static int op_http_connect_fd(int _fd, const struct sockaddr *_addr, socklen_t _addrlen) {
+    struct timeval tv;
+    fd_set wfds;
+    socklen_t len;
+    int flags;
+    int err;
+    int ret;
+    tv.tv_sec = OP_HTTP_TIMEOUT_MS / 1000;
+    tv.tv_usec = OP_HTTP_TIMEOUT_MS % 1000 * 1000;
+    setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    flags = fcntl(_fd, F_GETFL, 0);
+    if(flags < 0 || fcntl(_fd, F_SETFL, flags | O_NONBLOCK) < 0) return connect(_fd, _addr, _addrlen);
+    ret = connect(_fd, _addr, _addrlen);
+    if(ret < 0 && errno == EINPROGRESS) {
+        FD_ZERO(&wfds);
+        FD_SET(_fd, &wfds);
+        do ret = select(_fd + 1, NULL, &wfds, NULL, &tv);
+        while(ret < 0 && errno == EINTR);
+        if(ret > 0) {
+            err = 0;
+            len = sizeof(err);
+            ret = getsockopt(_fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0 ? -1 : 0;
+        }
+        else
+            ret = -1;
+    }
+    fcntl(_fd, F_SETFL, flags);
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_http_connect(OpusHttpStream_t *_s) {
+    struct addrinfo hints;
+    struct addrinfo *addrs;
+    struct addrinfo *ai;
+    int fd;
+    int one;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if(getaddrinfo(_s->host, _s->port, &hints, &addrs) != 0) return OP_EREAD;
+    fd = -1;
+    for(ai = addrs; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if(fd < 0) continue;
+        if(op_http_connect_fd(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addrs);
+    if(fd < 0) return OP_EREAD;
+    one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    pthread_mutex_lock(&_s->lock);
+    if(_s->quit) {
+        /*op_http_close() is waiting for us.*/
+        pthread_mutex_unlock(&_s->lock);
+        close(fd);
+        return OP_EREAD;
+    }
+    _s->fd = fd;
+    _s->st.connections++;
+    pthread_mutex_unlock(&_s->lock);
+    _s->sb_pos = _s->sb_len = 0;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Makes sure the socket buffer holds at least one byte.
+  Return: 1 on success, 0 if the peer closed the connection, or OP_EREAD.*/
+static int op_http_fill(OpusHttpStream_t *_s) {
+    ssize_t ret;
+    if(_s->sb_pos < _s->sb_len) return 1;
+    do
+        ret = recv(_s->fd, _s->sbuf, sizeof(_s->sbuf), 0);
+    while(ret < 0 && errno == EINTR);
+    if(ret < 0) return OP_EREAD;
+    _s->sb_pos = 0;
+    _s->sb_len = (int) ret;
+    return ret > 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Reads one header line without its CR LF.
+  Return: The line length, or a negative value on failure (or EOF).*/
+static int op_http_read_line(OpusHttpStream_t *_s, char *_line, int _max) {
+    int len;
+    len = 0;
+    for(;;) {
+        int c;
+        if(op_http_fill(_s) <= 0) return OP_EREAD;
+        c = _s->sbuf[_s->sb_pos++];
+        if(c == '\n') break;
+        if(len < _max - 1) _line[len++] = (char) c;
+    }
+    if(len > 0 && _line[len - 1] == '\r') len--;
+    _line[len] = '\0';
+    return len;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_http_send(OpusHttpStream_t *_s, const char *_buf, size_t _len) {
+    while(_len > 0) {
+        ssize_t ret;
+        ret = send(_s->fd, _buf, _len, MSG_NOSIGNAL);
+        if(ret < 0 && errno == EINTR) continue;
+        if(ret <= 0) return OP_EREAD;
+        _buf += ret;
+        _len -= ret;
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Reads a body of Content-Length, chunked or read-until-close framing.
+  Return: The number of bytes read, 0 at the end of the body, or OP_EREAD.*/
+static int op_http_body_read(OpusHttpStream_t *_s, unsigned char *_buf, int _n) {
+    int ret;
+    if(_s->body_mode == OP_HTTP_BODY_NONE) return 0;
+    if(_s->body_mode == OP_HTTP_BODY_LENGTH) {
+        if(_s->body_left <= 0) return 0;
+        if(_n > _s->body_left) _n = (int) _s->body_left;
+    }
+    else if(_s->body_mode == OP_HTTP_BODY_CHUNKED) {
+        if(_s->chunk_left == 0) {
+            char line[64];
+            if(_s->chunk_started && op_http_read_line(_s, line, sizeof(line)) != 0) return OP_EREAD;
+            if(op_http_read_line(_s, line, sizeof(line)) < 0) return OP_EREAD;
+            _s->chunk_left = strtoll(line, NULL, 16);
+            _s->chunk_started = 1;
+            if(_s->chunk_left < 0) return OP_EREAD;
+            if(_s->chunk_left == 0) {
+                /*Skip the trailer.*/
+                do
+                    ret = op_http_read_line(_s, line, sizeof(line));
+                while(ret > 0);
+                if(ret < 0) return OP_EREAD;
+                _s->body_mode = OP_HTTP_BODY_NONE;
+                return 0;
+            }
+        }
+        if(_n > _s->chunk_left) _n = (int) _s->chunk_left;
+    }
+    ret = op_http_fill(_s);
+    if(ret < 0) return ret;
+    if(ret == 0) {
+        /*The peer closed the connection: the normal end of a read-until-close
+           body, and a truncated response otherwise.*/
+        if(_s->body_mode != OP_HTTP_BODY_CLOSE) return OP_EREAD;
+        _s->body_mode = OP_HTTP_BODY_NONE;
+        _s->keep_alive = 0;
+        return 0;
+    }
+    if(_n > _s->sb_len - _s->sb_pos) _n = _s->sb_len - _s->sb_pos;
+    memcpy(_buf, _s->sbuf + _s->sb_pos, _n);
+    _s->sb_pos += _n;
+    if(_s->body_mode == OP_HTTP_BODY_LENGTH)
+        _s->body_left -= _n;
+    else if(_s->body_mode == OP_HTTP_BODY_CHUNKED) _s->chunk_left -= _n;
+    return _n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_http_body_done(const OpusHttpStream_t *_s) {
+    return _s->body_mode == OP_HTTP_BODY_NONE || (_s->body_mode == OP_HTTP_BODY_LENGTH && _s->body_left <= 0);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Reads and throws away _n body bytes.*/
+static int op_http_body_skip(OpusHttpStream_t *_s, int64_t _n) {
+    unsigned char buf[256];
+    while(_n > 0) {
+        int ret;
+        ret = op_http_body_read(_s, buf, _n < (int64_t) sizeof(buf) ? (int) _n : (int) sizeof(buf));
+        if(ret <= 0) return OP_EREAD;
+        _n -= ret;
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Returns the value of header line _line if its name is _name, or NULL.*/
+static const char *op_http_header(const char *_line, const char *_name) {
+    size_t len;
+    len = strlen(_name);
+    if(op_strncasecmp(_line, _name, (int) len) != 0 || _line[len] != ':') return NULL;
+    _line += len + 1;
+    while(*_line == ' ' || *_line == '\t')
+        _line++;
+    return _line;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void op_http_set_info(char **_field, const char *_value) {
+    if(*_field == NULL) *_field = op_http_strdup(_value, strlen(_value));
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Sends a GET for [_start,_end] (_end<0: to the end, _start<0: no Range at all)
+   on the open connection and reads the response header.
+  The body framing and keep-alive state are set up for op_http_body_read(), and
+   for a 206 *_range_start and *_total come from Content-Range.
+  Return: The status code, or a negative value on failure.*/
+static int op_http_get(OpusHttpStream_t *_s, int64_t _start, int64_t _end, OpusServerInfo_t *_info, char **_location,
+        int64_t *_range_start, int64_t *_total) {
+    char line[OP_HTTP_LINE_MAX];
+    int64_t content_length;
+    int status;
+    int len;
+    int http10;
+    int chunked;
+    int conn_close;
+    int conn_keep;
+    len = snprintf(line, sizeof(line), "GET %s HTTP/1.1\r\nHost: %s%s%s\r\nUser-Agent: opusfile\r\nAccept: */*\r\n"
+            "Icy-MetaData: 1\r\nConnection: keep-alive\r\n", _s->path, _s->host, strcmp(_s->port, "80") ? ":" : "",
+            strcmp(_s->port, "80") ? _s->port : "");
+    if(_start >= 0) {
+        if(_end >= 0)
+            len += snprintf(line + len, sizeof(line) - len, "Range: bytes=%lld-%lld\r\n", (long long) _start,
+                    (long long) _end);
+        else
+            len += snprintf(line + len, sizeof(line) - len, "Range: bytes=%lld-\r\n", (long long) _start);
+    }
+    len += snprintf(line + len, sizeof(line) - len, "\r\n");
+    if(len >= (int) sizeof(line)) return OP_EINVAL;
+    if(op_http_send(_s, line, len) < 0) return OP_EREAD;
+    pthread_mutex_lock(&_s->lock);
+    _s->st.requests++;
+    pthread_mutex_unlock(&_s->lock);
+    /*Status line: "HTTP/1.x NNN reason", or Icecast's "ICY NNN reason".*/
+    if(op_http_read_line(_s, line, sizeof(line)) < 0) return OP_EREAD;
+    if(strncmp(line, "HTTP/1.", 7) == 0 && line[7] != '\0' && line[8] == ' ') {
+        http10 = line[7] == '0';
+        status = atoi(line + 9);
+    }
+    else if(strncmp(line, "ICY ", 4) == 0) {
+        http10 = 1;
+        status = atoi(line + 4);
+    }
+    else
+        return OP_ENOTFORMAT;
+    content_length = -1;
+    chunked = conn_close = conn_keep = 0;
+    *_range_start = *_total = -1;
+    _s->metaint = 0;
+    for(;;) {
+        const char *v;
+        len = op_http_read_line(_s, line, sizeof(line));
+        if(len < 0) return OP_EREAD;
+        if(len == 0) break;
+        if((v = op_http_header(line, "Content-Length")) != NULL)
+            content_length = strtoll(v, NULL, 10);
+        else if((v = op_http_header(line, "Content-Range")) != NULL) {
+            long long a;
+            long long b;
+            long long t;
+            if(sscanf(v, "bytes %lld-%lld/%lld", &a, &b, &t) == 3) {
+                *_range_start = a;
+                *_total = t;
+            }
+            /*"bytes a-b/" with a "*" total: the server does not know the length yet.*/
+            else if(sscanf(v, "bytes %lld-%lld/", &a, &b) == 2) *_range_start = a;
+        }
+        else if((v = op_http_header(line, "Transfer-Encoding")) != NULL)
+            chunked = op_strncasecmp(v, "chunked", 7) == 0;
+        else if((v = op_http_header(line, "Connection")) != NULL) {
+            conn_close = op_strncasecmp(v, "close", 5) == 0;
+            conn_keep = op_strncasecmp(v, "keep-alive", 10) == 0;
+        }
+        else if((v = op_http_header(line, "Location")) != NULL) {
+            if(_location != NULL && *_location == NULL) *_location = op_http_strdup(v, strlen(v));
+        }
+        else if((v = op_http_header(line, "icy-metaint")) != NULL)
+            _s->metaint = atoi(v);
+        else if(_info != NULL) {
+            if((v = op_http_header(line, "icy-name")) != NULL)
+                op_http_set_info(&_info->name, v);
+            else if((v = op_http_header(line, "icy-description")) != NULL)
+                op_http_set_info(&_info->description, v);
+            else if((v = op_http_header(line, "icy-genre")) != NULL)
+                op_http_set_info(&_info->genre, v);
+            else if((v = op_http_header(line, "icy-url")) != NULL)
+                op_http_set_info(&_info->url, v);
+            else if((v = op_http_header(line, "Server")) != NULL)
+                op_http_set_info(&_info->server, v);
+            else if((v = op_http_header(line, "Content-Type")) != NULL)
+                op_http_set_info(&_info->content_type, v);
+            else if((v = op_http_header(line, "icy-br")) != NULL)
+                _info->bitrate_kbps = atoi(v);
+            else if((v = op_http_header(line, "icy-pub")) != NULL) _info->is_public = atoi(v) != 0;
+        }
+    }
+    _s->keep_alive = http10 ? conn_keep : !conn_close;
+    _s->chunk_left = 0;
+    _s->chunk_started = 0;
+    if(chunked)
+        _s->body_mode = OP_HTTP_BODY_CHUNKED;
+    else if(content_length >= 0) {
+        _s->body_mode = OP_HTTP_BODY_LENGTH;
+        _s->body_left = content_length;
+    }
+    else if(status == 204 || status == 304 || (status >= 100 && status < 200))
+        _s->body_mode = OP_HTTP_BODY_NONE;
+    else {
+        _s->body_mode = OP_HTTP_BODY_CLOSE;
+        _s->keep_alive = 0;
+    }
+    _s->meta_left = _s->metaint;
+    _s->meta_len = -1;
+    return status;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Issues the range request for the data at _start on the current connection if
+   it can be reused, or on a new one.*/
+static int op_http_fetch_range(OpusHttpStream_t *_s, int64_t _start) {
+    int64_t end;
+    int attempt;
+    OP_ASSERT(_s->seekable);
+    end = _min(_start + _s->chunk_size, _s->size) - 1;
+    if(_s->fd >= 0 && !op_http_body_done(_s)) {
+        if(_s->keep_alive && _s->body_mode == OP_HTTP_BODY_LENGTH && _s->body_left <= OP_HTTP_DRAIN_MAX) {
+            if(op_http_body_skip(_s, _s->body_left) < 0) op_http_disconnect(_s);
+        }
+        else
+            op_http_disconnect(_s);
+    }
+    if(_s->fd >= 0 && !_s->keep_alive) op_http_disconnect(_s);
+    for(attempt = 0;; attempt++) {
+        int64_t range_start;
+        int64_t total;
+        int reused;
+        int status;
+        reused = _s->fd >= 0;
+        if(!reused && op_http_connect(_s) < 0) return OP_EREAD;
+        status = op_http_get(_s, _start, end, NULL, NULL, &range_start, &total);
+        if(status == 206 && range_start == _start && total == _s->size) break;
+        op_http_disconnect(_s);
+        /*A kept-alive connection may have been closed by the server while idle:
+           try once more on a fresh one.*/
+        if(status >= 0 || !reused || attempt > 0) return OP_EREAD;
+    }
+    _s->net_pos = _start;
+    _s->req_end = end + 1;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Picks StreamTitle='...' out of a complete Icecast metadata block.*/
+static void op_http_parse_icy(OpusHttpStream_t *_s) {
+    const char *title;
+    const char *end;
+    title = strstr(_s->meta, "StreamTitle='");
+    if(title == NULL) return;
+    title += 13;
+    end = strstr(title, "';");
+    if(end == NULL) end = title + strlen(title);
+    pthread_mutex_lock(&_s->lock);
+    if(end - title >= (ptrdiff_t) sizeof(_s->st.stream_title)) end = title + sizeof(_s->st.stream_title) - 1;
+    memcpy(_s->st.stream_title, title, end - title);
+    _s->st.stream_title[end - title] = '\0';
+    _s->st.metadata_updates++;
+    pthread_mutex_unlock(&_s->lock);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Removes the Icecast metadata blocks from _n freshly received body bytes in
+   place.
+  Return: The number of audio bytes left.*/
+static int op_http_strip_icy(OpusHttpStream_t *_s, unsigned char *_buf, int _n) {
+    int out;
+    int i;
+    if(_s->metaint <= 0) return _n;
+    for(i = out = 0; i < _n;) {
+        int k;
+        if(_s->meta_left > 0) {
+            k = _min(_n - i, _s->meta_left);
+            memmove(_buf + out, _buf + i, k);
+            out += k;
+            i += k;
+            _s->meta_left -= k;
+        }
+        else if(_s->meta_len < 0) {
+            _s->meta_len = 16 * _buf[i++];
+            _s->meta_fill = 0;
+            if(_s->meta_len == 0) {
+                _s->meta_left = _s->metaint;
+                _s->meta_len = -1;
+            }
+        }
+        else {
+            k = _min(_n - i, _s->meta_len - _s->meta_fill);
+            memcpy(_s->meta + _s->meta_fill, _buf + i, k);
+            _s->meta_fill += k;
+            i += k;
+            if(_s->meta_fill == _s->meta_len) {
+                _s->meta[_s->meta_len] = '\0';
+                op_http_parse_icy(_s);
+                _s->meta_left = _s->metaint;
+                _s->meta_len = -1;
+            }
+        }
+    }
+    return out;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Moves the fetch position to _pos after a seek outside the ring.*/
+static int op_http_fetch_seek(OpusHttpStream_t *_s, int64_t _pos) {
+    if(_s->fd >= 0 && _s->body_mode == OP_HTTP_BODY_LENGTH && _pos >= _s->net_pos
+            && _pos - _s->net_pos <= OP_HTTP_SKIP_MAX && _pos < _s->req_end) {
+        /*A short hop forward: read through it on the current request.*/
+        if(op_http_body_skip(_s, _pos - _s->net_pos) >= 0) {
+            _s->net_pos = _pos;
+            return 0;
+        }
+        op_http_disconnect(_s);
+    }
+    pthread_mutex_lock(&_s->lock);
+    _s->st.seeks++;
+    pthread_mutex_unlock(&_s->lock);
+    _s->chunk_size = OP_HTTP_CHUNK_MIN;
+    return op_http_fetch_range(_s, _pos);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void op_http_set_state(OpusHttpStream_t *_s, int _gen, int *_flag) {
+    pthread_mutex_lock(&_s->lock);
+    if(_gen == _s->gen) {
+        *_flag = 1;
+        pthread_cond_broadcast(&_s->data_cond);
+    }
+    pthread_mutex_unlock(&_s->lock);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void *op_http_fetch_main(void *_arg) {
+    OpusHttpStream_t *s;
+    unsigned char buf[OP_HTTP_RECV_SIZE];
+    s = (OpusHttpStream_t*) _arg;
+    for(;;) {
+        int64_t restart_pos;
+        size_t room;
+        int restart;
+        int gen;
+        int ret;
+        pthread_mutex_lock(&s->lock);
+        while(!s->quit && !s->restart && (s->fill >= s->ring_size || s->eof || s->error)) {
+            pthread_cond_wait(&s->space_cond, &s->lock);
+        }
+        if(s->quit) {
+            pthread_mutex_unlock(&s->lock);
+            break;
+        }
+        restart = s->restart;
+        restart_pos = s->restart_pos;
+        s->restart = 0;
+        gen = s->gen;
+        room = s->ring_size - s->fill;
+        pthread_mutex_unlock(&s->lock);
+        if(restart) {
+            s->retries = 0;
+            /*op_open() seeks to the end just to learn the size: no request.*/
+            if(restart_pos >= s->size)
+                op_http_set_state(s, gen, &s->eof);
+            else if(op_http_fetch_seek(s, restart_pos) < 0) op_http_set_state(s, gen, &s->error);
+            continue;
+        }
+        if(op_http_body_done(s)) {
+            if(!s->seekable || s->net_pos >= s->size) {
+                op_http_set_state(s, gen, &s->eof);
+                continue;
+            }
+            /*The request ran to its end: ask for a bigger one.*/
+            s->chunk_size = _min(2 * s->chunk_size, OP_HTTP_CHUNK_MAX);
+            if(op_http_fetch_range(s, s->net_pos) < 0) op_http_set_state(s, gen, &s->error);
+            continue;
+        }
+        ret = op_http_body_read(s, buf, (int) _min(room, sizeof(buf)));
+        if(ret < 0) {
+            /*A dropped connection can be picked up where it left off on a
+               seekable server.*/
+            op_http_disconnect(s);
+            if(!s->seekable || s->retries++ >= OP_HTTP_RETRIES || op_http_fetch_range(s, s->net_pos) < 0) {
+                op_http_set_state(s, gen, &s->error);
+            }
+            continue;
+        }
+        if(ret == 0) continue;
+        s->net_pos += ret;
+        ret = op_http_strip_icy(s, buf, ret);
+        pthread_mutex_lock(&s->lock);
+        if(gen == s->gen && ret > 0) {
+            size_t tail;
+            size_t k;
+            tail = (s->ring_head + s->fill) % s->ring_size;
+            k = _min((size_t) ret, s->ring_size - tail);
+            memcpy(s->ring + tail, buf, k);
+            memcpy(s->ring, buf + k, ret - k);
+            s->fill += ret;
+            if(s->st.bytes == 0) s->st.first_byte_ms = op_http_elapsed_ms(&s->start_time);
+            s->st.bytes += ret;
+            pthread_cond_broadcast(&s->data_cond);
+        }
+        pthread_mutex_unlock(&s->lock);
+    }
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_http_read(void *_stream, unsigned char *_ptr, int _nbytes) {
+    OpusHttpStream_t *s;
+    int ret;
+    s = (OpusHttpStream_t*) _stream;
+    if(_nbytes <= 0) return 0;
+    pthread_mutex_lock(&s->lock);
+    if(s->fill == 0 && !s->eof && !s->error) {
+        size_t want;
+        /*Running dry during playback is a rebuffer: wait for half the read-ahead
+           so it does not stutter on every packet that arrives.
+          While opening or seeking, return as soon as anything arrives.*/
+        want = 1;
+        if(s->delivered >= OP_HTTP_PLAYING) {
+            s->st.rebuffers++;
+            want = s->ring_size >> 1;
+        }
+        while(s->fill < want && !s->eof && !s->error)
+            pthread_cond_wait(&s->data_cond, &s->lock);
+    }
+    if(s->fill > 0) {
+        size_t k;
+        ret = (int) _min((size_t) _nbytes, s->fill);
+        k = _min((size_t) ret, s->ring_size - s->ring_head);
+        memcpy(_ptr, s->ring + s->ring_head, k);
+        memcpy(_ptr + k, s->ring, ret - k);
+        s->ring_head = (s->ring_head + ret) % s->ring_size;
+        s->fill -= ret;
+        s->pos += ret;
+        s->delivered += ret;
+        pthread_cond_signal(&s->space_cond);
+    }
+    else
+        ret = s->error ? OP_EREAD : 0;
+    if(s->user_stats != NULL) *s->user_stats = s->st;
+    pthread_mutex_unlock(&s->lock);
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_http_seek(void *_stream, int64_t _offset, int _whence) {
+    OpusHttpStream_t *s;
+    int64_t pos;
+    s = (OpusHttpStream_t*) _stream;
+    if(!s->seekable) return -1;
+    pthread_mutex_lock(&s->lock);
+    switch(_whence){
+        case SEEK_SET:
+            pos = _offset;
+            break;
+        case SEEK_CUR:
+            pos = s->pos + _offset;
+            break;
+        case SEEK_END:
+            pos = s->size + _offset;
+            break;
+        default:
+            pos = -1;
+    }
+    if(pos < 0 || pos > s->size) {
+        pthread_mutex_unlock(&s->lock);
+        return -1;
+    }
+    if(pos >= s->pos && pos - s->pos <= (int64_t) s->fill) {
+        /*Inside the read-ahead: just drop what is skipped.*/
+        size_t skip;
+        skip = (size_t) (pos - s->pos);
+        s->ring_head = (s->ring_head + skip) % s->ring_size;
+        s->fill -= skip;
+        if(skip > 0) pthread_cond_signal(&s->space_cond);
+    }
+    else {
+        s->gen++;
+        s->ring_head = 0;
+        s->fill = 0;
+        s->restart = 1;
+        s->restart_pos = pos;
+        s->eof = s->error = 0;
+        s->delivered = 0;
+        pthread_cond_signal(&s->space_cond);
+    }
+    s->pos = pos;
+    pthread_mutex_unlock(&s->lock);
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int64_t op_http_tell(void *_stream) {
+    OpusHttpStream_t *s;
+    int64_t pos;
+    s = (OpusHttpStream_t*) _stream;
+    pthread_mutex_lock(&s->lock);
+    pos = s->pos;
+    pthread_mutex_unlock(&s->lock);
+    return pos;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void op_http_stream_free(OpusHttpStream_t *_s) {
+    if(_s->fd >= 0) close(_s->fd);
+    pthread_cond_destroy(&_s->space_cond);
+    pthread_cond_destroy(&_s->data_cond);
+    pthread_mutex_destroy(&_s->lock);
+    free(_s->ring);
+    free(_s->path);
+    free(_s);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_http_close(void *_stream) {
+    OpusHttpStream_t *s;
+    s = (OpusHttpStream_t*) _stream;
+    pthread_mutex_lock(&s->lock);
+    s->quit = 1;
+    /*Wake the fetch thread even if it is blocked in recv().*/
+    if(s->fd >= 0) shutdown(s->fd, SHUT_RDWR);
+    pthread_cond_signal(&s->space_cond);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+    op_http_stream_free(s);
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static const OpusFileCallbacks_t OP_HTTP_CALLBACKS = { op_http_read, op_http_seek, op_http_tell, op_http_close };
+//----------------------------------------------------------------------------------------------------------------------
+/*Opens the connection, follows redirects and reads the first response, which
+   decides whether the stream is seekable.*/
+static int op_http_open(OpusHttpStream_t *_s, const char *_url, OpusServerInfo_t *_info) {
+    char *location;
+    int redirects;
+    int no_range;
+    int ret;
+    ret = op_http_parse_url(_s, _url);
+    if(ret < 0) return ret;
+    location = NULL;
+    no_range = 0;
+    for(redirects = 0;;) {
+        int64_t range_start;
+        int64_t total;
+        int status;
+        if(op_http_connect(_s) < 0) return OP_EREAD;
+        /*Only the final response describes the stream.*/
+        opus_server_info_clear(_info);
+        opus_server_info_init(_info);
+        /*Ask for a bounded range up front: a server that honours it is seekable
+           and the connection stays reusable, while Icecast ignores it and
+           starts the live stream.*/
+        status = op_http_get(_s, no_range ? -1 : 0, OP_HTTP_CHUNK_MIN - 1, _info, &location, &range_start, &total);
+        if(status < 0) return status;
+        if(status == 206 && range_start == 0 && total < 0 && !no_range) {
+            /*The server ranges a resource whose length it does not know (yet):
+               read it through once, like a server without range support.*/
+            op_http_disconnect(_s);
+            no_range = 1;
+            continue;
+        }
+        if(status == 206 && range_start == 0 && total > 0) {
+            _s->seekable = 1;
+            _s->size = total;
+            _s->req_end = _min(OP_HTTP_CHUNK_MIN, total);
+            break;
+        }
+        if(status == 200) {
+            /*No range support: the whole resource follows, and we can only read
+               it through once.*/
+            _s->seekable = 0;
+            _s->size = _s->body_mode == OP_HTTP_BODY_LENGTH ? _s->body_left : -1;
+            break;
+        }
+        op_http_disconnect(_s);
+        if(status >= 300 && status < 400 && location != NULL && redirects++ < OP_HTTP_REDIRECTS) {
+            ret = op_http_follow(_s, location);
+            free(location);
+            location = NULL;
+            if(ret < 0) return ret;
+            no_range = 0;
+            continue;
+        }
+        free(location);
+        return OP_EREAD;
+    }
+    free(location);
+    _s->net_pos = 0;
+    _s->chunk_size = OP_HTTP_CHUNK_MIN;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void* op_url_stream_vcreate_impl(OpusFileCallbacks_t *_cb, const char *_url, OpusServerInfo_t *_info,
+        OpusServerInfo_t **_pinfo, int *_error, va_list _ap) {
+    OpusHttpStream_t *s;
+    OpusHttpStats_t *stats;
+    OpusServerInfo_t *pinfo;
+    pthread_attr_t attr;
+    int32_t readahead_ms;
+    int32_t kbps;
+    int64_t ring_size;
+    int ret;
+    readahead_ms = OP_HTTP_READAHEAD_MS_DEFAULT;
+    kbps = -1;
+    stats = NULL;
+    pinfo = NULL;
+    *_pinfo = NULL;
+    *_error = OP_EINVAL;
+    for(;;) {
+        ptrdiff_t request;
+        request = va_arg(_ap, char*) - (char*) NULL;
+        if(request == 0) break;
+        switch(request){
+            case OP_SSL_SKIP_CERTIFICATE_CHECK_REQUEST: {
+                /*There is no TLS, so there is nothing to skip.*/
+                (void) va_arg(_ap, int32_t);
+            }
+                break;
+            case OP_GET_SERVER_INFO_REQUEST: {
+                pinfo = va_arg(_ap, OpusServerInfo_t*);
+            }
+                break;
+            case OP_HTTP_READAHEAD_MS_REQUEST: {
+                readahead_ms = va_arg(_ap, int32_t);
+            }
+                break;
+            case OP_HTTP_BITRATE_KBPS_REQUEST: {
+                kbps = va_arg(_ap, int32_t);
+            }
+                break;
+            case OP_HTTP_STATS_REQUEST: {
+                stats = va_arg(_ap, OpusHttpStats_t*);
+            }
+                break;
+            /*Proxies are not supported.*/
+            default:
+                return NULL;
+        }
+    }
+    *_error = OP_EFAULT;
+    s = (OpusHttpStream_t*) calloc(1, sizeof(*s));
+    if(s == NULL) return NULL;
+    s->fd = -1;
+    s->size = -1;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->data_cond, NULL);
+    pthread_cond_init(&s->space_cond, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &s->start_time);
+    opus_server_info_init(_info);
+    ret = op_http_open(s, _url, _info);
+    if(ret < 0) {
+        *_error = ret;
+        opus_server_info_clear(_info);
+        op_http_stream_free(s);
+        return NULL;
+    }
+    /*Size the read-ahead in time, from the bitrate the caller gave us, or the
+       one the server announced.*/
+    if(kbps <= 0) kbps = _info->bitrate_kbps > 0 ? _info->bitrate_kbps : OP_HTTP_ASSUMED_KBPS;
+    ring_size = (int64_t) readahead_ms * kbps / 8;
+    s->ring_size = (size_t) OP_CLAMP(OP_HTTP_RING_MIN, ring_size, OP_HTTP_RING_MAX);
+    s->ring = (unsigned char*) malloc(s->ring_size);
+    s->user_stats = stats;
+    pthread_attr_init(&attr);
+#if defined(ESP_PLATFORM)
+    /*The fetch thread needs little besides its receive buffer.
+      Hosts keep their default stack: glibc refuses anything below
+       PTHREAD_STACK_MIN, and its resolver wants more than that anyway.*/
+    ret = pthread_attr_setstacksize(&attr, OP_HTTP_STACK_SIZE + OP_HTTP_RECV_SIZE);
+#else
+    ret = 0;
+#endif
+    if(ret != 0 || s->ring == NULL || pthread_create(&s->thread, &attr, op_http_fetch_main, s) != 0) {
+        *_error = OP_EFAULT;
+        pthread_attr_destroy(&attr);
+        opus_server_info_clear(_info);
+        op_http_stream_free(s);
+        return NULL;
+    }
+    pthread_attr_destroy(&attr);
+    _info->is_ssl = 0;
+    *_cb = OP_HTTP_CALLBACKS;
+    *_pinfo = pinfo;
+    return s;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* op_url_stream_vcreate(OpusFileCallbacks_t *_cb, const char *_url, va_list _ap) {
+    OpusServerInfo_t info;
+    OpusServerInfo_t *pinfo;
+    void *ret;
+    int error;
+    ret = op_url_stream_vcreate_impl(_cb, _url, &info, &pinfo, &error, _ap);
+    if(pinfo != NULL)
+        *pinfo = info;
+    else if(ret != NULL) opus_server_info_clear(&info);
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* op_url_stream_create(OpusFileCallbacks_t *_cb, const char *_url, ...) {
+    va_list ap;
+    void *ret;
+    va_start(ap, _url);
+    ret = op_url_stream_vcreate(_cb, _url, ap);
+    va_end(ap);
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Shared by the URL open/test functions: creates the stream and hands the server
+   info out only if the file opens.*/
+static OggOpusFile* op_url_open_impl(const char *_url, int *_error, int _test, va_list _ap) {
+    OpusFileCallbacks_t cb;
+    OggOpusFile *of;
+    OpusServerInfo_t info;
+    OpusServerInfo_t *pinfo;
+    void *source;
+    int error;
+    source = op_url_stream_vcreate_impl(&cb, _url, &info, &pinfo, &error, _ap);
+    if(source == NULL) {
+        if(_error != NULL) *_error = error;
+        return NULL;
+    }
+    of = _test ? op_test_callbacks(source, &cb, NULL, 0, _error) : op_open_callbacks(source, &cb, NULL, 0, _error);
+    if(of == NULL) {
+        opus_server_info_clear(&info);
+        (*cb.close)(source);
+    }
+    else if(pinfo != NULL)
+        *pinfo = info;
+    else
+        opus_server_info_clear(&info);
+    return of;
+}
+//----------------------------------------------------------------------------------------------------------------------
+OggOpusFile* op_vopen_url(const char *_url, int *_error, va_list _ap) {
+    return op_url_open_impl(_url, _error, 0, _ap);
+}
+//----------------------------------------------------------------------------------------------------------------------
+OggOpusFile* op_open_url(const char *_url, int *_error, ...) {
+    OggOpusFile *ret;
+    va_list ap;
+    va_start(ap, _error);
+    ret = op_vopen_url(_url, _error, ap);
+    va_end(ap);
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+OggOpusFile* op_vtest_url(const char *_url, int *_error, va_list _ap) {
+    return op_url_open_impl(_url, _error, 1, _ap);
+}
+//----------------------------------------------------------------------------------------------------------------------
+OggOpusFile* op_test_url(const char *_url, int *_error, ...) {
+    OggOpusFile *ret;
+    va_list ap;
+    va_start(ap, _error);
+    ret = op_vtest_url(_url, _error, ap);
+    va_end(ap);
+    return ret;
+}
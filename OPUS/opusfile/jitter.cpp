@@ -0,0 +1,569 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE libopusfile SOFTWARE CODEC SOURCE CODE. *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE libopusfile SOURCE CODE IS (C) COPYRIGHT 2012-2020           *
+ * by the Xiph.Org Foundation and contributors https://xiph.org/    *
+ *                                                                  *
+ ********************************************************************/
+
+/* Jitter buffer for raw Opus packets (RTP-style: a 16-bit sequence number and a
+   48 kHz timestamp per packet, no Ogg), e.g. an intercom receiving over UDP.
+   The network side op_jitter_put()s packets as they arrive, the audio side
+   op_jitter_get()s one frame per period. A missing packet is rebuilt from the
+   in-band FEC (LBRR) of its successor when that is already here, and concealed
+   with the decoder's PLC otherwise. The playout delay follows the measured
+   arrival jitter between the caller's target and maximum: a frame of PLC is
+   inserted when the buffer runs dry, and a frame is dropped when it has held
+   more than it needs for a while. op_jitter_simulate() runs the same buffer over
+   a simulated lossy, jittery link.*/
+
+#include "config.h"
+#include "Arduino.h"
+#include "internal.h"
+#include "opusfile.h"
+#include <pthread.h>
+
+/*Transit times remembered for the delay estimate, and the share of them the
+   target delay must cover (in 1/64ths).*/
+#define OP_JITTER_HISTORY    (64)
+#define OP_JITTER_COVER      (61)
+/*Gets in a row the buffer must hold more than it needs before a frame is
+   dropped.*/
+#define OP_JITTER_SHRINK_GETS (25)
+/*A packet this short is DTX/comfort noise: drop it at once if over target.*/
+#define OP_JITTER_DTX_BYTES  (3)
+#define OP_JITTER_FRAME_MAX  (5760)
+
+typedef struct OpusJitterSlot{
+    int            len;
+    uint16_t       seq;
+    uint32_t       ts;
+    int            used;
+    unsigned char  data[OP_JITTER_PACKET_MAX];
+} OpusJitterSlot_t;
+
+struct OpusJitterBuffer{
+    pthread_mutex_t    lock;
+    OpusDecoder       *decoder;
+    int                channels;
+    int                target_ms;
+    int                max_ms;
+    /*Playout state: the next sequence number and timestamp to play.*/
+    int                started;
+    uint16_t           next_seq;
+    uint32_t           next_ts;
+    /*The newest packet seen, and the end of its audio.*/
+    int                have_last;
+    uint16_t           last_seq;
+    uint32_t           last_end;
+    int                frame_size;
+    int                shrink_gets;
+    int                dry_gets;
+    /*RTP timestamps wrap: the newest one, and its value on a 64-bit timeline.*/
+    uint32_t           ts_ref;
+    int64_t            ts_ext;
+    /*RFC 3550 interarrival jitter in 1/16 ms, and recent transit times.*/
+    int32_t            jitter_q4;
+    int32_t            last_transit;
+    int32_t            transit[OP_JITTER_HISTORY];
+    int                ntransit;
+    int                transit_pos;
+    int32_t            min_transit;
+    int32_t            need_ms;
+    OpusJitterStats_t  st;
+    OpusJitterSlot_t   slots[OP_JITTER_SLOTS];
+    /*The packet(s) op_jitter_get() decodes, copied out of the slots.*/
+    unsigned char      pkt[2 * OP_JITTER_PACKET_MAX];
+};
+//----------------------------------------------------------------------------------------------------------------------
+OpusJitterBuffer* op_jitter_create(int _channels, int _target_ms, int _max_ms, int *_error) {
+    OpusJitterBuffer *jb;
+    int err;
+    if(_channels < 1 || _channels > 2 || _target_ms < 0 || _max_ms < _target_ms) {
+        if(_error != NULL) *_error = OP_EINVAL;
+        return NULL;
+    }
+    jb = (OpusJitterBuffer*) calloc(1, sizeof(*jb));
+    if(jb == NULL) {
+        if(_error != NULL) *_error = OP_EFAULT;
+        return NULL;
+    }
+    jb->decoder = opus_decoder_create(48000, _channels, &err);
+    if(jb->decoder == NULL) {
+        free(jb);
+        if(_error != NULL) *_error = OP_EFAULT;
+        return NULL;
+    }
+    pthread_mutex_init(&jb->lock, NULL);
+    jb->channels = _channels;
+    jb->target_ms = _target_ms;
+    jb->max_ms = _max_ms;
+    jb->frame_size = 960;
+    jb->need_ms = _target_ms;
+    jb->st.target_ms = _target_ms;
+    if(_error != NULL) *_error = 0;
+    return jb;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void op_jitter_free(OpusJitterBuffer *_jb) {
+    if(_jb == NULL) return;
+    opus_decoder_destroy(_jb->decoder);
+    pthread_mutex_destroy(&_jb->lock);
+    free(_jb);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_jitter_set_target(OpusJitterBuffer *_jb, int _target_ms, int _max_ms) {
+    if(_target_ms < 0 || _max_ms < _target_ms) return OP_EINVAL;
+    pthread_mutex_lock(&_jb->lock);
+    _jb->target_ms = _target_ms;
+    _jb->max_ms = _max_ms;
+    pthread_mutex_unlock(&_jb->lock);
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void op_jitter_stats(OpusJitterBuffer *_jb, OpusJitterStats_t *_stats) {
+    pthread_mutex_lock(&_jb->lock);
+    *_stats = _jb->st;
+    pthread_mutex_unlock(&_jb->lock);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void op_jitter_reset(OpusJitterBuffer *_jb) {
+    int i;
+    for(i = 0; i < OP_JITTER_SLOTS; i++)
+        _jb->slots[i].used = 0;
+    _jb->started = 0;
+    _jb->have_last = 0;
+    _jb->shrink_gets = 0;
+    _jb->dry_gets = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Updates the jitter estimate and the delay needed to catch OP_JITTER_COVER/64
+   of the packets, from how much later than the fastest one they arrive.*/
+static int64_t op_jitter_ts_ms(const OpusJitterBuffer *_jb, uint32_t _ts) {
+    return (_jb->ts_ext + (int32_t) (_ts - _jb->ts_ref)) / 48;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void op_jitter_track(OpusJitterBuffer *_jb, uint32_t _ts, int64_t _arrival_ms) {
+    int32_t sorted[OP_JITTER_HISTORY];
+    int32_t transit;
+    int32_t d;
+    int i;
+    int j;
+    if(_jb->ntransit == 0) {
+        _jb->ts_ref = _ts;
+        _jb->ts_ext = 0;
+    }
+    else if((int32_t) (_ts - _jb->ts_ref) > 0) {
+        _jb->ts_ext += (int32_t) (_ts - _jb->ts_ref);
+        _jb->ts_ref = _ts;
+    }
+    transit = (int32_t) (_arrival_ms - op_jitter_ts_ms(_jb, _ts));
+    if(_jb->ntransit > 0) {
+        d = transit - _jb->last_transit;
+        if(d < 0) d = -d;
+        _jb->jitter_q4 += d - ((_jb->jitter_q4 + 8) >> 4);
+    }
+    _jb->last_transit = transit;
+    _jb->transit[_jb->transit_pos] = transit;
+    _jb->transit_pos = (_jb->transit_pos + 1) % OP_JITTER_HISTORY;
+    if(_jb->ntransit < OP_JITTER_HISTORY) _jb->ntransit++;
+    /*Insertion sort: the history is short, and this runs once per packet.*/
+    for(i = 0; i < _jb->ntransit; i++) {
+        d = _jb->transit[i];
+        for(j = i; j > 0 && sorted[j - 1] > d; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = d;
+    }
+    _jb->min_transit = sorted[0];
+    _jb->need_ms = sorted[(_jb->ntransit - 1) * OP_JITTER_COVER / 64] - sorted[0];
+    _jb->st.jitter_ms = _jb->jitter_q4 >> 4;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_jitter_put(OpusJitterBuffer *_jb, const unsigned char *_data, int _len, uint16_t _seq, uint32_t _ts,
+        int64_t _arrival_ms) {
+    OpusJitterSlot_t *slot;
+    int nsamples;
+    int ret;
+    if(_len <= 0 || _len > OP_JITTER_PACKET_MAX) return OP_EINVAL;
+    nsamples = opus_packet_get_nb_samples(_data, _len, 48000);
+    if(nsamples <= 0) return OP_EBADPACKET;
+    pthread_mutex_lock(&_jb->lock);
+    _jb->st.received++;
+    op_jitter_track(_jb, _ts, _arrival_ms);
+    ret = 0;
+    if(_jb->started && (int16_t) (_seq - _jb->next_seq) < 0) {
+        /*Its turn has passed: it was concealed already.*/
+        _jb->st.late++;
+    }
+    else {
+        if(_jb->have_last && (int16_t) (_seq - _jb->last_seq) >= OP_JITTER_SLOTS) {
+            /*Too far ahead to keep everything in between: the sender restarted
+               or we fell hopelessly behind.*/
+            op_jitter_reset(_jb);
+            _jb->st.resyncs++;
+        }
+        if(_jb->started && (int16_t) (_seq - _jb->next_seq) >= OP_JITTER_SLOTS) {
+            op_jitter_reset(_jb);
+            _jb->st.resyncs++;
+        }
+        slot = _jb->slots + (_seq & (OP_JITTER_SLOTS - 1));
+        if(slot->used && slot->seq == _seq)
+            _jb->st.duplicates++;
+        else {
+            slot->used = 1;
+            slot->seq = _seq;
+            slot->ts = _ts;
+            slot->len = _len;
+            memcpy(slot->data, _data, _len);
+            if(!_jb->have_last || (int16_t) (_seq - _jb->last_seq) > 0) {
+                _jb->have_last = 1;
+                _jb->last_seq = _seq;
+                _jb->last_end = _ts + nsamples;
+            }
+            ret = 1;
+        }
+    }
+    pthread_mutex_unlock(&_jb->lock);
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static OpusJitterSlot_t* op_jitter_slot(OpusJitterBuffer *_jb, uint16_t _seq) {
+    OpusJitterSlot_t *slot;
+    slot = _jb->slots + (_seq & (OP_JITTER_SLOTS - 1));
+    return slot->used && slot->seq == _seq ? slot : NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*The milliseconds of audio queued ahead of the playout point.*/
+static int32_t op_jitter_buffered_ms(const OpusJitterBuffer *_jb) {
+    int32_t samples;
+    if(!_jb->have_last) return 0;
+    samples = (int32_t) (_jb->last_end - _jb->next_ts);
+    return samples > 0 ? samples / 48 : 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Picks what to play next and copies the packet(s) it needs out of the ring, so
+   the decoding can happen without the lock.
+  Return: An OP_JITTER_* kind.*/
+static int op_jitter_plan(OpusJitterBuffer *_jb, unsigned char *_pkt, int *_len, int *_drop_len, uint32_t *_ts,
+        int64_t _now_ms) {
+    OpusJitterSlot_t *slot;
+    int32_t target;
+    int32_t buffered;
+    int frame_ms;
+    int i;
+    *_len = *_drop_len = 0;
+    frame_ms = _jb->frame_size / 48;
+    target = OP_CLAMP(_jb->target_ms, _jb->need_ms + frame_ms, _jb->max_ms);
+    _jb->st.target_ms = target;
+    if(!_jb->started) {
+        uint16_t first;
+        int found;
+        /*Prebuffer: start with the oldest packet once enough is queued behind
+           it.*/
+        found = 0;
+        first = 0;
+        for(i = 0; i < OP_JITTER_SLOTS; i++) {
+            slot = _jb->slots + i;
+            if(slot->used && (!found || (int16_t) (slot->seq - first) < 0)) {
+                first = slot->seq;
+                found = 1;
+            }
+        }
+        if(!found) return OP_JITTER_SILENCE;
+        slot = op_jitter_slot(_jb, first);
+        if((int32_t) (_jb->last_end - slot->ts) / 48 < target) return OP_JITTER_SILENCE;
+        _jb->started = 1;
+        _jb->next_seq = first;
+        _jb->next_ts = slot->ts;
+    }
+    buffered = op_jitter_buffered_ms(_jb);
+    _jb->st.buffered_ms = buffered;
+    slot = op_jitter_slot(_jb, _jb->next_seq);
+    if(slot != NULL) {
+        _jb->dry_gets = 0;
+        /*Shrink toward the target by dropping a frame, preferably silence, once
+           the excess has lasted a while (or the buffer is over its maximum).*/
+        if(buffered - frame_ms > target) {
+            _jb->shrink_gets++;
+            if(_jb->shrink_gets >= OP_JITTER_SHRINK_GETS || slot->len <= OP_JITTER_DTX_BYTES
+                    || buffered > _jb->max_ms) {
+                OpusJitterSlot_t *next;
+                next = op_jitter_slot(_jb, (uint16_t) (_jb->next_seq + 1));
+                if(next != NULL) {
+                    memcpy(_pkt, slot->data, slot->len);
+                    *_drop_len = slot->len;
+                    slot->used = 0;
+                    _jb->next_seq++;
+                    _jb->next_ts = next->ts;
+                    _jb->shrink_gets = 0;
+                    _jb->st.dropped++;
+                    slot = next;
+                }
+            }
+        }
+        else
+            _jb->shrink_gets = 0;
+        memcpy(_pkt + *_drop_len, slot->data, slot->len);
+        *_len = slot->len;
+        *_ts = slot->ts;
+        slot->used = 0;
+        _jb->next_seq++;
+        _jb->next_ts = slot->ts + opus_packet_get_nb_samples(_pkt + *_drop_len, *_len, 48000);
+        return OP_JITTER_DECODED;
+    }
+    *_ts = _jb->next_ts;
+    if((int16_t) (_jb->last_seq - _jb->next_seq) < 0) {
+        if(++_jb->dry_gets * frame_ms > _jb->max_ms) {
+            /*The talker went away: prebuffer again when it comes back.*/
+            op_jitter_reset(_jb);
+            _jb->st.resyncs++;
+            return OP_JITTER_SILENCE;
+        }
+    }
+    else
+        _jb->dry_gets = 0;
+    if(_now_ms < op_jitter_ts_ms(_jb, _jb->next_ts) + _jb->min_transit + _jb->need_ms) {
+        /*Most packets would not be here yet either: it is late (or reordered),
+           not lost. Conceal in place and let the delay grow by a frame.*/
+        return OP_JITTER_STRETCH;
+    }
+    /*Lost: rebuild it from the redundancy in its successor, if that is here.*/
+    _jb->next_seq++;
+    _jb->next_ts += _jb->frame_size;
+    slot = op_jitter_slot(_jb, _jb->next_seq);
+    if(slot != NULL && opus_packet_has_lbrr(slot->data, slot->len) > 0) {
+        memcpy(_pkt, slot->data, slot->len);
+        *_len = slot->len;
+        return OP_JITTER_FEC;
+    }
+    return OP_JITTER_PLC;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_jitter_get_impl(OpusJitterBuffer *_jb, int16_t *_pcm, int _buf_size, int64_t _now_ms, int *_kind,
+        uint32_t *_ts) {
+    unsigned char *pkt;
+    int drop_len;
+    int frame_size;
+    int kind;
+    int len;
+    int ret;
+    pkt = _jb->pkt;
+    pthread_mutex_lock(&_jb->lock);
+    kind = op_jitter_plan(_jb, pkt, &len, &drop_len, _ts, _now_ms);
+    frame_size = _jb->frame_size;
+    pthread_mutex_unlock(&_jb->lock);
+    if(_buf_size < frame_size * _jb->channels) return OP_EINVAL;
+    _buf_size /= _jb->channels;
+    switch(kind){
+        case OP_JITTER_SILENCE: {
+            memset(_pcm, 0, sizeof(*_pcm) * frame_size * _jb->channels);
+            ret = frame_size;
+        }
+            break;
+        case OP_JITTER_DECODED: {
+            if(drop_len > 0) {
+                /*Decode the dropped frame anyway, so the decoder's history stays
+                   continuous.*/
+                ret = opus_decode(_jb->decoder, pkt, drop_len, _pcm, _buf_size, 0);
+            }
+            ret = opus_decode(_jb->decoder, pkt + drop_len, len, _pcm, _buf_size, 0);
+            if(ret < 0) {
+                /*Corrupt: conceal it like a lost one.*/
+                ret = opus_decode(_jb->decoder, NULL, 0, _pcm, frame_size, 0);
+                kind = OP_JITTER_PLC;
+            }
+        }
+            break;
+        case OP_JITTER_FEC: {
+            ret = opus_decode(_jb->decoder, pkt, len, _pcm, frame_size, 1);
+        }
+            break;
+        default:
+            ret = opus_decode(_jb->decoder, NULL, 0, _pcm, frame_size, 0);
+    }
+    if(ret < 0) {
+        memset(_pcm, 0, sizeof(*_pcm) * frame_size * _jb->channels);
+        ret = frame_size;
+    }
+    pthread_mutex_lock(&_jb->lock);
+    if(kind == OP_JITTER_DECODED) _jb->frame_size = ret;
+    if(kind != OP_JITTER_SILENCE) {
+        _jb->st.frames++;
+        _jb->st.play_ts = *_ts;
+    }
+    switch(kind){
+        case OP_JITTER_DECODED:
+            _jb->st.decoded++;
+            break;
+        case OP_JITTER_FEC:
+            _jb->st.fec++;
+            break;
+        case OP_JITTER_PLC:
+            _jb->st.plc++;
+            break;
+        case OP_JITTER_STRETCH:
+            _jb->st.stretched++;
+            break;
+    }
+    pthread_mutex_unlock(&_jb->lock);
+    *_kind = kind;
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_jitter_get(OpusJitterBuffer *_jb, int16_t *_pcm, int _buf_size, int64_t _now_ms) {
+    uint32_t ts;
+    int kind;
+    return op_jitter_get_impl(_jb, _pcm, _buf_size, _now_ms, &kind, &ts);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*xorshift32: the simulation must give the same result for the same seed on
+   every platform.*/
+static uint32_t op_jitter_rand(uint32_t *_state) {
+    uint32_t x;
+    x = *_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *_state = x;
+    return x;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_jitter_simulate(const unsigned char *const *_packets, const int *_lens, int _npackets,
+        const OpusJitterSimParams_t *_params, OpusJitterSimResult_t *_result, op_jitter_pcm_func _pcm_cb, void *_ctx) {
+    OpusJitterBuffer *jb;
+    int64_t *arrival;
+    uint32_t *ts;
+    int *order;
+    int32_t *hist;
+    int16_t *pcm;
+    int64_t now;
+    int64_t latency_sum;
+    int64_t end_ms;
+    uint32_t rng;
+    uint32_t t;
+    int latency_n;
+    int bad;
+    int next;
+    int err;
+    int i;
+    memset(_result, 0, sizeof(*_result));
+    if(_npackets <= 0) return OP_EINVAL;
+    jb = op_jitter_create(_params->channels, _params->target_ms, _params->max_ms, &err);
+    if(jb == NULL) return err;
+    arrival = (int64_t*) malloc(sizeof(*arrival) * _npackets);
+    ts = (uint32_t*) malloc(sizeof(*ts) * _npackets);
+    order = (int*) malloc(sizeof(*order) * _npackets);
+    hist = (int32_t*) calloc(OP_JITTER_SIM_HIST_MS, sizeof(*hist));
+    pcm = (int16_t*) malloc(sizeof(*pcm) * OP_JITTER_FRAME_MAX * _params->channels);
+    if(arrival == NULL || ts == NULL || order == NULL || hist == NULL || pcm == NULL) {
+        err = OP_EFAULT;
+        goto done;
+    }
+    /*The sender: each packet leaves once its audio has been captured. The link:
+       a Gilbert-Elliott loss model (losses come in bursts of mean length
+       burst_len) and a uniformly distributed extra delay.*/
+    rng = _params->seed != 0 ? _params->seed : 1;
+    bad = 0;
+    t = 0;
+    end_ms = 0;
+    for(i = 0; i < _npackets; i++) {
+        int nsamples;
+        int lost;
+        nsamples = opus_packet_get_nb_samples(_packets[i], _lens[i], 48000);
+        if(nsamples <= 0) nsamples = 960;
+        ts[i] = t;
+        t += nsamples;
+        if(_params->loss_pct > 0) {
+            int burst;
+            burst = _max(_params->burst_len, 1);
+            /*P(good->bad)=p/(burst*(1-p)) keeps the long-run loss rate at p.*/
+            if(bad)
+                bad = op_jitter_rand(&rng) % 1000 >= (uint32_t) (1000 / burst);
+            else
+                bad = op_jitter_rand(&rng) % (1000 * burst * (100 - _params->loss_pct) / 100 + 1)
+                        < (uint32_t) (10 * _params->loss_pct);
+        }
+        lost = bad;
+        arrival[i] = lost ? -1 : (int64_t) t / 48 + _params->delay_ms
+                + (_params->jitter_ms > 0 ? op_jitter_rand(&rng) % (_params->jitter_ms + 1) : 0);
+        if(arrival[i] > end_ms) end_ms = arrival[i];
+        _result->sent++;
+        if(lost) _result->lost++;
+        order[i] = i;
+    }
+    /*Deliver in arrival order (jitter reorders packets).*/
+    for(i = 1; i < _npackets; i++) {
+        int k;
+        int j;
+        k = order[i];
+        for(j = i; j > 0 && arrival[order[j - 1]] > arrival[k]; j--)
+            order[j] = order[j - 1];
+        order[j] = k;
+    }
+    /*The receiver plays one frame per frame period, starting when the first
+       packet could have arrived.*/
+    end_ms += _params->max_ms + 1000;
+    latency_sum = 0;
+    latency_n = 0;
+    next = 0;
+    while(next < _npackets && arrival[order[next]] < 0)
+        next++;
+    now = 0;
+    for(;;) {
+        uint32_t play_ts;
+        int kind;
+        int ret;
+        while(next < _npackets && arrival[order[next]] <= now) {
+            op_jitter_put(jb, _packets[order[next]], _lens[order[next]], (uint16_t) order[next], ts[order[next]],
+                    arrival[order[next]]);
+            next++;
+        }
+        ret = op_jitter_get_impl(jb, pcm, OP_JITTER_FRAME_MAX * _params->channels, now, &kind, &play_ts);
+        if(ret <= 0) {
+            err = ret;
+            goto done;
+        }
+        if(_pcm_cb != NULL) (*_pcm_cb)(_ctx, pcm, ret, kind, play_ts);
+        if(kind != OP_JITTER_SILENCE && kind != OP_JITTER_STRETCH) {
+            int32_t latency;
+            /*Mouth to ear: from the capture of the frame's first sample to the
+               moment it starts playing.*/
+            latency = (int32_t) (now - play_ts / 48);
+            latency_sum += latency;
+            latency_n++;
+            hist[OP_CLAMP(0, latency, OP_JITTER_SIM_HIST_MS - 1)]++;
+            if(latency > _result->latency_max_ms) _result->latency_max_ms = latency;
+            if(play_ts + ret >= t) break;
+        }
+        now += ret / 48;
+        if(now > end_ms) break;
+    }
+    op_jitter_stats(jb, &_result->stats);
+    if(latency_n > 0) {
+        int32_t cum;
+        _result->latency_avg_ms = (int32_t) (latency_sum / latency_n);
+        cum = 0;
+        for(i = 0; i < OP_JITTER_SIM_HIST_MS; i++) {
+            cum += hist[i];
+            if(cum * 100 >= latency_n * 95) break;
+        }
+        _result->latency_p95_ms = i;
+    }
+    if(_result->stats.frames > 0) {
+        _result->concealed_permille = (int32_t) ((_result->stats.plc + _result->stats.stretched) * 1000
+                / _result->stats.frames);
+    }
+    err = 0;
+done:
+    free(pcm);
+    free(hist);
+    free(order);
+    free(ts);
+    free(arrival);
+    op_jitter_free(jb);
+    return err;
+}
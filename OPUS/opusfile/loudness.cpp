@@ -0,0 +1,602 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE libopusfile SOFTWARE CODEC SOURCE CODE. *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE libopusfile SOURCE CODE IS (C) COPYRIGHT 2012-2020           *
+ * by the Xiph.Org Foundation and contributors https://xiph.org/    *
+ *                                                                  *
+ ********************************************************************/
+
+/* EBU R128 loudness analysis and R128_TRACK_GAIN/R128_ALBUM_GAIN tagging.
+   The meter follows ITU-R BS.1770-4 in fixed point: each channel is K-weighted
+   (a high shelf and a high pass, at 48 kHz), 400 ms blocks overlapping by 75%
+   are summed over the channels with the surround weights, and the blocks go
+   into a loudness histogram of 1/8 dB bins. The integrated loudness gates the
+   histogram at -70 LUFS and then 10 LU below the ungated result, so an album is
+   just the sum of its tracks' histograms. op_tags_rewrite_gain() copies a file
+   with new gain tags: only the OpusTags pages are rebuilt, the audio pages are
+   copied as they are, renumbered if the tags took a different page count.*/
+
+#include "config.h"
+#include "Arduino.h"
+#include "internal.h"
+#include "opusfile.h"
+#if !defined(ESP_PLATFORM)
+#include <pthread.h>
+#endif
+
+/*The 100 ms step between blocks, and the steps per 400 ms block.*/
+#define OP_LOUDNESS_STEP     (4800)
+#define OP_LOUDNESS_STEPS    (4)
+/*Histogram range: 1/8 dB bins (Q8 >> 5) from the absolute gate up.*/
+#define OP_LOUDNESS_GATE_Q8  (-70 * 256)
+#define OP_LOUDNESS_BIN_SH   (5)
+/*-0.691 dB: BS.1770 puts a full-scale 1 kHz sine at -3.01 LUFS.*/
+#define OP_LOUDNESS_OFFS_Q8  (-177)
+#define OP_LOUDNESS_REL_Q8   (-10 * 256)
+#define OP_LOUDNESS_REF_Q8   (-23 * 256)
+/*Interleaved samples per op_read_s32() in op_loudness_read().*/
+#define OP_LOUDNESS_CHUNK    (1920)
+
+/*K-weighting at 48 kHz (BS.1770-4, table 1 and 2). The shelf needs Q29 for
+   b1; the high pass has b = {1, -2, 1} and its poles in Q30.*/
+#define OP_KW_SH_B0 ((int32_t) 824163883)   /* 1.53512485958697 */
+#define OP_KW_SH_B1 ((int32_t) -1445093388) /*-2.69169618940638 */
+#define OP_KW_SH_B2 ((int32_t) 643382241)   /* 1.19839281085285 */
+#define OP_KW_SH_A1 ((int32_t) -907665797)  /*-1.69065929318241 */
+#define OP_KW_SH_A2 ((int32_t) 393247621)   /* 0.73248077421585 */
+#define OP_KW_HP_A1 ((int64_t) -2136797184) /*-1.99004745483398 */
+#define OP_KW_HP_A2 ((int64_t) 1063081984)  /* 0.99007225036621 */
+
+/*Channel weights in Q7 for the Vorbis channel orders (mapping families 0 and
+   1): 1.41 for the surrounds and 0 for the LFE.*/
+static const unsigned char OP_LOUDNESS_WEIGHTS[OP_MAPPING_MAX][OP_MAPPING_MAX] = {
+    {128},
+    {128, 128},
+    {128, 128, 128},
+    {128, 128, 180, 180},
+    {128, 128, 128, 180, 180},
+    {128, 128, 128, 180, 180, 0},
+    {128, 128, 128, 180, 180, 180, 0},
+    {128, 128, 128, 180, 180, 180, 180, 0}
+};
+//----------------------------------------------------------------------------------------------------------------------
+/*log2(_x) in Q16, bit by bit from the squares of the mantissa.*/
+static int32_t op_log2_q16(uint64_t _x) {
+    uint64_t m;
+    int32_t ret;
+    int e;
+    int i;
+    OP_ASSERT(_x > 0);
+    for(e = 0; (_x >> e) > 1; e++);
+    m = e >= 30 ? _x >> (e - 30) : _x << (30 - e);
+    ret = e << 16;
+    for(i = 15; i >= 0; i--) {
+        m = m * m >> 30;
+        if(m >= (uint64_t) 2 << 30) {
+            m >>= 1;
+            ret |= 1 << i;
+        }
+    }
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Loudness of the mean square _nrg / _n (Q32, full scale = 1) in LUFS, Q8.*/
+static int32_t op_loudness_q8(uint64_t _nrg, uint64_t _n) {
+    int64_t l2;
+    l2 = (int64_t) op_log2_q16(_nrg) - op_log2_q16(_n) - ((int64_t) 32 << 16);
+    /*10 * log10(2) * 256 / 65536, in Q20.*/
+    return OP_LOUDNESS_OFFS_Q8 + (int32_t) (l2 * 12330 >> 20);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void op_loudness_init(OpusLoudnessMeter_t *_lm) {
+    memset(_lm, 0, sizeof(*_lm));
+}
+//----------------------------------------------------------------------------------------------------------------------
+void op_loudness_set_layout(OpusLoudnessMeter_t *_lm, int _channels, int _mapping_family) {
+    unsigned char weights[OP_MAPPING_MAX];
+    int ci;
+    _channels = OP_CLAMP(1, _channels, OP_MAPPING_MAX);
+    for(ci = 0; ci < _channels; ci++) {
+        weights[ci] = _mapping_family <= 1 ? OP_LOUDNESS_WEIGHTS[_channels - 1][ci] : 128;
+    }
+    /*Chained links with the same layout keep the filters and the blocks going.*/
+    if(_channels == _lm->channels && memcmp(weights, _lm->weights_q7, _channels) == 0) return;
+    _lm->channels = _channels;
+    memcpy(_lm->weights_q7, weights, _channels);
+    memset(_lm->state, 0, sizeof(_lm->state));
+    memset(_lm->step_nrg, 0, sizeof(_lm->step_nrg));
+    _lm->step_len = 0;
+    _lm->nsteps = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*A 100 ms step is complete: weigh its channels and close the block it ends.*/
+static void op_loudness_step(OpusLoudnessMeter_t *_lm) {
+    uint64_t nrg;
+    uint64_t block;
+    int ci;
+    int si;
+    nrg = 0;
+    for(ci = 0; ci < _lm->channels; ci++) {
+        /*Samples carry 6 fractional bits below int16: full scale is 2^21.*/
+        nrg += (uint64_t) (_lm->step_nrg[ci] / OP_LOUDNESS_STEP) * _lm->weights_q7[ci];
+        _lm->step_nrg[ci] = 0;
+    }
+    nrg >>= 2 * 21 + 7 - 32;
+    block = nrg;
+    for(si = 0; si < OP_LOUDNESS_STEPS - 1; si++)
+        block += _lm->steps[si];
+    memmove(_lm->steps + 1, _lm->steps, sizeof(*_lm->steps) * (OP_LOUDNESS_STEPS - 2));
+    _lm->steps[0] = nrg;
+    _lm->step_len = 0;
+    if(++_lm->nsteps >= OP_LOUDNESS_STEPS) {
+        int32_t l_q8;
+        int bi;
+        block /= OP_LOUDNESS_STEPS;
+        if(block == 0) return;
+        l_q8 = op_loudness_q8(block, 1);
+        if(l_q8 <= OP_LOUDNESS_GATE_Q8) return;
+        bi = _min((l_q8 - OP_LOUDNESS_GATE_Q8) >> OP_LOUDNESS_BIN_SH, OP_LOUDNESS_BINS - 1);
+        _lm->counts[bi]++;
+        _lm->sums[bi] += block;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*_pcm holds _nsamples left-justified samples per channel, interleaved.*/
+void op_loudness_add(OpusLoudnessMeter_t *_lm, const int32_t *_pcm, int _nsamples) {
+    int nchannels;
+    nchannels = _lm->channels;
+    if(nchannels <= 0) return;
+    while(_nsamples > 0) {
+        int n;
+        int ci;
+        n = _min(_nsamples, OP_LOUDNESS_STEP - _lm->step_len);
+        for(ci = 0; ci < nchannels; ci++) {
+            const int32_t *x;
+            int32_t *st;
+            int64_t nrg;
+            int32_t x1, x2, s1, s2, y1, y2;
+            int64_t e1, e2;
+            int i;
+            x = _pcm + ci;
+            st = _lm->state[ci];
+            x1 = st[0]; x2 = st[1]; s1 = st[2]; s2 = st[3]; y1 = st[4]; y2 = st[5];
+            e1 = st[6]; e2 = st[7];
+            nrg = _lm->step_nrg[ci];
+            for(i = 0; i < n; i++) {
+                int64_t acc;
+                int32_t x0, s0, y0;
+                x0 = x[i * nchannels] >> 10;
+                acc = (int64_t) OP_KW_SH_B0 * x0 + (int64_t) OP_KW_SH_B1 * x1 + (int64_t) OP_KW_SH_B2 * x2
+                        - (int64_t) OP_KW_SH_A1 * s1 - (int64_t) OP_KW_SH_A2 * s2;
+                s0 = (int32_t) ((acc + ((int64_t) 1 << 28)) >> 29);
+                /*The high pass has a double pole next to DC, where it would pile
+                 up the rounding error: feed the error back twice over, so it
+                 sees the same (1 - z^-1)^2 as the signal.*/
+                acc = (int64_t) (s0 - 2 * s1 + s2) * ((int64_t) 1 << 30) - OP_KW_HP_A1 * y1 - OP_KW_HP_A2 * y2
+                        + 2 * e1 - e2;
+                y0 = (int32_t) (acc >> 30);
+                e2 = e1;
+                e1 = acc - (int64_t) y0 * ((int64_t) 1 << 30);
+                nrg += (int64_t) y0 * y0;
+                x2 = x1; x1 = x0; s2 = s1; s1 = s0; y2 = y1; y1 = y0;
+            }
+            st[0] = x1; st[1] = x2; st[2] = s1; st[3] = s2; st[4] = y1; st[5] = y2;
+            st[6] = (int32_t) e1; st[7] = (int32_t) e2;
+            _lm->step_nrg[ci] = nrg;
+        }
+        _pcm += n * nchannels;
+        _nsamples -= n;
+        _lm->step_len += n;
+        if(_lm->step_len >= OP_LOUDNESS_STEP) op_loudness_step(_lm);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void op_loudness_merge(OpusLoudnessMeter_t *_dst, const OpusLoudnessMeter_t *_src) {
+    int bi;
+    for(bi = 0; bi < OP_LOUDNESS_BINS; bi++) {
+        _dst->counts[bi] += _src->counts[bi];
+        _dst->sums[bi] += _src->sums[bi];
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Return: 0, or OP_FALSE if no block is above the absolute gate.*/
+int op_loudness_get(const OpusLoudnessMeter_t *_lm, int32_t *_loudness_q8) {
+    uint64_t nrg;
+    uint64_t n;
+    int32_t l_q8;
+    int bi;
+    nrg = n = 0;
+    for(bi = 0; bi < OP_LOUDNESS_BINS; bi++) {
+        n += _lm->counts[bi];
+        nrg += _lm->sums[bi];
+    }
+    if(n == 0) return OP_FALSE;
+    /*The relative gate falls inside a bin: take the bins whose centre is above.*/
+    l_q8 = op_loudness_q8(nrg, n) + OP_LOUDNESS_REL_Q8;
+    bi = _max((l_q8 - OP_LOUDNESS_GATE_Q8 + (1 << OP_LOUDNESS_BIN_SH >> 1)) >> OP_LOUDNESS_BIN_SH, 0);
+    nrg = n = 0;
+    for(; bi < OP_LOUDNESS_BINS; bi++) {
+        n += _lm->counts[bi];
+        nrg += _lm->sums[bi];
+    }
+    /*The loudest block is always above the relative gate.*/
+    OP_ASSERT(n > 0);
+    *_loudness_q8 = op_loudness_q8(nrg, n);
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*The R128 gain tags bring the loudness to -23 LUFS on top of the output gain.*/
+static void op_loudness_result(OpusLoudness_t *_res, const OpusLoudnessMeter_t *_lm) {
+    _res->loudness_q8 = OP_LOUDNESS_GATE_Q8;
+    _res->gain_q8 = 0;
+    _res->status = op_loudness_get(_lm, &_res->loudness_q8);
+    if(_res->status >= 0) _res->gain_q8 = OP_CLAMP(-32768, OP_LOUDNESS_REF_Q8 - _res->loudness_q8, 32767);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Decodes to the end of the stream with the header gain only, as the R128
+ tags expect, and leaves the gain that way.*/
+int op_loudness_read(OggOpusFile *_of, OpusLoudnessMeter_t *_lm) {
+    int32_t *pcm;
+    int prev_li;
+    int ret;
+    ret = op_set_gain_offset(_of, OP_HEADER_GAIN, 0);
+    if(ret < 0) return ret;
+    pcm = (int32_t*) malloc(sizeof(*pcm) * OP_LOUDNESS_CHUNK);
+    if(pcm == NULL) return OP_EFAULT;
+    prev_li = -1;
+    for(;;) {
+        int li;
+        ret = op_read_s32(_of, pcm, OP_LOUDNESS_CHUNK, &li);
+        if(ret == OP_HOLE) continue;
+        if(ret <= 0) break;
+        if(li != prev_li) {
+            const OpusHead_t *head;
+            head = op_head(_of, li);
+            /*A channel selection (op_set_channel_layout()) is weighed flat.*/
+            op_loudness_set_layout(_lm, _of->od_channel_count,
+                    _of->od_channel_count == head->channel_count ? head->mapping_family : 255);
+            prev_li = li;
+        }
+        op_loudness_add(_lm, pcm, ret);
+    }
+    free(pcm);
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Return: 0 (with the track's result in *_res), or a negative value on failure
+ (also left in _res->status).*/
+int op_loudness_file(OpusLoudness_t *_res, OpusLoudnessMeter_t *_lm, const char *_path) {
+    OpusFileCallbacks_t cb;
+    OggOpusFile *of;
+    void *stream;
+    int ret;
+    _res->loudness_q8 = OP_LOUDNESS_GATE_Q8;
+    _res->gain_q8 = 0;
+    stream = op_fopen(&cb, _path, "rb");
+    if(stream == NULL) return _res->status = OP_EFAULT;
+    of = op_open_callbacks(stream, &cb, NULL, 0, &ret);
+    if(of == NULL) {
+        (*cb.close)(stream);
+        return _res->status = ret;
+    }
+    ret = op_loudness_read(of, _lm);
+    op_free(of);
+    if(ret < 0) return _res->status = ret;
+    op_loudness_result(_res, _lm);
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Shared state of the op_loudness_album() workers: each measures the next file
+ with its own meter and adds the histogram to the album's.*/
+typedef struct OpusLoudnessJob{
+    const char *const  *paths;
+    int                 npaths;
+    OpusLoudness_t     *tracks;
+    OpusLoudnessMeter_t album;
+    int                 next;
+#if !defined(ESP_PLATFORM)
+    pthread_mutex_t     lock;
+#endif
+} OpusLoudnessJob_t;
+//----------------------------------------------------------------------------------------------------------------------
+static void *op_loudness_worker(void *_arg) {
+    OpusLoudnessJob_t *job;
+    OpusLoudnessMeter_t *lm;
+    job = (OpusLoudnessJob_t*) _arg;
+    lm = (OpusLoudnessMeter_t*) malloc(sizeof(*lm));
+    for(;;) {
+        int i;
+#if !defined(ESP_PLATFORM)
+        pthread_mutex_lock(&job->lock);
+#endif
+        i = job->next < job->npaths ? job->next++ : -1;
+#if !defined(ESP_PLATFORM)
+        pthread_mutex_unlock(&job->lock);
+#endif
+        if(i < 0) break;
+        if(lm == NULL) {
+            job->tracks[i].status = OP_EFAULT;
+            continue;
+        }
+        op_loudness_init(lm);
+        if(op_loudness_file(job->tracks + i, lm, job->paths[i]) >= 0) {
+#if !defined(ESP_PLATFORM)
+            pthread_mutex_lock(&job->lock);
+#endif
+            op_loudness_merge(&job->album, lm);
+#if !defined(ESP_PLATFORM)
+            pthread_mutex_unlock(&job->lock);
+#endif
+        }
+    }
+    free(lm);
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Measures _npaths files as one album: _tracks gets each file's loudness and
+ track gain, _album the loudness and gain of all of them together. Hosts spread
+ the files over _nthreads threads; the ESP32 measures them one after another.
+ Return: The number of files measured, or a negative value on failure.*/
+int op_loudness_album(OpusLoudness_t *_tracks, OpusLoudness_t *_album, const char *const *_paths, int _npaths,
+        int _nthreads) {
+    OpusLoudnessJob_t *job;
+    int nmeasured;
+    int i;
+    /*The album histogram is too big for an ESP32 task stack.*/
+    job = (OpusLoudnessJob_t*) malloc(sizeof(*job));
+    if(job == NULL) return OP_EFAULT;
+    job->paths = _paths;
+    job->npaths = _npaths;
+    job->tracks = _tracks;
+    job->next = 0;
+    op_loudness_init(&job->album);
+#if !defined(ESP_PLATFORM)
+    pthread_mutex_init(&job->lock, NULL);
+    if(_nthreads > 1) {
+        pthread_t *threads;
+        int nthreads;
+        threads = (pthread_t*) malloc(sizeof(*threads) * (_nthreads - 1));
+        nthreads = 0;
+        if(threads != NULL) {
+            while(nthreads < _nthreads - 1
+                    && pthread_create(threads + nthreads, NULL, op_loudness_worker, job) == 0) {
+                nthreads++;
+            }
+        }
+        op_loudness_worker(job);
+        for(i = 0; i < nthreads; i++)
+            pthread_join(threads[i], NULL);
+        free(threads);
+    }
+    else
+        op_loudness_worker(job);
+    pthread_mutex_destroy(&job->lock);
+#else
+    (void) _nthreads;
+    op_loudness_worker(job);
+#endif
+    nmeasured = 0;
+    for(i = 0; i < _npaths; i++)
+        nmeasured += _tracks[i].status == 0 || _tracks[i].status == OP_FALSE;
+    op_loudness_result(_album, &job->album);
+    free(job);
+    return nmeasured;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t op_tags_get32(const unsigned char *_p) {
+    return _p[0] | (uint32_t) _p[1] << 8 | (uint32_t) _p[2] << 16 | (uint32_t) _p[3] << 24;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static unsigned char *op_tags_put32(unsigned char *_p, uint32_t _v) {
+    _p[0] = (unsigned char) _v;
+    _p[1] = (unsigned char) (_v >> 8);
+    _p[2] = (unsigned char) (_v >> 16);
+    _p[3] = (unsigned char) (_v >> 24);
+    return _p + 4;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Copies the OpusTags packet _src into a new packet (malloc()ed into *_dst)
+ without the R128 gain comments that are replaced, and with the new ones
+ appended. The vendor string, the other comments and the binary suffix are
+ kept byte for byte.
+ Return: The new size, or OP_EBADHEADER.*/
+static long op_tags_with_gain(unsigned char **_dst, const unsigned char *_src, long _len,
+        const int32_t *_track_gain_q8, const int32_t *_album_gain_q8) {
+    static const char *const NAMES[2] = {"R128_TRACK_GAIN", "R128_ALBUM_GAIN"};
+    const int32_t *gains[2];
+    char added[2][32];
+    unsigned char *dst;
+    unsigned char *p;
+    uint32_t ncomments;
+    uint32_t nkept;
+    size_t pos;
+    uint32_t size;
+    uint32_t ci;
+    int gi;
+    gains[0] = _track_gain_q8;
+    gains[1] = _album_gain_q8;
+    if(_len < 16 || memcmp(_src, "OpusTags", 8) != 0) return OP_EBADHEADER;
+    pos = 8;
+    size = op_tags_get32(_src + pos);
+    if(size > (size_t) (_len - 16)) return OP_EBADHEADER;
+    pos += 4 + size;
+    ncomments = op_tags_get32(_src + pos);
+    pos += 4;
+    /*Worst case: nothing dropped, so the input plus both new comments.*/
+    dst = (unsigned char*) malloc(_len + 2 * (4 + sizeof(added[0])));
+    if(dst == NULL) return OP_EFAULT;
+    memcpy(dst, _src, pos);
+    p = dst + pos;
+    nkept = 0;
+    for(ci = 0; ci < ncomments; ci++) {
+        int drop;
+        if((size_t) _len - pos < 4) break;
+        size = op_tags_get32(_src + pos);
+        if(size > (size_t) _len - pos - 4) break;
+        drop = 0;
+        for(gi = 0; gi < 2; gi++) {
+            if(gains[gi] != NULL && size > 15 && op_strncasecmp(NAMES[gi], (const char*) _src + pos + 4, 15) == 0
+                    && _src[pos + 4 + 15] == '=') {
+                drop = 1;
+            }
+        }
+        if(!drop) {
+            memcpy(p, _src + pos, 4 + size);
+            p += 4 + size;
+            nkept++;
+        }
+        pos += 4 + size;
+    }
+    if(ci < ncomments) {
+        free(dst);
+        return OP_EBADHEADER;
+    }
+    for(gi = 0; gi < 2; gi++) {
+        if(gains[gi] != NULL) {
+            int n;
+            n = snprintf(added[gi], sizeof(added[gi]), "%s=%i", NAMES[gi], (int) OP_CLAMP(-32768, *gains[gi], 32767));
+            p = op_tags_put32(p, (uint32_t) n);
+            memcpy(p, added[gi], n);
+            p += n;
+            nkept++;
+        }
+    }
+    /*Whatever follows the comments is the binary suffix.*/
+    memcpy(p, _src + pos, _len - pos);
+    p += _len - pos;
+    op_tags_put32(dst + 12 + op_tags_get32(_src + 8), nkept);
+    *_dst = dst;
+    return (long) (p - dst);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_page_write(FILE *_out, const ogg_page *_og) {
+    if(fwrite(_og->header, 1, _og->header_len, _out) != (size_t) _og->header_len) return OP_EFAULT;
+    if(fwrite(_og->body, 1, _og->body_len, _out) != (size_t) _og->body_len) return OP_EFAULT;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Copies the Ogg Opus file _in to _out with the R128_TRACK_GAIN and/or
+ R128_ALBUM_GAIN comments of every link set to the given values (NULL keeps a
+ tag as it is). Only the OpusTags pages are rebuilt; the pages after them are
+ copied, with their sequence numbers (and CRCs) fixed up if the tags now take a
+ different number of pages. Other multiplexed streams pass through unchanged.
+ The whole OpusTags packet is held in RAM, cover art included.
+ Return: The number of links rewritten, or a negative value on failure.*/
+int op_tags_rewrite_gain(FILE *_in, FILE *_out, const int32_t *_track_gain_q8, const int32_t *_album_gain_q8) {
+    ogg_sync_state oy;
+    ogg_stream_state is;
+    ogg_page og;
+    uint32_t serialno;
+    /*0: no Opus stream, 1: reading its tags, 2: renumbering its pages.*/
+    int state;
+    long pageno_delta;
+    int nold;
+    int nlinks;
+    int ret;
+    ogg_sync_init(&oy);
+    ogg_stream_init(&is, 0);
+    state = 0;
+    serialno = 0;
+    pageno_delta = 0;
+    nold = 0;
+    nlinks = 0;
+    ret = 0;
+    while(ret >= 0) {
+        long page_ret;
+        page_ret = ogg_sync_pageseek(&oy, &og);
+        if(page_ret < 0) continue;
+        if(page_ret == 0) {
+            char *buf;
+            size_t nread;
+            buf = ogg_sync_buffer(&oy, 4096);
+            if(buf == NULL) {
+                ret = OP_EFAULT;
+                break;
+            }
+            nread = fread(buf, 1, 4096, _in);
+            if(nread == 0) {
+                if(ferror(_in)) ret = OP_EREAD;
+                /*The file ended inside the headers.*/
+                else if(state == 1) ret = OP_EBADHEADER;
+                break;
+            }
+            ogg_sync_wrote(&oy, (long) nread);
+            continue;
+        }
+        if(ogg_page_bos(&og) && og.body_len >= 8 && memcmp(og.body, "OpusHead", 8) == 0) {
+            /*A new link: OpusHead is alone on its page, which stays as it is.*/
+            serialno = (uint32_t) ogg_page_serialno(&og);
+            ogg_stream_reset_serialno(&is, (int) serialno);
+            ogg_stream_pagein(&is, &og);
+            state = 1;
+            nold = 0;
+            ret = op_page_write(_out, &og);
+            continue;
+        }
+        if(state == 0 || (uint32_t) ogg_page_serialno(&og) != serialno) {
+            ret = op_page_write(_out, &og);
+            continue;
+        }
+        if(state == 2) {
+            if(pageno_delta != 0) {
+                uint32_t pageno;
+                pageno = (uint32_t) (ogg_page_pageno(&og) + pageno_delta);
+                op_tags_put32(og.header + 18, pageno);
+                ogg_page_checksum_set(&og);
+            }
+            ret = op_page_write(_out, &og);
+            continue;
+        }
+        /*Tags pages are held back until the packet is complete: it ends a page,
+         and the audio starts on the next one.*/
+        ogg_stream_pagein(&is, &og);
+        nold++;
+        for(;;) {
+            ogg_packet op;
+            int packet_ret;
+            packet_ret = ogg_stream_packetout(&is, &op);
+            if(packet_ret <= 0) break;
+            if(op.packetno == 1) {
+                ogg_stream_state os;
+                ogg_packet tags;
+                unsigned char *data;
+                long len;
+                int nnew;
+                len = op_tags_with_gain(&data, op.packet, op.bytes, _track_gain_q8, _album_gain_q8);
+                if(len < 0) {
+                    ret = (int) len;
+                    break;
+                }
+                ogg_stream_init(&os, (int) serialno);
+                /*Carry on from the OpusHead page.*/
+                os.b_o_s = 1;
+                os.pageno = 1;
+                tags.packet = data;
+                tags.bytes = len;
+                tags.b_o_s = 0;
+                tags.e_o_s = 0;
+                tags.granulepos = 0;
+                tags.packetno = 1;
+                ogg_stream_packetin(&os, &tags);
+                free(data);
+                nnew = 0;
+                while(ret >= 0 && ogg_stream_flush(&os, &og)) {
+                    ret = op_page_write(_out, &og);
+                    nnew++;
+                }
+                ogg_stream_clear(&os);
+                pageno_delta = nnew - nold;
+                state = 2;
+                nlinks++;
+                break;
+            }
+        }
+    }
+    ogg_stream_clear(&is);
+    ogg_sync_clear(&oy);
+    return ret < 0 ? ret : nlinks;
+}
@@ -15,6 +15,13 @@
 #include "Arduino.h"
 #include "internal.h"
 #include "opusfile.h"
+#include <math.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if !defined(ESP_PLATFORM)
+#include <pthread.h>
+#endif
 
 #define OP_PAGE_SIZE_MAX  (65307)
 
@@ -62,6 +69,43 @@ static int64_t op_position(const OggOpusFile *_of) {
     return _of->offset + _of->oy.fill - _of->oy.returned;
 }
 //----------------------------------------------------------------------------------------------------------------------
+/*Stream callbacks for parsing a memory buffer in place (op_open_memory()). The stream is the ogg_sync_state the buffer
+  is attached to, and its fill mark is the stream position: op_get_data() gets a pointer to the bytes already in place
+  from ogg_sync_buffer(), so a read only has to say how many of them to expose. Nothing is copied.*/
+static int op_mem_inplace_read(void *_stream, unsigned char *_ptr, int _buf_size) {
+    ogg_sync_state *oy;
+    oy = (ogg_sync_state*) _stream;
+    OP_ASSERT(_ptr == oy->data + oy->fill);
+    (void) _ptr;
+    if(_buf_size <= 0) return 0;
+    return _min(oy->storage - oy->fill, _buf_size);
+}
+static int op_mem_inplace_seek(void *_stream, int64_t _offset, int _whence) {
+    ogg_sync_state *oy;
+    int64_t pos;
+    oy = (ogg_sync_state*) _stream;
+    switch(_whence) {
+        case SEEK_SET: pos = _offset; break;
+        case SEEK_CUR: pos = oy->fill + _offset; break;
+        case SEEK_END: pos = oy->storage + _offset; break;
+        default: return -1;
+    }
+    if(pos < 0 || pos > oy->storage) return -1;
+    /*Seeking anywhere but the current position drops what is buffered, as there is
+     no way to keep it in front of non-contiguous data.*/
+    if(pos != oy->fill) {
+        oy->fill = (int) pos;
+        ogg_sync_reset(oy);
+    }
+    return 0;
+}
+static int64_t op_mem_inplace_tell(void *_stream) {
+    return ((ogg_sync_state*) _stream)->fill;
+}
+static const OpusFileCallbacks_t OP_MEM_INPLACE_CALLBACKS = {
+    op_mem_inplace_read, op_mem_inplace_seek, op_mem_inplace_tell, NULL
+};
+//----------------------------------------------------------------------------------------------------------------------
 /*From the head of the stream, get the next page. _boundary specifies if the function is allowed to fetch more data
   from the stream (and how much) or only use internally buffered data.
   _boundary: -1: Unbounded search. 0: Read no additional data. Use only cached data.
@@ -340,10 +384,20 @@ static int64_t op_get_last_page(OggOpusFile *_of, int64_t *_gp, int64_t _offset,
     return _offset;
 }
 //----------------------------------------------------------------------------------------------------------------------
+/*Submits a page to _of->os.
+  When the sync state is attached to the caller's memory the pages never move,
+   so packets are read from them directly instead of being copied.*/
+static int op_stream_pagein(OggOpusFile *_of, ogg_page *_og) {
+    if(_of->oy.external) return ogg_stream_pagein_inplace(&_of->os, _og);
+    return ogg_stream_pagein(&_of->os, _og);
+}
+//----------------------------------------------------------------------------------------------------------------------
 /*Uses the local ogg_stream storage in _of.  This is important for non-streaming input sources.*/
 static int op_fetch_headers_impl(OggOpusFile *_of, OpusHead_t *_head, OpusTags_t *_tags, uint32_t **_serialnos,
                                  int *_nserialnos, int *_cserialnos, ogg_page *_og) {
+    OpusTagsStream_t ts;
     ogg_packet op;
+    long pageno;
     int ret;
     if(_serialnos != NULL) *_nserialnos = 0;
     /*Extract the serialnos of all BOS pages plus the first set of Opus headers
@@ -362,7 +416,7 @@ static int op_fetch_headers_impl(OggOpusFile *_of, OpusHead_t *_head, OpusTags_t
              stream setup.
              We need a stream to get packets.*/
             ogg_stream_reset_serialno(&_of->os, ogg_page_serialno(_og));
-            ogg_stream_pagein(&_of->os, _og);
+            op_stream_pagein(_of, _og);
             if(ogg_stream_packetout(&_of->os, &op) > 0) {
                 ret = opus_head_parse(_head, op.packet, op.bytes);
                 /*Found a valid Opus header.
@@ -383,52 +437,74 @@ static int op_fetch_headers_impl(OggOpusFile *_of, OpusHead_t *_head, OpusTags_t
         }
     }
     if(_of->ready_state!=OP_STREAMSET) return OP_ENOTFORMAT;
-    /*If the first non-header page belonged to our Opus stream, submit it.*/
-    if(_of->os.serialno == ogg_page_serialno(_og)) ogg_stream_pagein(&_of->os, _og);
-    /*Loop getting packets.*/
+    /*The comment header goes to the tags parser straight from the page bodies
+     rather than through ogg_stream_packetout(), so a large one (cover art) is
+     never assembled in the stream buffer and comments over the size limit are
+     never copied at all.
+     This works because Opus requires the ID header to end its page and the
+     comment header to end its last one; streams that break this are rejected.*/
+    if(ogg_stream_packetpeek(&_of->os, NULL) != 0) return OP_EBADHEADER;
+    op_tags_stream_init(&ts, _of->tags_max_len, 0);
+    pageno = _of->os.pageno;
     for(;;) {
-        switch(ogg_stream_packetout(&_of->os, &op)){
-            case 0: {
-                /*Loop getting pages.*/
-                for(;;) {
-                    /*No need to clamp the boundary offset against _of->end, as all
-                     errors become OP_EBADHEADER.*/
-                    if(op_get_next_page(_of,_og, OP_ADV_OFFSET(_of->offset,OP_CHUNK_SIZE))<0) {
-                        return OP_EBADHEADER;
-                    }
-                    /*If this page belongs to the correct stream, go parse it.*/
-                    if(_of->os.serialno == ogg_page_serialno(_og)) {
-                        ogg_stream_pagein(&_of->os, _og);
-                        break;
-                    }
-                    /*If the link ends before we see the Opus comment header, abort.*/
-                    if(ogg_page_bos(_og)) return OP_EBADHEADER;
-                    /*Otherwise, keep looking.*/
-                }
-            }
-                break;
-                /*We shouldn't get a hole in the headers!*/
-            case -1:
+        if(_of->os.serialno == ogg_page_serialno(_og)) {
+            const unsigned char *lacing;
+            long body_len;
+            int started;
+            int nsegs;
+            int si;
+            lacing = _og->header + 27;
+            nsegs = _og->header[26];
+            /*We shouldn't get a hole in the headers, and only the pages after
+             the first one continue the comment header.*/
+            started = ts.state != OP_TAGS_MAGIC || ts.field_fill > 0;
+            if(ogg_page_pageno(_og) != pageno || ogg_page_continued(_og) != started) {
+                op_tags_stream_clear(&ts);
                 return OP_EBADHEADER;
-            default: {
-                /*Got a packet.
-                 It should be the comment header.*/
-                ret = opus_tags_parse(_tags, op.packet, op.bytes);
-                if(ret < 0) return ret;
-                /*Make sure the page terminated at the end of the comment header.
+            }
+            pageno++;
+            body_len = 0;
+            for(si = 0; si < nsegs && lacing[si] == 255; si++)
+                body_len += 255;
+            if(si < nsegs) {
+                /*The packet ends here.
+                 Make sure the page terminated at the end of the comment header.
                  If there is another packet on the page, or part of a packet, then
                  reject the stream.
                  Otherwise seekable sources won't be able to seek back to the start
                  properly.*/
-                ret = ogg_stream_packetout(&_of->os, &op);
-                if((ret!=0) || (_og->header[_og->header_len - 1] == 255)) {
-                    /*If we fail, the caller assumes our tags are uninitialized.*/
-                    opus_tags_clear(_tags);
+                if(si != nsegs - 1) {
+                    op_tags_stream_clear(&ts);
                     return OP_EBADHEADER;
                 }
+                body_len += lacing[si];
+            }
+            ret = op_tags_stream_feed(&ts, _og->body, body_len);
+            if(ret < 0) {
+                op_tags_stream_clear(&ts);
+                return ret;
+            }
+            if(si < nsegs) {
+                ret = op_tags_stream_finish(&ts, _tags);
+                if(ret < 0) return ret;
+                /*Nothing of the headers is left in the stream state; just carry
+                 on the page sequence so a hole before the audio still shows.*/
+                ogg_stream_reset_serialno(&_of->os, _of->os.serialno);
+                _of->os.pageno = pageno;
                 return 0;
             }
         }
+        /*If the link ends before we see the Opus comment header, abort.*/
+        else if(ogg_page_bos(_og)) {
+            op_tags_stream_clear(&ts);
+            return OP_EBADHEADER;
+        }
+        /*No need to clamp the boundary offset against _of->end, as all
+         errors become OP_EBADHEADER.*/
+        if(op_get_next_page(_of,_og, OP_ADV_OFFSET(_of->offset,OP_CHUNK_SIZE))<0) {
+            op_tags_stream_clear(&ts);
+            return OP_EBADHEADER;
+        }
     }
     return 0;
 }
@@ -738,7 +814,7 @@ static int op_find_initial_pcm_offset(OggOpusFile *_of, OggOpusLink_t *_link, og
         /*Ignore pages from other streams (not strictly necessary, because of the
          checks in ogg_stream_pagein(), but saves some work).*/
         if(serialno != (uint32_t) ogg_page_serialno(_og)) continue;
-        ogg_stream_pagein(&_of->os, _og);
+        op_stream_pagein(_of, _og);
         /*Bitrate tracking: add the header's bytes here.
          The body bytes are counted when we consume the packets.*/
         _of->bytes_tracked += _og->header_len;
@@ -1177,7 +1253,8 @@ static void op_update_gain(OggOpusFile *_of) {
     head = &_of->links[li].head;
     /*We don't have to worry about overflow here because the header gain and
      track gain must lie in the range [-32768,32767], and the user-supplied
-     offset has been pre-clamped to [-98302,98303].*/
+     offset and volume have been pre-clamped to [-98302,98303] and
+     [-32768,0].*/
     switch(_of->gain_type){
         case OP_ALBUM_GAIN: {
             int album_gain_q8;
@@ -1203,14 +1280,77 @@ static void op_update_gain(OggOpusFile *_of) {
         default:
             OP_ASSERT(0);
     }
-    gain_q8 = OP_CLAMP(-32768, gain_q8, 32767);
+    /*Mute must silence even when a positive header or track gain would lift the
+     sum off the -128 dB floor; at the floor the decoder's Q16 gain rounds to 0.*/
+    if(_of->volume_q8 <= OP_VOLUME_MUTE) gain_q8 = -32768;
+    else gain_q8 = OP_CLAMP(-32768, gain_q8 + _of->volume_q8, 32767);
     OP_ASSERT(_of->od!=NULL);
     opus_multistream_decoder_ctl(_of->od, OPUS_SET_GAIN(gain_q8));
 
 }
 //----------------------------------------------------------------------------------------------------------------------
+/*Fill in the channel mapping the decoder for _head should produce and return
+ its channel count: the link's own layout, or the one chosen with
+ op_set_channel_layout(), with channels the link does not have muted.*/
+static int op_output_layout(const OggOpusFile *_of, const OpusHead_t *_head, unsigned char *_mapping) {
+    int ci;
+    if(_of->out_channel_count <= 0) {
+        memcpy(_mapping, _head->mapping, sizeof(*_head->mapping) * _head->channel_count);
+        return _head->channel_count;
+    }
+    for(ci = 0; ci < _of->out_channel_count; ci++) {
+        int src;
+        src = _of->out_channels[ci];
+        _mapping[ci] = src < _head->channel_count ? _head->mapping[src] : 255;
+    }
+    return _of->out_channel_count;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Returns nonzero if the decoder in _slot was set up for the streams in _head
+ and the output layout in _channel_count/_mapping.*/
+static int op_decoder_slot_matches(const OpusDecoderSlot_t *_slot, const OpusHead_t *_head, int _channel_count,
+        const unsigned char *_mapping) {
+    return _slot->od != NULL && _slot->stream_count == _head->stream_count
+            && _slot->coupled_count == _head->coupled_count && _slot->channel_count == _channel_count
+            && memcmp(_slot->mapping, _mapping, sizeof(*_mapping) * _channel_count) == 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Exchange the active decoder with a parked one (either may be empty).*/
+static void op_decoder_swap(OggOpusFile *_of, OpusDecoderSlot_t *_slot) {
+    OpusDecoderSlot_t active;
+    active.od = _of->od;
+    active.stream_count = _of->od_stream_count;
+    active.coupled_count = _of->od_coupled_count;
+    active.channel_count = _of->od_channel_count;
+    memcpy(active.mapping, _of->od_mapping, sizeof(active.mapping));
+    _of->od = _slot->od;
+    _of->od_stream_count = _slot->stream_count;
+    _of->od_coupled_count = _slot->coupled_count;
+    _of->od_channel_count = _slot->channel_count;
+    memcpy(_of->od_mapping, _slot->mapping, sizeof(_of->od_mapping));
+    *_slot = active;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Move the active decoder into the pool so a later link with the same layout can
+ pick it up again with just a reset.
+ The pool is kept in most-recently-parked order; if it is full, the oldest
+ entry is destroyed to make room.*/
+static void op_decoder_park(OggOpusFile *_of) {
+    OpusDecoderSlot_t *pool;
+    int si;
+    if(_of->od == NULL) return;
+    pool = _of->od_pool;
+    si = OP_DECODER_POOL_SIZE - 1;
+    if(pool[si].od != NULL) opus_multistream_decoder_destroy(pool[si].od);
+    for(; si > 0; si--)
+        pool[si] = pool[si - 1];
+    pool[0].od = NULL;
+    op_decoder_swap(_of, pool);
+}
+//----------------------------------------------------------------------------------------------------------------------
 static int op_make_decode_ready(OggOpusFile *_of) {
     const OpusHead_t *head;
+    unsigned char mapping[OP_MAPPING_MAX];
     int li;
     int stream_count;
     int coupled_count;
@@ -1221,28 +1361,44 @@ static int op_make_decode_ready(OggOpusFile *_of) {
     head = &_of->links[li].head;
     stream_count = head->stream_count;
     coupled_count = head->coupled_count;
-    channel_count = head->channel_count;
+    channel_count = op_output_layout(_of, head, mapping);
     /*Check to see if the current decoder is compatible with the current link.*/
     if(_of->od != NULL && _of->od_stream_count == stream_count && _of->od_coupled_count == coupled_count
             && _of->od_channel_count == channel_count
-            && memcmp(_of->od_mapping, head->mapping, sizeof(*head->mapping) * channel_count) == 0) {
+            && memcmp(_of->od_mapping, mapping, sizeof(*mapping) * channel_count) == 0) {
         opus_multistream_decoder_ctl(_of->od, OPUS_RESET_STATE);
     }
     else {
-        int err;
-        opus_multistream_decoder_destroy(_of->od);
-        _of->od = opus_multistream_decoder_create(48000, channel_count, stream_count, coupled_count, head->mapping,
-                &err);
-        if(_of->od == NULL) return OP_EFAULT;
-        _of->od_stream_count = stream_count;
-        _of->od_coupled_count = coupled_count;
-        _of->od_channel_count = channel_count;
-        memcpy(_of->od_mapping, head->mapping, sizeof(*head->mapping) * channel_count);
+        int si;
+        /*Otherwise, see if we parked one for this layout earlier.
+         Reusing it avoids both the allocation and the SILK/CELT table setup
+         done by opus_multistream_decoder_init().*/
+        for(si = 0; si < OP_DECODER_POOL_SIZE; si++) {
+            if(op_decoder_slot_matches(_of->od_pool + si, head, channel_count, mapping)) break;
+        }
+        if(si < OP_DECODER_POOL_SIZE) {
+            op_decoder_swap(_of, _of->od_pool + si);
+            opus_multistream_decoder_ctl(_of->od, OPUS_RESET_STATE);
+        }
+        else {
+            int err;
+            op_decoder_park(_of);
+            _of->od = opus_multistream_decoder_create(48000, channel_count, stream_count, coupled_count,
+                    mapping, &err);
+            if(_of->od == NULL) return OP_EFAULT;
+            _of->od_stream_count = stream_count;
+            _of->od_coupled_count = coupled_count;
+            _of->od_channel_count = channel_count;
+            memcpy(_of->od_mapping, mapping, sizeof(*mapping) * channel_count);
+        }
     }
     _of->ready_state = OP_INITSET;
     _of->bytes_tracked = 0;
     _of->samples_tracked = 0;
     op_update_gain(_of);
+    if(opus_multistream_decoder_ctl(_of->od, OPUS_SET_HYBRID_WORKER(_of->hybrid_worker)) != OPUS_OK) {
+        _of->hybrid_worker = 0;
+    }
     return 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
@@ -1317,7 +1473,10 @@ static int op_open_seekable2(OggOpusFile *_of) {
     start_offset = _of->offset;
     memcpy(op_start, _of->op, sizeof(*op_start) * start_op_count);
     OP_ASSERT((*_of->callbacks.tell)(_of->stream)==op_position(_of));
-    ogg_sync_init(&_of->oy);
+    if(oy_start.external)
+        ogg_sync_attach(&_of->oy, oy_start.data, oy_start.storage);
+    else
+        ogg_sync_init(&_of->oy);
     ogg_stream_init(&_of->os, -1);
     ret = op_open_seekable2_impl(_of);
     /*Restore the old stream state.*/
@@ -1359,8 +1518,12 @@ static void op_decode_clear(OggOpusFile *_of) {
 //----------------------------------------------------------------------------------------------------------------------
 static void op_clear(OggOpusFile *_of) {
     OggOpusLink_t *links;
+    int si;
     free(_of->od_buffer);
     if(_of->od != NULL) opus_multistream_decoder_destroy(_of->od);
+    for(si = 0; si < OP_DECODER_POOL_SIZE; si++) {
+        if(_of->od_pool[si].od != NULL) opus_multistream_decoder_destroy(_of->od_pool[si].od);
+    }
     links = _of->links;
     if(!_of->seekable) {
         if(_of->ready_state > OP_OPENED || _of->ready_state == OP_PARTOPEN) {
@@ -1382,20 +1545,28 @@ static void op_clear(OggOpusFile *_of) {
 }
 //----------------------------------------------------------------------------------------------------------------------
 static int op_open1(OggOpusFile *_of, void *_stream, const OpusFileCallbacks_t *_cb, const unsigned char *_initial_data,
-        size_t _initial_bytes) {
+        size_t _initial_bytes, int _tags_max_len) {
     ogg_page og;
     ogg_page *pog;
+    int in_place;
     int seekable;
     int ret;
     memset(_of, 0, sizeof(*_of));
     if(_initial_bytes>(size_t)LONG_MAX) return OP_EFAULT;
+    _of->tags_max_len = _tags_max_len;
     _of->end = -1;
     _of->stream = _stream;
     *&_of->callbacks = *_cb;
     /*At a minimum, we need to be able to read data.*/
     if(_of->callbacks.read==NULL) return OP_EREAD;
-    /*Initialize the framing state.*/
-    ogg_sync_init(&_of->oy);
+    /*Initialize the framing state.
+     For in-place memory parsing (op_test_memory()) _initial_data is the whole
+     buffer, and the framer works on it directly.*/
+    in_place = _cb->read == op_mem_inplace_read;
+    if(in_place)
+        ogg_sync_attach(&_of->oy, _initial_data, (long) _initial_bytes);
+    else
+        ogg_sync_init(&_of->oy);
     /*Perhaps some data was previously read into a buffer for testing against
      other stream types.
      Allow initialization from this previously read data (especially as we may
@@ -1403,7 +1574,7 @@ static int op_open1(OggOpusFile *_of, void *_stream, const OpusFileCallbacks_t *
      This requires copying it into a buffer allocated by ogg_sync_buffer() and
      doesn't support seeking, so this is not a good mechanism to use for
      decoding entire files from RAM.*/
-    if(_initial_bytes > 0) {
+    if(_initial_bytes > 0 && !in_place) {
         char *buffer;
         buffer = ogg_sync_buffer(&_of->oy, (long) _initial_bytes);
         memcpy(buffer, _initial_data, _initial_bytes * sizeof(*buffer));
@@ -1421,7 +1592,7 @@ static int op_open1(OggOpusFile *_of, void *_stream, const OpusFileCallbacks_t *
         pos = (*_of->callbacks.tell)(_of->stream);
         /*If the current position is not equal to the initial bytes consumed,
          absolute seeking will not work.*/
-        if(pos != (int64_t )_initial_bytes) return OP_EINVAL;
+        if(pos != (in_place ? 0 : (int64_t )_initial_bytes)) return OP_EINVAL;
     }
     _of->seekable = seekable;
     /*Don't seek yet.
@@ -1478,14 +1649,14 @@ static int op_open2(OggOpusFile *_of) {
     return ret;
 }
 //----------------------------------------------------------------------------------------------------------------------
-OggOpusFile* op_test_callbacks(void *_stream, const OpusFileCallbacks_t *_cb, const unsigned char *_initial_data,
-        size_t _initial_bytes, int *_error) {
+static OggOpusFile* op_test_callbacks_impl(void *_stream, const OpusFileCallbacks_t *_cb,
+        const unsigned char *_initial_data, size_t _initial_bytes, int _tags_max_len, int *_error) {
     OggOpusFile *of;
     int ret;
     of = (OggOpusFile*) malloc(sizeof(*of));
     ret = OP_EFAULT;
     if(of!=NULL) {
-        ret = op_open1(of, _stream, _cb, _initial_data, _initial_bytes);
+        ret = op_open1(of, _stream, _cb, _initial_data, _initial_bytes, _tags_max_len);
         if(ret >= 0) {
             if(_error != NULL) *_error = 0;
             return of;
@@ -1499,6 +1670,11 @@ OggOpusFile* op_test_callbacks(void *_stream, const OpusFileCallbacks_t *_cb, co
     return NULL;
 }
 //----------------------------------------------------------------------------------------------------------------------
+OggOpusFile* op_test_callbacks(void *_stream, const OpusFileCallbacks_t *_cb, const unsigned char *_initial_data,
+        size_t _initial_bytes, int *_error) {
+    return op_test_callbacks_impl(_stream, _cb, _initial_data, _initial_bytes, OP_TAGS_MAX_LEN, _error);
+}
+//----------------------------------------------------------------------------------------------------------------------
 OggOpusFile* op_open_callbacks(void *_stream, const OpusFileCallbacks_t *_cb, const unsigned char *_initial_data,
         size_t _initial_bytes, int *_error) {
     OggOpusFile *of;
@@ -1531,9 +1707,406 @@ OggOpusFile* op_test_file(const char *_path, int *_error) {
     return op_test_close_on_failure(op_fopen(&cb, _path, "rb"), &cb, _error);
 }
 //----------------------------------------------------------------------------------------------------------------------
+/*Memory is parsed in place: pages are checked and split into packets straight
+ from _data, which must stay valid (and unchanged) until op_free(). It may be
+ read-only, e.g. a memory-mapped file or a flash partition.*/
 OggOpusFile* op_test_memory(const unsigned char *_data, size_t _size, int *_error) {
+    OggOpusFile *of;
+    int ret;
+    if(_size > (size_t) INT_MAX) {
+        if(_error != NULL) *_error = OP_EFAULT;
+        return NULL;
+    }
+    of = (OggOpusFile*) malloc(sizeof(*of));
+    ret = OP_EFAULT;
+    if(of!=NULL) {
+        /*The stream is the framer itself, so it can only be set up in place.*/
+        ret = op_open1(of, &of->oy, &OP_MEM_INPLACE_CALLBACKS, _data, _size, OP_TAGS_MAX_LEN);
+        if(ret >= 0) {
+            if(_error != NULL) *_error = 0;
+            return of;
+        }
+        op_clear(of);
+        free(of);
+    }
+    if(_error != NULL) *_error = ret;
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+OggOpusFile* op_open_memory(const unsigned char *_data, size_t _size, int *_error) {
+    OggOpusFile *of;
+    of = op_test_memory(_data, _size, _error);
+    if(of!=NULL) {
+        int ret;
+        ret = op_open2(of);
+        if(ret >= 0) return of;
+        if(_error != NULL) *_error = ret;
+        free(of);
+    }
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*The stream wrapper op_scan_callbacks() reads through: it counts the bytes read
+ and, once the budget is armed, fails reads that would exceed it.*/
+typedef struct OpusScanStream{
+    void                *stream;
+    OpusFileCallbacks_t  cb;
+    /*Bytes that may still be read, or -1 for no limit.*/
+    int64_t              left;
+    int64_t              nread;
+} OpusScanStream_t;
+//----------------------------------------------------------------------------------------------------------------------
+static int op_scan_read(void *_stream, unsigned char *_ptr, int _nbytes) {
+    OpusScanStream_t *ss;
+    int ret;
+    ss = (OpusScanStream_t*) _stream;
+    if(ss->left >= 0) {
+        if(ss->left == 0) return OP_EREAD;
+        if(_nbytes > ss->left) _nbytes = (int) ss->left;
+    }
+    ret = (*ss->cb.read)(ss->stream, _ptr, _nbytes);
+    if(ret > 0) {
+        ss->nread += ret;
+        if(ss->left >= 0) ss->left -= ret;
+    }
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_scan_seek(void *_stream, int64_t _offset, int _whence) {
+    OpusScanStream_t *ss;
+    ss = (OpusScanStream_t*) _stream;
+    return (*ss->cb.seek)(ss->stream, _offset, _whence);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int64_t op_scan_tell(void *_stream) {
+    OpusScanStream_t *ss;
+    ss = (OpusScanStream_t*) _stream;
+    return (*ss->cb.tell)(ss->stream);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Finds the total duration of a partially open file from the last page alone.
+ This reads the last OP_SCAN_TAIL_SIZE bytes instead of op_open_seekable2()'s
+ OP_CHUNK_SIZE, and only falls back to the full link enumeration if the last
+ page belongs to another link.
+ The result is the same op_pcm_total() would give after op_open2().
+ Return: The duration in samples, or a negative value on failure.*/
+static int64_t op_scan_pcm_total(OggOpusFile *_of, int *_chained) {
+    OpusSeekRecord_t sr;
+    ogg_page og;
+    int64_t data_offset;
+    int64_t window;
+    int64_t end;
+    int64_t total;
+    int ret;
+    if(!_of->seekable) return OP_ENOSEEK;
+    if((*_of->callbacks.seek)(_of->stream, 0, SEEK_END)) return OP_EREAD;
+    _of->offset = _of->end = end = (*_of->callbacks.tell)(_of->stream);
+    if(end < 0) return OP_EREAD;
+    data_offset = _of->links[0].data_offset;
+    if(end < data_offset) return OP_EBADLINK;
+    sr.offset = -1;
+    /*Most files end with a page well under OP_SCAN_TAIL_SIZE.
+     If none starts in it, go straight to the OP_CHUNK_SIZE window
+     op_open_seekable2() would have used, which covers any page; only trailing
+     junk needs more.*/
+    for(window = OP_SCAN_TAIL_SIZE;; window = window < OP_CHUNK_SIZE ? OP_CHUNK_SIZE : window << 1) {
+        int64_t begin;
+        int64_t llret;
+        begin = _max(end - window, data_offset);
+        ret = op_seek_helper(_of, begin);
+        if(ret < 0) return ret;
+        while((llret = op_get_next_page(_of, &og, end)) >= 0) {
+            sr.offset = llret;
+            sr.size = (int32_t) (_of->offset - llret);
+            sr.serialno = ogg_page_serialno(&og);
+            sr.gp = ogg_page_granulepos(&og);
+        }
+        if(llret < OP_FALSE) return llret;
+        if(sr.offset >= 0) break;
+        if(begin <= data_offset) return OP_EBADLINK;
+    }
+    /*If there's any trailing junk, forget about it.*/
+    _of->end = sr.offset + sr.size;
+    if(!op_lookup_serialno(sr.serialno, _of->serialnos, _of->nserialnos)) {
+        /*The file is chained: enumerate the links the usual way.*/
+        *_chained = 1;
+        _of->ready_state = OP_OPENED;
+        ret = op_open_seekable2(_of);
+        if(ret < 0) return ret;
+        return op_pcm_total(_of, -1);
+    }
+    total = 0;
+    ret = op_find_final_pcm_offset(_of, _of->serialnos, _of->nserialnos, _of->links, sr.offset, sr.serialno, sr.gp,
+            &total);
+    return ret < 0 ? ret : total;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Reads what a library index needs from one file: the ID header, the tags
+ (comments longer than OP_SCAN_TAGS_MAX_LEN, such as cover art, are skipped
+ while parsing) and the total duration, without creating a decoder.
+ Past the headers no more than _budget bytes are read (-1 for no limit); if
+ the duration can't be found within it, pcm_total is OP_EREAD.
+ nlinks is 0 for a chained file whose links could not be counted.
+ The stream is left open; it must be seekable for the duration to be found.
+ Return: 0 on success (pcm_total may still hold an error code), or a negative
+ value if the headers could not be read, as for op_test_callbacks().*/
+int op_scan_callbacks(OpusScanInfo_t *_info, void *_stream, const OpusFileCallbacks_t *_cb, int64_t _budget) {
+    OpusScanStream_t ss;
+    OpusFileCallbacks_t cb;
+    OggOpusFile *of;
+    int chained;
+    int ret;
+    memset(_info, 0, sizeof(*_info));
+    opus_tags_init(&_info->tags);
+    ss.stream = _stream;
+    ss.cb = *_cb;
+    ss.left = -1;
+    ss.nread = 0;
+    cb.read = _cb->read != NULL ? op_scan_read : NULL;
+    cb.seek = _cb->seek != NULL ? op_scan_seek : NULL;
+    cb.tell = _cb->tell != NULL ? op_scan_tell : NULL;
+    cb.close = NULL;
+    of = op_test_callbacks_impl(&ss, &cb, NULL, 0, OP_SCAN_TAGS_MAX_LEN, &ret);
+    if(of == NULL) return ret;
+    _info->head = of->links[0].head;
+    ss.left = _budget;
+    chained = 0;
+    _info->pcm_total = op_scan_pcm_total(of, &chained);
+    _info->nlinks = chained && of->nlinks < 2 ? 0 : of->nlinks;
+    _info->size = _max(of->end, 0);
+    _info->bytes_read = ss.nread;
+    /*Take over the tags of the first link.*/
+    _info->tags = of->links[0].tags;
+    opus_tags_init(&of->links[0].tags);
+    op_free(of);
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_scan_file(OpusScanInfo_t *_info, const char *_path, int64_t _budget) {
     OpusFileCallbacks_t cb;
-    return op_test_close_on_failure(op_mem_stream_create(&cb, _data, _size), &cb, _error);
+    void *stream;
+    int ret;
+    stream = op_fopen(&cb, _path, "rb");
+    if(stream == NULL) return OP_EFAULT;
+    ret = op_scan_callbacks(_info, stream, &cb, _budget);
+    (*cb.close)(stream);
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void op_scan_info_clear(OpusScanInfo_t *_info) {
+    opus_tags_clear(&_info->tags);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Catalogue records are little-endian:
+   u16 length of the rest of the record
+   u8  flags (OP_CATALOG_*)
+   u8  channel count
+   u32 input sample rate
+   s16 output gain (Q7.8 dB)
+   u32 file size in bytes (FAT32 caps files below 4 GiB)
+   s64 total duration in 48 kHz samples (0 if unknown)
+   then the path, TITLE, ARTIST and ALBUM, each as a u8 length and that many
+   bytes (truncated to 255, no terminator).*/
+static unsigned char *op_catalog_put(unsigned char *_p, uint64_t _v, int _nbytes) {
+    int i;
+    for(i = 0; i < _nbytes; i++)
+        *_p++ = (unsigned char) (_v >> 8 * i);
+    return _p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static unsigned char *op_catalog_put_str(unsigned char *_p, const char *_str) {
+    size_t len;
+    len = _str != NULL ? strlen(_str) : 0;
+    if(len > 255) len = 255;
+    *_p++ = (unsigned char) len;
+    if(len > 0) memcpy(_p, _str, len);
+    return _p + len;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Serializes one record into _buf (OP_CATALOG_RECORD_MAX bytes).
+ Return: The record size.*/
+static int op_catalog_record(unsigned char *_buf, const char *_path, const OpusScanInfo_t *_info) {
+    unsigned char *p;
+    int flags;
+    flags = 0;
+    if(_info->nlinks != 1) flags |= OP_CATALOG_CHAINED;
+    if(_info->pcm_total < 0) flags |= OP_CATALOG_NO_TOTAL;
+    p = _buf + 2;
+    *p++ = (unsigned char) flags;
+    *p++ = (unsigned char) _info->head.channel_count;
+    p = op_catalog_put(p, _info->head.input_sample_rate, 4);
+    p = op_catalog_put(p, (uint16_t) _info->head.output_gain, 2);
+    p = op_catalog_put(p, _info->size > 0xFFFFFFFF ? 0xFFFFFFFF : (uint64_t) _info->size, 4);
+    p = op_catalog_put(p, _info->pcm_total < 0 ? 0 : (uint64_t) _info->pcm_total, 8);
+    p = op_catalog_put_str(p, _path);
+    p = op_catalog_put_str(p, opus_tags_query(&_info->tags, "TITLE", 0));
+    p = op_catalog_put_str(p, opus_tags_query(&_info->tags, "ARTIST", 0));
+    p = op_catalog_put_str(p, opus_tags_query(&_info->tags, "ALBUM", 0));
+    op_catalog_put(_buf, (uint64_t) (p - _buf - 2), 2);
+    return (int) (p - _buf);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_catalog_write_header(FILE *_fp) {
+    return fwrite(OP_CATALOG_MAGIC, 1, 8, _fp) == 8 ? 0 : OP_EFAULT;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_catalog_add(FILE *_fp, const char *_path, const OpusScanInfo_t *_info) {
+    unsigned char buf[OP_CATALOG_RECORD_MAX];
+    size_t len;
+    len = (size_t) op_catalog_record(buf, _path, _info);
+    return fwrite(buf, 1, len, _fp) == len ? 0 : OP_EFAULT;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_catalog_read_header(FILE *_fp) {
+    char magic[8];
+    if(fread(magic, 1, 8, _fp) != 8 || memcmp(magic, OP_CATALOG_MAGIC, 8) != 0) return OP_ENOTFORMAT;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint64_t op_catalog_get(const unsigned char *_p, int _nbytes) {
+    uint64_t v;
+    int i;
+    v = 0;
+    for(i = _nbytes; i-- > 0;)
+        v = v << 8 | _p[i];
+    return v;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static const unsigned char *op_catalog_get_str(const unsigned char *_p, const unsigned char *_end, char *_str) {
+    int len;
+    if(_p >= _end || *_p >= _end - _p) return NULL;
+    len = *_p++;
+    memcpy(_str, _p, len);
+    _str[len] = '\0';
+    return _p + len;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Return: 1 if a record was read, 0 at the end of the catalogue, or
+ OP_ENOTFORMAT if it is damaged.*/
+int op_catalog_read(FILE *_fp, OpusCatalogEntry_t *_entry) {
+    unsigned char buf[OP_CATALOG_RECORD_MAX];
+    const unsigned char *p;
+    const unsigned char *end;
+    size_t len;
+    size_t nread;
+    nread = fread(buf, 1, 2, _fp);
+    if(nread == 0) return 0;
+    len = (size_t) op_catalog_get(buf, 2);
+    if(nread != 2 || len < 20 + 4 || len > sizeof(buf) - 2 || fread(buf + 2, 1, len, _fp) != len) {
+        return OP_ENOTFORMAT;
+    }
+    p = buf + 2;
+    end = p + len;
+    _entry->flags = p[0];
+    _entry->channels = p[1];
+    _entry->input_sample_rate = (uint32_t) op_catalog_get(p + 2, 4);
+    _entry->output_gain = (int16_t) op_catalog_get(p + 6, 2);
+    _entry->size = (uint32_t) op_catalog_get(p + 8, 4);
+    _entry->pcm_total = (int64_t) op_catalog_get(p + 12, 8);
+    p += 20;
+    p = op_catalog_get_str(p, end, _entry->path);
+    if(p != NULL) p = op_catalog_get_str(p, end, _entry->title);
+    if(p != NULL) p = op_catalog_get_str(p, end, _entry->artist);
+    if(p != NULL) p = op_catalog_get_str(p, end, _entry->album);
+    return p == end ? 1 : OP_ENOTFORMAT;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Shared state of the op_scan_catalog() workers: each takes the next path, scans
+ it and keeps the serialized record in its slot, so the catalogue comes out in
+ the order of _paths whatever the number of threads.*/
+typedef struct OpusCatalogJob{
+    const char *const *paths;
+    int                npaths;
+    int64_t            budget;
+    unsigned char    **records;
+    int                next;
+#if !defined(ESP_PLATFORM)
+    pthread_mutex_t    lock;
+#endif
+} OpusCatalogJob_t;
+//----------------------------------------------------------------------------------------------------------------------
+static void *op_catalog_worker(void *_arg) {
+    OpusCatalogJob_t *job;
+    job = (OpusCatalogJob_t*) _arg;
+    for(;;) {
+        OpusScanInfo_t info;
+        unsigned char buf[OP_CATALOG_RECORD_MAX];
+        int i;
+#if !defined(ESP_PLATFORM)
+        pthread_mutex_lock(&job->lock);
+#endif
+        i = job->next < job->npaths ? job->next++ : -1;
+#if !defined(ESP_PLATFORM)
+        pthread_mutex_unlock(&job->lock);
+#endif
+        if(i < 0) break;
+        if(op_scan_file(&info, job->paths[i], job->budget) >= 0) {
+            int len;
+            len = op_catalog_record(buf, job->paths[i], &info);
+            job->records[i] = (unsigned char*) malloc(len);
+            if(job->records[i] != NULL) memcpy(job->records[i], buf, len);
+            op_scan_info_clear(&info);
+        }
+    }
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Scans _npaths files and writes a catalogue of the Opus files among them to _fp.
+ Hosts spread the files over _nthreads threads; the ESP32 scans them one after
+ another, as they all come off the same SD card anyway.
+ Return: The number of records written, or a negative value on failure.*/
+int op_scan_catalog(FILE *_fp, const char *const *_paths, int _npaths, int _nthreads, int64_t _budget) {
+    OpusCatalogJob_t job;
+    int nrecords;
+    int ret;
+    int i;
+    ret = op_catalog_write_header(_fp);
+    if(ret < 0) return ret;
+    job.paths = _paths;
+    job.npaths = _npaths;
+    job.budget = _budget;
+    job.next = 0;
+    job.records = (unsigned char**) calloc(_npaths > 0 ? _npaths : 1, sizeof(*job.records));
+    if(job.records == NULL) return OP_EFAULT;
+#if !defined(ESP_PLATFORM)
+    pthread_mutex_init(&job.lock, NULL);
+    if(_nthreads > 1) {
+        pthread_t *threads;
+        int nthreads;
+        threads = (pthread_t*) malloc(sizeof(*threads) * (_nthreads - 1));
+        nthreads = 0;
+        if(threads != NULL) {
+            while(nthreads < _nthreads - 1
+                    && pthread_create(threads + nthreads, NULL, op_catalog_worker, &job) == 0) {
+                nthreads++;
+            }
+        }
+        /*The calling thread works too, so a failed thread creation only costs
+         parallelism.*/
+        op_catalog_worker(&job);
+        for(i = 0; i < nthreads; i++)
+            pthread_join(threads[i], NULL);
+        free(threads);
+    }
+    else
+        op_catalog_worker(&job);
+    pthread_mutex_destroy(&job.lock);
+#else
+    (void) _nthreads;
+    op_catalog_worker(&job);
+#endif
+    nrecords = 0;
+    for(i = 0; i < _npaths; i++) {
+        if(job.records[i] != NULL) {
+            size_t len;
+            len = 2 + (size_t) op_catalog_get(job.records[i], 2);
+            if(ret >= 0 && fwrite(job.records[i], 1, len, _fp) != len) ret = OP_EFAULT;
+            nrecords++;
+            free(job.records[i]);
+        }
+    }
+    free(job.records);
+    return ret < 0 ? ret : nrecords;
 }
 //----------------------------------------------------------------------------------------------------------------------
 int op_test_open(OggOpusFile *_of) {
@@ -1819,7 +2392,7 @@ static int op_fetch_and_process_page(OggOpusFile *_of, ogg_page *_og, int64_t _p
             if(ret < 0) return ret;
         }
         /*Extract all the packets from the current page.*/
-        ogg_stream_pagein(&_of->os, &og);
+        op_stream_pagein(_of, &og);
         if(_of->ready_state>=OP_INITSET) {
             int32_t total_duration;
             int *durations = (int*) malloc(255 * sizeof(int));
@@ -2084,7 +2657,7 @@ static int op_page_continues(const ogg_page *_og) {
 /*A small helper to buffer the continued packet data from a page.*/
 static void op_buffer_continued_data(OggOpusFile *_of, ogg_page *_og) {
     ogg_packet op;
-    ogg_stream_pagein(&_of->os, _og);
+    op_stream_pagein(_of, _og);
     /*Drain any packets that did end on this page (and ignore holes).
      We only care about the continued packet data.*/
     while(ogg_stream_packetout(&_of->os, &op))
@@ -2315,7 +2888,7 @@ static int op_pcm_seek_page(OggOpusFile *_of, int64_t _target_gp, int _li) {
                 if(gp == -1) {
                     if(buffering) {
                         if(has_packets)
-                            ogg_stream_pagein(&_of->os, &og);
+                            op_stream_pagein(_of, &og);
                         else {
                             /*If packets did end on this page, but we still didn't have a
                              valid granule position (in violation of the spec!), stop
@@ -2582,16 +3155,60 @@ int op_set_gain_offset(OggOpusFile *_of, int _gain_type, int32_t _gain_offset_q8
     return 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
+int op_set_volume(OggOpusFile *_of, int32_t _volume_q8) {
+    /*Volume only ever attenuates; boosting is what the gain offset is for.*/
+    _of->volume_q8 = OP_CLAMP(OP_VOLUME_MUTE, _volume_q8, 0);
+    op_update_gain(_of);
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
 void op_set_dither_enabled(OggOpusFile *_of, int _enabled) {
 
     (void) _of;
     (void) _enabled;
 }
 //----------------------------------------------------------------------------------------------------------------------
+/*Decode the SILK and CELT halves of hybrid packets on separate threads (on
+ the ESP32, separate cores). The output does not change. Returns OP_EIMPL
+ if the platform has no thread to hand the SILK half to.*/
+int op_set_hybrid_worker(OggOpusFile *_of, int _enabled) {
+    _enabled = !!_enabled;
+    if(_of->od != NULL && opus_multistream_decoder_ctl(_of->od, OPUS_SET_HYBRID_WORKER(_enabled)) != OPUS_OK) {
+        return OP_EIMPL;
+    }
+    _of->hybrid_worker = _enabled;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Choose which of a link's channels the reads return, and in what order.
+ The decoder is rebuilt for the new layout straight away; samples already
+ decoded for the old one are dropped.*/
+int op_set_channel_layout(OggOpusFile *_of, const unsigned char *_channels, int _nchannels) {
+    if(_nchannels < 0 || _nchannels > OP_MAPPING_MAX || (_nchannels > 0 && _channels == NULL)) return OP_EINVAL;
+    if(_nchannels == _of->out_channel_count
+            && (_nchannels == 0 || memcmp(_of->out_channels, _channels, sizeof(*_channels) * _nchannels) == 0)) {
+        return 0;
+    }
+    if(_nchannels > 0) memcpy(_of->out_channels, _channels, sizeof(*_channels) * _nchannels);
+    _of->out_channel_count = _nchannels;
+    if(_of->ready_state >= OP_INITSET) {
+        _of->od_buffer_pos = _of->od_buffer_size = 0;
+        _of->ready_state = OP_STREAMSET;
+        return op_make_decode_ready(_of);
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
 /*Allocate the decoder scratch buffer.
  This is done lazily, since if the user provides large enough buffers, we'll
- never need it.*/
-static int op_init_buffer(OggOpusFile *_of) {
+ never need it.
+ It only gets room for 32-bit samples once op_read_s32() needs it (_s32), in
+ which case an existing buffer is grown with its contents kept.
+ It is grown again if the decoder later outputs more channels than it holds
+ (an unseekable stream or a wider op_set_channel_layout()).*/
+static int op_init_buffer(OggOpusFile *_of, int _s32) {
+    op_sample *buf;
+    size_t sample_sz;
     int nchannels_max;
     if(_of->seekable) {
         const OggOpusLink_t *links;
@@ -2606,26 +3223,84 @@ static int op_init_buffer(OggOpusFile *_of) {
     }
     else
         nchannels_max = OP_NCHANNELS_MAX;
-    _of->od_buffer = (op_sample*) malloc(sizeof(*_of->od_buffer) * nchannels_max * 120 * 48);
-    if(_of->od_buffer == NULL) return OP_EFAULT;
+    nchannels_max = _max(nchannels_max, _max(_of->out_channel_count, _of->od_channel_count));
+    sample_sz = _s32 ? _max(sizeof(int32_t), sizeof(op_sample)) : sizeof(op_sample);
+    buf = (op_sample*) realloc(_of->od_buffer, sample_sz * nchannels_max * 120 * 48);
+    if(buf == NULL) return OP_EFAULT;
+    _of->od_buffer = buf;
+    _of->od_buffer_wide = sample_sz >= sizeof(int32_t);
+    _of->od_buffer_channels = nchannels_max;
     return 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
+/*Conversions between op_sample and left-justified 32-bit samples.*/
+static inline int32_t op_sample2s32(op_sample _x) {
+#if defined(OPUS_FLOAT_BUILD)
+    return (int32_t) lrintf(OP_CLAMP(-2147483648.f, 2147483648.f * _x, 2147483520.f));
+#else
+    return (int32_t) ((uint32_t) _x << 16);
+#endif
+}
+static inline op_sample op_s322sample(int32_t _x) {
+#if defined(OPUS_FLOAT_BUILD)
+    return (1.0f / 2147483648.f) * _x;
+#else
+    return (op_sample) _min(((_x >> 15) + 1) >> 1, 32767);
+#endif
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Convert samples _lo to _hi-1 of _buf in place, between op_sample and int32_t
+ (_s32 is the target layout). The buffer must have room for the wider type.
+ Widening runs backwards so no source sample is overwritten before it is read;
+ the memcpy()s keep the type punning well-defined.*/
+static void op_convert_samples(void *_buf, int _lo, int _hi, int _s32) {
+    unsigned char *buf;
+    int i;
+    buf = (unsigned char*) _buf;
+    if(_s32) {
+        for(i = _hi; i-- > _lo;) {
+            op_sample x;
+            int32_t y;
+            memcpy(&x, buf + i * sizeof(x), sizeof(x));
+            y = op_sample2s32(x);
+            memcpy(buf + i * sizeof(y), &y, sizeof(y));
+        }
+    }
+    else {
+        for(i = _lo; i < _hi; i++) {
+            int32_t x;
+            op_sample y;
+            memcpy(&x, buf + i * sizeof(x), sizeof(x));
+            y = op_s322sample(x);
+            memcpy(buf + i * sizeof(y), &y, sizeof(y));
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
 /*Decode a single packet into the target buffer.*/
 static int op_decode(OggOpusFile *_of, op_sample *_pcm, const ogg_packet *_op, int _nsamples, int _nchannels) {
     int ret;
     /*First we try using the application-provided decode callback.*/
     if(_of->decode_cb != NULL) {
         log_i("_nsamples %i, _nchannels %i _of->cur_link %i",_nsamples, _nchannels, _of->cur_link);
+#if defined(OPUS_FLOAT_BUILD)
+        ret = (*_of->decode_cb)(_of->decode_cb_ctx, _of->od, _pcm, _op, _nsamples, _nchannels, OP_DEC_FORMAT_FLOAT,
+                _of->cur_link);
+#else
         ret = (*_of->decode_cb)(_of->decode_cb_ctx, _of->od, _pcm, _op, _nsamples, _nchannels, OP_DEC_FORMAT_SHORT,
                 _of->cur_link);
+#endif
 
     }
     else
         ret = OP_DEC_USE_DEFAULT;
     /*If the application didn't want to handle decoding, do it ourselves.*/
     if(ret == OP_DEC_USE_DEFAULT) {
+#if defined(OPUS_FLOAT_BUILD)
+        ret = opus_multistream_decode_float(_of->od, _op->packet, _op->bytes, _pcm, _nsamples, 0);
+#else
         ret = opus_multistream_decode(_of->od, _op->packet, _op->bytes, _pcm, _nsamples, 0);
+#endif
         OP_ASSERT(ret < 0 || ret == _nsamples);
     }
     /*If the application returned a positive value other than 0 or
@@ -2635,8 +3310,28 @@ static int op_decode(OggOpusFile *_of, op_sample *_pcm, const ogg_packet *_op, i
     return ret;
 }
 //----------------------------------------------------------------------------------------------------------------------
-/*Read more samples from the stream, using the same API as op_read() or op_read_float().*/
-static int op_read_native(OggOpusFile *_of, op_sample *_pcm, int _buf_size, int *_li) {
+/*Decode a single packet into the target buffer as left-justified 32-bit samples.*/
+static int op_decode_s32(OggOpusFile *_of, int32_t *_pcm, const ogg_packet *_op, int _nsamples, int _nchannels) {
+    int ret;
+    /*The application decode callback only knows the 16-bit and float formats,
+     so let it fill the buffer in those and widen afterwards.*/
+    if(_of->decode_cb != NULL) {
+        ret = op_decode(_of, (op_sample*) _pcm, _op, _nsamples, _nchannels);
+        if(ret >= 0) op_convert_samples(_pcm, 0, _nsamples * _nchannels, 1);
+        return ret;
+    }
+    ret = opus_multistream_decode_s32(_of->od, _op->packet, _op->bytes, _pcm, _nsamples, 0);
+    OP_ASSERT(ret < 0 || ret == _nsamples);
+    if(ret < 0) return OP_EBADPACKET;
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Read more samples from the stream, using the same API as op_read() or op_read_float().
+ With _s32 the samples (in _pcm and in the scratch buffer) are left-justified int32_t
+ instead of op_sample.*/
+static int op_read_native(OggOpusFile *_of, void *_pcm, int _buf_size, int *_li, int _s32) {
+    size_t sample_sz;
+    sample_sz = _s32 ? sizeof(int32_t) : sizeof(op_sample);
 
     if(_of->ready_state<OP_OPENED) return OP_EINVAL;
     for(;;) {
@@ -2646,11 +3341,21 @@ static int op_read_native(OggOpusFile *_of, op_sample *_pcm, int _buf_size, int
             int od_buffer_pos;
             int nsamples;
             int op_pos;
-            nchannels = _of->links[_of->seekable ? _of->cur_link : 0].head.channel_count;
+            nchannels = _of->od_channel_count;
             od_buffer_pos = _of->od_buffer_pos;
             nsamples = _of->od_buffer_size - od_buffer_pos;
             /*If we have buffered samples, return them.*/
             if(nsamples > 0) {
+                /*They may have been decoded for a read in the other format.*/
+                if(_of->od_buffer_s32 != _s32) {
+                    if(_s32 && !_of->od_buffer_wide) {
+                        ret = op_init_buffer(_of, 1);
+                        if(ret < 0) return ret;
+                    }
+                    op_convert_samples(_of->od_buffer, nchannels * od_buffer_pos, nchannels * _of->od_buffer_size,
+                            _s32);
+                    _of->od_buffer_s32 = _s32;
+                }
                 if(nsamples * nchannels > _buf_size) nsamples = _buf_size / nchannels;
                 OP_ASSERT(_pcm!=NULL||nsamples<=0);
                 /*Check nsamples again so we don't pass NULL to memcpy() if _buf_size
@@ -2658,7 +3363,8 @@ static int op_read_native(OggOpusFile *_of, op_sample *_pcm, int _buf_size, int
                  That would technically be undefined behavior, even if the number of
                  bytes to copy were zero.*/
                 if(nsamples > 0) {
-                    memcpy(_pcm, _of->od_buffer + nchannels * od_buffer_pos, sizeof(*_pcm) * nchannels * nsamples);
+                    memcpy(_pcm, (unsigned char*) _of->od_buffer + sample_sz * nchannels * od_buffer_pos,
+                            sample_sz * nchannels * nsamples);
                     od_buffer_pos += nsamples;
                     _of->od_buffer_pos = od_buffer_pos;
                 }
@@ -2675,6 +3381,11 @@ static int op_read_native(OggOpusFile *_of, op_sample *_pcm, int _buf_size, int
                 int trimmed_duration;
                 pop = _of->op + op_pos++;
                 _of->op_pos = op_pos;
+                /*An energy scan leaves the decoder without the state audio needs.*/
+                if(_of->od_energy) {
+                    opus_multistream_decoder_ctl(_of->od, OPUS_RESET_STATE);
+                    _of->od_energy = 0;
+                }
                 cur_discard_count = _of->cur_discard_count;
                 duration = op_get_packet_duration(pop->packet, pop->bytes);
                 /*We don't buffer packets with an invalid TOC sequence.*/
@@ -2694,13 +3405,17 @@ static int op_read_native(OggOpusFile *_of, op_sample *_pcm, int _buf_size, int
                     op_sample *buf;
                     /*If the user's buffer is too small, decode into a scratch buffer.*/
                     buf = _of->od_buffer;
-                    if(buf==NULL) {
-                        ret = op_init_buffer(_of);
+                    if(buf==NULL || (_s32 && !_of->od_buffer_wide) || nchannels > _of->od_buffer_channels) {
+                        ret = op_init_buffer(_of, _s32);
                         if(ret < 0) return ret;
                         buf = _of->od_buffer;
                     }
-                    ret = op_decode(_of, buf, pop, duration, nchannels);
+                    if(_s32)
+                        ret = op_decode_s32(_of, (int32_t*) buf, pop, duration, nchannels);
+                    else
+                        ret = op_decode(_of, buf, pop, duration, nchannels);
                     if(ret < 0) return ret;
+                    _of->od_buffer_s32 = _s32;
                     /*Perform pre-skip/pre-roll.*/
                     od_buffer_pos = (int) _min(trimmed_duration, cur_discard_count);
                     cur_discard_count -= od_buffer_pos;
@@ -2715,7 +3430,10 @@ static int op_read_native(OggOpusFile *_of, op_sample *_pcm, int _buf_size, int
                 else {
                     OP_ASSERT(_pcm!=NULL);
                     /*Otherwise decode directly into the user's buffer.*/
-                    ret = op_decode(_of, _pcm, pop, duration, nchannels);
+                    if(_s32)
+                        ret = op_decode_s32(_of, (int32_t*) _pcm, pop, duration, nchannels);
+                    else
+                        ret = op_decode(_of, (op_sample*) _pcm, pop, duration, nchannels);
                     if(ret < 0) return ret;
                     if(trimmed_duration > 0) {
                         /*Perform pre-skip/pre-roll.*/
@@ -2724,8 +3442,8 @@ static int op_read_native(OggOpusFile *_of, op_sample *_pcm, int _buf_size, int
                         _of->cur_discard_count = cur_discard_count;
                         trimmed_duration -= od_buffer_pos;
                         if((trimmed_duration>0) && (od_buffer_pos > 0)) {
-                            memmove(_pcm, _pcm + od_buffer_pos * nchannels,
-                                    sizeof(*_pcm) * trimmed_duration * nchannels);
+                            memmove(_pcm, (unsigned char*) _pcm + sample_sz * od_buffer_pos * nchannels,
+                                    sample_sz * trimmed_duration * nchannels);
                         }
                         /*Update bitrate tracking based on the actual samples we used from
                          what was decoded.*/
@@ -2753,6 +3471,78 @@ static int op_read_native(OggOpusFile *_of, op_sample *_pcm, int _buf_size, int
     return 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
+/*The packet loop of op_read_native(), with opus_multistream_decode_energy() in
+ place of the decoder. One packet per call, so the caller's buffer only needs
+ room for the longest one.*/
+int op_read_energy(OggOpusFile *_of, int16_t *_band_db, int _max_frames, int *_frame_size, int *_li) {
+    if(_of->ready_state<OP_OPENED) return OP_EINVAL;
+    if(_max_frames < OP_ENERGY_FRAMES_MAX) return OP_EINVAL;
+    for(;;) {
+        int ret;
+        if(_of->ready_state>=OP_INITSET) {
+            int op_pos;
+            /*Buffered audio belongs to packets that are already consumed.*/
+            _of->od_buffer_pos = _of->od_buffer_size;
+            op_pos = _of->op_pos;
+            if(op_pos < _of->op_count) {
+                const ogg_packet *pop;
+                int64_t diff;
+                int32_t cur_discard_count;
+                int duration;
+                int trimmed_duration;
+                int frame_size;
+                int skip;
+                int first;
+                int last;
+                pop = _of->op + op_pos++;
+                _of->op_pos = op_pos;
+                duration = op_get_packet_duration(pop->packet, pop->bytes);
+                OP_ASSERT(duration>0);
+                trimmed_duration = duration;
+                if(pop->e_o_s) {
+                    if(op_granpos_cmp(pop->granulepos, _of->prev_packet_gp) <= 0) {
+                        trimmed_duration = 0;
+                    }
+                    else if(!op_granpos_diff(&diff, pop->granulepos, _of->prev_packet_gp)) {
+                        trimmed_duration = (int) _min(diff, trimmed_duration);
+                    }
+                }
+                _of->prev_packet_gp = pop->granulepos;
+                ret = opus_multistream_decode_energy(_of->od, pop->packet, pop->bytes, _band_db, _max_frames);
+                if(ret <= 0) return OP_EBADPACKET;
+                _of->od_energy = 1;
+                frame_size = duration / ret;
+                cur_discard_count = _of->cur_discard_count;
+                skip = (int) _min(trimmed_duration, cur_discard_count);
+                _of->cur_discard_count = cur_discard_count - skip;
+                _of->bytes_tracked += pop->bytes;
+                _of->samples_tracked += trimmed_duration - skip;
+                /*Perform pre-skip and end-trimming to the nearest whole frame.*/
+                first = (skip + (frame_size >> 1)) / frame_size;
+                last = (trimmed_duration + (frame_size >> 1)) / frame_size;
+                if(last > first) {
+                    if(first > 0) {
+                        memmove(_band_db, _band_db + first * OP_ENERGY_BANDS,
+                                sizeof(*_band_db) * (last - first) * OP_ENERGY_BANDS);
+                    }
+                    if(_frame_size != NULL) *_frame_size = frame_size;
+                    if(_li != NULL) *_li = _of->cur_link;
+                    return last - first;
+                }
+                continue;
+            }
+        }
+        /*Suck in another page.*/
+        ret = op_fetch_and_process_page(_of, NULL, -1, 1, 0);
+        if(ret==OP_EOF) {
+            if(_li != NULL) *_li = _of->cur_link;
+            return 0;
+        }
+        if(ret < 0) return ret;
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
 /*A generic filter to apply to the decoded audio data.
  _src is non-const because we will destructively modify the contents of the
  source buffer that we consume in some cases.*/
@@ -2764,7 +3554,7 @@ typedef int (*op_read_filter_func)(OggOpusFile *_of, void *_dst, int _dst_sz, op
 static int op_filter_read_native(OggOpusFile *_of, void *_dst, int _dst_sz, op_read_filter_func _filter, int *_li) {
     int ret;
     /*Ensure we have some decoded samples in our buffer.*/
-    ret = op_read_native(_of, NULL, 0, _li);
+    ret = op_read_native(_of, NULL, 0, _li, 0);
     /*Now apply the filter to them.*/
     if((ret>=0) && (_of->ready_state>=OP_INITSET)) {
         int od_buffer_pos;
@@ -2772,7 +3562,7 @@ static int op_filter_read_native(OggOpusFile *_of, void *_dst, int _dst_sz, op_r
         ret = _of->od_buffer_size - od_buffer_pos;
         if(ret > 0) {
             int nchannels;
-            nchannels = _of->links[_of->seekable ? _of->cur_link : 0].head.channel_count;
+            nchannels = _of->od_channel_count;
             ret = (*_filter)(_of, _dst, _dst_sz, _of->od_buffer + nchannels * od_buffer_pos, ret, nchannels);
             OP_ASSERT(ret>=0); OP_ASSERT(ret<=_of->od_buffer_size-od_buffer_pos);
             od_buffer_pos += ret;
@@ -2782,22 +3572,66 @@ static int op_filter_read_native(OggOpusFile *_of, void *_dst, int _dst_sz, op_r
     return ret;
 }
 
-//int op_read(OggOpusFile *_of, int16_t *_pcm, int _buf_size, int *_li) {
-//    return op_read_native(_of, _pcm, _buf_size, _li);
-//}
 //----------------------------------------------------------------------------------------------------------------------
-static int op_stereo_filter(OggOpusFile *_of, void *_dst, int _dst_sz, op_sample *_src, int _nsamples, int _nchannels) {
+/*Conversions from the decoder's native sample type.*/
+static inline int16_t op_sample2short(op_sample _x) {
+#if defined(OPUS_FLOAT_BUILD)
+    return (int16_t) lrintf(OP_CLAMP(-32768.f, 32768.f * _x, 32767.f));
+#else
+    return _x;
+#endif
+}
+static inline float op_sample2float(op_sample _x) {
+#if defined(OPUS_FLOAT_BUILD)
+    return _x;
+#else
+    return (1.0f / 32768) * _x;
+#endif
+}
+//----------------------------------------------------------------------------------------------------------------------
+#if defined(OPUS_FLOAT_BUILD)
+static int op_short_filter(OggOpusFile *_of, void *_dst, int _dst_sz, op_sample *_src, int _nsamples, int _nchannels) {
+    int16_t *dst;
+    int i;
     (void) _of;
-    _nsamples = _min(_nsamples, _dst_sz >> 1);
-    if(_nchannels == 2)
-        memcpy(_dst, _src, _nsamples * 2 * sizeof(*_src));
-    else {
+    _nsamples = _min(_nsamples, _dst_sz / _nchannels);
+    dst = (int16_t*) _dst;
+    for(i = 0; i < _nsamples * _nchannels; i++)
+        dst[i] = op_sample2short(_src[i]);
+    return _nsamples;
+}
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+/*All of the link's channels (or the op_set_channel_layout() selection), interleaved.*/
+int op_read(OggOpusFile *_of, int16_t *_pcm, int _buf_size, int *_li) {
+#if defined(OPUS_FLOAT_BUILD)
+    return op_filter_read_native(_of, _pcm, _buf_size, op_short_filter, _li);
+#else
+    return op_read_native(_of, _pcm, _buf_size, _li, 0);
+#endif
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_stereo_filter(OggOpusFile *_of, void *_dst, int _dst_sz, op_sample *_src, int _nsamples, int _nchannels) {
+    (void) _of;
+    _nsamples = _min(_nsamples, _dst_sz >> 1);
+    if(_nchannels == 2) {
+#if defined(OPUS_FLOAT_BUILD)
+        int16_t *dst;
+        int i;
+        dst = (int16_t*) _dst;
+        for(i = 0; i < _nsamples * 2; i++)
+            dst[i] = op_sample2short(_src[i]);
+#else
+        memcpy(_dst, _src, _nsamples * 2 * sizeof(*_src));
+#endif
+    }
+    else {
         int16_t *dst;
         int i;
         dst = (int16_t*) _dst;
         if(_nchannels == 1) {
             for(i = 0; i < _nsamples; i++)
-                dst[2 * i + 0] = dst[2 * i + 1] = _src[i];
+                dst[2 * i + 0] = dst[2 * i + 1] = op_sample2short(_src[i]);
         }
         else {
 
@@ -2812,6 +3646,93 @@ int op_read_stereo(OggOpusFile *_of, int16_t *_pcm, int _buf_size) {
     return op_filter_read_native(_of, _pcm, _buf_size, op_stereo_filter, NULL);
 }
 //----------------------------------------------------------------------------------------------------------------------
+#if !defined(OPUS_FLOAT_BUILD)
+static int op_float_filter(OggOpusFile *_of, void *_dst, int _dst_sz, op_sample *_src, int _nsamples, int _nchannels) {
+    float *dst;
+    int i;
+    (void) _of;
+    _nsamples = _min(_nsamples, _dst_sz / _nchannels);
+    dst = (float*) _dst;
+    for(i = 0; i < _nsamples * _nchannels; i++)
+        dst[i] = op_sample2float(_src[i]);
+    return _nsamples;
+}
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+int op_read_float(OggOpusFile *_of, float *_pcm, int _buf_size, int *_li) {
+#if defined(OPUS_FLOAT_BUILD)
+    /*The decoder already produces float: decode straight into the caller's buffer.*/
+    return op_read_native(_of, _pcm, _buf_size, _li, 0);
+#else
+    return op_filter_read_native(_of, _pcm, _buf_size, op_float_filter, _li);
+#endif
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_float_stereo_filter(OggOpusFile *_of, void *_dst, int _dst_sz, op_sample *_src, int _nsamples,
+        int _nchannels) {
+    float *dst;
+    int i;
+    (void) _of;
+    _nsamples = _min(_nsamples, _dst_sz >> 1);
+    dst = (float*) _dst;
+    if(_nchannels == 2) {
+#if defined(OPUS_FLOAT_BUILD)
+        memcpy(_dst, _src, _nsamples * 2 * sizeof(*_src));
+#else
+        for(i = 0; i < _nsamples * 2; i++)
+            dst[i] = op_sample2float(_src[i]);
+#endif
+    }
+    else if(_nchannels == 1) {
+        for(i = 0; i < _nsamples; i++)
+            dst[2 * i + 0] = dst[2 * i + 1] = op_sample2float(_src[i]);
+    }
+    return _nsamples;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_read_float_stereo(OggOpusFile *_of, float *_pcm, int _buf_size) {
+    return op_filter_read_native(_of, _pcm, _buf_size, op_float_stereo_filter, NULL);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_read_s32(OggOpusFile *_of, int32_t *_pcm, int _buf_size, int *_li) {
+    return op_read_native(_of, _pcm, _buf_size, _li, 1);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*The filters work on op_sample, so the stereo 32-bit read does its own copy out
+ of the (32-bit) scratch buffer, the same way op_filter_read_native() does.*/
+int op_read_stereo_s32(OggOpusFile *_of, int32_t *_pcm, int _buf_size) {
+    int ret;
+    ret = op_read_native(_of, NULL, 0, NULL, 1);
+    if((ret>=0) && (_of->ready_state>=OP_INITSET)) {
+        int od_buffer_pos;
+        od_buffer_pos = _of->od_buffer_pos;
+        ret = _of->od_buffer_size - od_buffer_pos;
+        if(ret > 0) {
+            const int32_t *src;
+            int nchannels;
+            int i;
+            nchannels = _of->od_channel_count;
+            src = (const int32_t*) _of->od_buffer + nchannels * od_buffer_pos;
+            ret = _min(ret, _buf_size >> 1);
+            if(nchannels == 2)
+                memcpy(_pcm, src, ret * 2 * sizeof(*src));
+            else if(nchannels == 1) {
+                for(i = 0; i < ret; i++)
+                    _pcm[2 * i + 0] = _pcm[2 * i + 1] = src[i];
+            }
+            else {
+                /*No downmix (see op_stereo_filter()): pass the front pair through.*/
+                for(i = 0; i < ret; i++) {
+                    _pcm[2 * i + 0] = src[nchannels * i + 0];
+                    _pcm[2 * i + 1] = src[nchannels * i + 1];
+                }
+            }
+            _of->od_buffer_pos = od_buffer_pos + ret;
+        }
+    }
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
 unsigned op_parse_uint16le(const unsigned char *_data) {
     return _data[0] | _data[1] << 8;
 }
@@ -2906,6 +3827,11 @@ void opus_tags_init(OpusTags_t *_tags) {
 void opus_tags_clear(OpusTags_t *_tags) {
     int ncomments;
     int ci;
+    /*Packed tags (opus_tags_parse_views()) live in a single block.*/
+    if(_tags->storage != NULL) {
+        free(_tags->storage);
+        return;
+    }
     ncomments = _tags->comments;
     if(_tags->user_comments != NULL)
         ncomments++;
@@ -2926,6 +3852,17 @@ int op_tags_ensure_capacity(OpusTags_t *_tags, size_t _ncomments) {
     int cur_ncomments;
     size_t size;
     if(_ncomments >= (size_t) INT_MAX) return OP_EFAULT;
+    /*Packed tags can't grow in place: give each string its own allocation
+     first, like opus_tags_parse() would have.*/
+    if(_tags->storage != NULL) {
+        OpusTags_t tags;
+        int ret;
+        ret = opus_tags_copy(&tags, _tags);
+        if(ret < 0) return ret;
+        tags.skipped = _tags->skipped;
+        opus_tags_clear(_tags);
+        *_tags = tags;
+    }
     size = sizeof(*_tags->comment_lengths) * (_ncomments + 1);
     if(size / sizeof(*_tags->comment_lengths) != _ncomments + 1) return OP_EFAULT;
     cur_ncomments = _tags->comments;
@@ -3056,6 +3993,322 @@ int opus_tags_parse(OpusTags_t *_tags, const unsigned char *_data, size_t _len)
         return opus_tags_parse_impl(NULL, _data, _len);
 }
 //----------------------------------------------------------------------------------------------------------------------
+/*Packed tags keep every string (vendor, comments, binary suffix) back to back
+ at the start of one block, with the comment pointer and length arrays after
+ them. Turn a block holding _nbytes of strings into that layout.*/
+static int op_tags_pack(OpusTags_t *_tags, char *_block, size_t _nbytes, int _ncomments) {
+    size_t offs;
+    size_t arrays;
+    char *block;
+    offs = (_nbytes + sizeof(char*) - 1) & ~(sizeof(char*) - 1);
+    arrays = (sizeof(*_tags->user_comments) + sizeof(*_tags->comment_lengths)) * (_ncomments + 1);
+    if(offs < _nbytes || arrays > SIZE_MAX - offs) return OP_EFAULT;
+    block = (char*) realloc(_block, offs + arrays);
+    if(block == NULL) return OP_EFAULT;
+    _tags->storage = block;
+    _tags->user_comments = (char**) (block + offs);
+    _tags->comment_lengths = (int*) (block + offs + sizeof(*_tags->user_comments) * (_ncomments + 1));
+    _tags->user_comments[_ncomments] = NULL;
+    _tags->comment_lengths[_ncomments] = 0;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Streaming OpusTags parser.
+ Bytes can arrive in any pieces (page bodies, straight from op_fetch_headers()),
+ so a comment header never has to be assembled in one buffer, and comments
+ over the size limit are stepped over without being stored anywhere.*/
+void op_tags_stream_init(OpusTagsStream_t *_ts, int _max_len, size_t _size_hint) {
+    memset(_ts, 0, sizeof(*_ts));
+    _ts->max_len = _max_len > 0 ? _max_len : INT_MAX;
+    /*With no limit the strings can't be longer than the packet; with one, grow
+     as needed instead of reserving room for cover art we will skip.*/
+    _ts->hint = _max_len > 0 ? _min(_size_hint, (size_t) 4096) : _size_hint;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void op_tags_stream_clear(OpusTagsStream_t *_ts) {
+    free(_ts->buf);
+    free(_ts->lengths);
+    _ts->buf = NULL;
+    _ts->lengths = NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Append _len bytes to the string area.*/
+static int op_tags_stream_append(OpusTagsStream_t *_ts, const unsigned char *_data, size_t _len) {
+    if(_len > _ts->buf_size - _ts->buf_fill) {
+        size_t size;
+        char *buf;
+        size = _max(_max(_ts->buf_size * 2, _ts->hint), _ts->buf_fill + _len);
+        if(size < _ts->buf_fill) return OP_EFAULT;
+        buf = (char*) realloc(_ts->buf, size);
+        if(buf == NULL) return OP_EFAULT;
+        _ts->buf = buf;
+        _ts->buf_size = size;
+    }
+    if(_len > 0) memcpy(_ts->buf + _ts->buf_fill, _data, _len);
+    _ts->buf_fill += _len;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*A string (vendor or comment) of _ts->left bytes is about to start.*/
+static int op_tags_stream_begin_string(OpusTagsStream_t *_ts, uint32_t _len) {
+    static const unsigned char nul = 0;
+    /*No valid packet holds a string this long (the API limits it to an int).*/
+    if(_len > (uint32_t) INT_MAX) return OP_EBADHEADER;
+    _ts->left = _len;
+    if(_ts->state == OP_TAGS_VENDOR) _ts->vendor_len = _len;
+    _ts->keep = _ts->state == OP_TAGS_VENDOR || _len <= (uint32_t) _ts->max_len;
+    if(_ts->state == OP_TAGS_COMMENT) {
+        if(!_ts->keep)
+            _ts->skipped++;
+        else {
+            if(_ts->nkept >= _ts->lengths_size) {
+                int *lengths;
+                int size;
+                size = _max(2 * _ts->lengths_size, 16);
+                lengths = (int*) realloc(_ts->lengths, sizeof(*lengths) * size);
+                if(lengths == NULL) return OP_EFAULT;
+                _ts->lengths = lengths;
+                _ts->lengths_size = size;
+            }
+            _ts->lengths[_ts->nkept++] = (int) _len;
+        }
+    }
+    /*Strings are stored NUL-terminated; reserve the terminator up front so an
+     empty string is complete right away.*/
+    if(_ts->keep && _len == 0) return op_tags_stream_append(_ts, &nul, 1);
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int op_tags_stream_feed(OpusTagsStream_t *_ts, const unsigned char *_data, size_t _len) {
+    static const unsigned char nul = 0;
+    while(_len > 0) {
+        size_t take;
+        int ret;
+        switch(_ts->state) {
+            case OP_TAGS_MAGIC:
+            case OP_TAGS_VENDOR_LEN:
+            case OP_TAGS_COUNT:
+            case OP_TAGS_COMMENT_LEN: {
+                uint32_t val;
+                int need;
+                need = _ts->state == OP_TAGS_MAGIC ? 8 : 4;
+                take = _min(_len, (size_t) (need - _ts->field_fill));
+                memcpy(_ts->field + _ts->field_fill, _data, take);
+                _ts->field_fill += (int) take;
+                _data += take;
+                _len -= take;
+                if(_ts->field_fill < need) break;
+                _ts->field_fill = 0;
+                if(_ts->state == OP_TAGS_MAGIC) {
+                    if(memcmp(_ts->field, "OpusTags", 8) != 0) return OP_ENOTFORMAT;
+                    _ts->state = OP_TAGS_VENDOR_LEN;
+                    break;
+                }
+                val = op_parse_uint32le(_ts->field);
+                if(_ts->state == OP_TAGS_COUNT) {
+                    /*No valid packet has this many comments (the API limits the
+                     count to an int).*/
+                    if(val > (uint32_t) INT_MAX - 1) return OP_EBADHEADER;
+                    _ts->ncomments = (int) val;
+                    _ts->state = val > 0 ? OP_TAGS_COMMENT_LEN : OP_TAGS_SUFFIX;
+                    break;
+                }
+                _ts->state = _ts->state == OP_TAGS_VENDOR_LEN ? OP_TAGS_VENDOR : OP_TAGS_COMMENT;
+                ret = op_tags_stream_begin_string(_ts, val);
+                if(ret < 0) return ret;
+                if(val == 0) {
+                    if(_ts->state == OP_TAGS_VENDOR)
+                        _ts->state = OP_TAGS_COUNT;
+                    else
+                        _ts->state = ++_ts->ci < _ts->ncomments ? OP_TAGS_COMMENT_LEN : OP_TAGS_SUFFIX;
+                }
+            }
+                break;
+            case OP_TAGS_VENDOR:
+            case OP_TAGS_COMMENT: {
+                take = _min(_len, (size_t) _ts->left);
+                if(_ts->keep) {
+                    ret = op_tags_stream_append(_ts, _data, take);
+                    if(ret < 0) return ret;
+                }
+                _data += take;
+                _len -= take;
+                _ts->left -= (uint32_t) take;
+                if(_ts->left > 0) break;
+                if(_ts->keep) {
+                    ret = op_tags_stream_append(_ts, &nul, 1);
+                    if(ret < 0) return ret;
+                }
+                if(_ts->state == OP_TAGS_VENDOR)
+                    _ts->state = OP_TAGS_COUNT;
+                else
+                    _ts->state = ++_ts->ci < _ts->ncomments ? OP_TAGS_COMMENT_LEN : OP_TAGS_SUFFIX;
+            }
+                break;
+            default: {
+                /*Binary suffix: only kept if it is flagged as such (the low bit of
+                 its first byte) and within the limit.*/
+                OP_ASSERT(_ts->state == OP_TAGS_SUFFIX);
+                if(_ts->suffix_len == 0) _ts->keep = _data[0] & 1;
+                if(_len > (size_t) INT_MAX - _ts->suffix_len) return OP_EFAULT;
+                if(_ts->keep && _ts->suffix_len + _len > (size_t) _ts->max_len) {
+                    /*Too long after all: drop what we have of it.*/
+                    _ts->buf_fill -= _ts->suffix_len;
+                    _ts->keep = 0;
+                    _ts->skipped++;
+                }
+                if(_ts->keep) {
+                    ret = op_tags_stream_append(_ts, _data, _len);
+                    if(ret < 0) return ret;
+                }
+                _ts->suffix_len += _len;
+                _len = 0;
+            }
+        }
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*The packet is complete: check it ended where it should have and hand the
+ packed result to _tags. The stream is cleared either way.*/
+int op_tags_stream_finish(OpusTagsStream_t *_ts, OpusTags_t *_tags) {
+    OpusTags_t tags;
+    char *p;
+    int ret;
+    int ci;
+    if(_ts->state != OP_TAGS_SUFFIX) {
+        ret = _ts->state == OP_TAGS_MAGIC ? OP_ENOTFORMAT : OP_EBADHEADER;
+        op_tags_stream_clear(_ts);
+        return ret;
+    }
+    opus_tags_init(&tags);
+    ret = op_tags_pack(&tags, _ts->buf, _ts->buf_fill, _ts->nkept);
+    if(ret < 0) {
+        op_tags_stream_clear(_ts);
+        return ret;
+    }
+    _ts->buf = NULL;
+    p = tags.storage;
+    tags.vendor = p;
+    /*The vendor string may hold NULs of its own.*/
+    p += _ts->vendor_len + 1;
+    for(ci = 0; ci < _ts->nkept; ci++) {
+        tags.user_comments[ci] = p;
+        tags.comment_lengths[ci] = _ts->lengths[ci];
+        p += _ts->lengths[ci] + 1;
+    }
+    tags.comments = _ts->nkept;
+    if(_ts->keep && _ts->suffix_len > 0) {
+        tags.user_comments[ci] = p;
+        tags.comment_lengths[ci] = (int) _ts->suffix_len;
+    }
+    tags.skipped = _ts->skipped;
+    op_tags_stream_clear(_ts);
+    *_tags = tags;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Parse an OpusTags packet into packed tags: one allocation holds every
+ NUL-terminated comment, so user_comments[]/comment_lengths[] are
+ (pointer, length) views into it. Comments (and a binary suffix) longer than
+ _max_len bytes are left out and counted in skipped; _max_len <= 0 keeps
+ everything.
+ Any of the opus_tags_add*() calls first unpacks the tags.*/
+int opus_tags_parse_views(OpusTags_t *_tags, const unsigned char *_data, size_t _len, int _max_len) {
+    OpusTagsStream_t ts;
+    int ret;
+    if(_tags == NULL) return opus_tags_parse_impl(NULL, _data, _len);
+    op_tags_stream_init(&ts, _max_len, _len);
+    ret = op_tags_stream_feed(&ts, _data, _len);
+    if(ret < 0) {
+        op_tags_stream_clear(&ts);
+        return ret;
+    }
+    return op_tags_stream_finish(&ts, _tags);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Drop the comments (and binary suffix) of _tags longer than _max_len bytes,
+ repacking what is left so the dropped data is freed.*/
+static int op_tags_trim(OpusTags_t *_tags, int _max_len) {
+    OpusTags_t tags;
+    size_t vendor_len;
+    size_t nbytes;
+    char *block;
+    char *dst;
+    int ncomments;
+    int nkept;
+    int suffix_len;
+    int ret;
+    int ci;
+    ncomments = _tags->comments;
+    suffix_len = _tags->comment_lengths == NULL ? 0 : _tags->comment_lengths[ncomments];
+    nkept = 0;
+    nbytes = 0;
+    for(ci = 0; ci < ncomments; ci++) {
+        if(_tags->comment_lengths[ci] <= _max_len) {
+            nbytes += _tags->comment_lengths[ci] + 1;
+            nkept++;
+        }
+    }
+    if(nkept == ncomments && suffix_len <= _max_len) return 0;
+    if(suffix_len > _max_len) suffix_len = 0;
+    vendor_len = _tags->vendor == NULL ? 0 : strlen(_tags->vendor);
+    nbytes += vendor_len + 1 + suffix_len;
+    block = (char*) malloc(nbytes);
+    if(block == NULL) return OP_EFAULT;
+    opus_tags_init(&tags);
+    ret = op_tags_pack(&tags, block, nbytes, nkept);
+    if(ret < 0) {
+        free(block);
+        return ret;
+    }
+    dst = tags.storage;
+    tags.skipped = _tags->skipped;
+    tags.vendor = dst;
+    if(vendor_len > 0) memcpy(dst, _tags->vendor, vendor_len);
+    dst[vendor_len] = '\0';
+    dst += vendor_len + 1;
+    for(ci = 0; ci < ncomments; ci++) {
+        int len;
+        len = _tags->comment_lengths[ci];
+        if(len <= _max_len) {
+            tags.user_comments[tags.comments] = dst;
+            tags.comment_lengths[tags.comments] = len;
+            tags.comments++;
+            memcpy(dst, _tags->user_comments[ci], len);
+            dst[len] = '\0';
+            dst += len + 1;
+        }
+        else
+            tags.skipped++;
+    }
+    if(suffix_len > 0) {
+        tags.user_comments[nkept] = dst;
+        tags.comment_lengths[nkept] = suffix_len;
+        memcpy(dst, _tags->user_comments[ncomments], suffix_len);
+    }
+    else if(_tags->comment_lengths[ncomments] > 0)
+        tags.skipped++;
+    opus_tags_clear(_tags);
+    *_tags = tags;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Links whose headers were already read are trimmed now; later ones (and
+ unseekable link changes) never copy the long comments at all.*/
+int op_set_tags_limit(OggOpusFile *_of, int _max_len) {
+    int li;
+    if(_max_len < 0) return OP_EINVAL;
+    _of->tags_max_len = _max_len;
+    if(_max_len == 0) return 0;
+    for(li = 0; li < _of->nlinks; li++) {
+        int ret;
+        ret = op_tags_trim(&_of->links[li].tags, _max_len);
+        if(ret < 0) return ret;
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
 /*The actual implementation of opus_tags_copy().
  Unlike the public API, this function requires _dst to already be
  initialized, modifies its contents before success is guaranteed, and assumes
@@ -3386,209 +4639,606 @@ void op_extract_gif_params(const unsigned char *_buf, size_t _buf_sz, uint32_t *
     }
 }
 //----------------------------------------------------------------------------------------------------------------------
-/*The actual implementation of opus_picture_tag_parse().
- Unlike the public API, this function requires _pic to already be
- initialized, modifies its contents before success is guaranteed, and assumes
- the caller will clear it on error.*/
-int opus_picture_tag_parse_impl(OpusPictureTag_t *_pic, const char *_tag, unsigned char *_buf, size_t _buf_sz,
-        size_t _base64_sz) {
-    int32_t picture_type;
+/*BASE64 decoding table: the 6-bit value of each character of the alphabet, and
+ 0x80 for everything else (including the '=' pad, which is only accepted in
+ the final group and is handled there).*/
+static const unsigned char OP_BASE64_DEC[256] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3E, 0x80, 0x80, 0x80, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+};
+//----------------------------------------------------------------------------------------------------------------------
+/*Decodes _ngroups complete 4-character BASE64 groups into 3*_ngroups bytes.
+ Each group is assembled into one 24-bit word and invalid characters are caught
+ by OR-ing the table entries together, so there is a single check per call
+ instead of a chain of range compares per character.
+ With SSSE3 (host builds with -mssse3 or -march=native) 16 characters are
+ translated and packed per step using W. Mula's pshufb range check; the
+ scalar loop finishes the tail and re-checks any block that failed.
+ Return: 0 on success, or OP_ENOTFORMAT on a character outside the alphabet.*/
+static int op_base64_decode(unsigned char *_dst, const char *_src, size_t _ngroups) {
+    const unsigned char *src;
+    unsigned bad;
+    src = (const unsigned char*) _src;
+    bad = 0;
+#if defined(__SSSE3__)
+    {
+        const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13,
+                0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10,
+                0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i mask_2f = _mm_set1_epi8(0x2F);
+        const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        /*Every store writes 16 bytes for 12 decoded ones, so stop while the
+         destination still has room for the overhang.*/
+        while(_ngroups >= 6) {
+            __m128i str;
+            __m128i hi_nibbles;
+            __m128i lo_nibbles;
+            __m128i hi;
+            __m128i lo;
+            __m128i roll;
+            str = _mm_loadu_si128((const __m128i*) src);
+            hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+            lo_nibbles = _mm_and_si128(str, mask_2f);
+            hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+            lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+            if(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0) break;
+            roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(str, mask_2f), hi_nibbles));
+            str = _mm_add_epi8(str, roll);
+            /*Merge the 6-bit values: 4x6 -> 2x12 -> 1x24 bits per group.*/
+            str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+            str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+            _mm_storeu_si128((__m128i*) _dst, _mm_shuffle_epi8(str, pack));
+            src += 16;
+            _dst += 12;
+            _ngroups -= 4;
+        }
+    }
+#endif
+    for(; _ngroups > 0; _ngroups--) {
+        unsigned a;
+        unsigned b;
+        unsigned c;
+        unsigned d;
+        uint32_t value;
+        a = OP_BASE64_DEC[src[0]];
+        b = OP_BASE64_DEC[src[1]];
+        c = OP_BASE64_DEC[src[2]];
+        d = OP_BASE64_DEC[src[3]];
+        bad |= a | b | c | d;
+        value = (uint32_t) a << 18 | (uint32_t) b << 12 | c << 6 | d;
+        _dst[0] = (unsigned char) (value >> 16);
+        _dst[1] = (unsigned char) (value >> 8);
+        _dst[2] = (unsigned char) value;
+        src += 4;
+        _dst += 3;
+    }
+    return bad & 0x80 ? OP_ENOTFORMAT : 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*The BASE64 payload of a METADATA_BLOCK_PICTURE tag.
+ Any byte range of the decoded block can be produced without decoding what
+ precedes it, since byte n always comes from group n/3.*/
+typedef struct OpusPictureSrc{
+    const char *base64;
+    /*The number of 4-character groups.*/
+    size_t      base64_sz;
+    /*The decoded size, excluding padding.*/
+    size_t      buf_sz;
+} OpusPictureSrc_t;
+//----------------------------------------------------------------------------------------------------------------------
+static int op_picture_src_init(OpusPictureSrc_t *_src, const char *_tag) {
+    size_t tag_length;
+    size_t buf_sz;
+    if(opus_tagncompare("METADATA_BLOCK_PICTURE", 22, _tag) == 0) _tag += 23;
+    /*Figure out how much BASE64-encoded data we have.*/
+    tag_length = strlen(_tag);
+    if(tag_length & 3) return OP_ENOTFORMAT;
+    buf_sz = 3 * (tag_length >> 2);
+    if(buf_sz < 32) return OP_ENOTFORMAT;
+    if(_tag[tag_length - 1] == '=') buf_sz--;
+    if(_tag[tag_length - 2] == '=') buf_sz--;
+    if(buf_sz < 32) return OP_ENOTFORMAT;
+    _src->base64 = _tag;
+    _src->base64_sz = tag_length >> 2;
+    _src->buf_sz = buf_sz;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Decodes group _gi into _out, substituting zeros for the '=' padding if it is
+ the final group.*/
+static int op_picture_src_group(const OpusPictureSrc_t *_src, size_t _gi, unsigned char _out[3]) {
+    const char *group;
+    group = _src->base64 + 4 * _gi;
+    if(_gi + 1 == _src->base64_sz && 3 * _src->base64_sz > _src->buf_sz) {
+        char tmp[4];
+        int j;
+        memcpy(tmp, group, sizeof(tmp));
+        for(j = 4 - (int) (3 * _src->base64_sz - _src->buf_sz); j < 4; j++)
+            tmp[j] = 'A';
+        return op_base64_decode(_out, tmp, 1);
+    }
+    return op_base64_decode(_out, group, 1);
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Decodes bytes [_offs,_offs+_len) of the picture block into _dst.*/
+static int op_picture_src_read(const OpusPictureSrc_t *_src, size_t _offs, unsigned char *_dst, size_t _len) {
+    unsigned char tmp[3];
+    size_t gi;
+    size_t skip;
+    size_t n;
+    int ret;
+    OP_ASSERT(_offs<=_src->buf_sz&&_len<=_src->buf_sz-_offs);
+    gi = _offs / 3;
+    skip = _offs % 3;
+    if(skip > 0 && _len > 0) {
+        n = 3 - skip < _len ? 3 - skip : _len;
+        ret = op_picture_src_group(_src, gi++, tmp);
+        if(ret < 0) return ret;
+        memcpy(_dst, tmp + skip, n);
+        _dst += n;
+        _len -= n;
+    }
+    /*Whole groups never include the padded final group: it holds fewer than
+     three bytes, and we never read past the end of the block.*/
+    n = _len / 3;
+    ret = op_base64_decode(_dst, _src->base64 + 4 * gi, n);
+    if(ret < 0) return ret;
+    _dst += 3 * n;
+    _len -= 3 * n;
+    gi += n;
+    if(_len > 0) {
+        ret = op_picture_src_group(_src, gi, tmp);
+        if(ret < 0) return ret;
+        memcpy(_dst, tmp, _len);
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Parses the fields that precede the picture data, decoding only the bytes they
+ occupy.
+ Fills in everything except the data and format (the declared width, height,
+ depth and colors may still be overridden by the image itself), and stores the
+ offset of the picture data in *_data_offs and the declared length of the MIME
+ type in *_mime_type_length.
+ Like opus_picture_tag_parse_impl(), this assumes the caller clears _pic on
+ error.*/
+static int op_picture_parse_fields(OpusPictureTag_t *_pic, const OpusPictureSrc_t *_src, size_t *_data_offs,
+        uint32_t *_mime_type_length) {
+    unsigned char field[20];
     uint32_t mime_type_length;
     char *mime_type;
     uint32_t description_length;
     char *description;
-    uint32_t width;
-    uint32_t height;
-    uint32_t depth;
-    uint32_t colors;
-    uint32_t data_length;
-    uint32_t file_width;
-    uint32_t file_height;
-    uint32_t file_depth;
-    uint32_t file_colors;
-    int format;
-    int has_palette;
-    int colors_set;
+    size_t buf_sz;
     size_t i;
-    /*Decode the BASE64 data.*/
-    OP_ASSERT(_base64_sz>=11);
-    for(i = 0; i < _base64_sz; i++) {
-        uint32_t value;
-        int j;
-        value = 0;
-        for(j = 0; j < 4; j++) {
-            unsigned c;
-            unsigned d;
-            c = (unsigned char) _tag[4 * i + j];
-            if(c == '+')
-                d = 62;
-            else if(c == '/')
-                d = 63;
-            else if(c >= '0' && c <= '9')
-                d = 52 + c - '0';
-            else if(c >= 'a' && c <= 'z')
-                d = 26 + c - 'a';
-            else if(c >= 'A' && c <= 'Z')
-                d = c - 'A';
-            else if(c == '=' && 3 * i + j > _buf_sz)
-                d = 0;
-            else
-                return OP_ENOTFORMAT;
-            value = value << 6 | d;
-        }
-        _buf[3 * i] = (unsigned char) (value >> 16);
-        if(3 * i + 1 < _buf_sz) {
-            _buf[3 * i + 1] = (unsigned char) (value >> 8);
-            if(3 * i + 2 < _buf_sz) _buf[3 * i + 2] = (unsigned char) value;
-        }
-    }
-    i = 0;
-    picture_type = op_parse_uint32be(_buf + i);
-    i += 4;
+    int colors_set;
+    int ret;
+    buf_sz = _src->buf_sz;
+    ret = op_picture_src_read(_src, 0, field, 8);
+    if(ret < 0) return ret;
+    _pic->type = op_parse_uint32be(field);
+    i = 8;
     /*Extract the MIME type.*/
-    mime_type_length = op_parse_uint32be(_buf + i);
-    i += 4;
-    if(mime_type_length > _buf_sz - 32) return OP_ENOTFORMAT;
+    mime_type_length = op_parse_uint32be(field + 4);
+    if(mime_type_length > buf_sz - 32) return OP_ENOTFORMAT;
     mime_type = (char*) malloc(sizeof(*_pic->mime_type) * (mime_type_length + 1));
     if(mime_type == NULL) return OP_EFAULT;
-    memcpy(mime_type, _buf + i, sizeof(*mime_type) * mime_type_length);
-    mime_type[mime_type_length] = '\0';
     _pic->mime_type = mime_type;
+    ret = op_picture_src_read(_src, i, (unsigned char*) mime_type, mime_type_length);
+    if(ret < 0) return ret;
+    mime_type[mime_type_length] = '\0';
+    *_mime_type_length = mime_type_length;
     i += mime_type_length;
     /*Extract the description string.*/
-    description_length = op_parse_uint32be(_buf + i);
+    ret = op_picture_src_read(_src, i, field, 4);
+    if(ret < 0) return ret;
+    description_length = op_parse_uint32be(field);
     i += 4;
-    if(description_length > _buf_sz - mime_type_length - 32) return OP_ENOTFORMAT;
-    description = (char*) malloc(sizeof(*_pic->mime_type) * (description_length + 1));
+    if(description_length > buf_sz - mime_type_length - 32) return OP_ENOTFORMAT;
+    description = (char*) malloc(sizeof(*_pic->description) * (description_length + 1));
     if(description == NULL) return OP_EFAULT;
-    memcpy(description, _buf + i, sizeof(*description) * description_length);
-    description[description_length] = '\0';
     _pic->description = description;
+    ret = op_picture_src_read(_src, i, (unsigned char*) description, description_length);
+    if(ret < 0) return ret;
+    description[description_length] = '\0';
     i += description_length;
     /*Extract the remaining fields.*/
-    width = op_parse_uint32be(_buf + i);
-    i += 4;
-    height = op_parse_uint32be(_buf + i);
-    i += 4;
-    depth = op_parse_uint32be(_buf + i);
-    i += 4;
-    colors = op_parse_uint32be(_buf + i);
-    i += 4;
+    ret = op_picture_src_read(_src, i, field, 20);
+    if(ret < 0) return ret;
+    i += 20;
+    _pic->width = op_parse_uint32be(field);
+    _pic->height = op_parse_uint32be(field + 4);
+    _pic->depth = op_parse_uint32be(field + 8);
+    _pic->colors = op_parse_uint32be(field + 12);
     /*If one of these is set, they all must be, but colors==0 is a valid value.*/
-    colors_set = width != 0 || height != 0 || depth != 0 || colors != 0;
-    if((width == 0 || height == 0 || depth == 0) && colors_set) return OP_ENOTFORMAT;
-    data_length = op_parse_uint32be(_buf + i);
-    i += 4;
-    if(data_length > _buf_sz - i) return OP_ENOTFORMAT;
-    /*Trim extraneous data so we don't copy it below.*/
-    _buf_sz = i + data_length;
-    /*Attempt to determine the image format.*/
-    format = OP_PIC_FORMAT_UNKNOWN;
-    if(mime_type_length == 3 && strcmp(mime_type, "-->") == 0) {
-        format = OP_PIC_FORMAT_URL;
+    colors_set = _pic->width != 0 || _pic->height != 0 || _pic->depth != 0 || _pic->colors != 0;
+    if((_pic->width == 0 || _pic->height == 0 || _pic->depth == 0) && colors_set) return OP_ENOTFORMAT;
+    _pic->data_length = op_parse_uint32be(field + 16);
+    if(_pic->data_length > buf_sz - i) return OP_ENOTFORMAT;
+    *_data_offs = i;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Determines the image format from the MIME type (with its declared length,
+ which may include NULs) and the first few bytes of the picture data.*/
+static int op_picture_format(const char *_mime_type, uint32_t _mime_type_length, const unsigned char *_head,
+        size_t _head_sz) {
+    if(_mime_type_length == 3 && strcmp(_mime_type, "-->") == 0) return OP_PIC_FORMAT_URL;
+    if(_mime_type_length == 10 && op_strncasecmp(_mime_type, "image/jpeg", _mime_type_length) == 0) {
+        if(op_is_jpeg(_head, _head_sz)) return OP_PIC_FORMAT_JPEG;
+    }
+    else if(_mime_type_length == 9 && op_strncasecmp(_mime_type, "image/png", _mime_type_length) == 0) {
+        if(op_is_png(_head, _head_sz)) return OP_PIC_FORMAT_PNG;
+    }
+    else if(_mime_type_length == 9 && op_strncasecmp(_mime_type, "image/gif", _mime_type_length) == 0) {
+        if(op_is_gif(_head, _head_sz)) return OP_PIC_FORMAT_GIF;
+    }
+    else if(_mime_type_length == 0
+            || (_mime_type_length == 6 && op_strncasecmp(_mime_type, "image/", _mime_type_length) == 0)) {
+        if(op_is_jpeg(_head, _head_sz))
+            return OP_PIC_FORMAT_JPEG;
+        else if(op_is_png(_head, _head_sz))
+            return OP_PIC_FORMAT_PNG;
+        else if(op_is_gif(_head, _head_sz)) return OP_PIC_FORMAT_GIF;
+    }
+    return OP_PIC_FORMAT_UNKNOWN;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Applies the parameters extracted from the image (if any) and the constraints
+ on picture type 1.*/
+static int op_picture_finish(OpusPictureTag_t *_pic, uint32_t _file_width, uint32_t _file_height,
+        uint32_t _file_depth, uint32_t _file_colors, int _has_palette) {
+    if(_pic->format == OP_PIC_FORMAT_URL) {
         /*Picture type 1 must be a 32x32 PNG.*/
-        if(picture_type == 1 && (width != 0 || height != 0) && (width != 32 || height != 32)) {
+        if(_pic->type == 1 && (_pic->width != 0 || _pic->height != 0) && (_pic->width != 32 || _pic->height != 32)) {
             return OP_ENOTFORMAT;
         }
-        /*Append a terminating NUL for the convenience of our callers.*/
-        _buf[_buf_sz++] = '\0';
+        return 0;
     }
-    else {
-        if(mime_type_length == 10 && op_strncasecmp(mime_type, "image/jpeg", mime_type_length) == 0) {
-            if(op_is_jpeg(_buf + i, data_length)) format = OP_PIC_FORMAT_JPEG;
+    if(_has_palette >= 0) {
+        /*If we successfully extracted these parameters from the image, override
+         any declared values.*/
+        _pic->width = _file_width;
+        _pic->height = _file_height;
+        _pic->depth = _file_depth;
+        _pic->colors = _file_colors;
+    }
+    /*Picture type 1 must be a 32x32 PNG.*/
+    if(_pic->type == 1 && (_pic->format != OP_PIC_FORMAT_PNG || _pic->width != 32 || _pic->height != 32)) {
+        return OP_ENOTFORMAT;
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*The actual implementation of opus_picture_tag_parse().
+ Unlike the public API, this function requires _pic to already be
+ initialized, modifies its contents before success is guaranteed, and assumes
+ the caller will clear it on error.*/
+static int opus_picture_tag_parse_impl(OpusPictureTag_t *_pic, const OpusPictureSrc_t *_src) {
+    unsigned char *buf;
+    uint32_t mime_type_length;
+    uint32_t data_length;
+    uint32_t file_width;
+    uint32_t file_height;
+    uint32_t file_depth;
+    uint32_t file_colors;
+    int has_palette;
+    size_t i;
+    int ret;
+    ret = op_picture_parse_fields(_pic, _src, &i, &mime_type_length);
+    if(ret < 0) return ret;
+    /*Only the picture data itself is decoded into the output buffer.
+     Allocate an extra byte to allow appending a terminating NUL to URL data.*/
+    data_length = _pic->data_length;
+    buf = (unsigned char*) malloc(sizeof(*buf) * (data_length + (size_t) 1));
+    if(buf == NULL) return OP_EFAULT;
+    _pic->data = buf;
+    ret = op_picture_src_read(_src, i, buf, data_length);
+    if(ret < 0) return ret;
+    /*Reject bad characters in anything that follows the picture data too.*/
+    for(i += data_length; i < _src->buf_sz; i += 48) {
+        unsigned char tail[48];
+        ret = op_picture_src_read(_src, i, tail, _src->buf_sz - i < 48 ? _src->buf_sz - i : 48);
+        if(ret < 0) return ret;
+    }
+    _pic->format = op_picture_format(_pic->mime_type, mime_type_length, buf, data_length);
+    file_width = file_height = file_depth = file_colors = 0;
+    has_palette = -1;
+    switch(_pic->format){
+        case OP_PIC_FORMAT_URL: {
+            /*Append a terminating NUL for the convenience of our callers.*/
+            buf[data_length] = '\0';
         }
-        else if(mime_type_length == 9 && op_strncasecmp(mime_type, "image/png", mime_type_length) == 0) {
-            if(op_is_png(_buf + i, data_length)) format = OP_PIC_FORMAT_PNG;
+            break;
+        case OP_PIC_FORMAT_JPEG: {
+            op_extract_jpeg_params(buf, data_length, &file_width, &file_height, &file_depth, &file_colors,
+                    &has_palette);
+        }
+            break;
+        case OP_PIC_FORMAT_PNG: {
+            op_extract_png_params(buf, data_length, &file_width, &file_height, &file_depth, &file_colors,
+                    &has_palette);
+        }
+            break;
+        case OP_PIC_FORMAT_GIF: {
+            op_extract_gif_params(buf, data_length, &file_width, &file_height, &file_depth, &file_colors,
+                    &has_palette);
+        }
+            break;
+    }
+    return op_picture_finish(_pic, file_width, file_height, file_depth, file_colors, has_palette);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int opus_picture_tag_parse(OpusPictureTag_t *_pic, const char *_tag) {
+    OpusPictureTag_t pic;
+    OpusPictureSrc_t src;
+    int ret;
+    ret = op_picture_src_init(&src, _tag);
+    if(ret < 0) return ret;
+    opus_picture_tag_init(&pic);
+    ret = opus_picture_tag_parse_impl(&pic, &src);
+    if(ret < 0)
+        opus_picture_tag_clear(&pic);
+    else
+        *_pic = pic;
+    return ret;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*A small window over the picture data of a BASE64 block, so the image headers
+ can be walked without decoding the whole image.*/
+typedef struct OpusPictureProbe{
+    const OpusPictureSrc_t *src;
+    size_t                  data_offs;
+    size_t                  data_length;
+    size_t                  win_offs;
+    size_t                  win_len;
+    unsigned char           win[48];
+} OpusPictureProbe_t;
+//----------------------------------------------------------------------------------------------------------------------
+/*Returns the byte at offset _offs of the picture data, or -1 if it is past the
+ end (or could not be decoded).*/
+static int op_probe_byte(OpusPictureProbe_t *_p, size_t _offs) {
+    if(_offs >= _p->data_length) return -1;
+    if(_offs < _p->win_offs || _offs - _p->win_offs >= _p->win_len) {
+        size_t n;
+        n = _p->data_length - _offs;
+        if(n > sizeof(_p->win)) n = sizeof(_p->win);
+        _p->win_len = 0;
+        if(op_picture_src_read(_p->src, _p->data_offs + _offs, _p->win, n) < 0) return -1;
+        _p->win_offs = _offs;
+        _p->win_len = n;
+    }
+    return _p->win[_offs - _p->win_offs];
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Copies _n bytes of the picture data starting at _offs, or returns -1 if they
+ are not all available.*/
+static int op_probe_read(OpusPictureProbe_t *_p, size_t _offs, unsigned char *_dst, size_t _n) {
+    size_t k;
+    for(k = 0; k < _n; k++) {
+        int c;
+        c = op_probe_byte(_p, _offs + k);
+        if(c < 0) return -1;
+        _dst[k] = (unsigned char) c;
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*op_extract_jpeg_params() over a probe: the marker segments are skipped by
+ their length, so only their headers are ever decoded.*/
+static void op_probe_jpeg_params(OpusPictureProbe_t *_p, uint32_t *_width, uint32_t *_height, uint32_t *_depth,
+        uint32_t *_colors, int *_has_palette) {
+    size_t offs;
+    offs = 2;
+    for(;;) {
+        unsigned char seg[8];
+        size_t segment_len;
+        int marker;
+        while((marker = op_probe_byte(_p, offs)) >= 0 && marker != 0xFF)
+            offs++;
+        while((marker = op_probe_byte(_p, offs)) == 0xFF)
+            offs++;
+        if(marker < 0) break;
+        offs++;
+        /*If we hit EOI* (end of image), or another SOI* (start of image),
+         or SOS (start of scan), then stop now.*/
+        if(offs >= _p->data_length || (marker >= 0xD8 && marker <= 0xDA))
+            break;
+        /*RST* (restart markers): skip (no segment length).*/
+        else if(marker >= 0xD0 && marker <= 0xD7) continue;
+        /*Read the length of the marker segment.*/
+        if(op_probe_read(_p, offs, seg, 2) < 0) break;
+        segment_len = seg[0] << 8 | seg[1];
+        if(segment_len < 2 || _p->data_length - offs < segment_len) break;
+        if(marker == 0xC0 || (marker > 0xC0 && marker < 0xD0 && (marker & 3) != 0)) {
+            /*Found a SOFn (start of frame) marker segment:*/
+            if(segment_len >= 8 && op_probe_read(_p, offs, seg, 8) >= 0) {
+                *_height = seg[3] << 8 | seg[4];
+                *_width = seg[5] << 8 | seg[6];
+                *_depth = seg[2] * seg[7];
+                *_colors = 0;
+                *_has_palette = 0;
+            }
+            break;
         }
-        else if(mime_type_length == 9 && op_strncasecmp(mime_type, "image/gif", mime_type_length) == 0) {
-            if(op_is_gif(_buf + i, data_length)) format = OP_PIC_FORMAT_GIF;
+        /*Other markers: skip the whole marker segment.*/
+        offs += segment_len;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*op_extract_png_params() over a probe: only the chunk headers (and IHDR) are
+ decoded.*/
+static void op_probe_png_params(OpusPictureProbe_t *_p, uint32_t *_width, uint32_t *_height, uint32_t *_depth,
+        uint32_t *_colors, int *_has_palette) {
+    size_t offs;
+    offs = 8;
+    while(_p->data_length - offs >= 12) {
+        unsigned char chunk[8 + 13];
+        uint32_t chunk_len;
+        if(op_probe_read(_p, offs, chunk, 8) < 0) break;
+        chunk_len = op_parse_uint32be(chunk);
+        if(chunk_len > _p->data_length - (offs + 12))
+            break;
+        else if(chunk_len == 13 && memcmp(chunk + 4, "IHDR", 4) == 0) {
+            int color_type;
+            if(op_probe_read(_p, offs + 8, chunk + 8, 13) < 0) break;
+            *_width = op_parse_uint32be(chunk + 8);
+            *_height = op_parse_uint32be(chunk + 12);
+            color_type = chunk[17];
+            if(color_type == 3) {
+                *_depth = 24;
+                *_has_palette = 1;
+            }
+            else {
+                int sample_depth;
+                sample_depth = chunk[16];
+                if(color_type == 0)
+                    *_depth = sample_depth;
+                else if(color_type == 2)
+                    *_depth = sample_depth * 3;
+                else if(color_type == 4)
+                    *_depth = sample_depth * 2;
+                else if(color_type == 6) *_depth = sample_depth * 4;
+                *_colors = 0;
+                *_has_palette = 0;
+                break;
+            }
         }
-        else if(mime_type_length == 0
-                || (mime_type_length == 6 && op_strncasecmp(mime_type, "image/", mime_type_length) == 0)) {
-            if(op_is_jpeg(_buf + i, data_length))
-                format = OP_PIC_FORMAT_JPEG;
-            else if(op_is_png(_buf + i, data_length))
-                format = OP_PIC_FORMAT_PNG;
-            else if(op_is_gif(_buf + i, data_length)) format = OP_PIC_FORMAT_GIF;
+        else if(*_has_palette > 0 && memcmp(chunk + 4, "PLTE", 4) == 0) {
+            *_colors = chunk_len / 3;
+            break;
         }
+        offs += 12 + chunk_len;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Like opus_picture_tag_parse(), but without decoding the picture data.
+ Only the fields in front of it and the image headers needed for the width,
+ height, depth and colors are decoded, so this costs a few hundred bytes of
+ BASE64 work no matter how large the picture is.
+ On success _pic->data is NULL; use opus_picture_tag_stream() to fetch it.
+ The BASE64 characters of the picture data are not validated here, so a
+ corrupt image is only reported by opus_picture_tag_stream().*/
+int opus_picture_tag_parse_info(OpusPictureTag_t *_pic, const char *_tag) {
+    OpusPictureTag_t pic;
+    OpusPictureSrc_t src;
+    OpusPictureProbe_t probe;
+    unsigned char head[14];
+    size_t head_sz;
+    uint32_t mime_type_length;
+    uint32_t file_width;
+    uint32_t file_height;
+    uint32_t file_depth;
+    uint32_t file_colors;
+    int has_palette;
+    int ret;
+    ret = op_picture_src_init(&src, _tag);
+    if(ret < 0) return ret;
+    opus_picture_tag_init(&pic);
+    ret = op_picture_parse_fields(&pic, &src, &probe.data_offs, &mime_type_length);
+    if(ret >= 0) {
+        probe.src = &src;
+        probe.data_length = pic.data_length;
+        probe.win_offs = 0;
+        probe.win_len = 0;
+        head_sz = pic.data_length < sizeof(head) ? pic.data_length : sizeof(head);
+        ret = op_probe_read(&probe, 0, head, head_sz) < 0 ? OP_ENOTFORMAT : 0;
+    }
+    if(ret >= 0) {
+        pic.format = op_picture_format(pic.mime_type, mime_type_length, head, head_sz);
         file_width = file_height = file_depth = file_colors = 0;
         has_palette = -1;
-        switch(format){
+        switch(pic.format){
             case OP_PIC_FORMAT_JPEG: {
-                op_extract_jpeg_params(_buf + i, data_length, &file_width, &file_height, &file_depth, &file_colors,
-                        &has_palette);
+                op_probe_jpeg_params(&probe, &file_width, &file_height, &file_depth, &file_colors, &has_palette);
             }
                 break;
             case OP_PIC_FORMAT_PNG: {
-                op_extract_png_params(_buf + i, data_length, &file_width, &file_height, &file_depth, &file_colors,
-                        &has_palette);
+                op_probe_png_params(&probe, &file_width, &file_height, &file_depth, &file_colors, &has_palette);
             }
                 break;
             case OP_PIC_FORMAT_GIF: {
-                op_extract_gif_params(_buf + i, data_length, &file_width, &file_height, &file_depth, &file_colors,
+                op_extract_gif_params(head, head_sz, &file_width, &file_height, &file_depth, &file_colors,
                         &has_palette);
             }
                 break;
         }
-        if(has_palette >= 0) {
-            /*If we successfully extracted these parameters from the image, override
-             any declared values.*/
-            width = file_width;
-            height = file_height;
-            depth = file_depth;
-            colors = file_colors;
-        }
-        /*Picture type 1 must be a 32x32 PNG.*/
-        if(picture_type == 1 && (format != OP_PIC_FORMAT_PNG || width != 32 || height != 32)) {
-            return OP_ENOTFORMAT;
-        }
+        ret = op_picture_finish(&pic, file_width, file_height, file_depth, file_colors, has_palette);
     }
-    /*Adjust _buf_sz instead of using data_length to capture the terminating NUL
-     for URLs.*/
-    _buf_sz -= i;
-    memmove(_buf, _buf + i, sizeof(*_buf) * _buf_sz);
-    _buf = (unsigned char*) realloc(_buf, _buf_sz);
-    if(_buf_sz > 0 && _buf == NULL) return OP_EFAULT;
-    _pic->type = picture_type;
-    _pic->width = width;
-    _pic->height = height;
-    _pic->depth = depth;
-    _pic->colors = colors;
-    _pic->data_length = data_length;
-    _pic->data = _buf;
-    _pic->format = format;
-    return 0;
+    if(ret < 0)
+        opus_picture_tag_clear(&pic);
+    else
+        *_pic = pic;
+    return ret;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int opus_picture_tag_parse(OpusPictureTag_t *_pic, const char *_tag) {
+/*Decodes the picture data of a METADATA_BLOCK_PICTURE tag and hands it to
+ _write in pieces of at most _buf_sz bytes, using _buf as the only decode
+ buffer.
+ _buf_sz should be at least 3; multiples of 3 keep every piece aligned to
+ whole BASE64 groups.
+ The fields in front of the data are checked as by opus_picture_tag_parse(),
+ but the image itself is passed through as stored.
+ Return: 0 on success, a negative value on failure, or the first non-zero
+ value returned by _write, which stops the decode.*/
+int opus_picture_tag_stream(const char *_tag, unsigned char *_buf, size_t _buf_sz, op_picture_write_func _write,
+        void *_ctx) {
     OpusPictureTag_t pic;
-    unsigned char *buf;
-    size_t base64_sz;
-    size_t buf_sz;
-    size_t tag_length;
+    OpusPictureSrc_t src;
+    uint32_t mime_type_length;
+    size_t offs;
+    size_t left;
     int ret;
-    if(opus_tagncompare("METADATA_BLOCK_PICTURE", 22, _tag) == 0) _tag += 23;
-    /*Figure out how much BASE64-encoded data we have.*/
-    tag_length = strlen(_tag);
-    if(tag_length & 3) return OP_ENOTFORMAT;
-    base64_sz = tag_length >> 2;
-    buf_sz = 3 * base64_sz;
-    if(buf_sz < 32) return OP_ENOTFORMAT;
-    if(_tag[tag_length - 1] == '=') buf_sz--;
-    if(_tag[tag_length - 2] == '=') buf_sz--;
-    if(buf_sz < 32) return OP_ENOTFORMAT;
-    /*Allocate an extra byte to allow appending a terminating NUL to URL data.*/
-    buf = (unsigned char*) malloc(sizeof(*buf) * (buf_sz + 1));
-    if(buf == NULL) return OP_EFAULT;
+    if(_buf_sz < 3) return OP_EINVAL;
+    ret = op_picture_src_init(&src, _tag);
+    if(ret < 0) return ret;
     opus_picture_tag_init(&pic);
-    ret = opus_picture_tag_parse_impl(&pic, _tag, buf, buf_sz, base64_sz);
-    if(ret < 0) {
-        opus_picture_tag_clear(&pic);
-        free(buf);
+    ret = op_picture_parse_fields(&pic, &src, &offs, &mime_type_length);
+    left = pic.data_length;
+    opus_picture_tag_clear(&pic);
+    if(ret < 0) return ret;
+    _buf_sz -= _buf_sz % 3;
+    while(left > 0) {
+        size_t n;
+        /*The first piece ends on a group boundary so that all later ones start
+         on one.*/
+        n = _buf_sz - offs % 3;
+        if(n > left) n = left;
+        ret = op_picture_src_read(&src, offs, _buf, n);
+        if(ret < 0) return ret;
+        ret = (*_write)(_ctx, _buf, n);
+        if(ret != 0) return ret;
+        offs += n;
+        left -= n;
     }
-    else
-        *_pic = *&pic;
-    return ret;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int op_picture_fwrite(void *_ctx, const unsigned char *_data, size_t _len) {
+    return fwrite(_data, 1, _len, (FILE*) _ctx) == _len ? 0 : OP_EFAULT;
+}
+//----------------------------------------------------------------------------------------------------------------------
+/*Writes the picture data of a METADATA_BLOCK_PICTURE tag to _fp through a
+ OP_PICTURE_CHUNK_SIZE stack buffer.*/
+int opus_picture_tag_save(const char *_tag, FILE *_fp) {
+    unsigned char buf[OP_PICTURE_CHUNK_SIZE];
+    return opus_picture_tag_stream(_tag, buf, sizeof(buf), op_picture_fwrite, _fp);
 }
 //----------------------------------------------------------------------------------------------------------------------
 void opus_picture_tag_init(OpusPictureTag_t *_pic) {
@@ -17,7 +17,13 @@
 #include "../libopus/opus_multistream.h"
 
 
+/*The decoder's native sample type: int16 for the fixed-point build that runs
+ on the ESP32, float when the codec is built with OPUS_FLOAT_BUILD (hosts).*/
+#if defined(OPUS_FLOAT_BUILD)
+typedef float op_sample;
+#else
 typedef int16_t op_sample;
+#endif
 
 #define OP_ASSERT(_cond)
 
@@ -39,6 +45,101 @@ typedef struct OpusMemStream OpusMemStream;
 
 #define OP_NCHANNELS_MAX (2)
 #define OPUS_CHANNEL_COUNT_MAX (255)
+/*Channel mapping family 1 allows up to 8 channels, and family 255 is rejected,
+   so this is the largest mapping we ever have to remember for a decoder.*/
+#define OP_MAPPING_MAX (8)
+/*The number of idle multistream decoders kept around for reuse.
+  Chained streams usually alternate between one or two channel layouts, so a
+   link change can pick up a parked decoder and only reset it.*/
+#define OP_DECODER_POOL_SIZE (2)
+/*Default op_set_tags_limit(): comments longer than this many bytes are not kept
+ when the headers are read (0 keeps everything).*/
+#ifndef OP_TAGS_MAX_LEN
+#define OP_TAGS_MAX_LEN (0)
+#endif
+
+/*op_scan_callbacks(): the tail window searched for the last page first, and
+ the longest comment kept.*/
+#ifndef OP_SCAN_TAIL_SIZE
+#define OP_SCAN_TAIL_SIZE (8192)
+#endif
+#ifndef OP_SCAN_TAGS_MAX_LEN
+#define OP_SCAN_TAGS_MAX_LEN (256)
+#endif
+
+/*Size of the stack buffer opus_picture_tag_save() decodes cover art through.
+ A multiple of 3, so every chunk covers whole BASE64 groups.*/
+#ifndef OP_PICTURE_CHUNK_SIZE
+#define OP_PICTURE_CHUNK_SIZE (768)
+#endif
+
+/*op_open_url(): the default read-ahead, in milliseconds of audio, and the
+ bitrate it is sized with when neither the caller nor the server gives one.*/
+#ifndef OP_HTTP_READAHEAD_MS_DEFAULT
+#define OP_HTTP_READAHEAD_MS_DEFAULT (4000)
+#endif
+#ifndef OP_HTTP_ASSUMED_KBPS
+#define OP_HTTP_ASSUMED_KBPS (128)
+#endif
+
+/*op_jitter_create(): packets held (a power of two, so at 20 ms a little over
+ half a second), and the largest packet accepted (one UDP payload).*/
+#ifndef OP_JITTER_SLOTS
+#define OP_JITTER_SLOTS (32)
+#endif
+#ifndef OP_JITTER_PACKET_MAX
+#define OP_JITTER_PACKET_MAX (1500)
+#endif
+/*op_jitter_simulate(): latencies above this land in the last histogram bin.*/
+#define OP_JITTER_SIM_HIST_MS (2000)
+
+/*op_read_energy(): levels per frame, and the most frames a packet can carry
+ (120 ms of 2.5 ms frames).*/
+#define OP_ENERGY_BANDS      (OPUS_ENERGY_BANDS)
+#define OP_ENERGY_FRAMES_MAX (48)
+
+/*op_loudness_*(): 1/8 dB histogram bins from the -70 LUFS gate to +10 LUFS.*/
+#define OP_LOUDNESS_BINS (640)
+
+/*What a frame from the jitter buffer holds (op_jitter_pcm_func).*/
+#define OP_JITTER_SILENCE (0)
+#define OP_JITTER_DECODED (1)
+#define OP_JITTER_FEC     (2)
+#define OP_JITTER_PLC     (3)
+#define OP_JITTER_STRETCH (4)
+
+/*Requests for op_url_stream_create() and op_open_url(), each followed by its
+ argument, and the list ended by NULL.*/
+#define OP_URL_OPT(_request) ((_request)+(char *)NULL)
+#define OP_CHECK_INT(_x) ((void)((_x)==(int32_t)0),(int32_t)(_x))
+#define OP_CHECK_SERVER_INFO_PTR(_x) ((_x)+((_x)-(OpusServerInfo_t *)(_x)))
+#define OP_CHECK_HTTP_STATS_PTR(_x) ((_x)+((_x)-(OpusHttpStats_t *)(_x)))
+
+#define OP_SSL_SKIP_CERTIFICATE_CHECK_REQUEST (6464)
+#define OP_HTTP_PROXY_HOST_REQUEST            (6528)
+#define OP_HTTP_PROXY_PORT_REQUEST            (6592)
+#define OP_HTTP_PROXY_USER_REQUEST            (6656)
+#define OP_HTTP_PROXY_PASS_REQUEST            (6720)
+#define OP_GET_SERVER_INFO_REQUEST            (6784)
+#define OP_HTTP_READAHEAD_MS_REQUEST          (6848)
+#define OP_HTTP_BITRATE_KBPS_REQUEST          (6912)
+#define OP_HTTP_STATS_REQUEST                 (6976)
+
+/*Accepted for compatibility; there is no TLS support.*/
+#define OP_SSL_SKIP_CERTIFICATE_CHECK(_b) \
+ OP_URL_OPT(OP_SSL_SKIP_CERTIFICATE_CHECK_REQUEST),OP_CHECK_INT(_b)
+/*Fills in an OpusServerInfo_t (free it with opus_server_info_clear()).*/
+#define OP_GET_SERVER_INFO(_info) \
+ OP_URL_OPT(OP_GET_SERVER_INFO_REQUEST),OP_CHECK_SERVER_INFO_PTR(_info)
+/*How much audio the fetch thread keeps buffered ahead of the reader.*/
+#define OP_HTTP_READAHEAD_MS(_ms) \
+ OP_URL_OPT(OP_HTTP_READAHEAD_MS_REQUEST),OP_CHECK_INT(_ms)
+/*The bitrate the read-ahead is sized for, overriding icy-br.*/
+#define OP_HTTP_BITRATE_KBPS(_kbps) \
+ OP_URL_OPT(OP_HTTP_BITRATE_KBPS_REQUEST),OP_CHECK_INT(_kbps)
+/*An OpusHttpStats_t refreshed on every read, which must outlive the stream.*/
+#define OP_HTTP_STATS(_stats) \
+ OP_URL_OPT(OP_HTTP_STATS_REQUEST),OP_CHECK_HTTP_STATS_PTR(_stats)
 
 /*Initial state.*/
 # define  OP_NOTOPEN   (0)
@@ -56,6 +157,8 @@ typedef int (*op_seek_func)(void *_stream,int64_t _offset,int _whence);
 typedef int64_t (*op_tell_func)(void *_stream);
 typedef int (*op_close_func)(void *_stream);
 
+typedef int (*op_picture_write_func)(void *_ctx,const unsigned char *_data,size_t _len);
+
 typedef int (*op_decode_cb_func)(void *_ctx,OpusMSDecoder *_decoder,void *_pcm, const ogg_packet *_op,
              int _nsamples,int _nchannels,int _format,int _li);
 
@@ -76,6 +179,10 @@ typedef struct OpusTags{
   int          *comment_lengths;
   int           comments;
   char         *vendor;
+  /*The single block behind packed tags (opus_tags_parse_views()), or NULL.*/
+  char         *storage;
+  /*Comments (and binary suffix) left out for being over the size limit.*/
+  int           skipped;
 } OpusTags_t;
 
 typedef struct OpusPictureTag{
@@ -91,6 +198,59 @@ typedef struct OpusPictureTag{
   int           format;
 } OpusPictureTag_t;
 
+typedef struct OpusScanInfo{
+  OpusHead_t    head;
+  OpusTags_t    tags;
+  /*Total duration in samples, or a negative error code.*/
+  int64_t       pcm_total;
+  int           nlinks;
+  int64_t       size;
+  int64_t       bytes_read;
+} OpusScanInfo_t;
+
+#define OP_CATALOG_MAGIC      "OPCATLG\1"
+#define OP_CATALOG_RECORD_MAX (2+20+4*256)
+#define OP_CATALOG_CHAINED    (1)
+#define OP_CATALOG_NO_TOTAL   (2)
+
+typedef struct OpusCatalogEntry{
+  int           flags;
+  int           channels;
+  uint32_t      input_sample_rate;
+  int           output_gain;
+  uint32_t      size;
+  int64_t       pcm_total;
+  char          path[256];
+  char          title[256];
+  char          artist[256];
+  char          album[256];
+} OpusCatalogEntry_t;
+
+/*BS.1770 meter state: the K-weighting filters of each channel, the 100 ms
+ steps of the current block, and the histogram of the gated blocks (Q32 mean
+ squares, full scale = 1). About 8 kB: allocate it rather than putting it on
+ an ESP32 task stack.*/
+typedef struct OpusLoudnessMeter{
+  int           channels;
+  unsigned char weights_q7[OP_MAPPING_MAX];
+  int32_t       state[OP_MAPPING_MAX][8];
+  int64_t       step_nrg[OP_MAPPING_MAX];
+  int           step_len;
+  int           nsteps;
+  uint64_t      steps[3];
+  uint32_t      counts[OP_LOUDNESS_BINS];
+  uint64_t      sums[OP_LOUDNESS_BINS];
+} OpusLoudnessMeter_t;
+
+typedef struct OpusLoudness{
+  /*0, OP_FALSE if nothing is above the -70 LUFS gate (the gain is then 0),
+   or a negative error code.*/
+  int           status;
+  /*Integrated loudness in LUFS and the R128 gain to -23 LUFS, both Q7.8.*/
+  int32_t       loudness_q8;
+  int32_t       gain_q8;
+} OpusLoudness_t;
+
 typedef struct OpusServerInfo{
   char        *name;
   char        *description;
@@ -103,6 +263,20 @@ typedef struct OpusServerInfo{
   int          is_ssl;
 }OpusServerInfo_t;
 
+typedef struct OpusHttpStats{
+  int           connections;
+  int           requests;
+  /*Times the reader found the read-ahead empty after playback had started.*/
+  int           rebuffers;
+  int           seeks;
+  int64_t       bytes;
+  /*Milliseconds from opening the URL to the first audio byte buffered.*/
+  int32_t       first_byte_ms;
+  /*Icecast StreamTitle updates, and the latest title.*/
+  int           metadata_updates;
+  char          stream_title[128];
+} OpusHttpStats_t;
+
 typedef struct OpusFileCallbacks{
   op_read_func  read;
   op_seek_func  seek;
@@ -110,6 +284,56 @@ typedef struct OpusFileCallbacks{
   op_close_func close;
 } OpusFileCallbacks_t;
 
+typedef struct OpusJitterBuffer OpusJitterBuffer;
+
+typedef struct OpusJitterStats{
+  int64_t       received;
+  /*Packets that arrived after their turn, and arrived twice.*/
+  int64_t       late;
+  int64_t       duplicates;
+  /*Frames played, by how they were made.*/
+  int64_t       frames;
+  int64_t       decoded;
+  int64_t       fec;
+  int64_t       plc;
+  /*PLC frames inserted while waiting for a late packet, and frames dropped to
+   bring the delay back down.*/
+  int64_t       stretched;
+  int64_t       dropped;
+  int           resyncs;
+  /*RFC 3550 interarrival jitter, the current playout target and fill.*/
+  int32_t       jitter_ms;
+  int32_t       target_ms;
+  int32_t       buffered_ms;
+  uint32_t      play_ts;
+} OpusJitterStats_t;
+
+typedef struct OpusJitterSimParams{
+  int           channels;
+  int           target_ms;
+  int           max_ms;
+  /*Long-run loss rate in percent, and the mean length of a loss burst.*/
+  int           loss_pct;
+  int           burst_len;
+  /*One-way delay, plus a uniform random extra of up to jitter_ms.*/
+  int           delay_ms;
+  int           jitter_ms;
+  uint32_t      seed;
+} OpusJitterSimParams_t;
+
+typedef struct OpusJitterSimResult{
+  int           sent;
+  int           lost;
+  int32_t       latency_avg_ms;
+  int32_t       latency_p95_ms;
+  int32_t       latency_max_ms;
+  /*PLC and stretched frames per thousand frames played.*/
+  int32_t       concealed_permille;
+  OpusJitterStats_t stats;
+} OpusJitterSimResult_t;
+
+typedef void (*op_jitter_pcm_func)(void *_ctx,const int16_t *_pcm,int _nsamples,int _kind,uint32_t _ts);
+
 typedef struct OggOpusLink{
   int64_t           offset;
   int64_t           data_offset;
@@ -122,6 +346,14 @@ typedef struct OggOpusLink{
   OpusTags_t        tags;
 } OggOpusLink_t;
 
+typedef struct OpusDecoderSlot{
+  OpusMSDecoder    *od;
+  int               stream_count;
+  int               coupled_count;
+  int               channel_count;
+  unsigned char     mapping[OP_MAPPING_MAX];
+} OpusDecoderSlot_t;
+
 typedef struct OggOpusFile{
   OpusFileCallbacks_t  callbacks;
   void             *stream;
@@ -151,12 +383,22 @@ typedef struct OggOpusFile{
   int               od_stream_count;
   int               od_coupled_count;
   int               od_channel_count;
-  unsigned char     od_mapping[OP_NCHANNELS_MAX];
+  unsigned char     od_mapping[OP_MAPPING_MAX];
+  OpusDecoderSlot_t od_pool[OP_DECODER_POOL_SIZE];
   op_sample        *od_buffer;
   int               od_buffer_pos;
   int               od_buffer_size;
+  int               od_buffer_s32;
+  int               od_buffer_wide;
+  int               od_buffer_channels;
+  int               od_energy;
+  int               tags_max_len;
+  int               out_channel_count;
+  unsigned char     out_channels[OP_MAPPING_MAX];
   int               gain_type;
   int32_t           gain_offset_q8;
+  int32_t           volume_q8;
+  int               hybrid_worker;
 } OggOpusFile_t;
 
 struct OpusMemStream {
@@ -165,6 +407,41 @@ struct OpusMemStream {
     ptrdiff_t pos;
 };
 
+/*States of the streaming OpusTags parser: the field it expects next.*/
+#define OP_TAGS_MAGIC       (0)
+#define OP_TAGS_VENDOR_LEN  (1)
+#define OP_TAGS_VENDOR      (2)
+#define OP_TAGS_COUNT       (3)
+#define OP_TAGS_COMMENT_LEN (4)
+#define OP_TAGS_COMMENT     (5)
+#define OP_TAGS_SUFFIX      (6)
+
+typedef struct OpusTagsStream{
+  int               state;
+  unsigned char     field[8];
+  int               field_fill;
+  uint32_t          left;
+  uint32_t          vendor_len;
+  int               keep;
+  int               ncomments;
+  int               ci;
+  int               max_len;
+  char             *buf;
+  size_t            buf_size;
+  size_t            buf_fill;
+  size_t            hint;
+  int              *lengths;
+  int               lengths_size;
+  int               nkept;
+  int               skipped;
+  size_t            suffix_len;
+} OpusTagsStream_t;
+
+void op_tags_stream_init(OpusTagsStream_t *_ts,int _max_len,size_t _size_hint);
+int op_tags_stream_feed(OpusTagsStream_t *_ts,const unsigned char *_data,size_t _len);
+int op_tags_stream_finish(OpusTagsStream_t *_ts,OpusTags_t *_tags);
+void op_tags_stream_clear(OpusTagsStream_t *_ts);
+
 
 int op_strncasecmp(const char *_a,const char *_b,int _n);
 
@@ -174,8 +451,7 @@ int op_strncasecmp(const char *_a,const char *_b,int _n);
 /*Enable special features for gcc and gcc-compatible compilers.*/
 //
 //#  if defined(__GNUC__)&&defined(__GNUC_MINOR__)
-//#   define OP_GNUC_PREREQ(_maj,_min) \
-// ((__GNUC__<<16)+__GNUC_MINOR__>=((_maj)<<16)+(_min))
+//#   define OP_GNUC_PREREQ(_maj,_min) ((__GNUC__<<16)+__GNUC_MINOR__>=((_maj)<<16)+(_min))
 //
 //
 //# if OP_GNUC_PREREQ(4,0)
@@ -229,6 +505,7 @@ typedef struct OggOpusFile       OggOpusFile;
 int opus_head_parse(OpusHead_t *_head, const unsigned char *_data,size_t _len);
 int64_t opus_granule_sample(const OpusHead_t *_head,int64_t _gp);
 int opus_tags_parse(OpusTags_t *_tags, const unsigned char *_data,size_t _len);
+int opus_tags_parse_views(OpusTags_t *_tags, const unsigned char *_data,size_t _len,int _max_len);
 int opus_tags_copy(OpusTags_t *_dst,const OpusTags_t *_src);
 void opus_tags_init(OpusTags_t *_tags);
 int opus_tags_add(OpusTags_t *_tags,const char *_tag,const char *_value);
@@ -243,12 +520,18 @@ void opus_tags_clear(OpusTags_t *_tags);
 int opus_tagcompare(const char *_tag_name,const char *_comment);
 int opus_tagncompare(const char *_tag_name,int _tag_len,const char *_comment);
 int opus_picture_tag_parse(OpusPictureTag_t *_pic, const char *_tag);
+int opus_picture_tag_parse_info(OpusPictureTag_t *_pic, const char *_tag);
+int opus_picture_tag_stream(const char *_tag,unsigned char *_buf,size_t _buf_sz,
+                            op_picture_write_func _write,void *_ctx);
+int opus_picture_tag_save(const char *_tag,FILE *_fp);
 void opus_picture_tag_init(OpusPictureTag_t *_pic);
 void opus_picture_tag_clear(OpusPictureTag_t *_pic);
 void *op_fopen(OpusFileCallbacks_t *_cb, const char *_path,const char *_mode);
 void *op_fdopen(OpusFileCallbacks_t *_cb, int _fd,const char *_mode);
 void *op_freopen(OpusFileCallbacks_t *_cb, const char *_path,const char *_mode,void *_stream);
 void *op_mem_stream_create(OpusFileCallbacks_t *_cb, const unsigned char *_data,size_t _size);
+void opus_server_info_init(OpusServerInfo_t *_info);
+void opus_server_info_clear(OpusServerInfo_t *_info);
 void *op_url_stream_vcreate(OpusFileCallbacks_t *_cb, const char *_url,va_list _ap);
 void *op_url_stream_create(OpusFileCallbacks_t *_cb, const char *_url,...);
 OggOpusFile *op_open_file(const char *_path,int *_error);
@@ -258,6 +541,26 @@ OggOpusFile *op_open_url(const char *_url, int *_error,...);
 OggOpusFile *op_open_callbacks(void *_stream,
 const OpusFileCallbacks_t *_cb,const unsigned char *_initial_data, size_t _initial_bytes,int *_error);
 
+OpusJitterBuffer *op_jitter_create(int _channels,int _target_ms,int _max_ms,int *_error);
+void op_jitter_free(OpusJitterBuffer *_jb);
+int op_jitter_set_target(OpusJitterBuffer *_jb,int _target_ms,int _max_ms);
+int op_jitter_put(OpusJitterBuffer *_jb,const unsigned char *_data,int _len,uint16_t _seq,uint32_t _ts,
+                  int64_t _arrival_ms);
+int op_jitter_get(OpusJitterBuffer *_jb,int16_t *_pcm,int _buf_size,int64_t _now_ms);
+void op_jitter_stats(OpusJitterBuffer *_jb,OpusJitterStats_t *_stats);
+int op_jitter_simulate(const unsigned char *const *_packets,const int *_lens,int _npackets,
+                       const OpusJitterSimParams_t *_params,OpusJitterSimResult_t *_result,
+                       op_jitter_pcm_func _pcm_cb,void *_ctx);
+
+int op_scan_callbacks(OpusScanInfo_t *_info,void *_stream,const OpusFileCallbacks_t *_cb,int64_t _budget);
+int op_scan_file(OpusScanInfo_t *_info,const char *_path,int64_t _budget);
+void op_scan_info_clear(OpusScanInfo_t *_info);
+int op_scan_catalog(FILE *_fp,const char *const *_paths,int _npaths,int _nthreads,int64_t _budget);
+int op_catalog_write_header(FILE *_fp);
+int op_catalog_add(FILE *_fp,const char *_path,const OpusScanInfo_t *_info);
+int op_catalog_read_header(FILE *_fp);
+int op_catalog_read(FILE *_fp,OpusCatalogEntry_t *_entry);
+
 OggOpusFile *op_test_file(const char *_path,int *_error);
 int op_test(OpusHead_t *_head, const unsigned char *_initial_data,size_t _initial_bytes);
 OggOpusFile *op_test_memory(const unsigned char *_data, size_t _size,int *_error);
@@ -297,10 +600,60 @@ void op_set_decode_callback(OggOpusFile *_of, op_decode_cb_func _decode_cb,void
 #define OP_ABSOLUTE_GAIN (3009)
 
 int op_set_gain_offset(OggOpusFile *_of, int _gain_type,int32_t _gain_offset_q8);
+
+#define OP_VOLUME_MUTE (-32768)
+
+/*Playback volume in dB (Q7.8), 0 for full scale, added on top of the gain
+ op_set_gain_offset() selects so it costs no pass over the samples of its own.
+ Once audio has been decoded, changes glide over 10 ms instead of stepping.
+ OP_VOLUME_MUTE silences the output whatever the other gains add. Call it
+ from the thread that reads, between reads.*/
+int op_set_volume(OggOpusFile *_of,int32_t _volume_q8);
 void op_set_dither_enabled(OggOpusFile *_of,int _enabled);
+int op_set_hybrid_worker(OggOpusFile *_of,int _enabled);
+/*Select the channels op_read(), op_read_float() and op_read_s32() return:
+ output channel i carries channel _channels[i] of the link (Vorbis order, as in
+ its OpusHead), or silence if the link has fewer channels. E.g. {0,2} gives the
+ front L/R of a 5.1 file. The decoder is built for this layout, so unselected
+ channels are never copied out and streams feeding none of the selected ones
+ are skipped. _nchannels==0 restores the native layout.*/
+int op_set_channel_layout(OggOpusFile *_of,const unsigned char *_channels,int _nchannels);
+/*Comments longer than _max_len bytes (typically METADATA_BLOCK_PICTURE cover
+ art) are dropped from the tags instead of being kept in RAM; 0 keeps them all.
+ The headers of the first link are read on open, so set OP_TAGS_MAX_LEN at
+ build time to keep them from being copied at all.*/
+int op_set_tags_limit(OggOpusFile *_of,int _max_len);
 int op_read(OggOpusFile *_of, int16_t *_pcm,int _buf_size,int *_li);
 int op_read_float(OggOpusFile *_of, float *_pcm,int _buf_size,int *_li);
 int op_read_stereo(OggOpusFile *_of, int16_t *_pcm,int _buf_size);
 int op_read_float_stereo(OggOpusFile *_of, float *_pcm,int _buf_size);
+/*Left-justified 32-bit output for 24/32-bit I2S DACs: CELT frames come straight
+ from the decoder's internal precision, with the op_set_gain_offset() gain
+ applied before quantisation.*/
+int op_read_s32(OggOpusFile *_of, int32_t *_pcm,int _buf_size,int *_li);
+int op_read_stereo_s32(OggOpusFile *_of, int32_t *_pcm,int _buf_size);
+/*Scan the next packet for its band levels instead of decoding it: only the
+ entropy-coded energies are read, many times faster than op_read(). Fills
+ _band_db (room for OP_ENERGY_FRAMES_MAX frames) with OP_ENERGY_BANDS levels
+ per frame, in dB Q8 relative to full scale (see opus_decode_energy()), and
+ returns the number of frames, each *_frame_size samples at 48 kHz, or 0 at
+ the end of the stream. Pre-skip and end trimming drop whole frames. Audio
+ still buffered from an earlier op_read() is discarded, and the next read of
+ audio after a scan restarts the decoder, as after a seek.*/
+int op_read_energy(OggOpusFile *_of, int16_t *_band_db,int _max_frames,int *_frame_size,int *_li);
+/*EBU R128 loudness: feed a meter with op_loudness_set_layout() and
+ op_loudness_add() (left-justified samples, as op_read_s32() returns them), or
+ let op_loudness_read() decode the rest of a file into it. op_loudness_merge()
+ adds one meter's histogram to another's, e.g. a track to its album.*/
+void op_loudness_init(OpusLoudnessMeter_t *_lm);
+void op_loudness_set_layout(OpusLoudnessMeter_t *_lm,int _channels,int _mapping_family);
+void op_loudness_add(OpusLoudnessMeter_t *_lm,const int32_t *_pcm,int _nsamples);
+void op_loudness_merge(OpusLoudnessMeter_t *_dst,const OpusLoudnessMeter_t *_src);
+int op_loudness_get(const OpusLoudnessMeter_t *_lm,int32_t *_loudness_q8);
+int op_loudness_read(OggOpusFile *_of,OpusLoudnessMeter_t *_lm);
+int op_loudness_file(OpusLoudness_t *_res,OpusLoudnessMeter_t *_lm,const char *_path);
+int op_loudness_album(OpusLoudness_t *_tracks,OpusLoudness_t *_album,const char *const *_paths,int _npaths,
+ int _nthreads);
+int op_tags_rewrite_gain(FILE *_in,FILE *_out,const int32_t *_track_gain_q8,const int32_t *_album_gain_q8);
 
 
@@ -0,0 +1,17 @@
+/*Host stand-in for the parts of the Arduino core the decoder sources use,
+ so tests/http/run.sh can build them with the system compiler.*/
+#ifndef TESTS_HTTP_ARDUINO_H
+#define TESTS_HTTP_ARDUINO_H
+#include <limits.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define _min(a,b) ((a)<(b)?(a):(b))
+#define _max(a,b) ((a)>(b)?(a):(b))
+#define log_i(...) ((void)0)
+#define log_w(...) ((void)0)
+#define log_e(...) ((void)0)
+#endif
@@ -0,0 +1 @@
+/*Host stand-in: the sources include it, but need nothing from it.*/
@@ -0,0 +1,5 @@
+/*Host stand-in: flash tables are ordinary memory.*/
+#define PROGMEM
+#define pgm_read_byte(a) (*(const unsigned char*)(a))
+#define pgm_read_word(a) (*(const unsigned short*)(a))
+#define pgm_read_dword(a) (*(const unsigned int*)(a))
@@ -0,0 +1,129 @@
+/*Checks op_open_url() against op_open_memory() on the same file.
+ Run against tests/http/server.py; see README.md there.
+
+ For every file and serving mode it decodes the whole stream both ways and
+ compares the PCM. On seekable modes it then compares 20 random op_pcm_seek()
+ calls. If the local open fails, the URL open must fail with the same error.
+ Usage: http_check <base-url> <file>...
+ Exit status: 0 if every check matched, 1 otherwise.*/
+#include "OPUS/opusfile/opusfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define CHECK_BUF (5760*8)
+#define CHECK_SEEKS (20)
+
+static const char *const MODES[] = { "range", "chunked", "norange", "close", "icy", "redir/range", "redir/chunked" };
+
+static int read_all(OggOpusFile *_of, std::vector<int16_t> &_pcm) {
+    static int16_t buf[CHECK_BUF];
+    for(;;) {
+        int li;
+        int ret;
+        ret = op_read(_of, buf, CHECK_BUF, &li);
+        if(ret < 0) return ret;
+        if(ret == 0) return 0;
+        _pcm.insert(_pcm.end(), buf, buf + ret * op_channel_count(_of, li));
+    }
+}
+
+/*Seeks both streams to the same offsets and compares one read after each.*/
+static int check_seeks(OggOpusFile *_ref, OggOpusFile *_url) {
+    static int16_t a[CHECK_BUF];
+    static int16_t b[CHECK_BUF];
+    int64_t total;
+    int i;
+    total = op_pcm_total(_ref, -1);
+    if(total <= 0) return 0;
+    for(i = 0; i < CHECK_SEEKS; i++) {
+        int64_t offs;
+        int na;
+        int nb;
+        int li;
+        offs = (int64_t) ((double) rand() / RAND_MAX * (double) (total - 1));
+        if(op_pcm_seek(_ref, offs) != 0 || op_pcm_seek(_url, offs) != 0) return -1;
+        na = op_read(_ref, a, CHECK_BUF, &li);
+        nb = op_read(_url, b, CHECK_BUF, &li);
+        if(na != nb) return -1;
+        if(na > 0 && memcmp(a, b, sizeof(*a) * na * op_channel_count(_ref, li)) != 0) return -1;
+    }
+    return 0;
+}
+
+static int check_file(const char *_base, const char *_path) {
+    std::vector<unsigned char> data;
+    std::vector<int16_t> ref_pcm;
+    std::vector<int16_t> url_pcm;
+    const char *name;
+    OggOpusFile *ref;
+    FILE *f;
+    size_t mi;
+    int ref_err;
+    int failed;
+    f = fopen(_path, "rb");
+    if(f == NULL) {
+        fprintf(stderr, "%s: can't open\n", _path);
+        return 1;
+    }
+    for(;;) {
+        unsigned char tmp[65536];
+        size_t n;
+        n = fread(tmp, 1, sizeof(tmp), f);
+        if(n == 0) break;
+        data.insert(data.end(), tmp, tmp + n);
+    }
+    fclose(f);
+    name = strrchr(_path, '/');
+    name = name == NULL ? _path : name + 1;
+    ref = op_open_memory(data.data(), data.size(), &ref_err);
+    if(ref != NULL) {
+        ref_err = read_all(ref, ref_pcm);
+        op_free(ref);
+    }
+    failed = 0;
+    for(mi = 0; mi < sizeof(MODES) / sizeof(*MODES); mi++) {
+        OpusHttpStats_t stats;
+        OggOpusFile *url;
+        std::string u;
+        int url_err;
+        int ok;
+        u = std::string(_base) + "/" + MODES[mi] + "/" + name;
+        memset(&stats, 0, sizeof(stats));
+        url = op_open_url(u.c_str(), &url_err, OP_HTTP_STATS(&stats), NULL);
+        url_pcm.clear();
+        if(url != NULL) {
+            url_err = read_all(url, url_pcm);
+            op_free(url);
+        }
+        ok = url_err == ref_err && url_pcm == ref_pcm;
+        if(ok && ref_err == 0 && strcmp(MODES[mi], "icy") == 0) ok = stats.metadata_updates > 0;
+        if(ok && ref_err == 0 && (strcmp(MODES[mi], "range") == 0 || strcmp(MODES[mi], "redir/range") == 0)) {
+            ref = op_open_memory(data.data(), data.size(), NULL);
+            url = op_open_url(u.c_str(), NULL, NULL);
+            ok = ref != NULL && url != NULL && op_seekable(url) && check_seeks(ref, url) == 0;
+            op_free(ref);
+            op_free(url);
+        }
+        printf("%-4s %-14s %s (error %d, %u samples, %d conn, %d req)\n", ok ? "ok" : "FAIL", MODES[mi], name,
+                url_err, (unsigned) url_pcm.size(), stats.connections, stats.requests);
+        failed |= !ok;
+    }
+    return failed;
+}
+
+int main(int _argc, char **_argv) {
+    int failed;
+    int i;
+    if(_argc < 3) {
+        fprintf(stderr, "Usage: %s <base-url> <file>...\n", _argv[0]);
+        return 1;
+    }
+    srand(1);
+    failed = 0;
+    for(i = 2; i < _argc; i++)
+        failed |= check_file(_argv[1], _argv[i]);
+    return failed;
+}
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Builds http_check against the decoder sources, starts server.py on a
+# loopback port and checks every serving mode on the given files
+# (sample1.opus by default). Extra server options go in SERVER_OPTS,
+# e.g. SERVER_OPTS="--rate 70000 --latency 30 --stall 300000".
+set -e
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/../.." && pwd)
+out=${OUT:-"$here/build"}
+port=${PORT:-8765}
+mkdir -p "$out/obj"
+if [ $# -eq 0 ]; then set -- "$root/sample1.opus"; fi
+files=
+for f in "$@"; do files="$files $(cd "$(dirname "$f")" && pwd)/$(basename "$f")"; done
+
+# The audio sources take the host shim headers in place of the Arduino core.
+for src in $(cd "$root" && find OPUS -name '*.c' -o -name '*.cpp' | grep -v '_sse4_1\|_avx2' | sort); do
+    obj="$out/obj/$(echo "$src" | tr / _).o"
+    case $src in
+        *.cpp) cc="${CXX:-g++} -std=gnu++17";;
+        *) cc="${CC:-gcc} -std=gnu11";;
+    esac
+    $cc -c -O2 -w -I"$here/host" "$root/$src" -o "$obj"
+done
+rm -f "$out/libopus.a"
+ar rcs "$out/libopus.a" "$out"/obj/*.o
+${CXX:-g++} -std=gnu++17 -O2 -I"$root" -I"$here/host" "$here/http_check.cpp" "$out/libopus.a" \
+    -o "$out/http_check" -lpthread -lm
+
+# Serve the directory of the first file; the others must sit next to it.
+dir=$(dirname $(echo $files | cut -d' ' -f1))
+python3 "$here/server.py" "$dir" --port "$port" $SERVER_OPTS &
+server=$!
+trap 'kill $server 2>/dev/null' EXIT
+sleep 1
+"$out/http_check" "http://127.0.0.1:$port" $files
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Loopback HTTP/Icecast server for the op_open_url() checks.
+
+Serves the files in one directory. The first path segment picks how:
+
+  /range/<file>      HTTP/1.1, keep-alive, honours Range (206/416)
+  /chunked/<file>    HTTP/1.1, chunked transfer encoding, no Range
+  /norange/<file>    HTTP/1.1, Content-Length, ignores Range (200 only)
+  /close/<file>      HTTP/1.0 style: no length, body ends at close
+  /icy/<file>        "ICY 200 OK", icy-metaint with StreamTitle blocks
+  /redir/<mode>/<file>
+                     302 with a relative Location to /<mode>/<file>
+
+Unknown files give 404. --rate throttles every response (bytes/s),
+--latency delays each response, and --stall stalls once, the first time
+a response passes that byte offset of a file.
+"""
+
+import argparse
+import http.server
+import os
+import re
+import socketserver
+import threading
+import time
+
+ICY_METAINT = 8000
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def log_message(self, *args):
+        pass
+
+    def _empty(self, code, headers=()):
+        self.send_response(code)
+        for k, v in headers:
+            self.send_header(k, v)
+        self.send_header('Content-Length', '0')
+        self.end_headers()
+
+    def _write(self, name, offs, data):
+        """Writes data, which starts at byte offs of the file, throttled."""
+        cfg = self.server.cfg
+        pos = 0
+        step = 4096
+        while pos < len(data):
+            piece = data[pos:pos + step]
+            stall = cfg.stall
+            if stall is not None and offs + pos <= stall < offs + pos + len(piece):
+                with self.server.lock:
+                    first = name not in self.server.stalled
+                    self.server.stalled.add(name)
+                if first:
+                    time.sleep(cfg.stall_ms / 1000.0)
+            self.wfile.write(piece)
+            pos += len(piece)
+            if cfg.rate > 0:
+                time.sleep(len(piece) / float(cfg.rate))
+
+    def do_GET(self):
+        cfg = self.server.cfg
+        if cfg.latency > 0:
+            time.sleep(cfg.latency / 1000.0)
+        parts = self.path.split('?')[0].lstrip('/').split('/')
+        if len(parts) == 3 and parts[0] == 'redir':
+            self._empty(302, [('Location', '../../' + parts[1] + '/' + parts[2])])
+            return
+        if len(parts) != 2:
+            self._empty(404)
+            return
+        mode, name = parts
+        fn = os.path.join(cfg.root, os.path.basename(name))
+        if not os.path.isfile(fn):
+            self._empty(404)
+            return
+        with open(fn, 'rb') as f:
+            data = f.read()
+        if mode == 'range':
+            self._range(name, data)
+        elif mode == 'chunked':
+            self._chunked(name, data)
+        elif mode == 'norange':
+            self.send_response(200)
+            self.send_header('Content-Length', str(len(data)))
+            self.end_headers()
+            self._write(name, 0, data)
+        elif mode == 'close':
+            self.send_response(200)
+            self.send_header('Connection', 'close')
+            self.end_headers()
+            self._write(name, 0, data)
+            self.close_connection = True
+        elif mode == 'icy':
+            self._icy(name, data)
+        else:
+            self._empty(404)
+
+    def _range(self, name, data):
+        rng = self.headers.get('Range')
+        if rng is None:
+            self.send_response(200)
+            self.send_header('Accept-Ranges', 'bytes')
+            self.send_header('Content-Length', str(len(data)))
+            self.end_headers()
+            self._write(name, 0, data)
+            return
+        m = re.match(r'bytes=(\d+)-(\d*)$', rng)
+        a = int(m.group(1))
+        b = int(m.group(2)) if m.group(2) else len(data) - 1
+        if a >= len(data):
+            self._empty(416, [('Content-Range', 'bytes */%d' % len(data))])
+            return
+        b = min(b, len(data) - 1)
+        self.send_response(206)
+        self.send_header('Content-Range', 'bytes %d-%d/%d' % (a, b, len(data)))
+        self.send_header('Content-Length', str(b - a + 1))
+        self.end_headers()
+        self._write(name, a, data[a:b + 1])
+
+    def _chunked(self, name, data):
+        self.send_response(200)
+        self.send_header('Transfer-Encoding', 'chunked')
+        self.end_headers()
+        pos = 0
+        size = 1
+        while pos < len(data):
+            # Odd, growing chunk sizes so chunk edges land everywhere.
+            piece = data[pos:pos + size]
+            self.wfile.write(b'%x\r\n' % len(piece))
+            self._write(name, pos, piece)
+            self.wfile.write(b'\r\n')
+            pos += len(piece)
+            size = size * 3 + 7 if size < 20000 else 1
+        self.wfile.write(b'0\r\n\r\n')
+
+    def _icy(self, name, data):
+        # Icecast answers with its own status line and no length.
+        self.wfile.write(b'ICY 200 OK\r\n')
+        self.wfile.write(b'content-type: audio/ogg\r\n')
+        self.wfile.write(b'icy-name: loopback\r\n')
+        self.wfile.write(b'icy-br: 128\r\n')
+        if self.headers.get('Icy-MetaData') == '1':
+            self.wfile.write(b'icy-metaint: %d\r\n' % ICY_METAINT)
+            metaint = ICY_METAINT
+        else:
+            metaint = 0
+        self.wfile.write(b'\r\n')
+        pos = 0
+        n = 0
+        while pos < len(data):
+            step = metaint if metaint > 0 else len(data)
+            self._write(name, pos, data[pos:pos + step])
+            pos += step
+            if metaint > 0:
+                meta = b"StreamTitle='title %d';" % n
+                meta += b'\0' * (-len(meta) % 16)
+                self.wfile.write(bytes([len(meta) // 16]) + meta)
+                n += 1
+        self.close_connection = True
+
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+    def handle_error(self, request, client_address):
+        # The client drops connections it no longer needs; that's expected.
+        pass
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('root', help='directory with the files to serve')
+    ap.add_argument('--port', type=int, default=8765)
+    ap.add_argument('--rate', type=int, default=0, help='bytes/s per response, 0 = unthrottled')
+    ap.add_argument('--latency', type=int, default=0, help='ms before each response')
+    ap.add_argument('--stall', type=int, default=None, help='byte offset to stall at once per file')
+    ap.add_argument('--stall-ms', type=int, default=1000)
+    cfg = ap.parse_args()
+    srv = Server(('127.0.0.1', cfg.port), Handler)
+    srv.cfg = cfg
+    srv.lock = threading.Lock()
+    srv.stalled = set()
+    srv.serve_forever()
+
+
+if __name__ == '__main__':
+    main()